@@ -37,6 +37,9 @@
 #include "itkAdvancedCombinationTransform.h"
 
 #include "itkPlatformMultiThreader.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -140,6 +143,7 @@ public:
   typedef typename ImageSamplerType::Pointer                      ImageSamplerPointer;
   typedef typename ImageSamplerType::OutputVectorContainerType    ImageSampleContainerType;
   typedef typename ImageSamplerType::OutputVectorContainerPointer ImageSampleContainerPointer;
+  typedef typename ImageSamplerType::SampleWeightContainerType    SampleWeightContainerType;
 
   /** Typedefs for Limiter support. */
   typedef LimiterFunctionBase<RealType, FixedImageDimension>  FixedImageLimiterType;
@@ -155,21 +159,25 @@ public:
   typedef typename AdvancedTransformType::NumberOfParametersType                   NumberOfParametersType;
 
   /** Typedef's for the B-spline transform. */
-  typedef AdvancedCombinationTransform<ScalarType, FixedImageDimension>          CombinationTransformType;
-  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 1> BSplineOrder1TransformType;
-  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 2> BSplineOrder2TransformType;
-  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 3> BSplineOrder3TransformType;
-  typedef typename BSplineOrder1TransformType::Pointer                           BSplineOrder1TransformPointer;
-  typedef typename BSplineOrder2TransformType::Pointer                           BSplineOrder2TransformPointer;
-  typedef typename BSplineOrder3TransformType::Pointer                           BSplineOrder3TransformPointer;
+  typedef AdvancedCombinationTransform<ScalarType, FixedImageDimension>           CombinationTransformType;
+  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 1>  BSplineOrder1TransformType;
+  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 2>  BSplineOrder2TransformType;
+  typedef AdvancedBSplineDeformableTransform<ScalarType, FixedImageDimension, 3>  BSplineOrder3TransformType;
+  typedef typename BSplineOrder1TransformType::Pointer                            BSplineOrder1TransformPointer;
+  typedef typename BSplineOrder2TransformType::Pointer                            BSplineOrder2TransformPointer;
+  typedef typename BSplineOrder3TransformType::Pointer                            BSplineOrder3TransformPointer;
+  typedef AdvancedBSplineDeformableTransformBase<ScalarType, FixedImageDimension> BSplineTransformBaseType;
 
   /** Hessian type; for SelfHessian (experimental feature) */
   typedef typename DerivativeType::ValueType  HessianValueType;
   typedef vnl_sparse_matrix<HessianValueType> HessianType;
 
   /** Typedefs for multi-threading. */
-  typedef itk::PlatformMultiThreader          ThreaderType;
-  typedef typename ThreaderType::WorkUnitInfo ThreadInfoType;
+  typedef itk::PlatformMultiThreader                ThreaderType;
+  typedef typename ThreaderType::WorkUnitInfo       ThreadInfoType;
+  typedef typename ThreaderType::ThreadFunctionType ThreadFunctionType;
+  typedef WorkStealingThreadPool                    ThreadPoolType;
+  typedef typename ThreadPoolType::Pointer          ThreadPoolPointer;
 
   /** Public methods ********************/
 
@@ -207,6 +215,16 @@ public:
    * This method allows the user to inspect this setting. */
   itkGetConstMacro(UseImageSampler, bool);
 
+  /** Returns whether the metric multiplies the contribution of every sample by its
+   * importance weight, see ImageSamplerBase::GetSampleWeights(). Initialize() refuses
+   * an image sampler with sample weights when this is false. Default: false.
+   */
+  virtual bool
+  SampleWeightsSupported(void) const
+  {
+    return false;
+  }
+
   /** Set/Get the required ratio of valid samples; default 0.25.
    * When less than this ratio*numberOfSamplesTried samples map
    * inside the moving image buffer, an exception will be thrown. */
@@ -284,6 +302,60 @@ public:
   itkGetConstReferenceMacro(UseMultiThread, bool);
   itkBooleanMacro(UseMultiThread);
 
+  /** Returns whether GetValueAndDerivative() spreads its work over multiple threads.
+   * Metrics that always compute single-threaded return false, such that the
+   * CombinationImageToImageMetric can run them as a task on the thread pool.
+   * Default: UseMultiThread.
+   */
+  virtual bool
+  GetValueAndDerivativeIsMultiThreaded(void) const
+  {
+    return this->m_UseMultiThread;
+  }
+
+  /** Set/Get a persistent thread pool. When set, the threaded parts of the metric
+   * (and of the image sampler) run on the threads of the pool, instead of on threads
+   * that are created and joined by the ITK threader at every call.
+   * Typically the pool is owned by the registration and shared by all components.
+   */
+  itkSetObjectMacro(ThreadPool, ThreadPoolType);
+  itkGetModifiableObjectMacro(ThreadPool, ThreadPoolType);
+
+  /** Select the batched evaluation of samples. Metrics that support it process
+   * their samples in batches of SampleBatchSize samples, see EvaluateSampleBatch(),
+   * and otherwise in batches of one sample, through the same loop.
+   * Metrics that do not support it ignore this setting. Default: true.
+   */
+  itkSetMacro(UseSampleBatches, bool);
+  itkGetConstReferenceMacro(UseSampleBatches, bool);
+  itkBooleanMacro(UseSampleBatches);
+
+  /** Select the sparse accumulation of the per-thread derivatives. The parameters
+   * are divided in tiles of DerivativeTileSize parameters, and each thread records
+   * which tiles it touched. The accumulation then only visits the touched tiles,
+   * which saves a lot of time for transforms with many parameters and compact
+   * support, such as fine B-spline grids. The per-thread derivatives themselves
+   * remain dense, so this saves time, not memory. Only used by metrics that record
+   * the touched tiles (AdvancedMeanSquares). Default: true.
+   */
+  itkSetMacro(UseSparseDerivativeAccumulation, bool);
+  itkGetConstReferenceMacro(UseSparseDerivativeAccumulation, bool);
+  itkBooleanMacro(UseSparseDerivativeAccumulation);
+
+  /** Select spatially partitioned sampling. For B-spline transforms, the samples are
+   * grouped in slabs of control points along one grid axis. The even slabs, and
+   * then the odd slabs, are processed in parallel. Since the B-spline supports of
+   * samples in different even (or odd) slabs do not overlap, all threads write to
+   * the same derivative, and no accumulation of per-thread derivatives is needed.
+   * Falls back to the normal threading when the grid has too few slabs, or the
+   * transform is not suited. The partition is only recomputed when the image sampler
+   * generates new samples. Only used by metrics that support it (AdvancedMeanSquares).
+   * Default: false.
+   */
+  itkSetMacro(UseSpatiallyPartitionedSampling, bool);
+  itkGetConstReferenceMacro(UseSpatiallyPartitionedSampling, bool);
+  itkBooleanMacro(UseSpatiallyPartitionedSampling);
+
   /** Contains calls from GetValueAndDerivative that are thread-unsafe,
    * together with preparation for multi-threading.
    * Note that the only reason why this function is not protected, is
@@ -332,6 +404,29 @@ protected:
   /** Typedefs for support of sparse Jacobians and compact support of transformations. */
   typedef typename AdvancedTransformType::NonZeroJacobianIndicesType NonZeroJacobianIndicesType;
 
+  /** The number of parameters in a tile, for the sparse accumulation of derivatives. */
+  itkStaticConstMacro(DerivativeTileSize, unsigned int, 64);
+
+  /** The maximum number of samples in a sample batch. */
+  itkStaticConstMacro(SampleBatchSize, unsigned int, 16);
+
+  /** A structure-of-arrays buffer for the batched evaluation of samples.
+   * Only the first m_NumberOfValidSamples entries are filled, with the
+   * samples that passed all checks, in the order of the sample container.
+   */
+  struct SampleBatchType
+  {
+    unsigned int               m_NumberOfValidSamples;
+    FixedImagePointType        m_FixedPoints[SampleBatchSize];
+    RealType                   m_FixedImageValues[SampleBatchSize];
+    RealType                   m_SampleWeights[SampleBatchSize];
+    MovingImagePointType       m_MappedPoints[SampleBatchSize];
+    RealType                   m_MovingImageValues[SampleBatchSize];
+    MovingImageDerivativeType  m_MovingImageDerivatives[SampleBatchSize];
+    DerivativeType             m_ImageJacobians[SampleBatchSize];
+    NonZeroJacobianIndicesType m_NonZeroJacobianIndices[SampleBatchSize];
+  };
+
   /** Protected Variables **************/
 
   /** Variables for ImageSampler support. m_ImageSampler is mutable,
@@ -375,6 +470,14 @@ protected:
   ThreadedGetValue(ThreadIdType threadID)
   {}
 
+  /** Multi-threaded version of GetValue(), for the samples [firstSample, lastSample[.
+   * Only used when m_UseThreadedSampleRanges is set: the results are then added to
+   * the per-thread variables of threadID, which may be called for several ranges.
+   */
+  virtual inline void
+  ThreadedGetValueOfSampleRange(ThreadIdType threadID, SizeValueType firstSample, SizeValueType lastSample)
+  {}
+
   /** Finalize multi-threaded metric computation. */
   virtual inline void
   AfterThreadedGetValue(MeasureType & value) const
@@ -393,6 +496,15 @@ protected:
   ThreadedGetValueAndDerivative(ThreadIdType threadID)
   {}
 
+  /** Multi-threaded version of GetValueAndDerivative(), for the samples [firstSample, lastSample[.
+   * See ThreadedGetValueOfSampleRange().
+   */
+  virtual inline void
+  ThreadedGetValueAndDerivativeOfSampleRange(ThreadIdType  threadID,
+                                             SizeValueType firstSample,
+                                             SizeValueType lastSample)
+  {}
+
   /** Finalize multi-threaded metric computation. */
   virtual inline void
   AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const
@@ -410,10 +522,35 @@ protected:
   static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
   AccumulateDerivativesThreaderCallback(void * arg);
 
+  /** Launch a threader callback for all work units, on the thread pool if
+   * one is set, and otherwise on the ITK threader. */
+  void
+  LaunchThreaderCallback(ThreadFunctionType callback, void * userData) const;
+
+  /** Whether the samples can be distributed over the threads of the pool in chunks,
+   * see LaunchSampleRangesOnThreadPool(). */
+  bool
+  CanLaunchSampleRangesOnThreadPool(void) const;
+
+  /** Distribute the samples over the threads of the pool in small chunks, which idle
+   * threads steal from busy ones, and call func(threadID, firstSample, lastSample).
+   */
+  void
+  LaunchSampleRangesOnThreadPool(const typename ThreadPoolType::RangeFunctionType & func) const;
+
   /** Variables for multi-threading. */
-  bool m_UseMetricSingleThreaded;
-  bool m_UseMultiThread;
-  bool m_UseOpenMP;
+  bool              m_UseMetricSingleThreaded;
+  bool              m_UseMultiThread;
+  bool              m_UseOpenMP;
+  ThreadPoolPointer m_ThreadPool;
+
+  /** Set by metrics that compute their sums on ranges of samples, which are then launched with
+   * LaunchSampleRangesOnThreadPool(): AdvancedMeanSquares and AdvancedNormalizedCorrelation (via
+   * ThreadedGetValueOfSampleRange() and ThreadedGetValueAndDerivativeOfSampleRange()), and the
+   * joint histograms and the low-memory derivative of the Parzen window metrics. The other metrics
+   * split the samples equally over the work units. Default: false.
+   */
+  bool m_UseThreadedSampleRanges;
 
   /** Helper structs that multi-threads the computation of
    * the metric derivative using ITK threads.
@@ -425,9 +562,33 @@ protected:
     // Used for accumulating derivatives
     DerivativeValueType * st_DerivativePointer;
     DerivativeValueType   st_NormalizationFactor;
+    // Only accumulate the tiles in st_TouchedDerivativeTiles
+    bool st_UseTouchedDerivativeTiles;
   };
   mutable MultiThreaderParameterType m_ThreaderMetricParameters;
 
+  /** Helper struct for the spatially partitioned computation of the metric derivative. */
+  struct SpatialPartitionThreaderParameterType
+  {
+    AdvancedImageToImageMetric * st_Metric;
+    DerivativeType *             st_Derivative;
+    unsigned int                 st_Phase;
+  };
+  mutable SpatialPartitionThreaderParameterType m_SpatialPartitionThreaderParameters;
+
+  /** The samples sorted by slab, and the offset of each slab in this container.
+   * The last slab contains the samples near the border of the grid, which are
+   * processed by a single thread. The sample container it was made of, and its
+   * modification time, are kept to reuse the partition for the same samples.
+   * The sample weights, if any, are sorted along.
+   */
+  mutable bool                        m_SpatialPartitionIsInitialized;
+  mutable ImageSampleContainerPointer m_PartitionedSampleContainer;
+  mutable SampleWeightContainerType   m_PartitionedSampleWeights;
+  mutable std::vector<unsigned long>  m_PartitionSlabOffsets;
+  mutable ImageSampleContainerPointer m_PartitionSourceSampleContainer;
+  mutable ModifiedTimeType            m_PartitionSourceMTime;
+
   /** Most metrics will perform multi-threading by letting
    * each thread compute a part of the value and derivative.
    *
@@ -454,6 +615,8 @@ protected:
     SizeValueType  st_NumberOfPixelsCounted;
     MeasureType    st_Value;
     DerivativeType st_Derivative;
+    // One flag per tile of DerivativeTileSize parameters
+    std::vector<unsigned char> st_TouchedDerivativeTiles;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
                GetValueAndDerivativePerThreadStruct,
@@ -468,6 +631,41 @@ protected:
   virtual void
   InitializeThreadingParameters(void) const;
 
+  /** Flag the derivative tiles that contain the nonzero Jacobian indices. */
+  void
+  MarkTouchedDerivativeTiles(const NonZeroJacobianIndicesType & nzji, std::vector<unsigned char> & touchedTiles) const;
+
+  /** Sort the samples in slabs for spatially partitioned sampling.
+   * Returns false if the transform or grid does not allow it.
+   */
+  virtual bool
+  InitializeSpatialPartition(void) const;
+
+  /** Compute the value and derivative of the samples in the even slabs, and
+   * then of the odd slabs, using all threads. The derivative is not normalized.
+   */
+  void
+  LaunchSpatiallyPartitionedGetValueAndDerivative(DerivativeType & derivative) const;
+
+  /** Spatially partitioned GetValueAndDerivative threader callback function. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  SpatiallyPartitionedGetValueAndDerivativeThreaderCallback(void * arg);
+
+  /** Add the contributions of the samples [first, last[ to the number of valid
+   * samples, the (unnormalized) value and the derivative. The sample weights start
+   * at the weight of the first sample, or are null when all weights are 1. If
+   * touchedDerivativeTiles is not null, the touched tiles of the derivative are flagged.
+   * Metrics that support spatially partitioned sampling override this function.
+   */
+  virtual void
+  GetValueAndDerivativeOfSamples(const typename ImageSampleContainerType::ConstIterator & first,
+                                 const typename ImageSampleContainerType::ConstIterator & last,
+                                 const float *                                            sampleWeights,
+                                 SizeValueType &                                          numberOfPixelsCounted,
+                                 MeasureType &                                            measure,
+                                 DerivativeType &                                         derivative,
+                                 std::vector<unsigned char> *                             touchedDerivativeTiles) const;
+
   /** Protected methods ************** */
 
   /** Methods for image sampler support **********/
@@ -505,6 +703,12 @@ protected:
                                         RealType &                   movingImageValue,
                                         MovingImageDerivativeType *  gradient) const;
 
+  /** Multiply a moving image gradient with the MovingImageDerivativeScales, when requested.
+   * Called by EvaluateMovingImageValueAndDerivative() and EvaluateSampleBatch().
+   */
+  void
+  ApplyMovingImageDerivativeScales(MovingImageDerivativeType & gradient) const;
+
   /** Computes the inner product of transform Jacobian with moving image gradient.
    * The results are stored in imageJacobian, which is supposed
    * to have the right size (same length as Jacobian's number of columns).
@@ -545,6 +749,62 @@ protected:
                             TransformJacobianType &      jacobian,
                             NonZeroJacobianIndicesType & nzji) const;
 
+  /** Methods for the batched evaluation of samples **********/
+
+  /** Allocate the image Jacobians and nonzero Jacobian indices of a sample batch. */
+  virtual void
+  InitializeSampleBatch(SampleBatchType & batch) const;
+
+  /** Evaluate the samples [first, last[, at most SampleBatchSize, in one go: transform
+   * the points, check the moving mask and evaluate the moving image value and,
+   * if requested, its derivative. The valid samples are stored in the batch.
+   * This replaces the per-sample calls to TransformPoint(), IsInsideMovingMask()
+   * and EvaluateMovingImageValueAndDerivative(). With UseSampleBatches off, metrics
+   * call it with batches of one sample.
+   * With the AdvancedLinearInterpolateImageFunction, all moving image values and
+   * derivatives of the batch are interpolated with a single call.
+   * The sample weights start at the weight of the first sample, or are null when
+   * all weights are 1, see GetSampleWeightsAt().
+   */
+  virtual void
+  EvaluateSampleBatch(const typename ImageSampleContainerType::ConstIterator & first,
+                      const typename ImageSampleContainerType::ConstIterator & last,
+                      SampleBatchType &                                        batch,
+                      const bool                                               computeDerivative,
+                      const float *                                            sampleWeights = nullptr) const;
+
+  /** The importance weights of the samples of the image sampler output from the
+   * given position on, or null when all samples have weight 1.
+   */
+  const float *
+  GetSampleWeightsAt(const SizeValueType position) const
+  {
+    const SampleWeightContainerType & sampleWeights = this->GetImageSampler()->GetSampleWeights();
+    return sampleWeights.empty() ? nullptr : sampleWeights.data() + position;
+  }
+
+  /** The same for the samples sorted by slab, for spatially partitioned sampling. */
+  const float *
+  GetPartitionedSampleWeightsAt(const SizeValueType position) const
+  {
+    return this->m_PartitionedSampleWeights.empty() ? nullptr : this->m_PartitionedSampleWeights.data() + position;
+  }
+
+  /** Compute the inner products of the transform Jacobian and the moving image
+   * derivative of all valid samples of a batch, using the batched transform API.
+   * Metrics may modify the moving image values and derivatives (e.g. with a
+   * limiter) between EvaluateSampleBatch() and this call.
+   */
+  virtual void
+  EvaluateSampleBatchImageJacobians(SampleBatchType & batch) const;
+
+  /** The number of samples per batch: SampleBatchSize, or 1 when UseSampleBatches is off. */
+  unsigned int
+  GetSampleBatchSize(void) const
+  {
+    return this->m_UseSampleBatches ? static_cast<unsigned int>(SampleBatchSize) : 1;
+  }
+
   /** Convenience method: check if point is inside the moving mask. *****************/
   virtual bool
   IsInsideMovingMask(const MovingImagePointType & point) const;
@@ -569,6 +829,9 @@ private:
 
   /** Private member variables. */
   bool   m_UseImageSampler;
+  bool   m_UseSampleBatches;
+  bool   m_UseSparseDerivativeAccumulation;
+  bool   m_UseSpatiallyPartitionedSampling;
   bool   m_UseFixedImageLimiter;
   bool   m_UseMovingImageLimiter;
   double m_RequiredRatioOfValidSamples;
@@ -29,6 +29,9 @@
 
 #include "itkTimeProbe.h"
 
+#include <algorithm> // For min and fill.
+#include <cmath>
+
 namespace itk
 {
 
@@ -50,6 +53,13 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AdvancedImageToImageMetri
   this->m_ImageSampler = nullptr;
   this->m_UseImageSampler = false;
   this->m_RequiredRatioOfValidSamples = 0.25;
+  this->m_UseSampleBatches = true;
+  this->m_UseSparseDerivativeAccumulation = true;
+  this->m_UseSpatiallyPartitionedSampling = false;
+  this->m_SpatialPartitionIsInitialized = false;
+  this->m_PartitionedSampleContainer = nullptr;
+  this->m_PartitionSourceSampleContainer = nullptr;
+  this->m_PartitionSourceMTime = 0;
 
   this->m_LinearInterpolator = nullptr;
   this->m_BSplineInterpolator = nullptr;
@@ -86,6 +96,8 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AdvancedImageToImageMetri
   /** Threading related variables. */
   this->m_UseMetricSingleThreaded = true;
   this->m_UseMultiThread = false;
+  this->m_ThreadPool = nullptr;
+  this->m_UseThreadedSampleRanges = false;
 
   /** OpenMP related. Switch to on when available */
 #ifdef ELASTIX_USE_OPENMP
@@ -99,6 +111,10 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AdvancedImageToImageMetri
 
   /** Initialize the m_ThreaderMetricParameters. */
   this->m_ThreaderMetricParameters.st_Metric = this;
+  this->m_ThreaderMetricParameters.st_UseTouchedDerivativeTiles = false;
+  this->m_SpatialPartitionThreaderParameters.st_Metric = this;
+  this->m_SpatialPartitionThreaderParameters.st_Derivative = nullptr;
+  this->m_SpatialPartitionThreaderParameters.st_Phase = 0;
 
   // Multi-threading structs
   this->m_GetValuePerThreadVariables = nullptr;
@@ -166,6 +182,9 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void)
   /** Check if the transform is a B-spline transform. */
   this->CheckForBSplineTransform();
 
+  /** The B-spline grid may have changed, so the spatial partition must be recomputed. */
+  this->m_PartitionSourceSampleContainer = nullptr;
+
   /** Initialize some threading related parameters. */
   if (this->m_UseMultiThread)
   {
@@ -212,6 +231,8 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
   }
 
   /** Some initialization. */
+  const std::size_t numberOfDerivativeTiles =
+    (this->GetNumberOfParameters() + DerivativeTileSize - 1) / DerivativeTileSize;
   for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_GetValuePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
@@ -222,6 +243,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeThreadingParame
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.SetSize(this->GetNumberOfParameters());
     this->m_GetValueAndDerivativePerThreadVariables[i].st_Derivative.Fill(
       NumericTraits<DerivativeValueType>::ZeroValue());
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_TouchedDerivativeTiles.assign(numberOfDerivativeTiles, 0);
   }
 
 } // end InitializeThreadingParameters()
@@ -363,10 +385,18 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeImageSampler(vo
       itkExceptionMacro(<< "ImageSampler is not present");
     }
 
+    /** A metric that ignores the sample weights would be biased towards the important samples. */
+    if (this->m_ImageSampler->HasSampleWeights() && !this->SampleWeightsSupported())
+    {
+      itkExceptionMacro(<< "ERROR: the " << this->m_ImageSampler->GetNameOfClass() << " weights its samples, which "
+                        << this->GetNameOfClass() << " does not support.");
+    }
+
     /** Initialize the Image Sampler. */
     this->m_ImageSampler->SetInput(this->m_FixedImage);
     this->m_ImageSampler->SetMask(this->m_FixedImageMask);
     this->m_ImageSampler->SetInputImageRegion(this->GetFixedImageRegion());
+    this->m_ImageSampler->SetThreadPool(this->m_ThreadPool);
   }
 
 } // end InitializeImageSampler()
@@ -618,45 +648,8 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateMovingImageValueA
       }
 
       /** The moving image gradient is multiplied with its scales, when requested. */
-      if (this->m_UseMovingImageDerivativeScales)
-      {
-        if (!this->m_ScaleGradientWithRespectToMovingImageOrientation)
-        {
-          for (unsigned int i = 0; i < MovingImageDimension; ++i)
-          {
-            (*gradient)[i] *= this->m_MovingImageDerivativeScales[i];
-          }
-        }
-        else
-        {
-          /** Optionally, the scales are applied with respect to the moving image orientation.
-           * The above default option implicitly applies the scales with respect to the
-           * orientation of the transformation axis. In some cases you may want to restrict
-           * moving image motion with respect to its own axes. This is achieved below by pre
-           * and post rotation by the direction cosines of the moving image.
-           * First the gradient is rotated backwards to a standardized axis.
-           */
-          typedef typename MovingImageType::DirectionType::InternalMatrixType InternalMatrixType;
-          const InternalMatrixType M = this->GetMovingImage()->GetDirection().GetVnlMatrix();
-          vnl_vector<double>       rotated_gradient_vnl = M.transpose() * gradient->GetVnlVector();
-
-          /** Then scales are applied. */
-          for (unsigned int i = 0; i < MovingImageDimension; ++i)
-          {
-            rotated_gradient_vnl[i] *= this->m_MovingImageDerivativeScales[i];
-          }
-
-          /** The scaled gradient is then rotated forwards again. */
-          rotated_gradient_vnl = M * rotated_gradient_vnl;
-
-          /** Copy the vnl version back to the original. */
-          for (unsigned int i = 0; i < MovingImageDimension; ++i)
-          {
-            (*gradient)[i] = rotated_gradient_vnl[i];
-          }
-        }
-      } // end if m_UseMovingImageDerivativeScales
-    }   // end if gradient
+      this->ApplyMovingImageDerivativeScales(*gradient);
+    } // end if gradient
     else
     {
       movingImageValue = this->m_Interpolator->EvaluateAtContinuousIndex(cindex);
@@ -668,6 +661,59 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateMovingImageValueA
 } // end EvaluateMovingImageValueAndDerivative()
 
 
+/**
+ * ******************* ApplyMovingImageDerivativeScales ******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::ApplyMovingImageDerivativeScales(
+  MovingImageDerivativeType & gradient) const
+{
+  if (!this->m_UseMovingImageDerivativeScales)
+  {
+    return;
+  }
+
+  if (!this->m_ScaleGradientWithRespectToMovingImageOrientation)
+  {
+    for (unsigned int i = 0; i < MovingImageDimension; ++i)
+    {
+      gradient[i] *= this->m_MovingImageDerivativeScales[i];
+    }
+  }
+  else
+  {
+    /** Optionally, the scales are applied with respect to the moving image orientation.
+     * The above default option implicitly applies the scales with respect to the
+     * orientation of the transformation axis. In some cases you may want to restrict
+     * moving image motion with respect to its own axes. This is achieved below by pre
+     * and post rotation by the direction cosines of the moving image.
+     * First the gradient is rotated backwards to a standardized axis.
+     */
+    typedef typename MovingImageType::DirectionType::InternalMatrixType InternalMatrixType;
+    const InternalMatrixType M = this->GetMovingImage()->GetDirection().GetVnlMatrix();
+    vnl_vector<double>       rotated_gradient_vnl = M.transpose() * gradient.GetVnlVector();
+
+    /** Then scales are applied. */
+    for (unsigned int i = 0; i < MovingImageDimension; ++i)
+    {
+      rotated_gradient_vnl[i] *= this->m_MovingImageDerivativeScales[i];
+    }
+
+    /** The scaled gradient is then rotated forwards again. */
+    rotated_gradient_vnl = M * rotated_gradient_vnl;
+
+    /** Copy the vnl version back to the original. */
+    for (unsigned int i = 0; i < MovingImageDimension; ++i)
+    {
+      gradient[i] = rotated_gradient_vnl[i];
+    }
+  }
+
+} // end ApplyMovingImageDerivativeScales()
+
+
 /**
  * *************** EvaluateTransformJacobianInnerProduct ****************
  */
@@ -768,6 +814,134 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateTransformJacobian
 } // end EvaluateTransformJacobian()
 
 
+/**
+ * *************** InitializeSampleBatch ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeSampleBatch(SampleBatchType & batch) const
+{
+  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
+
+  batch.m_NumberOfValidSamples = 0;
+  for (unsigned int i = 0; i < SampleBatchSize; ++i)
+  {
+    batch.m_ImageJacobians[i].SetSize(nnzji);
+    batch.m_NonZeroJacobianIndices[i].resize(nnzji);
+  }
+
+} // end InitializeSampleBatch()
+
+
+/**
+ * *************** EvaluateSampleBatch ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleBatch(
+  const typename ImageSampleContainerType::ConstIterator & first,
+  const typename ImageSampleContainerType::ConstIterator & last,
+  SampleBatchType &                                        batch,
+  const bool                                               computeDerivative,
+  const float *                                            sampleWeights) const
+{
+  /** With the linear interpolator, the moving image values and derivatives of
+   * all valid samples are interpolated at once, after the loop over the samples.
+   */
+  const bool                     useBatchedLinear = this->m_InterpolatorIsLinear && !this->GetComputeGradient();
+  MovingImageContinuousIndexType cindices[SampleBatchSize];
+
+  batch.m_NumberOfValidSamples = 0;
+  for (typename ImageSampleContainerType::ConstIterator fiter = first; fiter != last; ++fiter)
+  {
+    const unsigned int          v = batch.m_NumberOfValidSamples;
+    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+
+    /** Transform point and check if it is inside the B-spline support region. */
+    bool sampleOk = this->TransformPoint(fixedPoint, batch.m_MappedPoints[v]);
+
+    /** Check if point is inside mask. */
+    if (sampleOk)
+    {
+      sampleOk = this->IsInsideMovingMask(batch.m_MappedPoints[v]);
+    }
+
+    /** Compute the moving image value M(T(x)) and possibly the derivative dM/dx,
+     * and check if the point is inside the moving image buffer.
+     */
+    if (sampleOk && useBatchedLinear)
+    {
+      this->m_Interpolator->ConvertPointToContinuousIndex(batch.m_MappedPoints[v], cindices[v]);
+      sampleOk = this->m_Interpolator->IsInsideBuffer(cindices[v]);
+    }
+    else if (sampleOk)
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(batch.m_MappedPoints[v],
+                                                             batch.m_MovingImageValues[v],
+                                                             computeDerivative ? &batch.m_MovingImageDerivatives[v]
+                                                                               : nullptr);
+    }
+
+    /** Keep the valid sample, overwriting the entry otherwise. */
+    if (sampleOk)
+    {
+      batch.m_FixedPoints[v] = fixedPoint;
+      batch.m_FixedImageValues[v] = static_cast<RealType>((*fiter).Value().m_ImageValue);
+      batch.m_SampleWeights[v] =
+        sampleWeights != nullptr ? static_cast<RealType>(sampleWeights[fiter.Index() - first.Index()]) : 1.0;
+      ++batch.m_NumberOfValidSamples;
+    }
+  }
+
+  if (useBatchedLinear && computeDerivative)
+  {
+    this->m_LinearInterpolator->EvaluateValueAndDerivativeAtContinuousIndices(
+      batch.m_NumberOfValidSamples, cindices, batch.m_MovingImageValues, batch.m_MovingImageDerivatives);
+    for (unsigned int v = 0; v < batch.m_NumberOfValidSamples; ++v)
+    {
+      this->ApplyMovingImageDerivativeScales(batch.m_MovingImageDerivatives[v]);
+    }
+  }
+  else if (useBatchedLinear)
+  {
+    this->m_LinearInterpolator->EvaluateAtContinuousIndices(
+      batch.m_NumberOfValidSamples, cindices, batch.m_MovingImageValues);
+  }
+
+} // end EvaluateSampleBatch()
+
+
+/**
+ * *************** EvaluateSampleBatchImageJacobians ****************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::EvaluateSampleBatchImageJacobians(SampleBatchType & batch) const
+{
+  typedef typename AdvancedTransformType::MovingImageGradientType MovingImageGradientType;
+
+  MovingImageGradientType movingImageGradients[SampleBatchSize];
+  for (unsigned int v = 0; v < batch.m_NumberOfValidSamples; ++v)
+  {
+    for (unsigned int j = 0; j < MovingImageDimension; ++j)
+    {
+      movingImageGradients[v][j] = batch.m_MovingImageDerivatives[v][j];
+    }
+  }
+
+  /** Compute the inner products of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+  this->m_AdvancedTransform->BatchEvaluateJacobianWithImageGradientProduct(batch.m_NumberOfValidSamples,
+                                                                           batch.m_FixedPoints,
+                                                                           movingImageGradients,
+                                                                           batch.m_ImageJacobians,
+                                                                           batch.m_NonZeroJacobianIndices);
+
+} // end EvaluateSampleBatchImageJacobians()
+
+
 /**
  * ************************** IsInsideMovingMask *************************
  */
@@ -831,6 +1005,9 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::BeforeThreadedGetValueAnd
     }
   }
 
+  /** The spatial partition is set up by the metrics that use it. */
+  this->m_SpatialPartitionIsInitialized = false;
+
 } // end BeforeThreadedGetValueAndDerivative()
 
 
@@ -862,12 +1039,18 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueThreaderCallback(void) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(this->GetValueThreaderCallback,
-                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  if (this->CanLaunchSampleRangesOnThreadPool())
+  {
+    Self * metric = this->m_ThreaderMetricParameters.st_Metric;
+    this->LaunchSampleRangesOnThreadPool(
+      [metric](ThreadIdType threadID, SizeValueType firstSample, SizeValueType lastSample) {
+        metric->ThreadedGetValueOfSampleRange(threadID, firstSample, lastSample);
+      });
+    return;
+  }
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->LaunchThreaderCallback(this->GetValueThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
 
 } // end LaunchGetValueThreaderCallback()
 
@@ -900,16 +1083,82 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchGetValueAndDerivativeThreaderCallback(void) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(this->GetValueAndDerivativeThreaderCallback,
-                                    const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+  if (this->CanLaunchSampleRangesOnThreadPool())
+  {
+    Self * metric = this->m_ThreaderMetricParameters.st_Metric;
+    this->LaunchSampleRangesOnThreadPool(
+      [metric](ThreadIdType threadID, SizeValueType firstSample, SizeValueType lastSample) {
+        metric->ThreadedGetValueAndDerivativeOfSampleRange(threadID, firstSample, lastSample);
+      });
+    return;
+  }
 
-  /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->LaunchThreaderCallback(this->GetValueAndDerivativeThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
 
 } // end LaunchGetValueAndDerivativeThreaderCallback()
 
 
+/**
+ * *********************** LaunchThreaderCallback***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchThreaderCallback(ThreadFunctionType callback,
+                                                                              void *             userData) const
+{
+  if (this->m_ThreadPool.IsNotNull())
+  {
+    /** Run all work units on the persistent threads of the pool. */
+    this->m_ThreadPool->SingleMethodExecute(Self::GetNumberOfWorkUnits(), callback, userData);
+  }
+  else
+  {
+    /** Setup threader and launch. */
+    this->m_Threader->SetSingleMethod(callback, userData);
+    this->m_Threader->SingleMethodExecute();
+  }
+
+} // end LaunchThreaderCallback()
+
+
+/**
+ * *********************** CanLaunchSampleRangesOnThreadPool ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::CanLaunchSampleRangesOnThreadPool(void) const
+{
+  /** The pool threads index the per-thread variables, so there must be enough of them.
+   * Otherwise, as when the pool is shared and has more threads than this metric, the
+   * work units are run on the pool instead. */
+  return this->m_UseThreadedSampleRanges && this->m_ThreadPool.IsNotNull() &&
+         this->m_ThreadPool->GetNumberOfThreads() <= Self::GetNumberOfWorkUnits();
+
+} // end CanLaunchSampleRangesOnThreadPool()
+
+
+/**
+ * *********************** LaunchSampleRangesOnThreadPool ***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchSampleRangesOnThreadPool(
+  const typename ThreadPoolType::RangeFunctionType & func) const
+{
+  /** A grain size of zero lets the pool create a few chunks per thread, so that
+   * threads that finish early (e.g. because their samples fall outside the moving
+   * mask) can take over the remaining chunks of the others.
+   */
+  const SizeValueType numberOfSamples = this->GetImageSampler()->GetOutput()->Size();
+  this->m_ThreadPool->ParallelFor(numberOfSamples, 0, func);
+
+} // end LaunchSampleRangesOnThreadPool()
+
+
 /**
  *********** AccumulateDerivativesThreaderCallback *************
  */
@@ -924,7 +1173,52 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
 
   MultiThreaderParameterType * temp = static_cast<MultiThreaderParameterType *>(infoStruct->UserData);
 
-  const unsigned int numPar = temp->st_Metric->GetNumberOfParameters();
+  const unsigned int        numPar = temp->st_Metric->GetNumberOfParameters();
+  const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
+  const DerivativeValueType normalization = 1.0 / temp->st_NormalizationFactor;
+
+  /** Sparse accumulation: only visit the tiles that were touched by a thread.
+   * Each thread handles whole tiles, so that each flag is reset by one thread.
+   */
+  if (temp->st_UseTouchedDerivativeTiles)
+  {
+    const unsigned int numTiles = (numPar + DerivativeTileSize - 1) / DerivativeTileSize;
+    const unsigned int tilesPerThread = (numTiles + nrOfThreads - 1) / nrOfThreads;
+    const unsigned int tmin = std::min(threadID * tilesPerThread, numTiles);
+    const unsigned int tmax = std::min((threadID + 1) * tilesPerThread, numTiles);
+
+    DerivativeValueType * derivative = temp->st_DerivativePointer;
+    for (unsigned int t = tmin; t < tmax; ++t)
+    {
+      const unsigned int jmin = t * DerivativeTileSize;
+      const unsigned int jmax = std::min(jmin + DerivativeTileSize, numPar);
+      std::fill(derivative + jmin, derivative + jmax, zero);
+
+      for (ThreadIdType i = 0; i < nrOfThreads; ++i)
+      {
+        auto & perThreadVariables = temp->st_Metric->m_GetValueAndDerivativePerThreadVariables[i];
+        if (perThreadVariables.st_TouchedDerivativeTiles[t])
+        {
+          for (unsigned int j = jmin; j < jmax; ++j)
+          {
+            derivative[j] += perThreadVariables.st_Derivative[j];
+
+            /** Reset this variable for the next iteration. */
+            perThreadVariables.st_Derivative[j] = zero;
+          }
+          perThreadVariables.st_TouchedDerivativeTiles[t] = 0;
+        }
+      }
+
+      for (unsigned int j = jmin; j < jmax; ++j)
+      {
+        derivative[j] *= normalization;
+      }
+    }
+
+    return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+  }
+
   const unsigned int subSize =
     static_cast<unsigned int>(std::ceil(static_cast<double>(numPar) / static_cast<double>(nrOfThreads)));
   const unsigned int jmin = threadID * subSize;
@@ -934,8 +1228,6 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
   /** This thread accumulates all sub-derivatives into a single one, for the
    * range [ jmin, jmax [. Additionally, the sub-derivatives are reset.
    */
-  const DerivativeValueType zero = NumericTraits<DerivativeValueType>::Zero;
-  const DerivativeValueType normalization = 1.0 / temp->st_NormalizationFactor;
   for (unsigned int j = jmin; j < jmax; ++j)
   {
     DerivativeValueType tmp = zero;
@@ -954,6 +1246,303 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::AccumulateDerivativesThre
 } // end AccumulateDerivativesThreaderCallback()
 
 
+/**
+ *********** MarkTouchedDerivativeTiles *************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::MarkTouchedDerivativeTiles(
+  const NonZeroJacobianIndicesType & nzji,
+  std::vector<unsigned char> &       touchedTiles) const
+{
+  /** The indices are mostly sorted in runs, so skip repeated tiles. */
+  std::size_t previousTile = touchedTiles.size();
+  for (const auto index : nzji)
+  {
+    const std::size_t tile = index / DerivativeTileSize;
+    if (tile != previousTile)
+    {
+      touchedTiles[tile] = 1;
+      previousTile = tile;
+    }
+  }
+
+} // end MarkTouchedDerivativeTiles()
+
+
+/**
+ *********** InitializeSpatialPartition *************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::InitializeSpatialPartition(void) const
+{
+  this->m_SpatialPartitionIsInitialized = false;
+
+  /** Get the B-spline transform. It must be applied directly to the fixed image
+   * points, so an initial transform is only allowed in addition mode.
+   */
+  const BSplineTransformBaseType * bsplineTransform =
+    dynamic_cast<const BSplineTransformBaseType *>(this->m_AdvancedTransform.GetPointer());
+  const CombinationTransformType * combinationTransform =
+    dynamic_cast<const CombinationTransformType *>(this->m_AdvancedTransform.GetPointer());
+  if (combinationTransform != nullptr)
+  {
+    if (combinationTransform->GetInitialTransform() != nullptr && !combinationTransform->GetUseAddition())
+    {
+      return false;
+    }
+    bsplineTransform = dynamic_cast<const BSplineTransformBaseType *>(combinationTransform->GetCurrentTransform());
+  }
+  if (bsplineTransform == nullptr)
+  {
+    return false;
+  }
+
+  /** The support of a sample spans SplineOrder + 1 control points per dimension,
+   * which follows from the number of weights, (SplineOrder + 1)^Dimension.
+   */
+  const double supportSize = std::floor(
+    std::pow(static_cast<double>(bsplineTransform->GetNumberOfAffectedWeights()), 1.0 / FixedImageDimension) + 0.5);
+  const double halfSupportSize = 0.5 * supportSize;
+
+  /** Partition along the grid axis with the most control points. The slabs are
+   * SplineOrder + 2 control points wide, so that the supports of samples in
+   * slabs k and k + 2 never overlap.
+   */
+  const auto &       gridRegion = bsplineTransform->GetGridRegion();
+  const unsigned int slabWidth = static_cast<unsigned int>(supportSize) + 1;
+  unsigned int       axis = 0;
+  for (unsigned int d = 1; d < FixedImageDimension; ++d)
+  {
+    if (gridRegion.GetSize()[d] > gridRegion.GetSize()[axis])
+    {
+      axis = d;
+    }
+  }
+  const unsigned long numberOfSlabs = (gridRegion.GetSize()[axis] + slabWidth - 1) / slabWidth;
+
+  /** Each phase needs at least one slab per thread to be worthwhile. */
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  if (numberOfThreads < 2 || numberOfSlabs < 2 * static_cast<unsigned long>(numberOfThreads))
+  {
+    return false;
+  }
+
+  /** The matrix that converts a point to a continuous grid index. */
+  typename BSplineTransformBaseType::DirectionType scaledDirection;
+  for (unsigned int i = 0; i < FixedImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < FixedImageDimension; ++j)
+    {
+      scaledDirection[i][j] = bsplineTransform->GetGridDirection()[i][j] * bsplineTransform->GetGridSpacing()[j];
+    }
+  }
+  const auto   pointToIndex = scaledDirection.GetInverse();
+  const auto & gridOrigin = bsplineTransform->GetGridOrigin();
+
+  /** Determine the slab of each sample. Samples whose support may extend beyond
+   * the grid get slab number numberOfSlabs, and are processed separately.
+   */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const unsigned long         sampleContainerSize = sampleContainer->Size();
+  if (sampleContainerSize == 0)
+  {
+    return false;
+  }
+
+  /** Reuse the partition if the sampler did not generate new samples since, which is
+   * the case for e.g. the full and grid samplers.
+   */
+  const ModifiedTimeType sampleContainerMTime =
+    std::max(sampleContainer->GetMTime(), sampleContainer->GetUpdateMTime());
+  if (sampleContainer == this->m_PartitionSourceSampleContainer &&
+      sampleContainerMTime == this->m_PartitionSourceMTime &&
+      this->m_PartitionSlabOffsets.size() == numberOfSlabs + 2)
+  {
+    this->m_SpatialPartitionIsInitialized = true;
+    return true;
+  }
+
+  std::vector<unsigned long> slabOfSample(sampleContainerSize);
+  this->m_PartitionSlabOffsets.assign(numberOfSlabs + 2, 0);
+  for (unsigned long s = 0; s < sampleContainerSize; ++s)
+  {
+    const FixedImagePointType & point = sampleContainer->ElementAt(s).m_ImageCoordinates;
+
+    unsigned long slab = numberOfSlabs;
+    bool          inside = true;
+    double        axisIndex = 0.0;
+    for (unsigned int i = 0; i < FixedImageDimension; ++i)
+    {
+      double cindex = 0.0;
+      for (unsigned int j = 0; j < FixedImageDimension; ++j)
+      {
+        cindex += pointToIndex(i, j) * (point[j] - gridOrigin[j]);
+      }
+      cindex -= static_cast<double>(gridRegion.GetIndex()[i]);
+      inside &= (cindex - halfSupportSize >= 0.0) &&
+                (cindex + halfSupportSize <= static_cast<double>(gridRegion.GetSize()[i]) - 1.0);
+      if (i == axis)
+      {
+        axisIndex = cindex;
+      }
+    }
+    if (inside)
+    {
+      slab = std::min(static_cast<unsigned long>(axisIndex) / slabWidth, numberOfSlabs - 1);
+    }
+
+    slabOfSample[s] = slab;
+    ++this->m_PartitionSlabOffsets[slab + 1];
+  }
+
+  /** Sort the samples by slab, keeping their order within a slab. */
+  for (unsigned long k = 0; k <= numberOfSlabs; ++k)
+  {
+    this->m_PartitionSlabOffsets[k + 1] += this->m_PartitionSlabOffsets[k];
+  }
+  if (this->m_PartitionedSampleContainer.IsNull())
+  {
+    this->m_PartitionedSampleContainer = ImageSampleContainerType::New();
+  }
+  this->m_PartitionedSampleContainer->Reserve(sampleContainerSize);
+  const float * sampleWeights = this->GetSampleWeightsAt(0);
+  this->m_PartitionedSampleWeights.resize(sampleWeights != nullptr ? sampleContainerSize : 0);
+  std::vector<unsigned long> position(this->m_PartitionSlabOffsets.begin(), this->m_PartitionSlabOffsets.end() - 1);
+  for (unsigned long s = 0; s < sampleContainerSize; ++s)
+  {
+    const unsigned long partitionedPosition = position[slabOfSample[s]]++;
+    this->m_PartitionedSampleContainer->SetElement(partitionedPosition, sampleContainer->ElementAt(s));
+    if (sampleWeights != nullptr)
+    {
+      this->m_PartitionedSampleWeights[partitionedPosition] = sampleWeights[s];
+    }
+  }
+  this->m_PartitionSourceSampleContainer = sampleContainer;
+  this->m_PartitionSourceMTime = sampleContainerMTime;
+
+  this->m_SpatialPartitionIsInitialized = true;
+  return true;
+
+} // end InitializeSpatialPartition()
+
+
+/**
+ *********** LaunchSpatiallyPartitionedGetValueAndDerivative *************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::LaunchSpatiallyPartitionedGetValueAndDerivative(
+  DerivativeType & derivative) const
+{
+  /** All threads add to this derivative. */
+  derivative.SetSize(this->GetNumberOfParameters());
+  derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = NumericTraits<SizeValueType>::Zero;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+  /** First the even slabs, then the odd slabs. */
+  this->m_SpatialPartitionThreaderParameters.st_Derivative = &derivative;
+  for (unsigned int phase = 0; phase < 2; ++phase)
+  {
+    this->m_SpatialPartitionThreaderParameters.st_Phase = phase;
+    this->LaunchThreaderCallback(
+      this->SpatiallyPartitionedGetValueAndDerivativeThreaderCallback,
+      const_cast<void *>(static_cast<const void *>(&this->m_SpatialPartitionThreaderParameters)));
+  }
+
+  /** Finally the samples near the border of the grid, in this thread. */
+  const unsigned long                              numberOfSlabs = this->m_PartitionSlabOffsets.size() - 2;
+  typename ImageSampleContainerType::ConstIterator first = this->m_PartitionedSampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator last = this->m_PartitionedSampleContainer->Begin();
+  first += (int)this->m_PartitionSlabOffsets[numberOfSlabs];
+  last += (int)this->m_PartitionSlabOffsets[numberOfSlabs + 1];
+  this->GetValueAndDerivativeOfSamples(first,
+                                       last,
+                                       this->GetPartitionedSampleWeightsAt(this->m_PartitionSlabOffsets[numberOfSlabs]),
+                                       this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted,
+                                       this->m_GetValueAndDerivativePerThreadVariables[0].st_Value,
+                                       derivative,
+                                       nullptr);
+
+} // end LaunchSpatiallyPartitionedGetValueAndDerivative()
+
+
+/**
+ *********** SpatiallyPartitionedGetValueAndDerivativeThreaderCallback *************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::SpatiallyPartitionedGetValueAndDerivativeThreaderCallback(
+  void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadID = infoStruct->WorkUnitID;
+  ThreadIdType     nrOfThreads = infoStruct->NumberOfWorkUnits;
+
+  SpatialPartitionThreaderParameterType * temp =
+    static_cast<SpatialPartitionThreaderParameterType *>(infoStruct->UserData);
+  const Self &                       metric = *temp->st_Metric;
+  const std::vector<unsigned long> & offsets = metric.m_PartitionSlabOffsets;
+  const unsigned long                numberOfSlabs = offsets.size() - 2;
+
+  /** This thread processes the slabs phase + 2 * ( threadID + m * nrOfThreads ). */
+  SizeValueType numberOfPixelsCounted = 0;
+  MeasureType   measure = NumericTraits<MeasureType>::Zero;
+  for (unsigned long slab = temp->st_Phase + 2 * threadID; slab < numberOfSlabs; slab += 2 * nrOfThreads)
+  {
+    typename ImageSampleContainerType::ConstIterator first = metric.m_PartitionedSampleContainer->Begin();
+    typename ImageSampleContainerType::ConstIterator last = metric.m_PartitionedSampleContainer->Begin();
+    first += (int)offsets[slab];
+    last += (int)offsets[slab + 1];
+    metric.GetValueAndDerivativeOfSamples(first,
+                                          last,
+                                          metric.GetPartitionedSampleWeightsAt(offsets[slab]),
+                                          numberOfPixelsCounted,
+                                          measure,
+                                          *temp->st_Derivative,
+                                          nullptr);
+  }
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  metric.m_GetValueAndDerivativePerThreadVariables[threadID].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  metric.m_GetValueAndDerivativePerThreadVariables[threadID].st_Value += measure;
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end SpatiallyPartitionedGetValueAndDerivativeThreaderCallback()
+
+
+/**
+ *********** GetValueAndDerivativeOfSamples *************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeOfSamples(
+  const typename ImageSampleContainerType::ConstIterator &,
+  const typename ImageSampleContainerType::ConstIterator &,
+  const float *,
+  SizeValueType &,
+  MeasureType &,
+  DerivativeType &,
+  std::vector<unsigned char> *) const
+{
+  itkExceptionMacro(<< "GetValueAndDerivativeOfSamples() is not implemented by this metric.");
+
+} // end GetValueAndDerivativeOfSamples()
+
+
 /**
  * *********************** CheckNumberOfSamples ***********************
  */
@@ -986,6 +1575,7 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream &
   os << indent << "Variables related to the Sampler: " << std::endl;
   os << indent.GetNextIndent() << "ImageSampler: " << this->m_ImageSampler.GetPointer() << std::endl;
   os << indent.GetNextIndent() << "UseImageSampler: " << this->m_UseImageSampler << std::endl;
+  os << indent.GetNextIndent() << "UseSampleBatches: " << this->m_UseSampleBatches << std::endl;
 
   /** Variables for the Limiters. */
   os << indent << "Variables related to the Limiters: " << std::endl;
@@ -1019,6 +1609,15 @@ AdvancedImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::ostream &
   os << indent.GetNextIndent() << "TransformIsAdvanced: " << this->m_TransformIsAdvanced << std::endl;
   os << indent.GetNextIndent() << "AdvancedTransform: " << this->m_AdvancedTransform.GetPointer() << std::endl;
 
+  /** Variables related to multi-threading. */
+  os << indent << "Variables related to multi-threading: " << std::endl;
+  os << indent.GetNextIndent() << "UseMultiThread: " << this->m_UseMultiThread << std::endl;
+  os << indent.GetNextIndent() << "ThreadPool: " << this->m_ThreadPool.GetPointer() << std::endl;
+  os << indent.GetNextIndent() << "UseSparseDerivativeAccumulation: " << this->m_UseSparseDerivativeAccumulation
+     << std::endl;
+  os << indent.GetNextIndent() << "UseSpatiallyPartitionedSampling: " << this->m_UseSpatiallyPartitionedSampling
+     << std::endl;
+
   /** Other variables. */
   os << indent << "Other variables of the AdvancedImageToImageMetric: " << std::endl;
   os << indent.GetNextIndent() << "RequiredRatioOfValidSamples: " << this->m_RequiredRatioOfValidSamples << std::endl;
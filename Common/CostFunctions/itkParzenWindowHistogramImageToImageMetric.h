@@ -308,6 +308,7 @@ protected:
   struct ParzenWindowHistogramGetValueAndDerivativePerThreadStruct
   {
     SizeValueType   st_NumberOfPixelsCounted;
+    double          st_SumOfWeights;
     JointPDFPointer st_JointPDF;
   };
   itkPadStruct(ITK_CACHE_LINE_ALIGNMENT,
@@ -328,6 +329,13 @@ protected:
   inline void
   ThreadedComputePDFs(ThreadIdType threadId);
 
+  /** Multi-threaded version of the ComputePDF function, for the samples [firstSample, lastSample[.
+   * Adds to the joint PDF, the number of pixels and the sum of the sample weights of threadId,
+   * so it may be called for several ranges.
+   */
+  inline void
+  ThreadedComputePDFsOfSampleRange(ThreadIdType threadId, SizeValueType firstSample, SizeValueType lastSample);
+
   /** Single-threadedly accumulate results. */
   inline void
   AfterThreadedComputePDFs(void) const;
@@ -352,12 +360,14 @@ protected:
                        const KernelFunctionType * kernel,
                        ParzenValueContainerType & parzenValues) const;
 
-  /** Update the joint PDF with a pixel pair; on demand also updates the
-   * pdf derivatives (if the Jacobian pointers are nonzero).
+  /** Update the joint PDF with a pixel pair, scaled by the importance weight
+   * of the sample; on demand also updates the pdf derivatives (if the Jacobian
+   * pointers are nonzero).
    */
   virtual void
   UpdateJointPDFAndDerivatives(const RealType &                   fixedImageValue,
                                const RealType &                   movingImageValue,
+                               const double                       sampleWeight,
                                const DerivativeType *             imageJacobian,
                                const NonZeroJacobianIndicesType * nzji,
                                JointPDFType *                     jointPDF) const;
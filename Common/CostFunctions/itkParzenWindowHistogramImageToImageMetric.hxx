@@ -71,6 +71,9 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ParzenWindow
   /** Initialize the m_ParzenWindowHistogramThreaderParameters */
   this->m_ParzenWindowHistogramThreaderParameters.m_Metric = this;
 
+  /** The joint PDFs can be computed on chunks of samples, see LaunchComputePDFsThreaderCallback(). */
+  this->m_UseThreadedSampleRanges = true;
+
   // Multi-threading structs
   this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables = nullptr;
   this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariablesSize = 0;
@@ -471,6 +474,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::InitializeTh
   {
     this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted =
       NumericTraits<SizeValueType>::Zero;
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_SumOfWeights = 0.0;
 
     // Initialize the joint pdf
     JointPDFPointer & jointPDF = this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF;
@@ -553,6 +557,7 @@ void
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointPDFAndDerivatives(
   const RealType &                   fixedImageValue,
   const RealType &                   movingImageValue,
+  const double                       sampleWeight,
   const DerivativeType *             imageJacobian,
   const NonZeroJacobianIndicesType * nzji,
   JointPDFType *                     jointPDF) const
@@ -596,7 +601,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
     /** Loop over the Parzen window region and increment the values. */
     for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
     {
-      const double fv = fixedParzenValues[f];
+      const double fv = sampleWeight * fixedParzenValues[f];
       for (unsigned int m = 0; m < movingParzenValues.GetSize(); ++m)
       {
         it.Value() += static_cast<PDFValueType>(fv * movingParzenValues[m]);
@@ -621,7 +626,7 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::UpdateJointP
      */
     for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
     {
-      const double fv = fixedParzenValues[f];
+      const double fv = sampleWeight * fixedParzenValues[f];
       const double fv_et = fv / et;
       for (unsigned int m = 0; m < movingParzenValues.GetSize(); ++m)
       {
@@ -1018,8 +1023,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
+  double                      sumOfWeights = 0.0;
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -1063,8 +1070,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
 
       /** Compute this sample's contribution to the joint distributions. */
+      const double sampleWeight = sampleWeights != nullptr ? sampleWeights[fiter.Index()] : 1.0;
+      sumOfWeights += sampleWeight;
       this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, nullptr, nullptr, this->m_JointPDF.GetPointer());
+        fixedImageValue, movingImageValue, sampleWeight, nullptr, nullptr, this->m_JointPDF.GetPointer());
     }
 
   } // end iterating over fixed image spatial sample container for loop
@@ -1072,8 +1081,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsS
   /** Check if enough samples were valid. */
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** Compute alpha. */
-  this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
+  /** Compute alpha, which normalizes the joint histogram by the sum of the sample weights. */
+  this->m_Alpha = 1.0 / sumOfWeights;
 
 } // end ComputePDFsSingleThreaded()
 
@@ -1132,11 +1141,8 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
     this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_JointPDF;
   jointPDF->FillBuffer(NumericTraits<PDFValueType>::ZeroValue());
 
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
-
   /** Get the samples for this thread. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
   const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
     std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
 
@@ -1145,15 +1151,39 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
+  this->ThreadedComputePDFsOfSampleRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedComputePDFs()
+
+
+/**
+ * ******************* ThreadedComputePDFsOfSampleRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputePDFsOfSampleRange(
+  ThreadIdType  threadId,
+  SizeValueType pos_begin,
+  SizeValueType pos_end)
+{
+  /** Get a handle to the joint PDF of the current thread, which is reset by the caller. */
+  JointPDFType & jointPDF = *this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_JointPDF;
+
   /** Create iterator over the sample container. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
   typename ImageSampleContainerType::ConstIterator fiter;
   typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
   typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
   fbegin += (int)pos_begin;
   fend += (int)pos_end;
 
+  /** Get the importance weights of the samples of this range. */
+  const float * sampleWeights = this->GetSampleWeightsAt(pos_begin);
+
   /** Create variables to store intermediate results. circumvent false sharing */
   unsigned long numberOfPixelsCounted = 0;
+  double        sumOfWeights = 0.0;
 
   /** Loop over sample container and compute contribution of each sample to pdfs. */
   for (fiter = fbegin; fiter != fend; ++fiter)
@@ -1192,15 +1222,20 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComp
       movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue);
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, nullptr, nullptr, jointPDF.GetPointer());
+      const double sampleWeight = sampleWeights != nullptr ? sampleWeights[fiter.Index() - pos_begin] : 1.0;
+      sumOfWeights += sampleWeight;
+      this->UpdateJointPDFAndDerivatives(fixedImageValue, movingImageValue, sampleWeight, nullptr, nullptr, &jointPDF);
     }
   } // end iterating over fixed image spatial sample container for loop
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted =
+  /** Only update these variables at the end to prevent unnecessary "false sharing".
+   * A thread may process several ranges, so add to them.
+   */
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted +=
     numberOfPixelsCounted;
+  this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[threadId].st_SumOfWeights += sumOfWeights;
 
-} // end ThreadedComputePDFs()
+} // end ThreadedComputePDFsOfSampleRange()
 
 
 /**
@@ -1213,55 +1248,55 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::AfterThreade
 {
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
-  /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted =
-    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  /** Accumulate the number of pixels and the sum of the sample weights. */
+  this->m_NumberOfPixelsCounted = 0;
+  double sumOfWeights = 0.0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted +=
       this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+    sumOfWeights += this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_SumOfWeights;
 
-    /** Reset this variable for the next iteration. */
+    /** Reset these variables for the next iteration. */
     this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_SumOfWeights = 0.0;
   }
 
   /** Check if enough samples were valid. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** Compute alpha. */
-  this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
+  /** Compute alpha, which normalizes the joint histogram by the sum of the sample weights. */
+  this->m_Alpha = 1.0 / sumOfWeights;
 
-  /** Accumulate joint histogram. */
-  // could be multi-threaded too, by each thread updating only a part of the JointPDF.
-  typedef ImageScanlineIterator<JointPDFType> JointPDFIteratorType;
-  JointPDFIteratorType                        it(this->m_JointPDF, this->m_JointPDF->GetBufferedRegion());
-  std::vector<JointPDFIteratorType>           itT(numberOfThreads);
-  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-  {
-    itT[i] = JointPDFIteratorType(this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF,
-                                  this->m_JointPDF->GetBufferedRegion());
-  }
+  /** Accumulate joint histogram. Each thread sums a range of bins over the
+   * histograms of all threads, in the order of the threads, so the result
+   * does not depend on how the bins are distributed.
+   */
+  const SizeValueType  numberOfBins = this->m_JointPDF->GetPixelContainer()->Size();
+  PDFValueType * const jointPDF = this->m_JointPDF->GetBufferPointer();
 
-  PDFValueType sum;
-  while (!it.IsAtEnd())
-  {
-    while (!it.IsAtEndOfLine())
+  const auto accumulate = [this, numberOfThreads, jointPDF](ThreadIdType, SizeValueType begin, SizeValueType end) {
+    const AlignedParzenWindowHistogramGetValueAndDerivativePerThreadStruct * perThreadVariables =
+      this->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables;
+    for (SizeValueType b = begin; b < end; ++b)
     {
-      sum = NumericTraits<PDFValueType>::Zero;
+      PDFValueType sum = NumericTraits<PDFValueType>::Zero;
       for (ThreadIdType i = 0; i < numberOfThreads; ++i)
       {
-        sum += itT[i].Value();
-        ++itT[i];
+        sum += perThreadVariables[i].st_JointPDF->GetBufferPointer()[b];
       }
-      it.Set(sum);
-      ++it;
-    }
-    it.NextLine();
-    for (ThreadIdType i = 0; i < numberOfThreads; ++i)
-    {
-      itT[i].NextLine();
+      jointPDF[b] = sum;
     }
+  };
+
+  if (this->m_ThreadPool.IsNotNull())
+  {
+    this->m_ThreadPool->ParallelFor(numberOfBins, 0, accumulate);
+  }
+  else
+  {
+    accumulate(0, 0, numberOfBins);
   }
 
 } // end AfterThreadedComputePDFs()
@@ -1296,13 +1331,31 @@ template <class TFixedImage, class TMovingImage>
 void
 ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::LaunchComputePDFsThreaderCallback(void) const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(
-    this->ComputePDFsThreaderCallback,
-    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
+  /** Distribute the samples over the pool in chunks, which each thread adds to its own joint PDF,
+   * so those are reset first.
+   */
+  if (this->CanLaunchSampleRangesOnThreadPool())
+  {
+    Self * metric = this->m_ParzenWindowHistogramThreaderParameters.m_Metric;
+    this->m_ThreadPool->ParallelFor(
+      Self::GetNumberOfWorkUnits(), 1, [metric](ThreadIdType, SizeValueType begin, SizeValueType end) {
+        for (SizeValueType i = begin; i < end; ++i)
+        {
+          metric->m_ParzenWindowHistogramGetValueAndDerivativePerThreadVariables[i].st_JointPDF->FillBuffer(
+            NumericTraits<PDFValueType>::ZeroValue());
+        }
+      });
+    this->LaunchSampleRangesOnThreadPool(
+      [metric](ThreadIdType threadId, SizeValueType firstSample, SizeValueType lastSample) {
+        metric->ThreadedComputePDFsOfSampleRange(threadId, firstSample, lastSample);
+      });
+    return;
+  }
 
   /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->LaunchThreaderCallback(
+    this->ComputePDFsThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowHistogramThreaderParameters)));
 
 } // end LaunchComputePDFsThreaderCallback()
 
@@ -1342,8 +1395,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
+  double                      sumOfWeights = 0.0;
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -1394,8 +1449,10 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
 
       /** Update the joint pdf and the joint pdf derivatives. */
+      const double sampleWeight = sampleWeights != nullptr ? sampleWeights[fiter.Index()] : 1.0;
+      sumOfWeights += sampleWeight;
       this->UpdateJointPDFAndDerivatives(
-        fixedImageValue, movingImageValue, &imageJacobian, &nzji, this->m_JointPDF.GetPointer());
+        fixedImageValue, movingImageValue, sampleWeight, &imageJacobian, &nzji, this->m_JointPDF.GetPointer());
 
     } // end if-block check sampleOk
   }   // end iterating over fixed image spatial sample container for loop
@@ -1403,11 +1460,11 @@ ParzenWindowHistogramImageToImageMetric<TFixedImage, TMovingImage>::ComputePDFsA
   /** Check if enough samples were valid. */
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
-  /** Compute alpha. */
+  /** Compute alpha, which normalizes the joint histogram by the sum of the sample weights. */
   this->m_Alpha = 0.0;
   if (this->m_NumberOfPixelsCounted > 0)
   {
-    this->m_Alpha = 1.0 / static_cast<double>(this->m_NumberOfPixelsCounted);
+    this->m_Alpha = 1.0 / sumOfWeights;
   }
 
 } // end ComputePDFsAndPDFDerivatives()
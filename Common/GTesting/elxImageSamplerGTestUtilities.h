@@ -0,0 +1,72 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxImageSamplerGTestUtilities_h
+#define elxImageSamplerGTestUtilities_h
+
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkSmartPointer.h>
+
+namespace elastix
+{
+namespace GTestUtilities
+{
+
+/// Creates an image of the specified size and spacing, and sets each pixel to the value that the specified function
+/// returns for its index.
+template <typename TImage, typename TIndexToPixelValue>
+itk::SmartPointer<TImage>
+CreateImageFromIndexFunction(const typename TImage::SizeType &    size,
+                             const typename TImage::SpacingType & spacing,
+                             TIndexToPixelValue                   indexToPixelValue)
+{
+  const auto image = TImage::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<TImage> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(static_cast<typename TImage::PixelType>(indexToPixelValue(it.GetIndex())));
+  }
+  return image;
+}
+
+
+/// Creates an image whose pixel values encode their index, as `x + 100 y + 10000 z`, so that each sample of an image
+/// sampler can be traced back to its pixel.
+template <typename TImage>
+itk::SmartPointer<TImage>
+CreateIndexEncodingImage(const typename TImage::SizeType &    size,
+                         const typename TImage::SpacingType & spacing = typename TImage::SpacingType(1.0))
+{
+  return CreateImageFromIndexFunction<TImage>(size, spacing, [](const typename TImage::IndexType & index) {
+    double value = 0.0;
+    double factor = 1.0;
+    for (unsigned int i = 0; i < TImage::ImageDimension; ++i)
+    {
+      value += factor * index[i];
+      factor *= 100.0;
+    }
+    return value;
+  });
+}
+
+} // namespace GTestUtilities
+} // namespace elastix
+
+
+#endif
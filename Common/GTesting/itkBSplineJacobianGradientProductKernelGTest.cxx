@@ -0,0 +1,104 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkBSplineJacobianGradientProductKernel.h"
+
+#include "itkRecursiveBSplineTransformImplementation.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using itk::BSplineJacobianGradientProductKernel;
+
+namespace
+{
+
+/** Checks that the kernel yields exactly the same image Jacobians as the recursive implementation. */
+template <unsigned int VDimension, unsigned int VSplineOrder>
+void
+Expect_kernel_equals_recursive_implementation()
+{
+  constexpr unsigned int numberOfWeights = VDimension * (VSplineOrder + 1);
+  unsigned int           numberOfIndices = 1;
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    numberOfIndices *= VSplineOrder + 1;
+  }
+
+  const unsigned int numberOfSamples = 5;
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+  std::vector<double> weights1D(numberOfSamples * numberOfWeights);
+  std::vector<double> gradients(numberOfSamples * VDimension);
+  for (auto & weight : weights1D)
+  {
+    weight = distribution(randomNumberEngine);
+  }
+  for (auto & gradient : gradients)
+  {
+    gradient = distribution(randomNumberEngine);
+  }
+
+  std::vector<std::vector<double>> actual(numberOfSamples, std::vector<double>(VDimension * numberOfIndices));
+  std::vector<double *>            actualPointers;
+  for (auto & imageJacobian : actual)
+  {
+    actualPointers.push_back(imageJacobian.data());
+  }
+  BSplineJacobianGradientProductKernel::Evaluate(
+    VDimension, VSplineOrder, numberOfSamples, weights1D.data(), gradients.data(), actualPointers.data());
+
+  for (unsigned int s = 0; s < numberOfSamples; ++s)
+  {
+    std::vector<double> expected(VDimension * numberOfIndices);
+    double *            expectedPointer = expected.data();
+    itk::RecursiveBSplineTransformImplementation<VDimension, VDimension, VSplineOrder, double>::
+      EvaluateJacobianWithImageGradientProduct(
+        expectedPointer, gradients.data() + s * VDimension, weights1D.data() + s * numberOfWeights, 1.0);
+
+    EXPECT_EQ(actual[s], expected);
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(BSplineJacobianGradientProductKernel, EqualsRecursiveImplementation)
+{
+  Expect_kernel_equals_recursive_implementation<2, 1>();
+  Expect_kernel_equals_recursive_implementation<2, 2>();
+  Expect_kernel_equals_recursive_implementation<2, 3>();
+  Expect_kernel_equals_recursive_implementation<3, 1>();
+  Expect_kernel_equals_recursive_implementation<3, 2>();
+  Expect_kernel_equals_recursive_implementation<3, 3>();
+  Expect_kernel_equals_recursive_implementation<4, 3>();
+}
+
+
+GTEST_TEST(BSplineJacobianGradientProductKernel, HasInstructionSetName)
+{
+  const std::string name = BSplineJacobianGradientProductKernel::GetInstructionSetName();
+  EXPECT_TRUE(name == "AVX-512" || name == "AVX2" || name == "scalar");
+}
@@ -0,0 +1,97 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkBrickedImageBuffer.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkImageRegionIterator.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+
+namespace
+{
+
+/** Checks that every pixel of the copy equals the pixel of the image, and has its own offset. */
+template <class TPixel, unsigned int VDimension>
+void
+Expect_copy_equals_image(const typename itk::Image<TPixel, VDimension>::RegionType & region)
+{
+  using ImageType = itk::Image<TPixel, VDimension>;
+
+  const auto image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  TPixel value = 0;
+  for (itk::ImageRegionIterator<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    it.Set(++value);
+  }
+
+  itk::BrickedImageBuffer<TPixel, VDimension> bricked;
+  EXPECT_TRUE(bricked.IsEmpty());
+  bricked.CopyImage(image.GetPointer());
+  ASSERT_FALSE(bricked.IsEmpty());
+  EXPECT_EQ(bricked.GetBufferedRegion(), region);
+
+  std::set<itk::SizeValueType> offsets;
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    EXPECT_EQ(bricked.GetPixel(it.GetIndex()), it.Get());
+    EXPECT_EQ(bricked.GetBufferPointer()[bricked.ComputeOffset(it.GetIndex())], it.Get());
+    offsets.insert(bricked.ComputeOffset(it.GetIndex()));
+  }
+  EXPECT_EQ(offsets.size(), region.GetNumberOfPixels());
+
+  bricked.Clear();
+  EXPECT_TRUE(bricked.IsEmpty());
+}
+
+} // namespace
+
+
+GTEST_TEST(BrickedImageBuffer, CopyEqualsImage)
+{
+  Expect_copy_equals_image<float, 2>({ { { 3, -2 } }, { { 21, 9 } } });
+  Expect_copy_equals_image<short, 3>({ { { 0, 0, 0 } }, { { 8, 8, 8 } } });
+  Expect_copy_equals_image<float, 3>({ { { -1, 4, 2 } }, { { 17, 9, 10 } } });
+  Expect_copy_equals_image<double, 3>({ { { 0, 0, 0 } }, { { 1, 1, 30 } } });
+}
+
+
+/** Neighbouring pixels within a brick are stored next to each other. */
+GTEST_TEST(BrickedImageBuffer, BricksAreContiguous)
+{
+  using ImageType = itk::Image<float, 3>;
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 20, 20, 20 } });
+  image->Allocate(true);
+
+  itk::BrickedImageBuffer<float, 3> bricked;
+  bricked.CopyImage(image.GetPointer());
+
+  constexpr unsigned int brickLength = itk::BrickedImageBuffer<float, 3>::BrickLength;
+  const auto             first = bricked.ComputeOffset({ { 8, 8, 8 } });
+  EXPECT_EQ(bricked.ComputeOffset({ { 9, 8, 8 } }), first + 1);
+  EXPECT_EQ(bricked.ComputeOffset({ { 8, 9, 8 } }), first + brickLength);
+  EXPECT_EQ(bricked.ComputeOffset({ { 8, 8, 9 } }), first + brickLength * brickLength);
+}
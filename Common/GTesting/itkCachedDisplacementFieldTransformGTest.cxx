@@ -0,0 +1,160 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkCachedDisplacementFieldTransform.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkAdvancedTranslationTransform.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+
+typedef itk::AdvancedBSplineDeformableTransform<double, 2, 3> TransformType;
+typedef itk::CachedDisplacementFieldTransform<double, 2>      CachedTransformType;
+
+/** Creates a smooth deformable transform, with random parameters. */
+TransformType::Pointer
+CreateTransform(void)
+{
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(TransformType::RegionType(TransformType::SizeType{ { 8, 8 } }));
+  transform->SetGridSpacing(itk::MakeVector(5.0, 5.0));
+  transform->SetGridOrigin(itk::MakePoint(-5.0, -5.0));
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  TransformType::ParametersType          parameters(transform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+
+/** Caches the transform on a grid of 21 x 16 points, from (2, 3) to (22, 18). */
+CachedTransformType::Pointer
+CreateCachedTransform(const TransformType & transform, const unsigned int splineOrder)
+{
+  const auto cachedTransform = CachedTransformType::New();
+  cachedTransform->SetTransform(&transform);
+  cachedTransform->SetGridSize(CachedTransformType::SizeType{ { 21, 16 } });
+  cachedTransform->SetGridOrigin(itk::MakePoint(2.0, 3.0));
+  cachedTransform->SetSplineOrder(splineOrder);
+  cachedTransform->UpdateCache();
+  return cachedTransform;
+}
+
+} // namespace
+
+
+GTEST_TEST(CachedDisplacementFieldTransform, EqualsTransformAtGridPoints)
+{
+  const auto transform = CreateTransform();
+
+  for (const unsigned int splineOrder : { 1u, 3u })
+  {
+    const auto cachedTransform = CreateCachedTransform(*transform, splineOrder);
+
+    for (unsigned int i = 0; i < 21; ++i)
+    {
+      for (unsigned int j = 0; j < 16; ++j)
+      {
+        const auto point = itk::MakePoint(2.0 + i, 3.0 + j);
+        ASSERT_TRUE(cachedTransform->IsInsideGrid(point));
+
+        const auto expected = transform->TransformPoint(point);
+        const auto actual = cachedTransform->TransformPoint(point);
+        EXPECT_NEAR(actual[0], expected[0], 1e-6);
+        EXPECT_NEAR(actual[1], expected[1], 1e-6);
+      }
+    }
+  }
+}
+
+
+GTEST_TEST(CachedDisplacementFieldTransform, ApproximatesTransformInsideGrid)
+{
+  const auto transform = CreateTransform();
+  const auto cachedTransform = CreateCachedTransform(*transform, 3);
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(0.0, 1.0);
+  for (unsigned int n = 0; n < 100; ++n)
+  {
+    const auto point = itk::MakePoint(2.0 + 20.0 * distribution(randomNumberEngine),
+                                      3.0 + 15.0 * distribution(randomNumberEngine));
+
+    const auto expected = transform->TransformPoint(point);
+    const auto actual = cachedTransform->TransformPoint(point);
+    EXPECT_NEAR(actual[0], expected[0], 1e-3);
+    EXPECT_NEAR(actual[1], expected[1], 1e-3);
+
+    CachedTransformType::SpatialJacobianType expectedJacobian;
+    CachedTransformType::SpatialJacobianType actualJacobian;
+    transform->GetSpatialJacobian(point, expectedJacobian);
+    cachedTransform->GetSpatialJacobian(point, actualJacobian);
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+      for (unsigned int j = 0; j < 2; ++j)
+      {
+        EXPECT_NEAR(actualJacobian(i, j), expectedJacobian(i, j), 1e-2);
+      }
+    }
+  }
+}
+
+
+GTEST_TEST(CachedDisplacementFieldTransform, EqualsTransformOutsideGrid)
+{
+  const auto transform = CreateTransform();
+  const auto cachedTransform = CreateCachedTransform(*transform, 3);
+
+  for (const auto point : { itk::MakePoint(1.5, 10.0), itk::MakePoint(22.5, 10.0), itk::MakePoint(10.0, 18.5) })
+  {
+    EXPECT_FALSE(cachedTransform->IsInsideGrid(point));
+    EXPECT_EQ(cachedTransform->TransformPoint(point), transform->TransformPoint(point));
+  }
+}
+
+
+GTEST_TEST(CachedDisplacementFieldTransform, HasNonZeroSpatialHessianForCubicSplineOrNonlinearTransform)
+{
+  const auto translation = itk::AdvancedTranslationTransform<double, 2>::New();
+  const auto cachedTransform = CachedTransformType::New();
+  cachedTransform->SetTransform(translation);
+  cachedTransform->SetGridSize(CachedTransformType::SizeType{ { 4, 4 } });
+
+  cachedTransform->SetSplineOrder(1);
+  cachedTransform->UpdateCache();
+  EXPECT_FALSE(cachedTransform->GetHasNonZeroSpatialHessian());
+
+  cachedTransform->SetSplineOrder(3);
+  cachedTransform->UpdateCache();
+  EXPECT_TRUE(cachedTransform->GetHasNonZeroSpatialHessian());
+
+  // Outside the grid, the spatial Hessian is the one of the B-spline deformable transform.
+  const auto transform = CreateTransform();
+  EXPECT_TRUE(CreateCachedTransform(*transform, 1)->GetHasNonZeroSpatialHessian());
+}
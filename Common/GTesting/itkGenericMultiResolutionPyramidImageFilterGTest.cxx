@@ -0,0 +1,123 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using ImageType = itk::Image<float, 3>;
+using PyramidType = itk::GenericMultiResolutionPyramidImageFilter<ImageType, ImageType>;
+
+ImageType::Pointer
+CreateImage()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 19, 14, 11 } });
+  image->SetSpacing(ImageType::SpacingType(0.5));
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(static_cast<float>((index[0] * 5 + index[1] * 11 + index[2] * 23) % 37));
+  }
+  return image;
+}
+
+void
+ExpectEqualImages(const ImageType * actual, const ImageType * expected)
+{
+  ASSERT_EQ(actual->GetBufferedRegion(), expected->GetBufferedRegion());
+  EXPECT_EQ(actual->GetSpacing(), expected->GetSpacing());
+  EXPECT_EQ(actual->GetOrigin(), expected->GetOrigin());
+
+  itk::ImageRegionConstIterator<ImageType> actualIt(actual, actual->GetBufferedRegion());
+  itk::ImageRegionConstIterator<ImageType> expectedIt(expected, expected->GetBufferedRegion());
+  for (; !actualIt.IsAtEnd(); ++actualIt, ++expectedIt)
+  {
+    EXPECT_EQ(actualIt.Get(), expectedIt.Get());
+  }
+}
+
+} // namespace
+
+
+/** Computing the levels one at a time, and releasing each level after use, gives the same levels. */
+GTEST_TEST(GenericMultiResolutionPyramidImageFilter, ReleasedLevelIsComputedAgain)
+{
+  const unsigned int numberOfLevels = 3;
+  const auto         image = CreateImage();
+
+  const auto expected = PyramidType::New();
+  expected->SetNumberOfLevels(numberOfLevels);
+  expected->SetInput(image);
+  expected->Update();
+
+  const auto pyramid = PyramidType::New();
+  pyramid->SetNumberOfLevels(numberOfLevels);
+  pyramid->SetInput(image);
+  pyramid->SetComputeOnlyForCurrentLevel(true);
+  pyramid->UpdateOutputInformation();
+
+  for (unsigned int level = 0; level < numberOfLevels; ++level)
+  {
+    pyramid->SetCurrentLevel(level);
+    pyramid->GetOutput(level)->Update();
+    ExpectEqualImages(pyramid->GetOutput(level), expected->GetOutput(level));
+
+    /** Only the current level is in memory. */
+    for (unsigned int otherLevel = 0; otherLevel < numberOfLevels; ++otherLevel)
+    {
+      if (otherLevel != level)
+      {
+        EXPECT_EQ(pyramid->GetOutput(otherLevel)->GetBufferedRegion().GetNumberOfPixels(), 0u);
+      }
+    }
+
+    /** A released level keeps its geometry, and is computed again when it is updated. */
+    pyramid->ReleaseCurrentLevel();
+    EXPECT_EQ(pyramid->GetOutput(level)->GetBufferedRegion().GetNumberOfPixels(), 0u);
+    EXPECT_EQ(pyramid->GetOutput(level)->GetLargestPossibleRegion(),
+              expected->GetOutput(level)->GetLargestPossibleRegion());
+    EXPECT_EQ(pyramid->GetOutput(level)->GetSpacing(), expected->GetOutput(level)->GetSpacing());
+
+    pyramid->GetOutput(level)->Update();
+    ExpectEqualImages(pyramid->GetOutput(level), expected->GetOutput(level));
+  }
+}
+
+
+/** Without per-level computation, releasing the current level does nothing. */
+GTEST_TEST(GenericMultiResolutionPyramidImageFilter, ReleaseCurrentLevelKeepsAllLevels)
+{
+  const auto pyramid = PyramidType::New();
+  pyramid->SetNumberOfLevels(2);
+  pyramid->SetInput(CreateImage());
+  pyramid->Update();
+
+  pyramid->ReleaseCurrentLevel();
+  EXPECT_GT(pyramid->GetOutput(0)->GetBufferedRegion().GetNumberOfPixels(), 0u);
+  EXPECT_GT(pyramid->GetOutput(1)->GetBufferedRegion().GetNumberOfPixels(), 0u);
+}
@@ -0,0 +1,122 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "GradientDifference/itkGradientDifferenceImageToImageMetric2.h"
+
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkAdvancedTranslationTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For min.
+#include <cmath>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using MetricType = itk::GradientDifferenceImageToImageMetric<ImageType, ImageType>;
+
+/** Creates an image with a ramp of slope 10 along both axes, up to index 12, and a truncated Gaussian blob at the
+ * specified center. The steepest gradients are those of the ramp, so that the subtraction factors of the metric do not
+ * depend on small translations. */
+ImageType::Pointer
+CreateImage(const double blobCenterX, const double blobCenterY)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 32, 32 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    const double dx = x - blobCenterX;
+    const double dy = y - blobCenterY;
+    const double blob =
+      (std::abs(dx) <= 6.0 && std::abs(dy) <= 6.0) ? 20.0 * std::exp(-(dx * dx + dy * dy) / 8.0) : 0.0;
+    it.Set(static_cast<float>(10.0 * std::min(x, 12.0) + 10.0 * std::min(y, 12.0) + blob));
+  }
+  return image;
+}
+
+} // namespace
+
+
+// Tests that the image sampler is only used when the metric is computed on the samples.
+GTEST_TEST(GradientDifferenceImageToImageMetric, UsesImageSamplerOnlyWithoutRayCastInterpolator)
+{
+  const auto metric = MetricType::New();
+  EXPECT_FALSE(metric->GetUseImageSampler());
+
+  const auto fixedImage = CreateImage(22.0, 20.0);
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(CreateImage(23.0, 21.0));
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetInterpolator(itk::AdvancedLinearInterpolateImageFunction<ImageType, double>::New());
+  metric->SetTransform(itk::AdvancedTranslationTransform<double, 2>::New());
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->Initialize();
+  EXPECT_TRUE(metric->GetUseImageSampler());
+}
+
+
+// Tests that the analytic derivative on the samples equals the finite difference derivative of the value.
+GTEST_TEST(GradientDifferenceImageToImageMetric, DerivativeOfSamplesEqualsFiniteDifferences)
+{
+  const auto fixedImage = CreateImage(22.0, 20.0);
+  const auto transform = itk::AdvancedTranslationTransform<double, 2>::New();
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(CreateImage(23.0, 21.0));
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetInterpolator(itk::AdvancedLinearInterpolateImageFunction<ImageType, double>::New());
+  metric->SetTransform(transform);
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->Initialize();
+
+  // Evaluate between the pixels, so that the linear interpolation is smooth within the finite difference step.
+  MetricType::TransformParametersType parameters(2);
+  parameters[0] = 0.3;
+  parameters[1] = 0.4;
+
+  MetricType::MeasureType    value{};
+  MetricType::DerivativeType derivative;
+  metric->GetValueAndDerivative(parameters, value, derivative);
+  EXPECT_NEAR(value, metric->GetValue(parameters), 1e-9 * std::abs(value));
+  ASSERT_EQ(derivative.size(), parameters.size());
+
+  constexpr double delta = 1e-4;
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    auto forward = parameters;
+    auto backward = parameters;
+    forward[i] += delta;
+    backward[i] -= delta;
+    const double finiteDifference = (metric->GetValue(forward) - metric->GetValue(backward)) / (2.0 * delta);
+
+    EXPECT_GT(std::abs(finiteDifference), 1e-6) << i;
+    EXPECT_NEAR(derivative[i], finiteDifference, 1e-4 * std::abs(finiteDifference)) << i;
+  }
+}
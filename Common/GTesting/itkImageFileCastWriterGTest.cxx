@@ -0,0 +1,95 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkImageFileCastWriter.h"
+
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace
+{
+
+typedef itk::Image<short, 3> InputImageType;
+typedef itk::Image<float, 3> OutputImageType;
+
+/** Creates an image with distinct pixel values, including negative ones. */
+InputImageType::Pointer
+CreateImage()
+{
+  const auto image = InputImageType::New();
+  image->SetRegions(InputImageType::SizeType{ { 7, 6, 5 } });
+  image->Allocate();
+  short value = -100;
+  for (itk::ImageRegionIterator<InputImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(value);
+    value += 3;
+  }
+  return image;
+}
+
+
+/** Writes the image with the cast to float, in the specified number of pieces, and reads it back. */
+OutputImageType::Pointer
+WriteAndRead(const InputImageType & image, const unsigned int numberOfStreamDivisions)
+{
+  const std::string fileName = itksys::SystemTools::GetCurrentWorkingDirectory() + "/ImageFileCastWriterGTest_" +
+                               std::to_string(numberOfStreamDivisions) + ".mhd";
+
+  const auto writer = itk::ImageFileCastWriter<InputImageType>::New();
+  writer->SetInput(&image);
+  writer->SetFileName(fileName);
+  writer->SetOutputComponentType("float");
+  writer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  writer->Update();
+
+  const auto reader = itk::ImageFileReader<OutputImageType>::New();
+  reader->SetFileName(fileName);
+  reader->Update();
+  return reader->GetOutput();
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageFileCastWriter, StreamedWritingCastsAllPixels)
+{
+  const auto image = CreateImage();
+
+  for (const unsigned int numberOfStreamDivisions : { 1u, 2u, 5u })
+  {
+    const auto result = WriteAndRead(*image, numberOfStreamDivisions);
+    ASSERT_EQ(result->GetBufferedRegion(), image->GetBufferedRegion());
+
+    itk::ImageRegionConstIterator<InputImageType>  expected(image, image->GetBufferedRegion());
+    itk::ImageRegionConstIterator<OutputImageType> actual(result, result->GetBufferedRegion());
+    for (; !expected.IsAtEnd(); ++expected, ++actual)
+    {
+      EXPECT_EQ(actual.Get(), static_cast<float>(expected.Get()));
+    }
+  }
+}
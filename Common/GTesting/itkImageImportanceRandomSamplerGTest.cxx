@@ -0,0 +1,325 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkImageImportanceRandomSampler.h"
+
+#include "AdvancedKappaStatistic/itkAdvancedKappaStatisticImageToImageMetric.h"
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+#include "AdvancedMeanSquares/itkAdvancedMeanSquaresImageToImageMetric.h"
+#include "AdvancedNormalizedCorrelation/itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include "elxImageSamplerGTestUtilities.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkAdvancedTranslationTransform.h"
+
+#include <itkImage.h>
+#include <itkImageMaskSpatialObject.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using SamplerType = itk::ImageImportanceRandomSampler<ImageType>;
+using MaskImageType = itk::Image<unsigned char, 2>;
+using MaskSpatialObjectType = itk::ImageMaskSpatialObject<2>;
+
+const double spacing[] = { 0.5, 2.0 };
+
+/** An image with a step edge on a ramp, so that the gradient magnitude varies. */
+ImageType::Pointer
+CreateImage()
+{
+  return elastix::GTestUtilities::CreateImageFromIndexFunction<ImageType>(
+    ImageType::SizeType{ { 32, 24 } }, spacing, [](const ImageType::IndexType & index) {
+      return index[1] + (index[0] < 20 ? 0 : 100);
+    });
+}
+
+double
+GetMeanPixelValue(const ImageType & image)
+{
+  double sum = 0.0;
+  for (itk::ImageRegionConstIterator<ImageType> it(&image, image.GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    sum += it.Get();
+  }
+  return sum / static_cast<double>(image.GetBufferedRegion().GetNumberOfPixels());
+}
+
+
+/** Initializes a metric of the specified type with the importance sampler. */
+template <typename TMetric>
+void
+InitializeMetric(const ImageType & image)
+{
+  const auto metric = TMetric::New();
+  metric->SetFixedImage(&image);
+  metric->SetMovingImage(&image);
+  metric->SetFixedImageRegion(image.GetBufferedRegion());
+  metric->SetInterpolator(itk::AdvancedLinearInterpolateImageFunction<ImageType, double>::New());
+  metric->SetTransform(itk::AdvancedTranslationTransform<double, 2>::New());
+  metric->SetImageSampler(SamplerType::New());
+  metric->Initialize();
+}
+
+
+/** The importance sampler without the sample weights, so that the metrics treat all samples equally. */
+class UnweightedImportanceRandomSampler : public SamplerType
+{
+public:
+  using Self = UnweightedImportanceRandomSampler;
+  using Pointer = itk::SmartPointer<Self>;
+  itkNewMacro(Self);
+
+  bool
+  HasSampleWeights() const override
+  {
+    return false;
+  }
+
+protected:
+  void
+  GenerateData() override
+  {
+    SamplerType::GenerateData();
+    this->GetSampleWeightsToFill().clear();
+  }
+};
+
+
+/** Computes the value and derivative of the metric for a translation of the image onto itself, with the samples of
+ * the specified sampler at a uniform distribution.
+ */
+template <typename TMetric>
+void
+GetValueAndDerivativeOfUniformSamples(TMetric &                          metric,
+                                      const ImageType &                  image,
+                                      SamplerType &                      sampler,
+                                      typename TMetric::MeasureType &    value,
+                                      typename TMetric::DerivativeType & derivative)
+{
+  sampler.SetUniformFraction(1.0);
+  sampler.SetNumberOfSamples(500);
+
+  metric.SetFixedImage(&image);
+  metric.SetMovingImage(&image);
+  metric.SetFixedImageRegion(image.GetBufferedRegion());
+  metric.SetInterpolator(itk::AdvancedLinearInterpolateImageFunction<ImageType, double>::New());
+  metric.SetTransform(itk::AdvancedTranslationTransform<double, 2>::New());
+  metric.SetImageSampler(&sampler);
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->SetSeed(12345);
+  metric.Initialize();
+
+  typename TMetric::TransformParametersType parameters(2);
+  parameters[0] = 1.3;
+  parameters[1] = 0.4;
+  derivative.SetSize(metric.GetNumberOfParameters());
+  metric.GetValueAndDerivative(parameters, value, derivative);
+}
+
+
+/** Expects the same value and derivative from both metrics, with the weighted and the unweighted importance sampler
+ * at a uniform distribution, of which all weights are 1.
+ */
+template <typename TMetric>
+void
+ExpectUniformWeightsGiveUnweightedResult(TMetric & weightedMetric, TMetric & unweightedMetric)
+{
+  const auto image = CreateImage();
+  const auto weightedSampler = SamplerType::New();
+  const auto unweightedSampler = UnweightedImportanceRandomSampler::New();
+
+  typename TMetric::MeasureType    weightedValue{};
+  typename TMetric::DerivativeType weightedDerivative;
+  GetValueAndDerivativeOfUniformSamples(weightedMetric, *image, *weightedSampler, weightedValue, weightedDerivative);
+  ASSERT_EQ(weightedSampler->GetSampleWeights().size(), 500u);
+
+  typename TMetric::MeasureType    unweightedValue{};
+  typename TMetric::DerivativeType unweightedDerivative;
+  GetValueAndDerivativeOfUniformSamples(
+    unweightedMetric, *image, *unweightedSampler, unweightedValue, unweightedDerivative);
+  ASSERT_TRUE(unweightedSampler->GetSampleWeights().empty());
+  ASSERT_EQ(weightedSampler->GetOutput()->CastToSTLConstContainer().size(), 500u);
+  for (std::size_t i = 0; i < 500; ++i)
+  {
+    ASSERT_EQ(weightedSampler->GetOutput()->ElementAt(i).m_ImageCoordinates,
+              unweightedSampler->GetOutput()->ElementAt(i).m_ImageCoordinates);
+  }
+
+  EXPECT_NE(unweightedValue, 0.0);
+  EXPECT_NEAR(weightedValue, unweightedValue, 1e-5 * std::abs(unweightedValue));
+  ASSERT_EQ(weightedDerivative.GetSize(), unweightedDerivative.GetSize());
+  for (unsigned int i = 0; i < unweightedDerivative.GetSize(); ++i)
+  {
+    EXPECT_NEAR(weightedDerivative[i], unweightedDerivative[i], 1e-5 * unweightedDerivative.two_norm());
+  }
+}
+
+} // namespace
+
+
+/** The weighted mean of the sample values estimates the mean of the image, like uniform sampling. */
+GTEST_TEST(ImageImportanceRandomSampler, WeightedMeanIsUnbiased)
+{
+  const auto   image = CreateImage();
+  const double expectedMean = GetMeanPixelValue(*image);
+
+  for (const bool useCounterBasedRandomGenerator : { false, true })
+  {
+    itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->SetSeed(12345);
+    const auto sampler = SamplerType::New();
+    sampler->SetInput(image);
+    sampler->SetNumberOfSamples(100000);
+    sampler->SetUseCounterBasedRandomGenerator(useCounterBasedRandomGenerator);
+    sampler->Update();
+    const auto & samples = sampler->GetOutput()->CastToSTLConstContainer();
+    const auto & weights = sampler->GetSampleWeights();
+    ASSERT_EQ(samples.size(), 100000u);
+    ASSERT_EQ(weights.size(), samples.size());
+
+    double sumOfWeights = 0.0;
+    double sumOfWeightedValues = 0.0;
+    for (std::size_t i = 0; i < samples.size(); ++i)
+    {
+      EXPECT_GT(weights[i], 0.0);
+      EXPECT_LE(weights[i], 1.0 / sampler->GetUniformFraction() + 1e-5);
+      sumOfWeights += weights[i];
+      sumOfWeightedValues += weights[i] * samples[i].m_ImageValue;
+    }
+    EXPECT_NEAR(sumOfWeights / samples.size(), 1.0, 0.05);
+    EXPECT_NEAR(sumOfWeightedValues / samples.size(), expectedMean, 0.05 * expectedMean);
+  }
+}
+
+
+/** Voxels of which the importance is zero are never drawn when the uniform fraction is zero. */
+GTEST_TEST(ImageImportanceRandomSampler, DrawsOnlyImportantVoxels)
+{
+  const auto image = CreateImage();
+
+  const auto weightImage = SamplerType::WeightImageType::New();
+  weightImage->SetRegions(image->GetBufferedRegion());
+  weightImage->SetSpacing(spacing);
+  weightImage->Allocate(true);
+  const ImageType::IndexType importantIndex{ { 7, 11 } };
+  weightImage->SetPixel(importantIndex, 5.0f);
+
+  const auto sampler = SamplerType::New();
+  sampler->SetInput(image);
+  sampler->SetWeightImage(weightImage);
+  sampler->SetUniformFraction(0.0);
+  sampler->SetNumberOfSamples(100);
+  sampler->Update();
+
+  ImageType::PointType importantPoint;
+  image->TransformIndexToPhysicalPoint(importantIndex, importantPoint);
+  const float numberOfVoxels = image->GetBufferedRegion().GetNumberOfPixels();
+  for (const auto & sample : sampler->GetOutput()->CastToSTLConstContainer())
+  {
+    EXPECT_EQ(sample.m_ImageCoordinates, importantPoint);
+    EXPECT_EQ(sample.m_ImageValue, image->GetPixel(importantIndex));
+  }
+  ASSERT_EQ(sampler->GetSampleWeights().size(), 100u);
+  for (const float weight : sampler->GetSampleWeights())
+  {
+    EXPECT_FLOAT_EQ(weight, 1.0f / numberOfVoxels);
+  }
+}
+
+
+GTEST_TEST(ImageImportanceRandomSampler, ThrowsWhenMaskIsEmpty)
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::SizeType{ { 32, 24 } });
+  maskImage->SetSpacing(spacing);
+  maskImage->Allocate(true);
+  const auto mask = MaskSpatialObjectType::New();
+  mask->SetImage(maskImage);
+  mask->Update();
+
+  const auto sampler = SamplerType::New();
+  sampler->SetInput(CreateImage());
+  sampler->SetMask(mask);
+  EXPECT_THROW(sampler->Update(), itk::ExceptionObject);
+}
+
+
+/** Only the metrics that multiply the samples by their weights accept this sampler. */
+GTEST_TEST(ImageImportanceRandomSampler, MetricsThatIgnoreWeightsRefuseSampler)
+{
+  const auto image = CreateImage();
+
+  EXPECT_NO_THROW(InitializeMetric<itk::AdvancedMeanSquaresImageToImageMetric<ImageType, ImageType>>(*image));
+  EXPECT_NO_THROW(
+    InitializeMetric<itk::AdvancedNormalizedCorrelationImageToImageMetric<ImageType, ImageType>>(*image));
+  EXPECT_NO_THROW(
+    InitializeMetric<itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>>(*image));
+  EXPECT_THROW(InitializeMetric<itk::AdvancedKappaStatisticImageToImageMetric<ImageType, ImageType>>(*image),
+               itk::ExceptionObject);
+}
+
+
+/** Under a uniform distribution, NormalizedCorrelation gives the same result with the weights as without. */
+GTEST_TEST(ImageImportanceRandomSampler, NormalizedCorrelationWithUniformWeights)
+{
+  using MetricType = itk::AdvancedNormalizedCorrelationImageToImageMetric<ImageType, ImageType>;
+
+  for (const bool useMultiThread : { false, true })
+  {
+    for (const bool subtractMean : { false, true })
+    {
+      const auto weightedMetric = MetricType::New();
+      const auto unweightedMetric = MetricType::New();
+      for (MetricType * const metric : { weightedMetric.GetPointer(), unweightedMetric.GetPointer() })
+      {
+        metric->SetUseMultiThread(useMultiThread);
+        metric->SetSubtractMean(subtractMean);
+      }
+      ExpectUniformWeightsGiveUnweightedResult(*weightedMetric, *unweightedMetric);
+    }
+  }
+}
+
+
+/** Under a uniform distribution, Mattes mutual information gives the same result with the weights as without, with
+ * both the explicit pdf derivatives and the low-memory derivative.
+ */
+GTEST_TEST(ImageImportanceRandomSampler, MattesMutualInformationWithUniformWeights)
+{
+  using MetricType = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+
+  for (const bool useMultiThread : { false, true })
+  {
+    for (const bool useExplicitPDFDerivatives : { false, true })
+    {
+      const auto weightedMetric = MetricType::New();
+      const auto unweightedMetric = MetricType::New();
+      for (MetricType * const metric : { weightedMetric.GetPointer(), unweightedMetric.GetPointer() })
+      {
+        metric->SetUseMultiThread(useMultiThread);
+        metric->SetUseExplicitPDFDerivatives(useExplicitPDFDerivatives);
+      }
+      ExpectUniformWeightsGiveUnweightedResult(*weightedMetric, *unweightedMetric);
+    }
+  }
+}
@@ -0,0 +1,134 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkImageQuasiRandomCoordinateSampler.h"
+
+#include "elxImageSamplerGTestUtilities.h"
+
+#include <itkImage.h>
+#include <itkImageMaskSpatialObject.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <utility>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using SamplerType = itk::ImageQuasiRandomCoordinateSampler<ImageType>;
+using MaskImageType = itk::Image<unsigned char, 2>;
+using MaskSpatialObjectType = itk::ImageMaskSpatialObject<2>;
+
+ImageType::Pointer
+CreateImage()
+{
+  return elastix::GTestUtilities::CreateIndexEncodingImage<ImageType>(ImageType::SizeType{ { 33, 17 } },
+                                                                      ImageType::SpacingType(0.5));
+}
+
+} // namespace
+
+
+/** The first 2^m points of a scrambled Sobol sequence are stratified. */
+GTEST_TEST(ImageQuasiRandomCoordinateSampler, SamplesAreStratified)
+{
+  const auto image = CreateImage();
+  const auto sampler = SamplerType::New();
+  sampler->SetInput(image);
+  sampler->SetInterpolator(itk::LinearInterpolateImageFunction<ImageType, double>::New());
+  sampler->SetNumberOfSamples(256);
+
+  for (unsigned int sampleSet = 0; sampleSet < 3; ++sampleSet)
+  {
+    sampler->Update();
+    const auto & samples = sampler->GetOutput()->CastToSTLConstContainer();
+    ASSERT_EQ(samples.size(), 256u);
+
+    /** The sample region is [0, 32] x [0, 16] in continuous index space. */
+    std::set<unsigned int>                           strata[2];
+    std::set<std::pair<unsigned int, unsigned int>> cells;
+    for (const auto & sample : samples)
+    {
+      const auto contIndex =
+        image->TransformPhysicalPointToContinuousIndex<double, double>(sample.m_ImageCoordinates);
+      const double       u[2] = { contIndex[0] / 32.0, contIndex[1] / 16.0 };
+      const unsigned int cell[2] = { static_cast<unsigned int>(u[0] * 16), static_cast<unsigned int>(u[1] * 16) };
+      strata[0].insert(static_cast<unsigned int>(u[0] * 256));
+      strata[1].insert(static_cast<unsigned int>(u[1] * 256));
+      cells.insert({ cell[0], cell[1] });
+    }
+    EXPECT_EQ(strata[0].size(), 256u);
+    EXPECT_EQ(strata[1].size(), 256u);
+    EXPECT_EQ(cells.size(), 256u);
+
+    sampler->SelectNewSamplesOnUpdate();
+  }
+}
+
+
+/** Every sample set is scrambled differently. */
+GTEST_TEST(ImageQuasiRandomCoordinateSampler, SampleSetsDiffer)
+{
+  const auto sampler = SamplerType::New();
+  sampler->SetInput(CreateImage());
+  sampler->SetNumberOfSamples(10);
+  sampler->Update();
+  const auto firstPoint = sampler->GetOutput()->ElementAt(0).m_ImageCoordinates;
+  sampler->SelectNewSamplesOnUpdate();
+  sampler->Update();
+  EXPECT_NE(sampler->GetOutput()->ElementAt(0).m_ImageCoordinates, firstPoint);
+}
+
+
+GTEST_TEST(ImageQuasiRandomCoordinateSampler, SamplesAreInsideMask)
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::SizeType{ { 33, 17 } });
+  maskImage->SetSpacing(MaskImageType::SpacingType(0.5));
+  maskImage->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto dx = it.GetIndex()[0] - 16;
+    const auto dy = it.GetIndex()[1] - 8;
+    it.Set(dx * dx + dy * dy < 25 ? 1 : 0);
+  }
+  const auto mask = MaskSpatialObjectType::New();
+  mask->SetImage(maskImage);
+  mask->Update();
+
+  for (const bool useMultiThread : { false, true })
+  {
+    const auto sampler = SamplerType::New();
+    sampler->SetInput(CreateImage());
+    sampler->SetMask(mask);
+    sampler->SetNumberOfSamples(500);
+    sampler->SetUseMultiThread(useMultiThread);
+    sampler->Update();
+
+    ASSERT_EQ(sampler->GetOutput()->Size(), 500u);
+    for (const auto & sample : sampler->GetOutput()->CastToSTLConstContainer())
+    {
+      EXPECT_TRUE(mask->IsInsideInWorldSpace(sample.m_ImageCoordinates));
+    }
+  }
+}
@@ -0,0 +1,173 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageRandomSamplerBase.h"
+
+#include "itkImageQuasiRandomCoordinateSampler.h"
+#include "itkImageRandomCoordinateSampler.h"
+#include "itkImageRandomSampler.h"
+#include "itkImageRandomSamplerSparseMask.h"
+#include "itkMultiInputImageRandomCoordinateSampler.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include "elxImageSamplerGTestUtilities.h"
+
+#include <itkImage.h>
+#include <itkImageMaskSpatialObject.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using SampleType = itk::ImageSample<ImageType>;
+using MaskImageType = itk::Image<unsigned char, 2>;
+using MaskSpatialObjectType = itk::ImageMaskSpatialObject<2>;
+
+ImageType::Pointer
+CreateImage()
+{
+  return elastix::GTestUtilities::CreateIndexEncodingImage<ImageType>(ImageType::SizeType{ { 32, 24 } });
+}
+
+
+/** A mask of a disk in the middle of the image. */
+MaskSpatialObjectType::Pointer
+CreateMask()
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::SizeType{ { 32, 24 } });
+  maskImage->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto dx = it.GetIndex()[0] - 16;
+    const auto dy = it.GetIndex()[1] - 12;
+    it.Set(dx * dx + dy * dy < 64 ? 1 : 0);
+  }
+  const auto mask = MaskSpatialObjectType::New();
+  mask->SetImage(maskImage);
+  mask->Update();
+  return mask;
+}
+
+
+/** Returns two consecutive sample sets, generated with the given threading settings. */
+template <typename TSampler>
+std::vector<std::vector<SampleType>>
+GetSampleSets(const bool useMask, const bool useMultiThread, const unsigned int numberOfWorkUnits, const bool usePool)
+{
+  const auto image = CreateImage();
+  const auto sampler = TSampler::New();
+  sampler->SetInput(image);
+  if (useMask)
+  {
+    sampler->SetMask(CreateMask());
+  }
+  sampler->SetNumberOfSamples(100);
+  sampler->UseCounterBasedRandomGeneratorOn();
+  sampler->SetRandomSeed(987654321);
+  sampler->SetUseMultiThread(useMultiThread);
+  sampler->SetNumberOfWorkUnits(numberOfWorkUnits);
+  if (usePool)
+  {
+    const auto threadPool = itk::WorkStealingThreadPool::New();
+    threadPool->SetNumberOfThreads(numberOfWorkUnits);
+    sampler->SetThreadPool(threadPool);
+  }
+
+  std::vector<std::vector<SampleType>> sampleSets;
+  for (unsigned int i = 0; i < 2; ++i)
+  {
+    sampler->Update();
+    const auto & samples = sampler->GetOutput()->CastToSTLConstContainer();
+    sampleSets.emplace_back(samples.begin(), samples.end());
+    sampler->SelectNewSamplesOnUpdate();
+  }
+  return sampleSets;
+}
+
+
+/** Checks that the sample sets do not depend on the threading settings. */
+template <typename TSampler>
+void
+Expect_samples_independent_of_threads(const bool useMask)
+{
+  const auto expected = GetSampleSets<TSampler>(useMask, false, 1, false);
+  ASSERT_EQ(expected.size(), 2u);
+  ASSERT_EQ(expected[0].size(), 100u);
+  EXPECT_NE(expected[0][0].m_ImageCoordinates, expected[1][0].m_ImageCoordinates);
+
+  for (const unsigned int numberOfWorkUnits : { 1u, 3u, 8u })
+  {
+    for (const bool usePool : { false, true })
+    {
+      const auto actual = GetSampleSets<TSampler>(useMask, true, numberOfWorkUnits, usePool);
+      ASSERT_EQ(actual.size(), expected.size());
+      for (std::size_t i = 0; i < actual.size(); ++i)
+      {
+        ASSERT_EQ(actual[i].size(), expected[i].size());
+        for (std::size_t j = 0; j < actual[i].size(); ++j)
+        {
+          EXPECT_EQ(actual[i][j].m_ImageCoordinates, expected[i][j].m_ImageCoordinates);
+          EXPECT_EQ(actual[i][j].m_ImageValue, expected[i][j].m_ImageValue);
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageRandomSamplerBase, CounterBasedSamplesAreIndependentOfThreads)
+{
+  Expect_samples_independent_of_threads<itk::ImageRandomSampler<ImageType>>(false);
+  Expect_samples_independent_of_threads<itk::ImageRandomSampler<ImageType>>(true);
+  Expect_samples_independent_of_threads<itk::ImageRandomCoordinateSampler<ImageType>>(false);
+  Expect_samples_independent_of_threads<itk::ImageRandomCoordinateSampler<ImageType>>(true);
+  Expect_samples_independent_of_threads<itk::ImageRandomSamplerSparseMask<ImageType>>(true);
+  Expect_samples_independent_of_threads<itk::MultiInputImageRandomCoordinateSampler<ImageType>>(false);
+  Expect_samples_independent_of_threads<itk::MultiInputImageRandomCoordinateSampler<ImageType>>(true);
+  Expect_samples_independent_of_threads<itk::ImageQuasiRandomCoordinateSampler<ImageType>>(false);
+  Expect_samples_independent_of_threads<itk::ImageQuasiRandomCoordinateSampler<ImageType>>(true);
+}
+
+
+GTEST_TEST(ImageRandomSamplerBase, CounterBasedSamplesAreInsideMask)
+{
+  const auto mask = CreateMask();
+  const auto sampler = itk::ImageRandomSampler<ImageType>::New();
+  sampler->SetInput(CreateImage());
+  sampler->SetMask(mask);
+  sampler->SetNumberOfSamples(100);
+  sampler->UseCounterBasedRandomGeneratorOn();
+  sampler->SetUseMultiThread(true);
+  sampler->Update();
+
+  ASSERT_EQ(sampler->GetOutput()->Size(), 100u);
+  for (const auto & sample : sampler->GetOutput()->CastToSTLConstContainer())
+  {
+    EXPECT_TRUE(mask->IsInsideInWorldSpace(sample.m_ImageCoordinates));
+  }
+}
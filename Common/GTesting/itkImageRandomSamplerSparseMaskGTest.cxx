@@ -0,0 +1,130 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageRandomSamplerSparseMask.h"
+
+#include "itkImageFullSampler.h"
+
+#include "elxImageSamplerGTestUtilities.h"
+
+#include <itkImage.h>
+#include <itkImageMaskSpatialObject.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <gtest/gtest.h>
+
+namespace
+{
+using ImageType = itk::Image<float, 3>;
+using MaskImageType = itk::Image<unsigned char, 3>;
+using MaskSpatialObjectType = itk::ImageMaskSpatialObject<3>;
+
+const double spacing[] = { 0.5, 1.0, 2.0 };
+
+ImageType::Pointer
+CreateImage()
+{
+  return elastix::GTestUtilities::CreateIndexEncodingImage<ImageType>(ImageType::SizeType{ { 20, 16, 12 } }, spacing);
+}
+
+
+/** A mask of two separate balls, such that the rows contain multiple runs. */
+MaskSpatialObjectType::Pointer
+CreateMask()
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::SizeType{ { 20, 16, 12 } });
+  maskImage->SetSpacing(spacing);
+  maskImage->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(maskImage, maskImage->GetBufferedRegion()); !it.IsAtEnd();
+       ++it)
+  {
+    const auto & index = it.GetIndex();
+    const auto   dy = index[1] - 8;
+    const auto   dz = index[2] - 6;
+    const auto   dx1 = index[0] - 5;
+    const auto   dx2 = index[0] - 14;
+    const bool   inside1 = dx1 * dx1 + dy * dy + dz * dz < 16;
+    const bool   inside2 = dx2 * dx2 + dy * dy + dz * dz < 9;
+    it.Set(inside1 || inside2 ? 1 : 0);
+  }
+  const auto mask = MaskSpatialObjectType::New();
+  mask->SetImage(maskImage);
+  mask->Update();
+  return mask;
+}
+
+} // namespace
+
+
+/** The run-length index selects the same samples as drawing from the output of the full sampler. */
+GTEST_TEST(ImageRandomSamplerSparseMask, EqualsDrawingFromFullSampler)
+{
+  const auto image = CreateImage();
+  const auto mask = CreateMask();
+
+  const auto fullSampler = itk::ImageFullSampler<ImageType>::New();
+  fullSampler->SetInput(image);
+  fullSampler->SetMask(mask);
+  fullSampler->Update();
+  const auto & allValidSamples = fullSampler->GetOutput()->CastToSTLConstContainer();
+  ASSERT_FALSE(allValidSamples.empty());
+
+  const auto randomGenerator = itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance();
+
+  for (const bool useMultiThread : { false, true })
+  {
+    randomGenerator->SetSeed(12345);
+    const auto sampler = itk::ImageRandomSamplerSparseMask<ImageType>::New();
+    sampler->SetInput(image);
+    sampler->SetMask(mask);
+    sampler->SetNumberOfSamples(200);
+    sampler->SetUseMultiThread(useMultiThread);
+    sampler->Update();
+    const auto & samples = sampler->GetOutput()->CastToSTLConstContainer();
+    ASSERT_EQ(samples.size(), 200u);
+
+    randomGenerator->SetSeed(12345);
+    for (const auto & sample : samples)
+    {
+      const auto & expected = allValidSamples[randomGenerator->GetIntegerVariate(allValidSamples.size() - 1)];
+      EXPECT_EQ(sample.m_ImageCoordinates, expected.m_ImageCoordinates);
+      EXPECT_EQ(sample.m_ImageValue, expected.m_ImageValue);
+    }
+  }
+}
+
+
+GTEST_TEST(ImageRandomSamplerSparseMask, ThrowsWhenMaskIsEmpty)
+{
+  const auto maskImage = MaskImageType::New();
+  maskImage->SetRegions(MaskImageType::SizeType{ { 20, 16, 12 } });
+  maskImage->SetSpacing(spacing);
+  maskImage->Allocate(true);
+  const auto mask = MaskSpatialObjectType::New();
+  mask->SetImage(maskImage);
+  mask->Update();
+
+  const auto sampler = itk::ImageRandomSamplerSparseMask<ImageType>::New();
+  sampler->SetInput(CreateImage());
+  sampler->SetMask(mask);
+  EXPECT_THROW(sampler->Update(), itk::ExceptionObject);
+}
@@ -0,0 +1,142 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkImageSamplerBase.h"
+
+#include "itkImageRandomCoordinateSampler.h"
+#include "itkImageRandomSampler.h"
+
+#include "elxImageSamplerGTestUtilities.h"
+
+#include <itkImage.h>
+#include <itkMersenneTwisterRandomVariateGenerator.h>
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using SampleType = itk::ImageSample<ImageType>;
+
+ImageType::Pointer
+CreateImage()
+{
+  return elastix::GTestUtilities::CreateIndexEncodingImage<ImageType>(ImageType::SizeType{ { 32, 24 } });
+}
+
+
+/** Returns the sample sets of a number of iterations, each selected by SelectNewSamplesOnUpdate(). */
+template <typename TSampler>
+std::vector<std::vector<SampleType>>
+GetSampleSets(const bool usePrefetching, const unsigned int numberOfIterations)
+{
+  itk::Statistics::MersenneTwisterRandomVariateGenerator::GetInstance()->SetSeed(12345);
+
+  const auto image = CreateImage();
+  const auto sampler = TSampler::New();
+  sampler->SetInput(image);
+  sampler->SetNumberOfSamples(50);
+  sampler->SetUseCounterBasedRandomGenerator(true);
+  sampler->SetUsePrefetching(usePrefetching);
+
+  std::vector<std::vector<SampleType>> sampleSets;
+  for (unsigned int i = 0; i < numberOfIterations; ++i)
+  {
+    sampler->Update();
+    const auto & samples = sampler->GetOutput()->CastToSTLConstContainer();
+    sampleSets.emplace_back(samples.begin(), samples.end());
+    sampler->SelectNewSamplesOnUpdate();
+  }
+  sampler->SetUsePrefetching(false);
+  return sampleSets;
+}
+
+
+/** Checks that prefetching yields the same sample sets as generating them on Update(). */
+template <typename TSampler>
+void
+Expect_prefetched_samples_equal_updated_samples()
+{
+  const auto expected = GetSampleSets<TSampler>(false, 4);
+  const auto actual = GetSampleSets<TSampler>(true, 4);
+
+  ASSERT_EQ(actual.size(), expected.size());
+  for (std::size_t i = 0; i < actual.size(); ++i)
+  {
+    ASSERT_EQ(actual[i].size(), 50u);
+    ASSERT_EQ(actual[i].size(), expected[i].size());
+    for (std::size_t j = 0; j < actual[i].size(); ++j)
+    {
+      EXPECT_EQ(actual[i][j].m_ImageCoordinates, expected[i][j].m_ImageCoordinates);
+      EXPECT_EQ(actual[i][j].m_ImageValue, expected[i][j].m_ImageValue);
+    }
+  }
+
+  /** The sample sets should be new in every iteration. */
+  EXPECT_NE(actual[0][0].m_ImageCoordinates, actual[1][0].m_ImageCoordinates);
+}
+
+} // namespace
+
+
+GTEST_TEST(ImageSamplerBase, PrefetchingYieldsSameSamples)
+{
+  Expect_prefetched_samples_equal_updated_samples<itk::ImageRandomSampler<ImageType>>();
+  Expect_prefetched_samples_equal_updated_samples<itk::ImageRandomCoordinateSampler<ImageType>>();
+}
+
+
+// Tests that the random samplers only support prefetching with their own counter-based random generator, because the
+// global random generator is shared with other components.
+GTEST_TEST(ImageSamplerBase, PrefetchingRequiresCounterBasedRandomGenerator)
+{
+  const auto sampler = itk::ImageRandomSampler<ImageType>::New();
+  sampler->SetInput(CreateImage());
+  EXPECT_FALSE(sampler->PrefetchingSupported());
+  EXPECT_THROW(sampler->SetUsePrefetching(true), itk::ExceptionObject);
+
+  sampler->SetUseCounterBasedRandomGenerator(true);
+  EXPECT_TRUE(sampler->PrefetchingSupported());
+  EXPECT_NO_THROW(sampler->SetUsePrefetching(true));
+  sampler->SetUsePrefetching(false);
+}
+
+
+GTEST_TEST(ImageSamplerBase, ChangingSettingsDiscardsPrefetchedSamples)
+{
+  const auto image = CreateImage();
+  const auto sampler = itk::ImageRandomSampler<ImageType>::New();
+  sampler->SetInput(image);
+  sampler->SetNumberOfSamples(50);
+  sampler->SetUseCounterBasedRandomGenerator(true);
+  sampler->UsePrefetchingOn();
+  sampler->Update();
+
+  /** The prefetched set has 50 samples, but the new settings ask for 20. */
+  sampler->UsePrefetchingOff();
+  sampler->SetNumberOfSamples(20);
+  sampler->UsePrefetchingOn();
+  sampler->SelectNewSamplesOnUpdate();
+  sampler->Update();
+  EXPECT_EQ(sampler->GetOutput()->Size(), 20u);
+  sampler->UsePrefetchingOff();
+}
@@ -0,0 +1,121 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "KNNGraphAlphaMutualInformation/itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
+
+#include "itkAdvancedTranslationTransform.h"
+#include "itkImageFullSampler.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using MetricType = itk::KNNGraphAlphaMutualInformationImageToImageMetric<ImageType, ImageType>;
+
+/** Creates an image with a ramp along the first axis and a Gaussian blob at the specified center. */
+ImageType::Pointer
+CreateImage(const double blobCenterX, const double blobCenterY)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 24, 24 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double dx = it.GetIndex()[0] - blobCenterX;
+    const double dy = it.GetIndex()[1] - blobCenterY;
+    it.Set(static_cast<float>(2.0 * it.GetIndex()[0] + 100.0 * std::exp(-(dx * dx + dy * dy) / 18.0)));
+  }
+  return image;
+}
+
+
+/** Creates a metric computed on all samples of the fixed image, with a translation transform and exact kNN searches.
+ * When a thread pool is specified, the metric uses three work units and generates its trees on the pool. */
+MetricType::Pointer
+CreateInitializedMetric(itk::WorkStealingThreadPool * const threadPool)
+{
+  const auto fixedImage = CreateImage(11.0, 12.0);
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(CreateImage(12.0, 11.0));
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetInterpolator(MetricType::BSplineInterpolatorType::New());
+  metric->SetTransform(itk::AdvancedTranslationTransform<double, 2>::New());
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->SetANNkDTree(10, "ANN_KD_SL_MIDPT");
+  metric->SetANNStandardTreeSearch(5, 0.0);
+  metric->SetAlpha(0.5);
+  metric->SetUseMultiThread(threadPool != nullptr);
+  metric->SetNumberOfWorkUnits(threadPool == nullptr ? 1 : 3);
+  metric->SetThreadPool(threadPool);
+  metric->Initialize();
+  return metric;
+}
+
+} // namespace
+
+
+// Tests that generating the trees on the thread pool and distributing the queries over the work units gives the same
+// value and derivative as a single thread. The full sampler keeps the fixed samples equal over the evaluations, so
+// the fixed tree is only generated at the first evaluation and reused at the next ones.
+GTEST_TEST(KNNGraphAlphaMutualInformationImageToImageMetric, MultiThreadedEqualsSingleThreaded)
+{
+  const auto threadPool = itk::WorkStealingThreadPool::New();
+  threadPool->SetNumberOfThreads(3);
+
+  const auto expectedMetric = CreateInitializedMetric(nullptr);
+  const auto actualMetric = CreateInitializedMetric(threadPool);
+
+  MetricType::TransformParametersType parameters(2);
+
+  for (const double offset : { 0.0, 0.3, -0.7 })
+  {
+    parameters[0] = offset;
+    parameters[1] = 0.5 * offset;
+
+    const MetricType::MeasureType expectedValue = expectedMetric->GetValue(parameters);
+    EXPECT_NEAR(actualMetric->GetValue(parameters), expectedValue, 1e-9 * std::abs(expectedValue));
+
+    MetricType::MeasureType    expectedValueOfDerivative{};
+    MetricType::DerivativeType expectedDerivative(expectedMetric->GetNumberOfParameters());
+    expectedMetric->GetValueAndDerivative(parameters, expectedValueOfDerivative, expectedDerivative);
+
+    MetricType::MeasureType    actualValueOfDerivative{};
+    MetricType::DerivativeType actualDerivative(actualMetric->GetNumberOfParameters());
+    actualMetric->GetValueAndDerivative(parameters, actualValueOfDerivative, actualDerivative);
+
+    EXPECT_NE(expectedValueOfDerivative, 0.0);
+    EXPECT_NEAR(actualValueOfDerivative, expectedValueOfDerivative, 1e-9 * std::abs(expectedValueOfDerivative));
+    ASSERT_EQ(actualDerivative.size(), expectedDerivative.size());
+    for (unsigned int i = 0; i < expectedDerivative.size(); ++i)
+    {
+      EXPECT_NEAR(actualDerivative[i], expectedDerivative[i], 1e-9 * std::abs(expectedDerivative[i]) + 1e-12) << i;
+    }
+  }
+}
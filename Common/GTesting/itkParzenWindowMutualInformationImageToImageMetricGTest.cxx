@@ -0,0 +1,119 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "AdvancedMattesMutualInformation/itkParzenWindowMutualInformationImageToImageMetric.h"
+
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkAdvancedTranslationTransform.h"
+#include "itkImageFullSampler.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+using MetricType = itk::ParzenWindowMutualInformationImageToImageMetric<ImageType, ImageType>;
+
+/** Creates an image with a ramp along the first axis and a Gaussian blob at the specified center. */
+ImageType::Pointer
+CreateImage(const double blobCenterX, const double blobCenterY)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 32, 32 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double dx = it.GetIndex()[0] - blobCenterX;
+    const double dy = it.GetIndex()[1] - blobCenterY;
+    it.Set(static_cast<float>(2.0 * it.GetIndex()[0] + 100.0 * std::exp(-(dx * dx + dy * dy) / 18.0)));
+  }
+  return image;
+}
+
+
+/** Creates a multi-threaded metric with three work units, computed on all samples of the fixed image, with a
+ * translation transform and the low-memory derivative. Without a thread pool, the samples are split equally over
+ * the work units. */
+MetricType::Pointer
+CreateInitializedMetric(itk::WorkStealingThreadPool * const threadPool)
+{
+  const auto fixedImage = CreateImage(15.0, 16.0);
+
+  const auto metric = MetricType::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(CreateImage(16.0, 15.0));
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetInterpolator(itk::AdvancedLinearInterpolateImageFunction<ImageType, double>::New());
+  metric->SetTransform(itk::AdvancedTranslationTransform<double, 2>::New());
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->SetUseExplicitPDFDerivatives(false);
+  metric->SetUseMultiThread(true);
+  metric->SetNumberOfWorkUnits(3);
+  metric->SetThreadPool(threadPool);
+  metric->Initialize();
+  return metric;
+}
+
+} // namespace
+
+
+// Tests that distributing the samples over the thread pool in chunks gives the same value and derivative as splitting
+// them equally over the work units, also when the metric is evaluated repeatedly.
+GTEST_TEST(ParzenWindowMutualInformationImageToImageMetric, SampleRangesOnThreadPoolEqualWorkUnits)
+{
+  const auto threadPool = itk::WorkStealingThreadPool::New();
+  threadPool->SetNumberOfThreads(3);
+
+  const auto expectedMetric = CreateInitializedMetric(nullptr);
+  const auto actualMetric = CreateInitializedMetric(threadPool);
+
+  MetricType::TransformParametersType parameters(2);
+  parameters[0] = 0.3;
+  parameters[1] = -0.2;
+
+  for (unsigned int evaluation = 0; evaluation < 2; ++evaluation)
+  {
+    const MetricType::MeasureType expectedValue = expectedMetric->GetValue(parameters);
+    EXPECT_NEAR(actualMetric->GetValue(parameters), expectedValue, 1e-9 * std::abs(expectedValue));
+
+    MetricType::MeasureType    expectedValueWithDerivative{};
+    MetricType::DerivativeType expectedDerivative(expectedMetric->GetNumberOfParameters());
+    expectedMetric->GetValueAndDerivative(parameters, expectedValueWithDerivative, expectedDerivative);
+
+    MetricType::MeasureType    actualValue{};
+    MetricType::DerivativeType actualDerivative(actualMetric->GetNumberOfParameters());
+    actualMetric->GetValueAndDerivative(parameters, actualValue, actualDerivative);
+
+    EXPECT_NE(expectedValueWithDerivative, 0.0);
+    EXPECT_NEAR(actualValue, expectedValueWithDerivative, 1e-9 * std::abs(expectedValueWithDerivative));
+    ASSERT_EQ(actualDerivative.size(), expectedDerivative.size());
+    for (unsigned int i = 0; i < expectedDerivative.size(); ++i)
+    {
+      EXPECT_NEAR(actualDerivative[i], expectedDerivative[i], 1e-9 * std::abs(expectedDerivative[i])) << i;
+    }
+  }
+}
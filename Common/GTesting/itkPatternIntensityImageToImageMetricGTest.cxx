@@ -0,0 +1,170 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "PatternIntensity/itkPatternIntensityImageToImageMetric.h"
+
+#include "itkAdvancedTranslationTransform.h"
+#include "itkImageFullSampler.h"
+
+#include <itkBSplineInterpolateImageFunction.h>
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+
+/** Gives access to the protected EvaluateProjection. */
+class PatternIntensityMetricForTest : public itk::PatternIntensityImageToImageMetric<ImageType, ImageType>
+{
+public:
+  using Self = PatternIntensityMetricForTest;
+  using Superclass = itk::PatternIntensityImageToImageMetric<ImageType, ImageType>;
+  using Pointer = itk::SmartPointer<Self>;
+  using typename Superclass::FixedImagePointType;
+  using typename Superclass::MovingImageDerivativeType;
+  using typename Superclass::RealType;
+
+  itkNewMacro(Self);
+
+  using Superclass::EvaluateProjection;
+};
+
+
+/** Creates an image with a Gaussian blob at the specified center. */
+ImageType::Pointer
+CreateImage(const double blobCenterX, const double blobCenterY)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 32, 32 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const double dx = it.GetIndex()[0] - blobCenterX;
+    const double dy = it.GetIndex()[1] - blobCenterY;
+    it.Set(static_cast<float>(100.0 * std::exp(-(dx * dx + dy * dy) / 18.0)));
+  }
+  return image;
+}
+
+
+/** Creates a metric that is computed on all samples of the fixed image, with a translation transform. */
+PatternIntensityMetricForTest::Pointer
+CreateInitializedMetric()
+{
+  const auto fixedImage = CreateImage(15.0, 16.0);
+
+  const auto metric = PatternIntensityMetricForTest::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(CreateImage(16.0, 15.0));
+  metric->SetFixedImageRegion(fixedImage->GetBufferedRegion());
+  metric->SetInterpolator(itk::BSplineInterpolateImageFunction<ImageType, double, double>::New());
+  metric->SetTransform(itk::AdvancedTranslationTransform<double, 2>::New());
+  metric->SetImageSampler(itk::ImageFullSampler<ImageType>::New());
+  metric->SetComputeOnSamples(true);
+  metric->Initialize();
+  return metric;
+}
+
+} // namespace
+
+
+// Tests that the image sampler is only used when the metric is computed on the samples.
+GTEST_TEST(PatternIntensityImageToImageMetric, UsesImageSamplerOnlyOnSamples)
+{
+  EXPECT_FALSE(PatternIntensityMetricForTest::New()->GetUseImageSampler());
+  EXPECT_TRUE(CreateInitializedMetric()->GetUseImageSampler());
+}
+
+
+// Tests that the gradient of a projection equals the finite difference derivative of the projection.
+GTEST_TEST(PatternIntensityImageToImageMetric, GradientOfProjectionEqualsFiniteDifferences)
+{
+  const auto metric = CreateInitializedMetric();
+
+  PatternIntensityMetricForTest::TransformParametersType parameters(2);
+  parameters[0] = 0.3;
+  parameters[1] = -0.2;
+  metric->SetTransformParameters(parameters);
+
+  using RealType = PatternIntensityMetricForTest::RealType;
+  using GradientType = PatternIntensityMetricForTest::MovingImageDerivativeType;
+
+  constexpr double delta = 1e-4;
+  for (const auto & point : { itk::MakePoint(12.6, 17.3), itk::MakePoint(18.2, 13.9) })
+  {
+    RealType     projection{};
+    GradientType pointGradient;
+    GradientType focalPointGradient;
+    metric->EvaluateProjection(point, projection, &pointGradient, &focalPointGradient);
+
+    for (unsigned int d = 0; d < 2; ++d)
+    {
+      auto forward = point;
+      auto backward = point;
+      forward[d] += delta;
+      backward[d] -= delta;
+      RealType forwardProjection{};
+      RealType backwardProjection{};
+      metric->EvaluateProjection(forward, forwardProjection, nullptr, nullptr);
+      metric->EvaluateProjection(backward, backwardProjection, nullptr, nullptr);
+      const double finiteDifference = (forwardProjection - backwardProjection) / (2.0 * delta);
+
+      EXPECT_GT(std::abs(finiteDifference), 1e-3) << d;
+      EXPECT_NEAR(pointGradient[d], finiteDifference, 1e-4 * std::abs(finiteDifference)) << d;
+      EXPECT_EQ(focalPointGradient[d], 0.0);
+    }
+  }
+}
+
+
+// Tests that the analytic derivative on the samples equals the finite difference derivative of the value.
+GTEST_TEST(PatternIntensityImageToImageMetric, DerivativeOfSamplesEqualsFiniteDifferences)
+{
+  const auto metric = CreateInitializedMetric();
+
+  PatternIntensityMetricForTest::TransformParametersType parameters(2);
+  parameters[0] = 0.3;
+  parameters[1] = -0.2;
+
+  PatternIntensityMetricForTest::MeasureType    value{};
+  PatternIntensityMetricForTest::DerivativeType derivative;
+  metric->GetValueAndDerivative(parameters, value, derivative);
+  EXPECT_NEAR(value, metric->GetValue(parameters), 1e-9 * std::abs(value));
+  ASSERT_EQ(derivative.size(), parameters.size());
+
+  constexpr double delta = 1e-4;
+  for (unsigned int i = 0; i < parameters.size(); ++i)
+  {
+    auto forward = parameters;
+    auto backward = parameters;
+    forward[i] += delta;
+    backward[i] -= delta;
+    const double finiteDifference = (metric->GetValue(forward) - metric->GetValue(backward)) / (2.0 * delta);
+
+    EXPECT_GT(std::abs(finiteDifference), 1e-9) << i;
+    EXPECT_NEAR(derivative[i], finiteDifference, 1e-4 * std::abs(finiteDifference)) << i;
+  }
+}
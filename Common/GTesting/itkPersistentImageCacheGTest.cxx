@@ -0,0 +1,280 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkPersistentImageCache.h"
+
+#include "itkErodeMaskImageFilter.h"
+#include "itkGenericMultiResolutionPyramidImageFilter.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+#include <gtest/gtest.h>
+
+#include <algorithm> // For min.
+#include <cstdint>
+#include <string>
+
+namespace
+{
+using ImageType = itk::Image<float, 3>;
+using MaskImageType = itk::Image<unsigned char, 3>;
+using PyramidType = itk::GenericMultiResolutionPyramidImageFilter<ImageType, ImageType>;
+using ErodeFilterType = itk::ErodeMaskImageFilter<MaskImageType>;
+using CacheType = itk::PersistentImageCache;
+
+/** An empty directory for the cache of a test. */
+std::string
+CreateEmptyCacheDirectory(const std::string & name)
+{
+  const std::string directory = itksys::SystemTools::GetCurrentWorkingDirectory() + "/" + name;
+  itksys::SystemTools::RemoveADirectory(directory);
+  return directory;
+}
+
+/** The number of files in a directory. */
+unsigned long
+GetNumberOfFiles(const std::string & directory)
+{
+  itksys::Directory dir;
+  dir.Load(directory);
+  unsigned long numberOfFiles = 0;
+  for (unsigned long i = 0; i < dir.GetNumberOfFiles(); ++i)
+  {
+    const std::string fileName = dir.GetFile(i);
+    numberOfFiles += (fileName != "." && fileName != "..") ? 1 : 0;
+  }
+  return numberOfFiles;
+}
+
+ImageType::Pointer
+CreateImage()
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 17, 12, 9 } });
+  image->SetSpacing(ImageType::SpacingType(0.75));
+  image->SetOrigin(ImageType::PointType(-3.0));
+  image->Allocate();
+  for (itk::ImageRegionIteratorWithIndex<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(static_cast<float>((index[0] * 7 + index[1] * 13 + index[2] * 29) % 31));
+  }
+  return image;
+}
+
+MaskImageType::Pointer
+CreateMask()
+{
+  const auto mask = MaskImageType::New();
+  mask->SetRegions(MaskImageType::SizeType{ { 17, 12, 9 } });
+  mask->Allocate(true);
+  for (itk::ImageRegionIteratorWithIndex<MaskImageType> it(mask, mask->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto & index = it.GetIndex();
+    it.Set(index[0] > 2 && index[0] < 14 && index[1] > 2 && index[1] < 9 && index[2] > 1 ? 1 : 0);
+  }
+  return mask;
+}
+
+template <class TImage>
+void
+ExpectEqualImages(const TImage * actual, const TImage * expected)
+{
+  ASSERT_EQ(actual->GetBufferedRegion(), expected->GetBufferedRegion());
+  EXPECT_EQ(actual->GetSpacing(), expected->GetSpacing());
+  EXPECT_EQ(actual->GetOrigin(), expected->GetOrigin());
+  EXPECT_EQ(actual->GetDirection(), expected->GetDirection());
+
+  itk::ImageRegionConstIterator<TImage> actualIt(actual, actual->GetBufferedRegion());
+  itk::ImageRegionConstIterator<TImage> expectedIt(expected, expected->GetBufferedRegion());
+  for (; !actualIt.IsAtEnd(); ++actualIt, ++expectedIt)
+  {
+    EXPECT_EQ(actualIt.Get(), expectedIt.Get());
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(PersistentImageCache, WrittenImageIsReadBack)
+{
+  const auto image = CreateImage();
+  const auto cache = CacheType::New();
+  cache->SetDirectory(CreateEmptyCacheDirectory("PersistentImageCacheGTest_ReadBack"));
+
+  const CacheType::HashType hash = CacheType::ComputeImageHash(image.GetPointer());
+  EXPECT_TRUE(cache->ReadImage<ImageType>("image", hash, "settings").IsNull());
+
+  cache->WriteImage("image", hash, "settings", image.GetPointer());
+  const auto cachedImage = cache->ReadImage<ImageType>("image", hash, "settings");
+  ASSERT_TRUE(cachedImage.IsNotNull());
+  ExpectEqualImages(cachedImage.GetPointer(), image.GetPointer());
+
+  /** Another pixel type, or another dimension, is a cache miss. */
+  EXPECT_TRUE((cache->ReadImage<itk::Image<short, 3>>("image", hash, "settings").IsNull()));
+  EXPECT_TRUE((cache->ReadImage<itk::Image<float, 2>>("image", hash, "settings").IsNull()));
+}
+
+
+/** A file that is found under the name of other settings, as after a collision of the hashes in
+ * the file names, is a cache miss, because the header holds the input hash and the settings. */
+GTEST_TEST(PersistentImageCache, HeaderIsVerifiedOnRead)
+{
+  const auto        image = CreateImage();
+  const std::string directory = CreateEmptyCacheDirectory("PersistentImageCacheGTest_Header");
+  const auto        cache = CacheType::New();
+  cache->SetDirectory(directory);
+
+  const CacheType::HashType hash = CacheType::ComputeImageHash(image.GetPointer());
+  cache->WriteImage("image", hash, "settings", image.GetPointer());
+
+  const auto copyFile = [&directory, hash](const CacheType::HashType otherHash, const std::string & otherSettings) {
+    const std::string fileName = directory + "/" + CacheType::MakeKey("image", CacheType::HashString("settings", hash));
+    const std::string otherFileName =
+      directory + "/" + CacheType::MakeKey("image", CacheType::HashString(otherSettings, otherHash));
+    ASSERT_TRUE(itksys::SystemTools::CopyFileAlways(fileName + ".cache", otherFileName + ".cache"));
+  };
+
+  copyFile(hash, "other settings");
+  EXPECT_TRUE(cache->ReadImage<ImageType>("image", hash, "other settings").IsNull());
+  copyFile(hash + 1, "settings");
+  EXPECT_TRUE(cache->ReadImage<ImageType>("image", hash + 1, "settings").IsNull());
+  EXPECT_TRUE(cache->ReadImage<ImageType>("image", hash, "settings").IsNotNull());
+}
+
+
+/** When the maximum size is exceeded, files are removed, except for the one that is just written. */
+GTEST_TEST(PersistentImageCache, MaximumSizeIsRespected)
+{
+  const auto        image = CreateImage();
+  const std::string directory = CreateEmptyCacheDirectory("PersistentImageCacheGTest_MaximumSize");
+  const auto        cache = CacheType::New();
+  cache->SetDirectory(directory);
+
+  const std::uint64_t fileSize =
+    CacheType::HeaderSize + image->GetBufferedRegion().GetNumberOfPixels() * sizeof(ImageType::PixelType);
+  cache->SetMaximumNumberOfBytes(2 * fileSize + fileSize / 2);
+
+  const CacheType::HashType hash = CacheType::ComputeImageHash(image.GetPointer());
+  for (unsigned int i = 0; i < 3; ++i)
+  {
+    cache->WriteImage("image", hash, std::to_string(i), image.GetPointer());
+    EXPECT_EQ(GetNumberOfFiles(directory), std::min(i + 1, 2u));
+    EXPECT_TRUE(cache->ReadImage<ImageType>("image", hash, std::to_string(i)).IsNotNull());
+  }
+}
+
+
+GTEST_TEST(PersistentImageCache, DisabledCacheDoesNothing)
+{
+  const auto image = CreateImage();
+  const auto cache = CacheType::New();
+  EXPECT_FALSE(cache->IsEnabled());
+
+  cache->WriteImage("image", 0, "settings", image.GetPointer());
+  EXPECT_TRUE(cache->ReadImage<ImageType>("image", 0, "settings").IsNull());
+}
+
+
+GTEST_TEST(PersistentImageCache, ImageHashDependsOnPixelsAndGeometry)
+{
+  const auto image = CreateImage();
+  const auto hash = CacheType::ComputeImageHash(image.GetPointer());
+  EXPECT_EQ(CacheType::ComputeImageHash(CreateImage().GetPointer()), hash);
+
+  const auto otherPixels = CreateImage();
+  otherPixels->SetPixel({ { 3, 4, 5 } }, 100.0f);
+  EXPECT_NE(CacheType::ComputeImageHash(otherPixels.GetPointer()), hash);
+
+  const auto otherSpacing = CreateImage();
+  otherSpacing->SetSpacing(ImageType::SpacingType(0.8));
+  EXPECT_NE(CacheType::ComputeImageHash(otherSpacing.GetPointer()), hash);
+}
+
+
+/** A second pyramid with the same input and settings reads all levels from the cache. */
+GTEST_TEST(PersistentImageCache, PyramidLevelsAreReused)
+{
+  const auto        image = CreateImage();
+  const std::string directory = CreateEmptyCacheDirectory("PersistentImageCacheGTest_Pyramid");
+  const auto        cache = CacheType::New();
+  cache->SetDirectory(directory);
+
+  const auto expected = PyramidType::New();
+  expected->SetNumberOfLevels(3);
+  expected->SetInput(image);
+  expected->Update();
+
+  for (unsigned int run = 0; run < 2; ++run)
+  {
+    const auto pyramid = PyramidType::New();
+    pyramid->SetNumberOfLevels(3);
+    pyramid->SetInput(image);
+    pyramid->SetPersistentCache(cache);
+    pyramid->Update();
+    EXPECT_EQ(GetNumberOfFiles(directory), 3ul);
+
+    for (unsigned int level = 0; level < 3; ++level)
+    {
+      ExpectEqualImages(pyramid->GetOutput(level), expected->GetOutput(level));
+    }
+  }
+
+  /** Other settings give other cache entries. */
+  const auto pyramid = PyramidType::New();
+  pyramid->SetNumberOfLevels(3);
+  pyramid->SetInput(image);
+  pyramid->SetUseShrinkImageFilter(true);
+  pyramid->SetPersistentCache(cache);
+  pyramid->Update();
+  EXPECT_EQ(GetNumberOfFiles(directory), 6ul);
+}
+
+
+/** A second erosion with the same mask and settings reads the eroded mask from the cache. */
+GTEST_TEST(PersistentImageCache, ErodedMaskIsReused)
+{
+  const auto        mask = CreateMask();
+  const std::string directory = CreateEmptyCacheDirectory("PersistentImageCacheGTest_ErodeMask");
+  const auto        cache = CacheType::New();
+  cache->SetDirectory(directory);
+
+  ErodeFilterType::ScheduleType schedule(2, 3);
+  schedule.Fill(2);
+
+  const auto expected = ErodeFilterType::New();
+  expected->SetInput(mask);
+  expected->SetSchedule(schedule);
+  expected->Update();
+
+  for (unsigned int run = 0; run < 2; ++run)
+  {
+    const auto erosion = ErodeFilterType::New();
+    erosion->SetInput(mask);
+    erosion->SetSchedule(schedule);
+    erosion->SetPersistentCache(cache);
+    erosion->Update();
+    EXPECT_EQ(GetNumberOfFiles(directory), 1ul);
+    ExpectEqualImages(erosion->GetOutput(), expected->GetOutput());
+  }
+}
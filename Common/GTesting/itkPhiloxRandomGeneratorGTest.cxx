@@ -0,0 +1,88 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkPhiloxRandomGenerator.h"
+
+#include <gtest/gtest.h>
+
+using itk::PhiloxRandomGenerator;
+using WordType = PhiloxRandomGenerator::WordType;
+
+
+/** The known answer tests of Philox4x32-10, from the Random123 library. */
+GTEST_TEST(PhiloxRandomGenerator, GeneratesKnownAnswers)
+{
+  const WordType zeroCounter[4] = { 0, 0, 0, 0 };
+  const WordType zeroKey[2] = { 0, 0 };
+  WordType       output[4];
+  PhiloxRandomGenerator::Generate(zeroCounter, zeroKey, output);
+  EXPECT_EQ(output[0], 0x6627e8d5u);
+  EXPECT_EQ(output[1], 0xe169c58du);
+  EXPECT_EQ(output[2], 0xbc57ac4cu);
+  EXPECT_EQ(output[3], 0x9b00dbd8u);
+
+  const WordType onesCounter[4] = { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff };
+  const WordType onesKey[2] = { 0xffffffff, 0xffffffff };
+  PhiloxRandomGenerator::Generate(onesCounter, onesKey, output);
+  EXPECT_EQ(output[0], 0x408f276du);
+  EXPECT_EQ(output[1], 0x41c83b0eu);
+  EXPECT_EQ(output[2], 0xa20bc7c6u);
+  EXPECT_EQ(output[3], 0x6d5451fdu);
+
+  const WordType piCounter[4] = { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 };
+  const WordType piKey[2] = { 0xa4093822, 0x299f31d0 };
+  PhiloxRandomGenerator::Generate(piCounter, piKey, output);
+  EXPECT_EQ(output[0], 0xd16cfe09u);
+  EXPECT_EQ(output[1], 0x94fdccebu);
+  EXPECT_EQ(output[2], 0x5001e420u);
+  EXPECT_EQ(output[3], 0x24126ea1u);
+}
+
+
+GTEST_TEST(PhiloxRandomGenerator, SubStreamsAreReproducibleAndDistinct)
+{
+  PhiloxRandomGenerator generator1(121212, 3, 7);
+  PhiloxRandomGenerator generator2(121212, 3, 7);
+  PhiloxRandomGenerator generator3(121212, 3, 8);
+  for (unsigned int i = 0; i < 10; ++i)
+  {
+    const WordType word = generator1.GetNextWord();
+    EXPECT_EQ(word, generator2.GetNextWord());
+    EXPECT_NE(word, generator3.GetNextWord());
+  }
+}
+
+
+GTEST_TEST(PhiloxRandomGenerator, VariatesAreInRange)
+{
+  PhiloxRandomGenerator generator(121212, 0, 0);
+  for (unsigned int i = 0; i < 1000; ++i)
+  {
+    const double uniform = generator.GetUniformVariate();
+    EXPECT_GE(uniform, 0.0);
+    EXPECT_LT(uniform, 1.0);
+
+    const double scaled = generator.GetUniformVariate(-2.0, 3.0);
+    EXPECT_GE(scaled, -2.0);
+    EXPECT_LT(scaled, 3.0);
+
+    EXPECT_LE(generator.GetIntegerVariate(4), 4u);
+  }
+}
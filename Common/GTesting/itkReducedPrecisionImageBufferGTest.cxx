@@ -0,0 +1,146 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkReducedPrecisionImageBuffer.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
+#include <itkImageRegionIterator.h>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+
+using ImageType = itk::Image<float, 3>;
+using BufferType = itk::ReducedPrecisionImageBuffer<float, 3>;
+
+namespace
+{
+
+/** Creates an image with the given region, filled by a function of the pixel number. */
+template <class TFunction>
+ImageType::Pointer
+CreateImage(const ImageType::RegionType & region, TFunction function)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(region);
+  image->Allocate();
+  unsigned int n = 0;
+  for (itk::ImageRegionIterator<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    it.Set(function(n++));
+  }
+  return image;
+}
+
+} // namespace
+
+
+/** Every finite half float is converted to a float and back without change. */
+GTEST_TEST(ReducedPrecisionImageBuffer, HalfFloatRoundTrip)
+{
+  for (unsigned int bits = 0; bits <= 0xFFFF; ++bits)
+  {
+    const auto half = static_cast<std::uint16_t>(bits);
+    if (((half >> 10) & 0x1F) == 0x1F)
+    {
+      continue;
+    }
+    EXPECT_EQ(BufferType::FloatToHalf(BufferType::HalfToFloat(half)), half);
+  }
+
+  EXPECT_EQ(BufferType::HalfToFloat(0x3C00), 1.0f);
+  EXPECT_EQ(BufferType::HalfToFloat(0xC000), -2.0f);
+  EXPECT_EQ(BufferType::HalfToFloat(0x0001), std::ldexp(1.0f, -24));
+  EXPECT_EQ(BufferType::FloatToHalf(1.0f + std::ldexp(1.0f, -11)), 0x3C00); // tie, to even
+  EXPECT_EQ(BufferType::FloatToHalf(1.0e9f), 0x7BFF);                       // clamped to 65504
+  EXPECT_EQ(BufferType::FloatToHalf(-1.0e9f), 0xFBFF);
+}
+
+
+/** Integer images with a range of at most 65536 values, such as CT images, are stored exactly. */
+GTEST_TEST(ReducedPrecisionImageBuffer, UInt16IsExactForIntegerImages)
+{
+  const ImageType::RegionType region{ { { -1, 4, 2 } }, { { 17, 9, 10 } } };
+  const auto image = CreateImage(region, [](unsigned int n) { return static_cast<float>(n % 4096) - 1024.0f; });
+
+  BufferType buffer;
+  EXPECT_TRUE(buffer.IsEmpty());
+  buffer.CopyImage(image.GetPointer(), BufferType::UInt16);
+  ASSERT_FALSE(buffer.IsEmpty());
+  EXPECT_EQ(buffer.GetBufferedRegion(), region);
+  EXPECT_EQ(buffer.GetScale(), 1.0f);
+  EXPECT_EQ(buffer.GetShift(), -1024.0f);
+
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    EXPECT_EQ(buffer.GetPixel(it.GetIndex()), it.Get());
+  }
+
+  buffer.Clear();
+  EXPECT_TRUE(buffer.IsEmpty());
+}
+
+
+/** The decoded pixels are within the precision of the encoding. */
+GTEST_TEST(ReducedPrecisionImageBuffer, DecodedPixelsAreWithinPrecision)
+{
+  const ImageType::RegionType region{ { { 0, 0, 0 } }, { { 20, 11, 7 } } };
+  const auto image = CreateImage(region, [](unsigned int n) { return 1000.0f * std::sin(0.37f * n) + 0.25f; });
+
+  BufferType uint16Buffer;
+  uint16Buffer.CopyImage(image.GetPointer(), BufferType::UInt16);
+  BufferType float16Buffer;
+  float16Buffer.CopyImage(image.GetPointer(), BufferType::Float16);
+
+  const double uint16Tolerance = 0.5 * uint16Buffer.GetScale() + 1.0e-4;
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    const double value = it.Get();
+    EXPECT_NEAR(uint16Buffer.GetPixel(it.GetIndex()), value, uint16Tolerance);
+    EXPECT_NEAR(float16Buffer.GetPixel(it.GetIndex()), value, std::abs(value) * std::ldexp(1.0, -11) + 1.0e-7);
+  }
+}
+
+
+GTEST_TEST(ReducedPrecisionImageBuffer, FixedEncodingViewDecodesAsBuffer)
+{
+  const ImageType::RegionType region{ { { 2, -3, 0 } }, { { 9, 8, 5 } } };
+  const auto image = CreateImage(region, [](unsigned int n) { return 37.5f * std::cos(0.21f * n) - 3.0f; });
+
+  BufferType uint16Buffer;
+  uint16Buffer.CopyImage(image.GetPointer(), BufferType::UInt16);
+  BufferType float16Buffer;
+  float16Buffer.CopyImage(image.GetPointer(), BufferType::Float16);
+
+  const BufferType::FixedEncodingView<BufferType::UInt16>  uint16View(uint16Buffer);
+  const BufferType::FixedEncodingView<BufferType::Float16> float16View(float16Buffer);
+  for (itk::ImageRegionConstIteratorWithIndex<ImageType> it(image, region); !it.IsAtEnd(); ++it)
+  {
+    BufferType::SizeValueType offset = 0;
+    for (unsigned int d = 0; d < ImageType::ImageDimension; ++d)
+    {
+      offset += uint16View.GetOffset(d, it.GetIndex()[d]);
+    }
+    EXPECT_EQ(offset, uint16Buffer.ComputeOffset(it.GetIndex()));
+    EXPECT_EQ(uint16View.GetPixelAtOffset(offset), uint16Buffer.GetPixel(it.GetIndex()));
+    EXPECT_EQ(float16View.GetPixelAtOffset(offset), float16Buffer.GetPixel(it.GetIndex()));
+  }
+}
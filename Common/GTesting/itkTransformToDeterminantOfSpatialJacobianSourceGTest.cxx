@@ -0,0 +1,89 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkTransformToDeterminantOfSpatialJacobianSource.h"
+
+#include "itkAdvancedBSplineDeformableTransform.h"
+#include "itkImage.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkStreamingImageFilter.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+
+typedef itk::Image<float, 2>                                                 ImageType;
+typedef itk::AdvancedBSplineDeformableTransform<double, 2, 3>                TransformType;
+typedef itk::TransformToDeterminantOfSpatialJacobianSource<ImageType, double> SourceType;
+
+/** Generates the determinant of the spatial Jacobian, in the specified number of pieces. */
+ImageType::Pointer
+Generate(const TransformType & transform, const unsigned int numberOfStreamDivisions)
+{
+  const auto source = SourceType::New();
+  source->SetTransform(&transform);
+  source->SetOutputSize(ImageType::SizeType{ { 13, 11 } });
+  source->SetOutputIndex(ImageType::IndexType{ { 2, 1 } });
+  source->SetOutputSpacing(itk::MakeVector(1.5, 2.0));
+
+  const auto streamer = itk::StreamingImageFilter<ImageType, ImageType>::New();
+  streamer->SetInput(source->GetOutput());
+  streamer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  streamer->Update();
+  return streamer->GetOutput();
+}
+
+} // namespace
+
+
+GTEST_TEST(TransformToDeterminantOfSpatialJacobianSource, StreamedOutputEqualsWholeOutput)
+{
+  const auto transform = TransformType::New();
+  transform->SetGridRegion(TransformType::RegionType(TransformType::SizeType{ { 8, 8 } }));
+  transform->SetGridSpacing(itk::MakeVector(5.0, 5.0));
+  transform->SetGridOrigin(itk::MakePoint(-5.0, -5.0));
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  TransformType::ParametersType          parameters(transform->GetNumberOfParameters());
+  for (auto & parameter : parameters)
+  {
+    parameter = distribution(randomNumberEngine);
+  }
+  transform->SetParameters(parameters);
+
+  const auto expected = Generate(*transform, 1);
+  ASSERT_EQ(expected->GetBufferedRegion(), expected->GetLargestPossibleRegion());
+
+  for (const unsigned int numberOfStreamDivisions : { 2u, 5u })
+  {
+    const auto actual = Generate(*transform, numberOfStreamDivisions);
+    ASSERT_EQ(actual->GetBufferedRegion(), expected->GetBufferedRegion());
+
+    itk::ImageRegionConstIterator<ImageType> expectedIt(expected, expected->GetBufferedRegion());
+    itk::ImageRegionConstIterator<ImageType> actualIt(actual, actual->GetBufferedRegion());
+    for (; !expectedIt.IsAtEnd(); ++expectedIt, ++actualIt)
+    {
+      EXPECT_EQ(actualIt.Get(), expectedIt.Get());
+    }
+  }
+}
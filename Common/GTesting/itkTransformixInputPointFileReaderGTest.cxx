@@ -0,0 +1,96 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkTransformixInputPointFileReader.h"
+
+#include "itkByteSwapper.h"
+#include "itkPointSet.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+typedef itk::PointSet<unsigned char, 3>                    PointSetType;
+typedef itk::TransformixInputPointFileReader<PointSetType> ReaderType;
+
+const std::vector<double> expectedCoordinates{ 1.5, -2.25, 3.0, 0.0, 100.125, -7.5 };
+
+/** Reads the points of the specified file, and checks that they are the expected points. */
+void
+Expect_points_are_read(const std::string & fileName, const bool expectedIsBinary)
+{
+  const auto reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->Update();
+
+  EXPECT_EQ(reader->GetIsBinary(), expectedIsBinary);
+  EXPECT_FALSE(reader->GetPointsAreIndices());
+  ASSERT_EQ(reader->GetNumberOfPoints(), 2u);
+
+  const PointSetType & pointSet = *reader->GetOutput();
+  ASSERT_EQ(pointSet.GetNumberOfPoints(), 2u);
+  for (unsigned int j = 0; j < 2; ++j)
+  {
+    const PointSetType::PointType point = pointSet.GetPoint(j);
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+      EXPECT_EQ(point[i], expectedCoordinates[j * 3 + i]);
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(TransformixInputPointFileReader, ReadsTextAndBinaryPointFiles)
+{
+  const std::string directory = itksys::SystemTools::GetCurrentWorkingDirectory();
+
+  const std::string textFileName = directory + "/TransformixInputPointFileReaderGTest.txt";
+  {
+    std::ofstream textFile(textFileName);
+    textFile << "point\n2\n1.5 -2.25 3.0\n0.0 100.125 -7.5\n";
+  }
+  Expect_points_are_read(textFileName, false);
+
+  const std::string binaryFileName = directory + "/TransformixInputPointFileReaderGTest.bin";
+  {
+    std::ofstream binaryFile(binaryFileName, std::ios::binary);
+    std::uint32_t dimensionAndPointsAreIndices[2] = { 3, 0 };
+    std::uint64_t numberOfPoints = 2;
+    auto          coordinates = expectedCoordinates;
+    itk::ByteSwapper<std::uint32_t>::SwapRangeFromSystemToLittleEndian(dimensionAndPointsAreIndices, 2);
+    itk::ByteSwapper<std::uint64_t>::SwapFromSystemToLittleEndian(&numberOfPoints);
+    itk::ByteSwapper<double>::SwapRangeFromSystemToLittleEndian(coordinates.data(), coordinates.size());
+    binaryFile.write(ReaderType::GetBinaryFileSignature(), ReaderType::BinaryFileSignatureLength);
+    binaryFile.write(reinterpret_cast<const char *>(dimensionAndPointsAreIndices),
+                     sizeof(dimensionAndPointsAreIndices));
+    binaryFile.write(reinterpret_cast<const char *>(&numberOfPoints), sizeof(numberOfPoints));
+    binaryFile.write(reinterpret_cast<const char *>(coordinates.data()), coordinates.size() * sizeof(double));
+  }
+  Expect_points_are_read(binaryFileName, true);
+}
@@ -0,0 +1,136 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include "itkTrilinearInterpolationKernel.h"
+
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkImage.h"
+#include "itkImageRegionIterator.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+using itk::TrilinearInterpolationKernel;
+
+namespace
+{
+
+/** Creates a 3D image with random pixel values, a nonzero start index, and an anisotropic, rotated grid. */
+template <class TPixel>
+typename itk::Image<TPixel, 3>::Pointer
+CreateRandomImage(std::mt19937 & randomNumberEngine)
+{
+  typedef itk::Image<TPixel, 3> ImageType;
+
+  typename ImageType::IndexType start = { { -2, 3, 1 } };
+  typename ImageType::SizeType  size = { { 11, 7, 5 } };
+  const auto                    image = ImageType::New();
+  image->SetRegions(typename ImageType::RegionType(start, size));
+  image->Allocate();
+
+  const double spacing[] = { 0.5, 1.0, 2.0 };
+  image->SetSpacing(spacing);
+  typename ImageType::DirectionType direction;
+  direction.Fill(0.0);
+  direction(0, 1) = 1.0;
+  direction(1, 0) = -1.0;
+  direction(2, 2) = 1.0;
+  image->SetDirection(direction);
+
+  std::uniform_real_distribution<double> distribution(0.0, 100.0);
+  for (itk::ImageRegionIterator<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    it.Set(static_cast<TPixel>(distribution(randomNumberEngine)));
+  }
+  return image;
+}
+
+
+/** Checks that the batched evaluation yields the same values and derivatives as the evaluation per point. */
+template <class TPixel>
+void
+Expect_batched_evaluation_equals_evaluation_per_point()
+{
+  typedef itk::Image<TPixel, 3>                                  ImageType;
+  typedef itk::AdvancedLinearInterpolateImageFunction<ImageType> InterpolatorType;
+  typedef typename InterpolatorType::ContinuousIndexType         ContinuousIndexType;
+  typedef typename InterpolatorType::OutputType                  OutputType;
+  typedef typename InterpolatorType::CovariantVectorType         CovariantVectorType;
+
+  std::mt19937 randomNumberEngine;
+  const auto   image = CreateRandomImage<TPixel>(randomNumberEngine);
+  const auto   interpolator = InterpolatorType::New();
+  interpolator->SetInputImage(image);
+
+  /** Random points inside the buffer, more than the batch size of the kernel. */
+  const unsigned int               numberOfPoints = 200;
+  std::vector<ContinuousIndexType> points(numberOfPoints);
+  const auto &                     region = image->GetBufferedRegion();
+  for (auto & point : points)
+  {
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      std::uniform_real_distribution<double> distribution(region.GetIndex(d) - 0.5,
+                                                          region.GetIndex(d) + region.GetSize(d) - 0.5);
+      point[d] = distribution(randomNumberEngine);
+    }
+    ASSERT_TRUE(interpolator->IsInsideBuffer(point));
+  }
+
+  std::vector<OutputType> values(numberOfPoints);
+  interpolator->EvaluateAtContinuousIndices(numberOfPoints, points.data(), values.data());
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    EXPECT_NEAR(values[i], interpolator->EvaluateAtContinuousIndex(points[i]), 1e-10);
+  }
+
+  std::vector<CovariantVectorType> derivatives(numberOfPoints);
+  interpolator->EvaluateValueAndDerivativeAtContinuousIndices(
+    numberOfPoints, points.data(), values.data(), derivatives.data());
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    OutputType          expectedValue;
+    CovariantVectorType expectedDerivative;
+    interpolator->EvaluateValueAndDerivativeAtContinuousIndex(points[i], expectedValue, expectedDerivative);
+    EXPECT_NEAR(values[i], expectedValue, 1e-10);
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+      EXPECT_NEAR(derivatives[i][d], expectedDerivative[d], 1e-8);
+    }
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(TrilinearInterpolationKernel, BatchedEvaluationEqualsEvaluationPerPoint)
+{
+  Expect_batched_evaluation_equals_evaluation_per_point<float>();
+  Expect_batched_evaluation_equals_evaluation_per_point<double>();
+}
+
+
+GTEST_TEST(TrilinearInterpolationKernel, HasInstructionSetName)
+{
+  const std::string name = TrilinearInterpolationKernel::GetInstructionSetName();
+  EXPECT_TRUE(name == "AVX-512" || name == "AVX2" || name == "scalar");
+}
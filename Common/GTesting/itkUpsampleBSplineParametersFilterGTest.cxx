@@ -0,0 +1,108 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkUpsampleBSplineParametersFilter.h"
+
+#include <itkImage.h>
+#include <itkOptimizerParameters.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace
+{
+
+/** Checks that the separable upsampling yields the same parameters as the image filter pipeline. */
+template <unsigned int VDimension>
+void
+Expect_separable_upsampling_equals_image_filters(const unsigned int splineOrder)
+{
+  using ImageType = itk::Image<double, VDimension>;
+  using ArrayType = itk::OptimizerParameters<double>;
+  using FilterType = itk::UpsampleBSplineParametersFilter<ArrayType, ImageType>;
+
+  /** A coarse grid, and a grid with half the spacing, a shifted origin and a nonzero start index. */
+  typename ImageType::RegionType    currentRegion;
+  typename ImageType::RegionType    requiredRegion;
+  typename ImageType::SpacingType   currentSpacing;
+  typename ImageType::SpacingType   requiredSpacing;
+  typename ImageType::PointType     currentOrigin;
+  typename ImageType::PointType     requiredOrigin;
+  typename ImageType::DirectionType direction;
+  direction.SetIdentity();
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    currentRegion.SetSize(d, 5 + d);
+    requiredRegion.SetSize(d, 7 + 2 * d);
+    requiredRegion.SetIndex(d, d % 2);
+    currentSpacing[d] = 8.0 + d;
+    requiredSpacing[d] = 0.5 * currentSpacing[d];
+    currentOrigin[d] = -10.0 * d;
+    requiredOrigin[d] = currentOrigin[d] + 0.25 * currentSpacing[d];
+  }
+
+  std::mt19937                           randomNumberEngine;
+  std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+  ArrayType                              parameters(currentRegion.GetNumberOfPixels() * VDimension);
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = distribution(randomNumberEngine);
+  }
+
+  const auto filter = FilterType::New();
+  filter->SetCurrentGridOrigin(currentOrigin);
+  filter->SetCurrentGridSpacing(currentSpacing);
+  filter->SetCurrentGridDirection(direction);
+  filter->SetCurrentGridRegion(currentRegion);
+  filter->SetRequiredGridOrigin(requiredOrigin);
+  filter->SetRequiredGridSpacing(requiredSpacing);
+  filter->SetRequiredGridDirection(direction);
+  filter->SetRequiredGridRegion(requiredRegion);
+  filter->SetBSplineOrder(splineOrder);
+
+  ArrayType actual;
+  filter->UseSeparableUpsamplingOn();
+  filter->UpsampleParameters(parameters, actual);
+
+  ArrayType expected;
+  filter->UseSeparableUpsamplingOff();
+  filter->UpsampleParameters(parameters, expected);
+
+  ASSERT_EQ(actual.GetSize(), requiredRegion.GetNumberOfPixels() * VDimension);
+  ASSERT_EQ(actual.GetSize(), expected.GetSize());
+  for (unsigned int i = 0; i < actual.GetSize(); ++i)
+  {
+    EXPECT_NEAR(actual[i], expected[i], 1e-8);
+  }
+}
+
+} // namespace
+
+
+GTEST_TEST(UpsampleBSplineParametersFilter, SeparableEqualsImageFilters)
+{
+  for (unsigned int splineOrder = 1; splineOrder <= 3; ++splineOrder)
+  {
+    Expect_separable_upsampling_equals_image_filters<2>(splineOrder);
+    Expect_separable_upsampling_equals_image_filters<3>(splineOrder);
+  }
+  Expect_separable_upsampling_equals_image_filters<4>(3);
+}
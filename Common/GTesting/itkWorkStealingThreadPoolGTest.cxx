@@ -0,0 +1,227 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+
+// First include the header file to be tested:
+#include "itkWorkStealingThreadPool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using itk::WorkStealingThreadPool;
+
+namespace
+{
+struct WorkUnitCounts
+{
+  std::vector<std::atomic<unsigned int>> m_Counts;
+  std::atomic<unsigned int>              m_WrongNumberOfWorkUnits{ 0 };
+
+  explicit WorkUnitCounts(const unsigned int numberOfWorkUnits)
+    : m_Counts(numberOfWorkUnits)
+  {}
+};
+
+
+itk::ITK_THREAD_RETURN_TYPE
+CountWorkUnit(void * arg)
+{
+  const auto & info = *static_cast<WorkStealingThreadPool::ThreadInfoType *>(arg);
+  auto &       counts = *static_cast<WorkUnitCounts *>(info.UserData);
+
+  ++counts.m_Counts[info.WorkUnitID];
+  if (info.NumberOfWorkUnits != counts.m_Counts.size())
+  {
+    ++counts.m_WrongNumberOfWorkUnits;
+  }
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+}
+
+} // namespace
+
+
+GTEST_TEST(WorkStealingThreadPool, ParallelForVisitsEachElementOnce)
+{
+  const auto pool = WorkStealingThreadPool::New();
+  pool->SetNumberOfThreads(4);
+
+  for (const itk::SizeValueType grainSize : { 0, 1, 7, 1000 })
+  {
+    std::vector<std::atomic<unsigned int>> visits(997);
+    std::atomic<bool>                      validThreadId{ true };
+
+    const auto func = [&](itk::ThreadIdType threadId, itk::SizeValueType begin, itk::SizeValueType end) {
+      if (threadId >= 4)
+      {
+        validThreadId = false;
+      }
+      for (auto i = begin; i < end; ++i)
+      {
+        ++visits[i];
+      }
+    };
+    pool->ParallelFor(visits.size(), grainSize, func);
+
+    EXPECT_TRUE(validThreadId);
+    for (const auto & count : visits)
+    {
+      ASSERT_EQ(count, 1U);
+    }
+  }
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, SingleMethodExecuteRunsEachWorkUnitOnce)
+{
+  const auto pool = WorkStealingThreadPool::New();
+
+  for (const itk::ThreadIdType numberOfThreads : { 1, 2, 8 })
+  {
+    pool->SetNumberOfThreads(numberOfThreads);
+
+    for (const unsigned int numberOfWorkUnits : { 1, 3, 16 })
+    {
+      WorkUnitCounts counts(numberOfWorkUnits);
+      pool->SingleMethodExecute(numberOfWorkUnits, CountWorkUnit, &counts);
+
+      EXPECT_EQ(counts.m_WrongNumberOfWorkUnits, 0U);
+      for (const auto & count : counts.m_Counts)
+      {
+        ASSERT_EQ(count, 1U);
+      }
+    }
+  }
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, RethrowsExceptionInCallingThread)
+{
+  const auto pool = WorkStealingThreadPool::New();
+  pool->SetNumberOfThreads(4);
+
+  EXPECT_THROW(pool->ParallelFor(100,
+                                 1,
+                                 [](itk::ThreadIdType, itk::SizeValueType begin, itk::SizeValueType) {
+                                   if (begin == 42)
+                                   {
+                                     throw std::runtime_error("expected");
+                                   }
+                                 }),
+               std::runtime_error);
+
+  // The pool remains usable after an exception.
+  std::atomic<itk::SizeValueType> sum{ 0 };
+  pool->ParallelFor(100, 0, [&sum](itk::ThreadIdType, itk::SizeValueType begin, itk::SizeValueType end) {
+    for (auto i = begin; i < end; ++i)
+    {
+      sum += i;
+    }
+  });
+  EXPECT_EQ(sum, 4950U);
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, NestedParallelForRunsSerially)
+{
+  const auto pool = WorkStealingThreadPool::New();
+  pool->SetNumberOfThreads(4);
+
+  std::atomic<itk::SizeValueType> count{ 0 };
+  pool->ParallelFor(8, 1, [&](itk::ThreadIdType, itk::SizeValueType, itk::SizeValueType) {
+    pool->ParallelFor(10, 1, [&count](itk::ThreadIdType, itk::SizeValueType begin, itk::SizeValueType end) {
+      count += end - begin;
+    });
+  });
+  EXPECT_EQ(count, 80U);
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, NestedParallelForRunsSeriallyAfterJobOfOtherPool)
+{
+  const auto pool = WorkStealingThreadPool::New();
+  const auto otherPool = WorkStealingThreadPool::New();
+  pool->SetNumberOfThreads(4);
+  otherPool->SetNumberOfThreads(2);
+
+  // A job of the other pool, within a job of the pool, must not clear the marker of the outer job:
+  // the nested call that follows is still executed serially, by the same thread.
+  std::atomic<itk::SizeValueType> count{ 0 };
+  std::atomic<unsigned int>       wrongThreadIds{ 0 };
+  pool->ParallelFor(8, 1, [&](const itk::ThreadIdType threadId, itk::SizeValueType, itk::SizeValueType) {
+    otherPool->ParallelFor(4, 1, [](itk::ThreadIdType, itk::SizeValueType, itk::SizeValueType) {});
+    pool->ParallelFor(
+      10, 1, [&](const itk::ThreadIdType nestedThreadId, itk::SizeValueType begin, itk::SizeValueType end) {
+        count += end - begin;
+        if (nestedThreadId != threadId)
+        {
+          ++wrongThreadIds;
+        }
+      });
+  });
+  EXPECT_EQ(count, 80U);
+  EXPECT_EQ(wrongThreadIds, 0U);
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, GlobalThreadPoolIsCreatedOnce)
+{
+  WorkStealingThreadPool * const pool = WorkStealingThreadPool::GetGlobalThreadPool();
+  ASSERT_NE(pool, nullptr);
+  EXPECT_EQ(WorkStealingThreadPool::GetGlobalThreadPool(), pool);
+  EXPECT_GE(pool->GetNumberOfThreads(), 1U);
+}
+
+
+GTEST_TEST(WorkStealingThreadPool, SubmitRunsTaskNextToParallelFor)
+{
+  const auto pool = WorkStealingThreadPool::New();
+
+  for (const itk::ThreadIdType numberOfThreads : { 1, 2, 4 })
+  {
+    pool->SetNumberOfThreads(numberOfThreads);
+
+    std::atomic<itk::SizeValueType> taskSum{ 0 };
+
+    auto future = pool->Submit([&taskSum] {
+      for (itk::SizeValueType i = 0; i < 1000; ++i)
+      {
+        taskSum += i;
+      }
+    });
+
+    std::atomic<itk::SizeValueType> sum{ 0 };
+    pool->ParallelFor(100, 1, [&sum](itk::ThreadIdType, itk::SizeValueType begin, itk::SizeValueType end) {
+      for (auto i = begin; i < end; ++i)
+      {
+        sum += i;
+      }
+    });
+
+    future.get();
+    EXPECT_EQ(taskSum, 499500U);
+    EXPECT_EQ(sum, 4950U);
+  }
+
+  // An exception thrown by a task is rethrown by the future.
+  pool->SetNumberOfThreads(2);
+  auto future = pool->Submit([] { throw std::runtime_error("expected"); });
+  EXPECT_THROW(future.get(), std::runtime_error);
+}
@@ -42,7 +42,7 @@ ImageFullSampler<TInputImage>::GenerateData(void)
 
   /** Get handles to the input image, output sample container, and the mask. */
   InputImageConstPointer                     inputImage = this->GetInput();
-  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetSampleContainerToFill();
   typename MaskType::ConstPointer            mask = this->GetMask();
 
   /** Clear the container. */
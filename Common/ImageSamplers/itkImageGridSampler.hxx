@@ -65,7 +65,7 @@ ImageGridSampler<TInputImage>::GenerateData(void)
 {
   /** Get handles to the input image, output sample container, and the mask. */
   InputImageConstPointer                     inputImage = this->GetInput();
-  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetSampleContainerToFill();
   typename MaskType::ConstPointer            mask = this->GetMask();
 
   /** Clear the container. */
@@ -0,0 +1,191 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageImportanceRandomSampler_h
+#define itkImageImportanceRandomSampler_h
+
+#include "itkImageRandomSamplerBase.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTimeStamp.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace itk
+{
+/** \class ImageImportanceRandomSampler
+ *
+ * \brief Samples randomly some voxels of an image, with a probability
+ * proportional to an importance image.
+ *
+ * Uniformly drawn samples in large homogeneous regions contribute almost
+ * nothing to the derivative of a similarity metric. This sampler draws the
+ * voxels of the cropped input image region (and mask) with a probability
+ * proportional to the importance of the voxel: by default the gradient
+ * magnitude of the input image, or else a user-supplied weight image,
+ * evaluated at the nearest voxel. To keep every voxel reachable, a fraction
+ * of the probability mass is distributed uniformly, see SetUniformFraction().
+ *
+ * Every sample gets the importance weight w = 1 / ( N p ), with N the number
+ * of voxels and p the probability of the voxel, see GetSampleWeights(). The
+ * mean of the weighted sample values over the sample set is therefore an
+ * unbiased estimate of the mean over all voxels, as with uniform sampling.
+ * Metrics multiply the contribution of every sample by its weight; metrics
+ * that do not support the weights refuse this sampler.
+ *
+ * The distribution is stored as an alias table (Walker, Vose), so a sample
+ * is drawn in constant time. The table takes 24 bytes per voxel, and holds at
+ * most 2^32 voxels. It is rebuilt when the input image, the mask, the weight
+ * image or the input image region changes, so once per resolution level in a
+ * registration.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template <class TInputImage>
+class ImageImportanceRandomSampler : public ImageRandomSamplerBase<TInputImage>
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef ImageImportanceRandomSampler        Self;
+  typedef ImageRandomSamplerBase<TInputImage> Superclass;
+  typedef SmartPointer<Self>                  Pointer;
+  typedef SmartPointer<const Self>            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageImportanceRandomSampler, ImageRandomSamplerBase);
+
+  /** Typedefs inherited from the superclass. */
+  typedef typename Superclass::DataObjectPointer            DataObjectPointer;
+  typedef typename Superclass::OutputVectorContainerType    OutputVectorContainerType;
+  typedef typename Superclass::OutputVectorContainerPointer OutputVectorContainerPointer;
+  typedef typename Superclass::InputImageType               InputImageType;
+  typedef typename Superclass::InputImagePointer            InputImagePointer;
+  typedef typename Superclass::InputImageConstPointer       InputImageConstPointer;
+  typedef typename Superclass::InputImageRegionType         InputImageRegionType;
+  typedef typename Superclass::InputImagePixelType          InputImagePixelType;
+  typedef typename Superclass::ImageSampleType              ImageSampleType;
+  typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
+  typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
+  typedef typename Superclass::MaskType                     MaskType;
+  typedef typename Superclass::InputImageIndexType          InputImageIndexType;
+  typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
+  typedef typename Superclass::SampleWeightContainerType    SampleWeightContainerType;
+
+  /** The input image dimension. */
+  itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
+
+  /** Other typdefs. */
+  typedef typename InputImageType::PointType InputImagePointType;
+
+  /** The type of the importance image. */
+  typedef Image<float, itkGetStaticConstMacro(InputImageDimension)> WeightImageType;
+  typedef typename WeightImageType::ConstPointer                     WeightImageConstPointer;
+
+  /** The random number generator used to generate random indices. */
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+  typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+  typedef typename Superclass::CounterBasedRandomGeneratorType   CounterBasedRandomGeneratorType;
+  typedef typename Superclass::RandomSeedType                    RandomSeedType;
+
+  /** Set/Get the image giving the importance of every voxel. Negative values are
+   * treated as zero. When no weight image is set, the gradient magnitude of the
+   * input image is used.
+   */
+  itkSetConstObjectMacro(WeightImage, WeightImageType);
+  itkGetConstObjectMacro(WeightImage, WeightImageType);
+
+  /** Set/Get the fraction of the probability mass that is distributed uniformly
+   * over the voxels. It bounds the importance weights by 1 / UniformFraction.
+   * Default: 0.1.
+   */
+  itkSetClampMacro(UniformFraction, double, 0.0, 1.0);
+  itkGetConstMacro(UniformFraction, double);
+
+  /** Every sample has an importance weight. */
+  bool
+  HasSampleWeights(void) const override
+  {
+    return true;
+  }
+
+protected:
+  /** A voxel of the distribution, which is also a column of the alias table.
+   * The offset is relative to the start of the input image region. The column
+   * selects its own voxel when a uniform variate is below the threshold, and
+   * the voxel m_Alias otherwise. The probability of the voxel times the number
+   * of voxels, q = N p, gives the importance weight 1 / q.
+   */
+  struct DistributionEntryType
+  {
+    SizeValueType m_Offset;
+    std::uint32_t m_Alias;
+    float         m_Threshold;
+    float         m_Probability;
+  };
+
+  /** The constructor. */
+  ImageImportanceRandomSampler();
+  /** The destructor. */
+  ~ImageImportanceRandomSampler() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+  /** Function that does the work. */
+  void
+  GenerateData(void) override;
+
+  /** Build the alias table, if the inputs changed since it was built. */
+  void
+  UpdateDistribution(void);
+
+  /** Construct the sample drawn from the given column of the alias table, with a
+   * uniform variate in [0, 1), and its importance weight.
+   */
+  void
+  GetDistributionSample(SizeValueType column, double variate, ImageSampleType & sample, float & weight) const;
+
+  RandomGeneratorPointer m_RandomGenerator;
+
+  std::vector<DistributionEntryType> m_Distribution;
+  InputImageRegionType               m_DistributionRegion;
+  double                             m_DistributionUniformFraction;
+  TimeStamp                          m_DistributionTime;
+
+private:
+  /** The deleted copy constructor. */
+  ImageImportanceRandomSampler(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+
+  WeightImageConstPointer m_WeightImage;
+  double                  m_UniformFraction;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkImageImportanceRandomSampler.hxx"
+#endif
+
+#endif // end #ifndef itkImageImportanceRandomSampler_h
@@ -0,0 +1,382 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageImportanceRandomSampler_hxx
+#define itkImageImportanceRandomSampler_hxx
+
+#include "itkImageImportanceRandomSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace itk
+{
+
+/**
+ * ******************* Constructor *******************
+ */
+
+template <class TInputImage>
+ImageImportanceRandomSampler<TInputImage>::ImageImportanceRandomSampler()
+{
+  /** Setup random generator. */
+  this->m_RandomGenerator = RandomGeneratorType::GetInstance();
+
+  this->m_UniformFraction = 0.1;
+  this->m_DistributionUniformFraction = 0.0;
+
+} // end Constructor
+
+
+/**
+ * ******************* GenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceRandomSampler<TInputImage>::GenerateData(void)
+{
+  /** Get a handle to the output sample container and the sample weights. */
+  ImageSampleContainerPointer sampleContainer = this->GetSampleContainerToFill();
+  SampleWeightContainerType & sampleWeights = this->GetSampleWeightsToFill();
+
+  /** Clear the container. */
+  sampleContainer->Initialize();
+  sampleWeights.clear();
+
+  /** Make sure the alias table is up-to-date. */
+  this->UpdateAllMasks();
+  this->UpdateDistribution();
+
+  const SizeValueType numberOfColumns = this->m_Distribution.size();
+  const SizeValueType numberOfSamples = this->GetNumberOfSamples();
+  sampleContainer->Reserve(numberOfSamples);
+  sampleWeights.resize(numberOfSamples);
+
+  /** With the counter-based random number generator, every sample is drawn from its own
+   * random stream, so all samples are drawn in parallel. All voxels of the distribution
+   * are inside the mask, so no sample is rejected.
+   */
+  if (this->GetUseCounterBasedRandomGenerator())
+  {
+    const RandomSeedType seed = this->GetRandomSeed();
+    const SizeValueType  sampleSetIndex = this->GetSampleSetIndex();
+    auto drawSamples = [&](ThreadIdType, SizeValueType first, SizeValueType last) {
+      for (SizeValueType i = first; i < last; ++i)
+      {
+        CounterBasedRandomGeneratorType generator(seed, sampleSetIndex, i);
+        const auto                      column = generator.GetIntegerVariate(numberOfColumns - 1);
+        const double                    variate = generator.GetUniformVariate();
+        this->GetDistributionSample(
+          static_cast<SizeValueType>(column), variate, sampleContainer->ElementAt(i), sampleWeights[i]);
+      }
+    };
+    if (this->m_UseMultiThread && this->m_ThreadPool.IsNotNull())
+    {
+      this->m_ThreadPool->ParallelFor(numberOfSamples, 0, drawSamples);
+    }
+    else
+    {
+      drawSamples(0, 0, numberOfSamples);
+    }
+
+    /** The next sample set uses other random streams. */
+    this->IncrementSampleSetIndex();
+    return;
+  }
+
+  /** Draw the samples from the alias table. Drawing is cheap, so this is not multi-threaded. */
+  for (SizeValueType i = 0; i < numberOfSamples; ++i)
+  {
+    const unsigned long column = this->m_RandomGenerator->GetIntegerVariate(numberOfColumns - 1);
+    const double        variate = this->m_RandomGenerator->GetVariateWithOpenUpperRange();
+    this->GetDistributionSample(column, variate, sampleContainer->ElementAt(i), sampleWeights[i]);
+  }
+
+} // end GenerateData()
+
+
+/**
+ * ******************* UpdateDistribution *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceRandomSampler<TInputImage>::UpdateDistribution(void)
+{
+  /** Only rebuild when the image, the mask, the weight image or the region changed. */
+  InputImageConstPointer       inputImage = this->GetInput();
+  const MaskType *             mask = this->GetMask();
+  const WeightImageType *      weightImage = this->m_WeightImage.GetPointer();
+  const InputImageRegionType & region = this->GetCroppedInputImageRegion();
+  ModifiedTimeType             inputsMTime = inputImage->GetMTime();
+  if (mask != nullptr)
+  {
+    inputsMTime = std::max(inputsMTime, mask->GetMTime());
+  }
+  if (weightImage != nullptr)
+  {
+    inputsMTime = std::max(inputsMTime, weightImage->GetMTime());
+  }
+  if (region == this->m_DistributionRegion && this->m_UniformFraction == this->m_DistributionUniformFraction &&
+      this->m_DistributionTime.GetMTime() > inputsMTime)
+  {
+    return;
+  }
+
+  /** The gradient magnitude of the input image, by central differences, or one-sided
+   * differences at the border of the buffered region.
+   */
+  const InputImageRegionType & bufferedRegion = inputImage->GetBufferedRegion();
+  const auto &                 spacing = inputImage->GetSpacing();
+
+  auto computeGradientMagnitude = [&](const InputImageIndexType & index) {
+    double squaredMagnitude = 0.0;
+    for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+    {
+      InputImageIndexType lower = index;
+      InputImageIndexType upper = index;
+      if (index[dim] > bufferedRegion.GetIndex()[dim])
+      {
+        --lower[dim];
+      }
+      if (index[dim] < bufferedRegion.GetUpperIndex()[dim])
+      {
+        ++upper[dim];
+      }
+      if (upper[dim] > lower[dim])
+      {
+        const double derivative =
+          (static_cast<double>(inputImage->GetPixel(upper)) - static_cast<double>(inputImage->GetPixel(lower))) /
+          (static_cast<double>(upper[dim] - lower[dim]) * spacing[dim]);
+        squaredMagnitude += derivative * derivative;
+      }
+    }
+    return std::sqrt(squaredMagnitude);
+  };
+
+  /** Scan the rows along the first dimension in chunks, in parallel, collecting the
+   * voxels inside the mask. In every chunk, m_Probability temporarily holds the importance.
+   */
+  const SizeValueType rowLength = region.GetSize()[0];
+  const SizeValueType numberOfRows = region.GetNumberOfPixels() / std::max<SizeValueType>(rowLength, 1);
+  const SizeValueType numberOfChunks = std::min<SizeValueType>(numberOfRows, 256);
+  std::vector<std::vector<DistributionEntryType>> chunkEntries(numberOfChunks);
+
+  auto scanChunk = [&](SizeValueType chunk) {
+    const SizeValueType firstRow = (numberOfRows * chunk) / numberOfChunks;
+    const SizeValueType lastRow = (numberOfRows * (chunk + 1)) / numberOfChunks;
+    std::vector<DistributionEntryType> & entries = chunkEntries[chunk];
+    InputImagePointType                  point;
+    for (SizeValueType row = firstRow; row < lastRow; ++row)
+    {
+      /** The index of the first voxel of the row. */
+      InputImageIndexType index = region.GetIndex();
+      SizeValueType       residual = row;
+      for (unsigned int dim = 1; dim < InputImageDimension; ++dim)
+      {
+        index[dim] += static_cast<IndexValueType>(residual % region.GetSize()[dim]);
+        residual /= region.GetSize()[dim];
+      }
+
+      for (SizeValueType x = 0; x < rowLength; ++x)
+      {
+        index[0] = region.GetIndex()[0] + static_cast<IndexValueType>(x);
+        inputImage->TransformIndexToPhysicalPoint(index, point);
+        if (mask != nullptr && !mask->IsInsideInWorldSpace(point))
+        {
+          continue;
+        }
+
+        double importance = 0.0;
+        if (weightImage == nullptr)
+        {
+          importance = computeGradientMagnitude(index);
+        }
+        else
+        {
+          typename WeightImageType::IndexType weightIndex;
+          if (weightImage->TransformPhysicalPointToIndex(point, weightIndex) &&
+              weightImage->GetBufferedRegion().IsInside(weightIndex))
+          {
+            importance = static_cast<double>(weightImage->GetPixel(weightIndex));
+          }
+        }
+
+        /** Negative and NaN importances become zero. */
+        entries.push_back({ row * rowLength + x, 0, 0.0f, importance > 0.0 ? static_cast<float>(importance) : 0.0f });
+      }
+    }
+  };
+
+  if (this->m_UseMultiThread && this->m_ThreadPool.IsNotNull())
+  {
+    const auto scanChunks = [&scanChunk](ThreadIdType, SizeValueType first, SizeValueType last) {
+      for (SizeValueType chunk = first; chunk < last; ++chunk)
+      {
+        scanChunk(chunk);
+      }
+    };
+    this->m_ThreadPool->ParallelFor(numberOfChunks, 1, scanChunks);
+  }
+  else
+  {
+    MultiThreaderBase * threader = this->GetMultiThreader();
+    threader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    threader->ParallelizeArray(0, numberOfChunks, scanChunk, nullptr);
+  }
+
+  /** Concatenate the chunks. */
+  SizeValueType numberOfVoxels = 0;
+  for (const auto & entries : chunkEntries)
+  {
+    numberOfVoxels += entries.size();
+  }
+  this->m_Distribution.clear();
+  this->m_Distribution.shrink_to_fit();
+  this->m_Distribution.reserve(numberOfVoxels);
+  double totalImportance = 0.0;
+  for (auto & entries : chunkEntries)
+  {
+    for (const DistributionEntryType & entry : entries)
+    {
+      this->m_Distribution.push_back(entry);
+      totalImportance += entry.m_Probability;
+    }
+    std::vector<DistributionEntryType>().swap(entries);
+  }
+
+  if (numberOfVoxels == 0)
+  {
+    itkExceptionMacro(<< "ERROR: the mask does not contain any voxel of the input image region.");
+  }
+  if (numberOfVoxels - 1 > std::numeric_limits<std::uint32_t>::max())
+  {
+    itkExceptionMacro(<< "ERROR: the distribution has " << numberOfVoxels << " voxels, more than the "
+                      << "alias table supports. Use a mask or a coarser image.");
+  }
+
+  /** The probabilities times the number of voxels, q = N p. A homogeneous importance
+   * image gives a uniform distribution. The alias table is built in double precision.
+   */
+  const double uniformFraction = totalImportance > 0.0 ? this->m_UniformFraction : 1.0;
+  const double importanceFactor =
+    totalImportance > 0.0 ? (1.0 - uniformFraction) * static_cast<double>(numberOfVoxels) / totalImportance : 0.0;
+  std::vector<double>        thresholds(numberOfVoxels);
+  std::vector<std::uint32_t> small;
+  std::vector<std::uint32_t> large;
+  for (SizeValueType i = 0; i < numberOfVoxels; ++i)
+  {
+    DistributionEntryType & entry = this->m_Distribution[i];
+    thresholds[i] = importanceFactor * entry.m_Probability + uniformFraction;
+    entry.m_Probability = static_cast<float>(thresholds[i]);
+    entry.m_Alias = static_cast<std::uint32_t>(i);
+    (thresholds[i] < 1.0 ? small : large).push_back(static_cast<std::uint32_t>(i));
+  }
+
+  /** Vose's method: pair every column that has too little probability with one that has too much. */
+  while (!small.empty() && !large.empty())
+  {
+    const std::uint32_t lessProbable = small.back();
+    const std::uint32_t moreProbable = large.back();
+    small.pop_back();
+    large.pop_back();
+
+    this->m_Distribution[lessProbable].m_Alias = moreProbable;
+    double & remainder = thresholds[moreProbable];
+    remainder = (remainder + thresholds[lessProbable]) - 1.0;
+    (remainder < 1.0 ? small : large).push_back(moreProbable);
+  }
+
+  /** The columns that are left are full, up to rounding errors. */
+  for (const std::uint32_t i : small)
+  {
+    thresholds[i] = 1.0;
+  }
+  for (const std::uint32_t i : large)
+  {
+    thresholds[i] = 1.0;
+  }
+  for (SizeValueType i = 0; i < numberOfVoxels; ++i)
+  {
+    this->m_Distribution[i].m_Threshold = static_cast<float>(thresholds[i]);
+  }
+
+  this->m_DistributionRegion = region;
+  this->m_DistributionUniformFraction = this->m_UniformFraction;
+  this->m_DistributionTime.Modified();
+
+} // end UpdateDistribution()
+
+
+/**
+ * ******************* GetDistributionSample *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceRandomSampler<TInputImage>::GetDistributionSample(const SizeValueType column,
+                                                                 const double        variate,
+                                                                 ImageSampleType &   sample,
+                                                                 float &             weight) const
+{
+  /** Select the voxel of the column, or its alias. */
+  const DistributionEntryType & columnEntry = this->m_Distribution[column];
+  const DistributionEntryType & entry =
+    variate < columnEntry.m_Threshold ? columnEntry : this->m_Distribution[columnEntry.m_Alias];
+
+  /** Translate the offset to an index. */
+  const InputImageRegionType & region = this->m_DistributionRegion;
+  SizeValueType                offset = entry.m_Offset;
+  InputImageIndexType          index;
+  for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+  {
+    index[dim] = region.GetIndex()[dim] + static_cast<IndexValueType>(offset % region.GetSize()[dim]);
+    offset /= region.GetSize()[dim];
+  }
+
+  /** Construct the sample. A voxel with zero probability is never drawn. */
+  const InputImageType * inputImage = this->GetInput();
+  inputImage->TransformIndexToPhysicalPoint(index, sample.m_ImageCoordinates);
+  sample.m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(index));
+  weight = entry.m_Probability > 0.0f ? 1.0f / entry.m_Probability : 0.0f;
+
+} // end GetDistributionSample()
+
+
+/**
+ * ******************* PrintSelf *******************
+ */
+
+template <class TInputImage>
+void
+ImageImportanceRandomSampler<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
+  os << indent << "WeightImage: " << this->m_WeightImage.GetPointer() << std::endl;
+  os << indent << "UniformFraction: " << this->m_UniformFraction << std::endl;
+  os << indent << "NumberOfDistributionVoxels: " << this->m_Distribution.size() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkImageImportanceRandomSampler_hxx
@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageQuasiRandomCoordinateSampler_h
+#define itkImageQuasiRandomCoordinateSampler_h
+
+#include "itkImageRandomCoordinateSampler.h"
+#include "itkScrambledSobolSequence.h"
+
+namespace itk
+{
+
+/** \class ImageQuasiRandomCoordinateSampler
+ *
+ * \brief Samples an image at quasi-random physical coordinates.
+ *
+ * Like the ImageRandomCoordinateSampler, this sampler selects points in
+ * physical space, in the (random) sample region, and within the mask. The
+ * points are taken from a scrambled Sobol sequence instead of being drawn
+ * independently. They cover the sample region more evenly, which reduces the
+ * variance of the metric and its derivative for a given number of samples.
+ *
+ * Every sample set uses a differently scrambled sequence, so the sample sets
+ * are as random as those of the ImageRandomCoordinateSampler, and each point
+ * is uniformly distributed. Points outside the mask are skipped, taking the
+ * next points of the sequence. The samples do not depend on the number of
+ * threads.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template <class TInputImage>
+class ImageQuasiRandomCoordinateSampler : public ImageRandomCoordinateSampler<TInputImage>
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef ImageQuasiRandomCoordinateSampler         Self;
+  typedef ImageRandomCoordinateSampler<TInputImage> Superclass;
+  typedef SmartPointer<Self>                        Pointer;
+  typedef SmartPointer<const Self>                  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageQuasiRandomCoordinateSampler, ImageRandomCoordinateSampler);
+
+  /** Typedefs inherited from the superclass. */
+  typedef typename Superclass::DataObjectPointer               DataObjectPointer;
+  typedef typename Superclass::OutputVectorContainerType       OutputVectorContainerType;
+  typedef typename Superclass::OutputVectorContainerPointer    OutputVectorContainerPointer;
+  typedef typename Superclass::InputImageType                  InputImageType;
+  typedef typename Superclass::InputImagePointer               InputImagePointer;
+  typedef typename Superclass::InputImageConstPointer          InputImageConstPointer;
+  typedef typename Superclass::InputImageRegionType            InputImageRegionType;
+  typedef typename Superclass::InputImagePixelType             InputImagePixelType;
+  typedef typename Superclass::ImageSampleType                 ImageSampleType;
+  typedef typename Superclass::ImageSampleContainerType        ImageSampleContainerType;
+  typedef typename Superclass::ImageSampleContainerPointer     ImageSampleContainerPointer;
+  typedef typename Superclass::MaskType                        MaskType;
+  typedef typename Superclass::InputImageSizeType              InputImageSizeType;
+  typedef typename Superclass::InputImageSpacingType           InputImageSpacingType;
+  typedef typename Superclass::InputImageIndexType             InputImageIndexType;
+  typedef typename Superclass::InputImagePointType             InputImagePointType;
+  typedef typename Superclass::InputImagePointValueType        InputImagePointValueType;
+  typedef typename Superclass::ImageSampleValueType            ImageSampleValueType;
+  typedef typename Superclass::CoordRepType                    CoordRepType;
+  typedef typename Superclass::InterpolatorType                InterpolatorType;
+  typedef typename Superclass::DefaultInterpolatorType         DefaultInterpolatorType;
+  typedef typename Superclass::CounterBasedRandomGeneratorType CounterBasedRandomGeneratorType;
+
+  /** The input image dimension. */
+  itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
+
+  /** The quasi-random sequence. */
+  typedef ScrambledSobolSequence QuasiRandomSequenceType;
+
+protected:
+  typedef typename Superclass::InputImageContinuousIndexType InputImageContinuousIndexType;
+
+  /** The constructor. */
+  ImageQuasiRandomCoordinateSampler() = default;
+  /** The destructor. */
+  ~ImageQuasiRandomCoordinateSampler() override = default;
+
+  /** Function that does the work. */
+  void
+  GenerateData(void) override;
+
+  /** Generate the sample of the point with the given index of the scrambled sequence.
+   * Returns false when the point is outside the mask. Thread-safe.
+   */
+  bool
+  GenerateQuasiRandomSample(QuasiRandomSequenceType::WordType index,
+                            QuasiRandomSequenceType::WordType seed,
+                            ImageSampleType &                 sample) const;
+
+private:
+  /** The deleted copy constructor. */
+  ImageQuasiRandomCoordinateSampler(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkImageQuasiRandomCoordinateSampler.hxx"
+#endif
+
+#endif // end #ifndef itkImageQuasiRandomCoordinateSampler_h
@@ -0,0 +1,195 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageQuasiRandomCoordinateSampler_hxx
+#define itkImageQuasiRandomCoordinateSampler_hxx
+
+#include "itkImageQuasiRandomCoordinateSampler.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * ******************* GenerateData *******************
+ */
+
+template <class TInputImage>
+void
+ImageQuasiRandomCoordinateSampler<TInputImage>::GenerateData(void)
+{
+  typedef QuasiRandomSequenceType::WordType WordType;
+
+  /** Get a handle to the output sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetSampleContainerToFill();
+  const SizeValueType         numberOfSamples = this->GetNumberOfSamples();
+  sampleContainer->Initialize();
+
+  /** Update the masks, set up the interpolator and select the sample region. */
+  this->UpdateAllMasks();
+  this->BeforeGenerateCandidateSamples();
+
+  /** Select the scrambling of the sequence for this sample set. */
+  WordType seed = 0;
+  if (this->GetUseCounterBasedRandomGenerator())
+  {
+    /** The second to last sub-stream, the last one is used for the sample region. */
+    CounterBasedRandomGeneratorType generator(
+      this->GetRandomSeed(),
+      this->GetSampleSetIndex(),
+      NumericTraits<CounterBasedRandomGeneratorType::IdentifierType>::max() - 1);
+    seed = generator.GetNextWord();
+    this->IncrementSampleSetIndex();
+  }
+  else
+  {
+    seed = static_cast<WordType>(this->m_RandomGenerator->GetIntegerVariate(NumericTraits<WordType>::max()));
+  }
+
+  /** Call the function for every index in [0, n[, on the thread pool if there is one. */
+  auto forEachIndex = [this](const SizeValueType n, const std::function<void(SizeValueType)> & function) {
+    if (!this->m_UseMultiThread)
+    {
+      for (SizeValueType i = 0; i < n; ++i)
+      {
+        function(i);
+      }
+    }
+    else if (this->m_ThreadPool.IsNotNull())
+    {
+      this->m_ThreadPool->ParallelFor(n, 0, [&function](ThreadIdType, SizeValueType first, SizeValueType last) {
+        for (SizeValueType i = first; i < last; ++i)
+        {
+          function(i);
+        }
+      });
+    }
+    else
+    {
+      MultiThreaderBase * threader = this->GetMultiThreader();
+      threader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+      threader->ParallelizeArray(0, n, function, nullptr);
+    }
+  };
+
+  /** Without a mask, the samples are simply the first points of the sequence. */
+  if (this->GetMask() == nullptr)
+  {
+    sampleContainer->Reserve(numberOfSamples);
+    forEachIndex(numberOfSamples, [this, seed, &sampleContainer](SizeValueType i) {
+      this->GenerateQuasiRandomSample(static_cast<WordType>(i), seed, sampleContainer->ElementAt(i));
+    });
+    return;
+  }
+
+  /** With a mask, take the first points of the sequence that are inside the mask. The
+   * candidates are generated in rounds, of a size estimated from the fraction accepted
+   * so far. Make sure we are not eternally trying to find samples.
+   */
+  const SizeValueType          maximumNumberOfSamplesToTry = 10 * numberOfSamples;
+  SizeValueType                numberOfSamplesTried = 0;
+  std::vector<ImageSampleType> candidates;
+  std::vector<unsigned char>   accepted;
+  sampleContainer->reserve(numberOfSamples);
+  while (sampleContainer->Size() < numberOfSamples)
+  {
+    if (numberOfSamplesTried >= maximumNumberOfSamplesToTry)
+    {
+      sampleContainer->Initialize();
+      itkExceptionMacro(<< "Could not find enough image samples within "
+                        << "reasonable time. Probably the mask is too small");
+    }
+
+    const SizeValueType numberOfSamplesLeft = numberOfSamples - sampleContainer->Size();
+    SizeValueType       numberOfCandidates = numberOfSamplesLeft;
+    if (numberOfSamplesTried > 0)
+    {
+      const double acceptedFraction =
+        std::max(static_cast<double>(sampleContainer->Size()) / static_cast<double>(numberOfSamplesTried), 0.01);
+      numberOfCandidates = static_cast<SizeValueType>(1.1 * numberOfSamplesLeft / acceptedFraction) + 64;
+    }
+    numberOfCandidates = std::min(numberOfCandidates, maximumNumberOfSamplesToTry - numberOfSamplesTried);
+
+    candidates.resize(numberOfCandidates);
+    accepted.resize(numberOfCandidates);
+    forEachIndex(numberOfCandidates, [&](SizeValueType i) {
+      const auto index = static_cast<WordType>(numberOfSamplesTried + i);
+      accepted[i] = this->GenerateQuasiRandomSample(index, seed, candidates[i]);
+    });
+
+    /** Keep the accepted candidates, in the order of the sequence. */
+    for (SizeValueType i = 0; i < numberOfCandidates && sampleContainer->Size() < numberOfSamples; ++i)
+    {
+      if (accepted[i])
+      {
+        sampleContainer->push_back(candidates[i]);
+      }
+    }
+    numberOfSamplesTried += numberOfCandidates;
+  }
+
+} // end GenerateData()
+
+
+/**
+ * ******************* GenerateQuasiRandomSample *******************
+ */
+
+template <class TInputImage>
+bool
+ImageQuasiRandomCoordinateSampler<TInputImage>::GenerateQuasiRandomSample(
+  const QuasiRandomSequenceType::WordType index,
+  const QuasiRandomSequenceType::WordType seed,
+  ImageSampleType &                       sample) const
+{
+  static_assert(InputImageDimension <= QuasiRandomSequenceType::MaximumDimension,
+                "The quasi-random sequence does not support this image dimension.");
+
+  /** Map the point of the sequence to the sample region. */
+  double point[InputImageDimension];
+  QuasiRandomSequenceType::GetPoint(index, seed, InputImageDimension, point);
+  InputImageContinuousIndexType sampleContIndex;
+  for (unsigned int i = 0; i < InputImageDimension; ++i)
+  {
+    const double smallest = this->m_SmallestSampleContIndex[i];
+    const double largest = this->m_LargestSampleContIndex[i];
+    sampleContIndex[i] = static_cast<InputImagePointValueType>(smallest + (largest - smallest) * point[i]);
+  }
+  this->GetInput()->TransformContinuousIndexToPhysicalPoint(sampleContIndex, sample.m_ImageCoordinates);
+
+  /** Check if it's inside the mask. */
+  const MaskType * mask = this->GetMask();
+  if (mask != nullptr && (!this->m_Interpolator->IsInsideBuffer(sampleContIndex) ||
+                          !mask->IsInsideInWorldSpace(sample.m_ImageCoordinates)))
+  {
+    return false;
+  }
+
+  /** Compute the value at the continuous index. */
+  sample.m_ImageValue =
+    static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleContIndex));
+  return true;
+
+} // end GenerateQuasiRandomSample()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkImageQuasiRandomCoordinateSampler_hxx
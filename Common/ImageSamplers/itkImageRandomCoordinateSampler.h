@@ -85,6 +85,7 @@ public:
   /** The random number generator used to generate random coordinates. */
   typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
   typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+  typedef typename Superclass::CounterBasedRandomGeneratorType   CounterBasedRandomGeneratorType;
 
   /** Set/Get the interpolator. A 3rd order B-spline interpolator is used by default. */
   itkSetObjectMacro(Interpolator, InterpolatorType);
@@ -123,16 +124,35 @@ protected:
   void
   ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
 
+  /** Set up the interpolator and the sample region, for the counter-based random number generator. */
+  void
+  BeforeGenerateCandidateSamples(void) override;
+
+  /** Draw a random point, which is rejected when outside the mask. */
+  bool
+  GenerateCandidateSample(CounterBasedRandomGeneratorType & generator, ImageSampleType & sample) override;
+
   /** Generate a point randomly in a bounding box. */
   virtual void
   GenerateRandomCoordinate(const InputImageContinuousIndexType & smallestContIndex,
                            const InputImageContinuousIndexType & largestContIndex,
                            InputImageContinuousIndexType &       randomContIndex);
 
+  /** Generate a point randomly in a bounding box, with the counter-based random number generator. */
+  void
+  GenerateRandomCoordinate(CounterBasedRandomGeneratorType &     generator,
+                           const InputImageContinuousIndexType & smallestContIndex,
+                           const InputImageContinuousIndexType & largestContIndex,
+                           InputImageContinuousIndexType &       randomContIndex) const;
+
   InterpolatorPointer    m_Interpolator;
   RandomGeneratorPointer m_RandomGenerator;
   InputImageSpacingType  m_SampleRegionSize;
 
+  /** The sample region of the current sample set, for the counter-based random number generator. */
+  InputImageContinuousIndexType m_SmallestSampleContIndex;
+  InputImageContinuousIndexType m_LargestSampleContIndex;
+
   /** Generate the two corners of a sampling region, given the two corners
    * of an image. If UseRandomSampleRegion=false, the smallesPoint and largestPoint
    * are just copies of the smallestImagePoint and largestImagePoint
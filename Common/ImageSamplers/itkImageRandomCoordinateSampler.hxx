@@ -53,6 +53,12 @@ template <class TInputImage>
 void
 ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
 {
+  /** With the counter-based random number generator, all samples are generated in parallel. */
+  if (this->GetUseCounterBasedRandomGenerator())
+  {
+    return this->GenerateDataWithCounterBasedRandomGenerator();
+  }
+
   /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
   typename MaskType::ConstPointer mask = this->GetMask();
   if (mask.IsNull() && this->m_UseMultiThread)
@@ -63,7 +69,7 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
 
   /** Get handles to the input image, output sample container, and interpolator. */
   InputImageConstPointer                     inputImage = this->GetInput();
-  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetSampleContainerToFill();
   typename InterpolatorType::Pointer         interpolator = this->GetModifiableInterpolator();
 
   /** Set up the interpolator. */
@@ -267,6 +273,61 @@ ImageRandomCoordinateSampler<TInputImage>::ThreadedGenerateData(const InputImage
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* BeforeGenerateCandidateSamples *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::BeforeGenerateCandidateSamples(void)
+{
+  /** Set up the interpolator. */
+  this->m_Interpolator->SetInputImage(this->GetInput());
+
+  /** Convert inputImageRegion to bounding box in physical space. */
+  InputImageSizeType unitSize;
+  unitSize.Fill(1);
+  InputImageIndexType           smallestIndex = this->GetCroppedInputImageRegion().GetIndex();
+  InputImageIndexType           largestIndex = smallestIndex + this->GetCroppedInputImageRegion().GetSize() - unitSize;
+  InputImageContinuousIndexType smallestImageContIndex(smallestIndex);
+  InputImageContinuousIndexType largestImageContIndex(largestIndex);
+  this->GenerateSampleRegion(
+    smallestImageContIndex, largestImageContIndex, this->m_SmallestSampleContIndex, this->m_LargestSampleContIndex);
+
+} // end BeforeGenerateCandidateSamples()
+
+
+/**
+ * ******************* GenerateCandidateSample *******************
+ */
+
+template <class TInputImage>
+bool
+ImageRandomCoordinateSampler<TInputImage>::GenerateCandidateSample(CounterBasedRandomGeneratorType & generator,
+                                                                   ImageSampleType &                 sample)
+{
+  /** Generate a point in the sample region. */
+  InputImageContinuousIndexType sampleContIndex;
+  this->GenerateRandomCoordinate(
+    generator, this->m_SmallestSampleContIndex, this->m_LargestSampleContIndex, sampleContIndex);
+  this->GetInput()->TransformContinuousIndexToPhysicalPoint(sampleContIndex, sample.m_ImageCoordinates);
+
+  /** Check if it's inside the mask. */
+  const MaskType * mask = this->GetMask();
+  if (mask != nullptr && (!this->m_Interpolator->IsInsideBuffer(sampleContIndex) ||
+                          !mask->IsInsideInWorldSpace(sample.m_ImageCoordinates)))
+  {
+    return false;
+  }
+
+  /** Compute the value at the continuous index. */
+  sample.m_ImageValue =
+    static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleContIndex));
+  return true;
+
+} // end GenerateCandidateSample()
+
+
 /**
  * ******************* GenerateRandomCoordinate *******************
  */
@@ -286,6 +347,26 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateRandomCoordinate(
 } // end GenerateRandomCoordinate()
 
 
+/**
+ * ******************* GenerateRandomCoordinate *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomCoordinateSampler<TInputImage>::GenerateRandomCoordinate(
+  CounterBasedRandomGeneratorType &     generator,
+  const InputImageContinuousIndexType & smallestContIndex,
+  const InputImageContinuousIndexType & largestContIndex,
+  InputImageContinuousIndexType &       randomContIndex) const
+{
+  for (unsigned int i = 0; i < InputImageDimension; ++i)
+  {
+    randomContIndex[i] =
+      static_cast<InputImagePointValueType>(generator.GetUniformVariate(smallestContIndex[i], largestContIndex[i]));
+  }
+} // end GenerateRandomCoordinate()
+
+
 /**
  * ******************* GenerateSampleRegion *******************
  */
@@ -321,7 +402,15 @@ ImageRandomCoordinateSampler<TInputImage>::GenerateSampleRegion(
     maxSmallestContIndex[i] = std::max(maxSmallestContIndex[i], smallestImageContIndex[i]);
   }
 
-  this->GenerateRandomCoordinate(smallestImageContIndex, maxSmallestContIndex, smallestContIndex);
+  if (this->GetUseCounterBasedRandomGenerator())
+  {
+    CounterBasedRandomGeneratorType generator = this->GetSampleSetRandomGenerator();
+    this->GenerateRandomCoordinate(generator, smallestImageContIndex, maxSmallestContIndex, smallestContIndex);
+  }
+  else
+  {
+    this->GenerateRandomCoordinate(smallestImageContIndex, maxSmallestContIndex, smallestContIndex);
+  }
   largestContIndex = smallestContIndex;
   largestContIndex += sampleRegionSize;
 
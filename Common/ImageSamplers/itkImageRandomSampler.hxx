@@ -34,6 +34,12 @@ template <class TInputImage>
 void
 ImageRandomSampler<TInputImage>::GenerateData(void)
 {
+  /** With the counter-based random number generator, all samples are generated in parallel. */
+  if (this->GetUseCounterBasedRandomGenerator())
+  {
+    return this->GenerateDataWithCounterBasedRandomGenerator();
+  }
+
   /** Get a handle to the mask. If there was no mask supplied we exercise a multi-threaded version. */
   typename MaskType::ConstPointer mask = this->GetMask();
   if (mask.IsNull() && this->m_UseMultiThread)
@@ -44,7 +50,7 @@ ImageRandomSampler<TInputImage>::GenerateData(void)
 
   /** Get handles to the input image, output sample container. */
   InputImageConstPointer                     inputImage = this->GetInput();
-  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetSampleContainerToFill();
 
   /** Reserve memory for the output. */
   sampleContainer->Reserve(this->GetNumberOfSamples());
@@ -19,6 +19,7 @@
 #define itkImageRandomSamplerBase_h
 
 #include "itkImageSamplerBase.h"
+#include "itkPhiloxRandomGenerator.h"
 
 namespace itk
 {
@@ -29,6 +30,18 @@ namespace itk
  *
  * It adds the Set/GetNumberOfSamples function.
  *
+ * By default the random numbers are drawn from the global
+ * MersenneTwisterRandomVariateGenerator, in the order of the samples. The
+ * resulting sample set therefore depends on everything else that draws from
+ * that generator, and the samples have to be drawn one after the other.
+ *
+ * Optionally, a counter-based random number generator is used instead, see
+ * SetUseCounterBasedRandomGenerator(). Every sample then gets its own random
+ * stream, identified by the RandomSeed, the index of the sample set and the
+ * index of the sample. All samples, including those that are rejected by the
+ * mask, are generated in parallel, and the sample sets are identical for any
+ * number of threads.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -61,10 +74,42 @@ public:
   typedef typename Superclass::ImageSampleContainerType     ImageSampleContainerType;
   typedef typename Superclass::ImageSampleContainerPointer  ImageSampleContainerPointer;
   typedef typename Superclass::MaskType                     MaskType;
+  typedef typename Superclass::InputImageIndexType          InputImageIndexType;
+  typedef typename Superclass::ImageSampleValueType         ImageSampleValueType;
 
   /** The input image dimension. */
   itkStaticConstMacro(InputImageDimension, unsigned int, Superclass::InputImageDimension);
 
+  /** The counter-based random number generator. */
+  typedef PhiloxRandomGenerator                           CounterBasedRandomGeneratorType;
+  typedef CounterBasedRandomGeneratorType::IdentifierType RandomSeedType;
+
+  /** Set/Get whether the samples are drawn with the counter-based random number generator.
+   * Default: false.
+   */
+  itkSetMacro(UseCounterBasedRandomGenerator, bool);
+  itkGetConstMacro(UseCounterBasedRandomGenerator, bool);
+  itkBooleanMacro(UseCounterBasedRandomGenerator);
+
+  /** Set/Get the seed of the counter-based random number generator. Default: 121212. */
+  itkSetMacro(RandomSeed, RandomSeedType);
+  itkGetConstMacro(RandomSeed, RandomSeedType);
+
+  /** Set/Get the index of the next sample set drawn with the counter-based random number
+   * generator. It is incremented for every sample set. Default: 0.
+   */
+  itkSetMacro(SampleSetIndex, SizeValueType);
+  itkGetConstMacro(SampleSetIndex, SizeValueType);
+
+  /** Prefetching is only supported with the counter-based random number generator,
+   * because the global random generator is shared with other components.
+   */
+  bool
+  PrefetchingSupported(void) const override
+  {
+    return this->m_UseCounterBasedRandomGenerator;
+  }
+
 protected:
   /** The constructor. */
   ImageRandomSamplerBase();
@@ -80,6 +125,44 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Generate the sample set with the counter-based random number generator.
+   * Every sample is drawn by GenerateCandidateSample(), from its own random stream,
+   * until a candidate is accepted. Like in the other samplers, at most ten times
+   * the number of samples candidates are drawn in total.
+   */
+  void
+  GenerateDataWithCounterBasedRandomGenerator(void);
+
+  /** Called once per sample set, before the samples are generated, to set up
+   * everything the samples share. Does nothing by default.
+   */
+  virtual void
+  BeforeGenerateCandidateSamples(void)
+  {}
+
+  /** Draw a candidate sample from the given random stream. Returns false when
+   * the candidate is rejected, for example because it is outside the mask.
+   * Called concurrently by multiple threads. By default, a random pixel of the
+   * cropped input image region is drawn, which is rejected when outside the mask.
+   */
+  virtual bool
+  GenerateCandidateSample(CounterBasedRandomGeneratorType & generator, ImageSampleType & sample);
+
+  /** A random stream of the current sample set, not used for any sample. For
+   * the random choices that all samples of the set share.
+   */
+  CounterBasedRandomGeneratorType
+  GetSampleSetRandomGenerator(void) const;
+
+  /** Move on to the next sample set of the counter-based random number generator.
+   * Not a modification of the sampler, so it does not invalidate prefetched samples.
+   */
+  void
+  IncrementSampleSetIndex(void)
+  {
+    ++this->m_SampleSetIndex;
+  }
+
   /** Member variable used when threading. */
   std::vector<double> m_RandomNumberList;
 
@@ -89,6 +172,10 @@ private:
   /** The deleted assignment operator. */
   void
   operator=(const Self &) = delete;
+
+  bool           m_UseCounterBasedRandomGenerator;
+  RandomSeedType m_RandomSeed;
+  SizeValueType  m_SampleSetIndex;
 };
 
 } // end namespace itk
@@ -23,6 +23,8 @@
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 
+#include <atomic>
+
 namespace itk
 {
 
@@ -35,6 +37,10 @@ ImageRandomSamplerBase<TInputImage>::ImageRandomSamplerBase()
 {
   this->m_NumberOfSamples = 1000;
 
+  this->m_UseCounterBasedRandomGenerator = false;
+  this->m_RandomSeed = 121212;
+  this->m_SampleSetIndex = 0;
+
 } // end Constructor
 
 
@@ -71,6 +77,133 @@ ImageRandomSamplerBase<TInputImage>::BeforeThreadedGenerateData(void)
 } // end BeforeThreadedGenerateData()
 
 
+/**
+ * ******************* GenerateDataWithCounterBasedRandomGenerator *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomSamplerBase<TInputImage>::GenerateDataWithCounterBasedRandomGenerator(void)
+{
+  /** Get a handle to the output sample container and allocate the samples. */
+  ImageSampleContainerType * sampleContainer = this->GetSampleContainerToFill();
+  const SizeValueType        numberOfSamples = this->GetNumberOfSamples();
+  sampleContainer->Initialize();
+  sampleContainer->Reserve(numberOfSamples);
+
+  /** Update the masks, and let the subclass set up what the samples share. */
+  this->UpdateAllMasks();
+  this->BeforeGenerateCandidateSamples();
+
+  /** Make sure we are not eternally trying to find samples. A sample stops when
+   * the budget is exhausted, so the total number of candidates only exceeds it
+   * when the sequential generation of all samples would also exceed it.
+   */
+  const RandomSeedType       seed = this->m_RandomSeed;
+  const SizeValueType        sampleSetIndex = this->m_SampleSetIndex;
+  const SizeValueType        maximumNumberOfSamplesToTry = 10 * numberOfSamples;
+  std::atomic<SizeValueType> numberOfSamplesTried(0);
+  auto generateSamples = [&](ThreadIdType, SizeValueType first, SizeValueType last) {
+    for (SizeValueType i = first; i < last; ++i)
+    {
+      CounterBasedRandomGeneratorType generator(seed, sampleSetIndex, i);
+      ImageSampleType &               sample = sampleContainer->ElementAt(i);
+      do
+      {
+        if (++numberOfSamplesTried > maximumNumberOfSamplesToTry)
+        {
+          return;
+        }
+      } while (!this->GenerateCandidateSample(generator, sample));
+    }
+  };
+
+  /** Generate all samples, on the thread pool if there is one. The result does not
+   * depend on the number of threads.
+   */
+  if (!this->m_UseMultiThread)
+  {
+    generateSamples(0, 0, numberOfSamples);
+  }
+  else if (this->m_ThreadPool.IsNotNull())
+  {
+    this->m_ThreadPool->ParallelFor(numberOfSamples, 0, generateSamples);
+  }
+  else
+  {
+    MultiThreaderBase * threader = this->GetMultiThreader();
+    threader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    threader->ParallelizeArray(
+      0, numberOfSamples, [&generateSamples](SizeValueType i) { generateSamples(0, i, i + 1); }, nullptr);
+  }
+
+  /** The next sample set uses other random streams. */
+  this->IncrementSampleSetIndex();
+
+  if (numberOfSamplesTried > maximumNumberOfSamplesToTry)
+  {
+    sampleContainer->Initialize();
+    itkExceptionMacro(<< "Could not find enough image samples within "
+                      << "reasonable time. Probably the mask is too small");
+  }
+
+} // end GenerateDataWithCounterBasedRandomGenerator()
+
+
+/**
+ * ******************* GenerateCandidateSample *******************
+ */
+
+template <class TInputImage>
+bool
+ImageRandomSamplerBase<TInputImage>::GenerateCandidateSample(CounterBasedRandomGeneratorType & generator,
+                                                             ImageSampleType &                 sample)
+{
+  /** Draw a random position in the cropped input image region. */
+  const InputImageRegionType & region = this->GetCroppedInputImageRegion();
+  const SizeValueType          lastPosition = region.GetNumberOfPixels() - 1;
+  SizeValueType                randomPosition = static_cast<SizeValueType>(generator.GetIntegerVariate(lastPosition));
+
+  /** Translate randomPosition to an index, like in the ImageRandomConstIteratorWithIndex. */
+  InputImageIndexType positionIndex;
+  for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+  {
+    const SizeValueType sizeInThisDimension = region.GetSize()[dim];
+    const SizeValueType residual = randomPosition % sizeInThisDimension;
+    positionIndex[dim] = static_cast<IndexValueType>(residual) + region.GetIndex()[dim];
+    randomPosition /= sizeInThisDimension;
+  }
+
+  /** Transform the index to physical coordinates, and check if it's inside the mask. */
+  const InputImageType * inputImage = this->GetInput();
+  inputImage->TransformIndexToPhysicalPoint(positionIndex, sample.m_ImageCoordinates);
+  const MaskType * mask = this->GetMask();
+  if (mask != nullptr && !mask->IsInsideInWorldSpace(sample.m_ImageCoordinates))
+  {
+    return false;
+  }
+
+  sample.m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(positionIndex));
+  return true;
+
+} // end GenerateCandidateSample()
+
+
+/**
+ * ******************* GetSampleSetRandomGenerator *******************
+ */
+
+template <class TInputImage>
+typename ImageRandomSamplerBase<TInputImage>::CounterBasedRandomGeneratorType
+ImageRandomSamplerBase<TInputImage>::GetSampleSetRandomGenerator(void) const
+{
+  /** The last sub-stream is never used by a sample. */
+  return CounterBasedRandomGeneratorType(
+    this->m_RandomSeed, this->m_SampleSetIndex, NumericTraits<CounterBasedRandomGeneratorType::IdentifierType>::max());
+
+} // end GetSampleSetRandomGenerator()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -82,6 +215,9 @@ ImageRandomSamplerBase<TInputImage>::PrintSelf(std::ostream & os, Indent indent)
   Superclass::PrintSelf(os, indent);
 
   os << indent << "NumberOfSamples: " << this->m_NumberOfSamples << std::endl;
+  os << indent << "UseCounterBasedRandomGenerator: " << this->m_UseCounterBasedRandomGenerator << std::endl;
+  os << indent << "RandomSeed: " << this->m_RandomSeed << std::endl;
+  os << indent << "SampleSetIndex: " << this->m_SampleSetIndex << std::endl;
 
 } // end PrintSelf()
 
@@ -20,7 +20,9 @@
 
 #include "itkImageRandomSamplerBase.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
-#include "itkImageFullSampler.h"
+#include "itkTimeStamp.h"
+
+#include <vector>
 
 namespace itk
 {
@@ -31,6 +33,17 @@ namespace itk
  * This version takes into account that the mask may be very small.
  * Also, it may be more efficient when very many different sample sets
  * of the same input image are required, because it does some precomputation.
+ *
+ * The precomputation is a run-length index of the mask: the runs of
+ * consecutive voxels inside the mask along the first dimension, with the
+ * number of mask voxels preceding each run. A random mask voxel is drawn by
+ * drawing its number, and looking up its run in a guide table. The sample is
+ * only constructed when drawn, so the memory use is proportional to the
+ * number of runs instead of the number of mask voxels. The index is rebuilt
+ * when the input image, the mask or the input image region changes. It
+ * selects the same voxels as the ImageFullSampler, in the same order, so the
+ * sample sets equal those of drawing from all samples of the full sampler.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -74,10 +87,17 @@ public:
   /** The random number generator used to generate random indices. */
   typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
   typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+  typedef typename Superclass::CounterBasedRandomGeneratorType   CounterBasedRandomGeneratorType;
 
 protected:
-  typedef itk::ImageFullSampler<InputImageType>     InternalFullSamplerType;
-  typedef typename InternalFullSamplerType::Pointer InternalFullSamplerPointer;
+  /** A run of consecutive voxels inside the mask, along the first dimension. The
+   * offset of the first voxel is relative to the start of the input image region.
+   */
+  struct MaskRunType
+  {
+    SizeValueType m_Offset;
+    SizeValueType m_NumberOfPrecedingVoxels;
+  };
 
   /** The constructor. */
   ImageRandomSamplerSparseMask();
@@ -99,8 +119,29 @@ protected:
   void
   ThreadedGenerateData(const InputImageRegionType & inputRegionForThread, ThreadIdType threadId) override;
 
-  RandomGeneratorPointer     m_RandomGenerator;
-  InternalFullSamplerPointer m_InternalFullSampler;
+  /** Draw a random voxel of the mask. */
+  bool
+  GenerateCandidateSample(CounterBasedRandomGeneratorType & generator, ImageSampleType & sample) override;
+
+  /** Build the run-length index of the mask, if the inputs changed since it was built. */
+  void
+  UpdateMaskRuns(void);
+
+  /** Construct the sample of the mask voxel with the given number. */
+  void
+  GetMaskVoxelSample(SizeValueType voxelNumber, ImageSampleType & sample);
+
+  RandomGeneratorPointer m_RandomGenerator;
+
+  /** The run-length index of the mask, and a table giving for every block of
+   * m_GuideBlockSize voxel numbers the run containing the first of them.
+   */
+  std::vector<MaskRunType>   m_MaskRuns;
+  std::vector<SizeValueType> m_MaskRunGuide;
+  SizeValueType              m_GuideBlockSize;
+  SizeValueType              m_NumberOfMaskVoxels;
+  InputImageRegionType       m_MaskRunsRegion;
+  TimeStamp                  m_MaskRunsTime;
 
 private:
   /** The deleted copy constructor. */
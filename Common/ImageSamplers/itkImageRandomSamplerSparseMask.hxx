@@ -20,6 +20,9 @@
 
 #include "itkImageRandomSamplerSparseMask.h"
 
+
+#include <algorithm>
+
 namespace itk
 {
 
@@ -33,7 +36,8 @@ ImageRandomSamplerSparseMask<TInputImage>::ImageRandomSamplerSparseMask()
   /** Setup random generator. */
   this->m_RandomGenerator = RandomGeneratorType::GetInstance();
 
-  this->m_InternalFullSampler = InternalFullSamplerType::New();
+  this->m_GuideBlockSize = 1;
+  this->m_NumberOfMaskVoxels = 0;
 
 } // end Constructor
 
@@ -55,42 +59,20 @@ ImageRandomSamplerSparseMask<TInputImage>::GenerateData(void)
     itkExceptionMacro(<< "ERROR: do not call this function when no mask is supplied.");
   }
 
-  /** Get handles to the input image and output sample container. */
-  InputImageConstPointer      inputImage = this->GetInput();
-  ImageSampleContainerPointer sampleContainer = this->GetOutput();
+  /** Get a handle to the output sample container. */
+  ImageSampleContainerPointer sampleContainer = this->GetSampleContainerToFill();
 
   /** Clear the container. */
   sampleContainer->Initialize();
 
-  /** Make sure the internal full sampler is up-to-date. */
-  this->m_InternalFullSampler->SetInput(inputImage);
-  this->m_InternalFullSampler->SetMask(mask);
-  this->m_InternalFullSampler->SetInputImageRegion(this->GetCroppedInputImageRegion());
+  /** Make sure the run-length index of the mask is up-to-date. */
+  this->UpdateAllMasks();
+  this->UpdateMaskRuns();
 
-  /** Use try/catch, since the full sampler may crash, due to insufficient memory. */
-  try
+  /** With the counter-based random number generator, all samples are generated in parallel. */
+  if (this->GetUseCounterBasedRandomGenerator())
   {
-    this->m_InternalFullSampler->Update();
-  }
-  catch (ExceptionObject & err)
-  {
-    std::string message = "ERROR: This ImageSampler internally uses the "
-                          "ImageFullSampler. Updating of this internal sampler raised the "
-                          "exception:\n";
-    message += err.GetDescription();
-
-    std::string            fullSamplerMessage = err.GetDescription();
-    std::string::size_type loc =
-      fullSamplerMessage.find("ERROR: failed to allocate memory for the sample container", 0);
-    if (loc != std::string::npos && this->GetMask() == nullptr)
-    {
-      message += "\nYou are using the ImageRandomSamplerSparseMask sampler, "
-                 "but you did not set a mask. The internal ImageFullSampler therefore "
-                 "requires a lot of memory. Consider using the ImageRandomSampler "
-                 "instead.";
-    }
-    const char * message2 = message.c_str();
-    itkExceptionMacro(<< message2);
+    return this->GenerateDataWithCounterBasedRandomGenerator();
   }
 
   /** If desired we exercise a multi-threaded version. */
@@ -100,15 +82,12 @@ ImageRandomSamplerSparseMask<TInputImage>::GenerateData(void)
     return Superclass::GenerateData();
   }
 
-  /** Get a handle to the full sampler output. */
-  typename ImageSampleContainerType::Pointer allValidSamples = this->m_InternalFullSampler->GetOutput();
-  unsigned long                              numberOfValidSamples = allValidSamples->Size();
-
-  /** Take random samples from the allValidSamples-container. */
+  /** Take random samples from the mask voxels. */
+  sampleContainer->Reserve(this->GetNumberOfSamples());
   for (unsigned int i = 0; i < this->GetNumberOfSamples(); ++i)
   {
-    unsigned long randomIndex = this->m_RandomGenerator->GetIntegerVariate(numberOfValidSamples - 1);
-    sampleContainer->push_back(allValidSamples->ElementAt(randomIndex));
+    unsigned long randomIndex = this->m_RandomGenerator->GetIntegerVariate(this->m_NumberOfMaskVoxels - 1);
+    this->GetMaskVoxelSample(randomIndex, sampleContainer->ElementAt(i));
   }
 
 } // end GenerateData()
@@ -126,13 +105,10 @@ ImageRandomSamplerSparseMask<TInputImage>::BeforeThreadedGenerateData(void)
   this->m_RandomNumberList.resize(0);
   this->m_RandomNumberList.reserve(this->m_NumberOfSamples);
 
-  /** Get a handle to the full sampler output size. */
-  const unsigned long numberOfValidSamples = this->m_InternalFullSampler->GetOutput()->Size();
-
   /** Fill the list with random numbers. */
   for (unsigned int i = 0; i < this->GetNumberOfSamples(); ++i)
   {
-    unsigned long randomIndex = this->m_RandomGenerator->GetIntegerVariate(numberOfValidSamples - 1);
+    unsigned long randomIndex = this->m_RandomGenerator->GetIntegerVariate(this->m_NumberOfMaskVoxels - 1);
     this->m_RandomNumberList.push_back(randomIndex);
   }
 
@@ -155,9 +131,6 @@ template <class TInputImage>
 void
 ImageRandomSamplerSparseMask<TInputImage>::ThreadedGenerateData(const InputImageRegionType &, ThreadIdType threadId)
 {
-  /** Get a handle to the full sampler output. */
-  typename ImageSampleContainerType::Pointer allValidSamples = this->m_InternalFullSampler->GetOutput();
-
   /** Figure out which samples to process. */
   unsigned long chunkSize = this->GetNumberOfSamples() / this->GetNumberOfWorkUnits();
   unsigned long sampleStart = threadId * chunkSize;
@@ -174,17 +147,198 @@ ImageRandomSamplerSparseMask<TInputImage>::ThreadedGenerateData(const InputImage
   typename ImageSampleContainerType::Iterator      iter;
   typename ImageSampleContainerType::ConstIterator end = sampleContainerThisThread->End();
 
-  /** Take random samples from the allValidSamples-container. */
+  /** Take random samples from the mask voxels. */
   unsigned long sampleId = sampleStart;
   for (iter = sampleContainerThisThread->Begin(); iter != end; ++iter, sampleId++)
   {
     unsigned long randomIndex = static_cast<unsigned long>(this->m_RandomNumberList[sampleId]);
-    (*iter).Value() = allValidSamples->ElementAt(randomIndex);
+    this->GetMaskVoxelSample(randomIndex, (*iter).Value());
   }
 
 } // end ThreadedGenerateData()
 
 
+/**
+ * ******************* GenerateCandidateSample *******************
+ */
+
+template <class TInputImage>
+bool
+ImageRandomSamplerSparseMask<TInputImage>::GenerateCandidateSample(CounterBasedRandomGeneratorType & generator,
+                                                                   ImageSampleType &                 sample)
+{
+  /** All voxels of the index are inside the mask, so the candidate is never rejected. */
+  const auto voxelNumber = generator.GetIntegerVariate(this->m_NumberOfMaskVoxels - 1);
+  this->GetMaskVoxelSample(static_cast<SizeValueType>(voxelNumber), sample);
+  return true;
+
+} // end GenerateCandidateSample()
+
+
+/**
+ * ******************* UpdateMaskRuns *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomSamplerSparseMask<TInputImage>::UpdateMaskRuns(void)
+{
+  /** Only rebuild when the geometry of the image, the mask or the region changed. */
+  InputImageConstPointer          inputImage = this->GetInput();
+  typename MaskType::ConstPointer mask = this->GetMask();
+  const InputImageRegionType &    region = this->GetCroppedInputImageRegion();
+  const ModifiedTimeType          inputsMTime = std::max(inputImage->GetMTime(), mask->GetMTime());
+  if (region == this->m_MaskRunsRegion && this->m_MaskRunsTime.GetMTime() > inputsMTime)
+  {
+    return;
+  }
+
+  /** Scan the rows along the first dimension in chunks, in parallel. In every
+   * chunk, m_NumberOfPrecedingVoxels temporarily holds the length of the run.
+   */
+  const SizeValueType rowLength = region.GetSize()[0];
+  const SizeValueType numberOfRows = region.GetNumberOfPixels() / std::max<SizeValueType>(rowLength, 1);
+  const SizeValueType numberOfChunks = std::min<SizeValueType>(numberOfRows, 256);
+  std::vector<std::vector<MaskRunType>> chunkRuns(numberOfChunks);
+
+  auto scanChunk = [&](SizeValueType chunk) {
+    const SizeValueType firstRow = (numberOfRows * chunk) / numberOfChunks;
+    const SizeValueType lastRow = (numberOfRows * (chunk + 1)) / numberOfChunks;
+    std::vector<MaskRunType> & runs = chunkRuns[chunk];
+    InputImagePointType        point;
+    for (SizeValueType row = firstRow; row < lastRow; ++row)
+    {
+      /** The index of the first voxel of the row. */
+      InputImageIndexType index = region.GetIndex();
+      SizeValueType       residual = row;
+      for (unsigned int dim = 1; dim < InputImageDimension; ++dim)
+      {
+        index[dim] += static_cast<IndexValueType>(residual % region.GetSize()[dim]);
+        residual /= region.GetSize()[dim];
+      }
+
+      bool insideRun = false;
+      for (SizeValueType x = 0; x < rowLength; ++x)
+      {
+        index[0] = region.GetIndex()[0] + static_cast<IndexValueType>(x);
+        inputImage->TransformIndexToPhysicalPoint(index, point);
+        if (!mask->IsInsideInWorldSpace(point))
+        {
+          insideRun = false;
+        }
+        else if (insideRun)
+        {
+          ++runs.back().m_NumberOfPrecedingVoxels;
+        }
+        else
+        {
+          runs.push_back({ row * rowLength + x, 1 });
+          insideRun = true;
+        }
+      }
+    }
+  };
+
+  if (this->m_UseMultiThread && this->m_ThreadPool.IsNotNull())
+  {
+    const auto scanChunks = [&scanChunk](ThreadIdType, SizeValueType first, SizeValueType last) {
+      for (SizeValueType chunk = first; chunk < last; ++chunk)
+      {
+        scanChunk(chunk);
+      }
+    };
+    this->m_ThreadPool->ParallelFor(numberOfChunks, 1, scanChunks);
+  }
+  else
+  {
+    MultiThreaderBase * threader = this->GetMultiThreader();
+    threader->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    threader->ParallelizeArray(0, numberOfChunks, scanChunk, nullptr);
+  }
+
+  /** Concatenate the chunks, and replace the run lengths by the number of preceding voxels. */
+  SizeValueType numberOfRuns = 0;
+  for (const auto & runs : chunkRuns)
+  {
+    numberOfRuns += runs.size();
+  }
+  this->m_MaskRuns.clear();
+  this->m_MaskRuns.shrink_to_fit();
+  this->m_MaskRuns.reserve(numberOfRuns);
+  SizeValueType numberOfVoxels = 0;
+  for (auto & runs : chunkRuns)
+  {
+    for (const MaskRunType & run : runs)
+    {
+      this->m_MaskRuns.push_back({ run.m_Offset, numberOfVoxels });
+      numberOfVoxels += run.m_NumberOfPrecedingVoxels;
+    }
+    std::vector<MaskRunType>().swap(runs);
+  }
+  this->m_NumberOfMaskVoxels = numberOfVoxels;
+
+  if (this->m_NumberOfMaskVoxels == 0)
+  {
+    this->m_MaskRunGuide.clear();
+    itkExceptionMacro(<< "ERROR: the mask does not contain any voxel of the input image region.");
+  }
+
+  /** The guide table has about one block per run, so a lookup only passes a few runs. */
+  this->m_GuideBlockSize = (numberOfVoxels + numberOfRuns - 1) / numberOfRuns;
+  const SizeValueType numberOfBlocks = (numberOfVoxels + this->m_GuideBlockSize - 1) / this->m_GuideBlockSize;
+  this->m_MaskRunGuide.resize(numberOfBlocks);
+  SizeValueType run = 0;
+  for (SizeValueType block = 0; block < numberOfBlocks; ++block)
+  {
+    const SizeValueType voxelNumber = block * this->m_GuideBlockSize;
+    while (run + 1 < numberOfRuns && this->m_MaskRuns[run + 1].m_NumberOfPrecedingVoxels <= voxelNumber)
+    {
+      ++run;
+    }
+    this->m_MaskRunGuide[block] = run;
+  }
+
+  this->m_MaskRunsRegion = region;
+  this->m_MaskRunsTime.Modified();
+
+} // end UpdateMaskRuns()
+
+
+/**
+ * ******************* GetMaskVoxelSample *******************
+ */
+
+template <class TInputImage>
+void
+ImageRandomSamplerSparseMask<TInputImage>::GetMaskVoxelSample(const SizeValueType voxelNumber, ImageSampleType & sample)
+{
+  /** Find the run containing the voxel, starting at the run given by the guide table. */
+  SizeValueType       run = this->m_MaskRunGuide[voxelNumber / this->m_GuideBlockSize];
+  const SizeValueType numberOfRuns = this->m_MaskRuns.size();
+  while (run + 1 < numberOfRuns && this->m_MaskRuns[run + 1].m_NumberOfPrecedingVoxels <= voxelNumber)
+  {
+    ++run;
+  }
+  SizeValueType offset =
+    this->m_MaskRuns[run].m_Offset + (voxelNumber - this->m_MaskRuns[run].m_NumberOfPrecedingVoxels);
+
+  /** Translate the offset to an index. */
+  const InputImageRegionType & region = this->m_MaskRunsRegion;
+  InputImageIndexType          index;
+  for (unsigned int dim = 0; dim < InputImageDimension; ++dim)
+  {
+    index[dim] = region.GetIndex()[dim] + static_cast<IndexValueType>(offset % region.GetSize()[dim]);
+    offset /= region.GetSize()[dim];
+  }
+
+  /** Construct the sample. */
+  const InputImageType * inputImage = this->GetInput();
+  inputImage->TransformIndexToPhysicalPoint(index, sample.m_ImageCoordinates);
+  sample.m_ImageValue = static_cast<ImageSampleValueType>(inputImage->GetPixel(index));
+
+} // end GetMaskVoxelSample()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -195,8 +349,9 @@ ImageRandomSamplerSparseMask<TInputImage>::PrintSelf(std::ostream & os, Indent i
 {
   Superclass::PrintSelf(os, indent);
 
-  os << indent << "InternalFullSampler: " << this->m_InternalFullSampler.GetPointer() << std::endl;
   os << indent << "RandomGenerator: " << this->m_RandomGenerator.GetPointer() << std::endl;
+  os << indent << "NumberOfMaskRuns: " << this->m_MaskRuns.size() << std::endl;
+  os << indent << "NumberOfMaskVoxels: " << this->m_NumberOfMaskVoxels << std::endl;
 
 } // end PrintSelf()
 
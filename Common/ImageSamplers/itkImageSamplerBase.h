@@ -23,6 +23,8 @@
 #include "itkVectorDataContainer.h"
 #include "itkSpatialObject.h"
 
+#include <future>
+
 namespace itk
 {
 /** \class ImageSamplerBase
@@ -35,6 +37,17 @@ namespace itk
  *    example: <tt>(ImageSampler "Random")</tt> \n
  *    The default is Random.
  *
+ * When UsePrefetching is enabled, the sample set that is selected by the next
+ * call of SelectNewSamplesOnUpdate() is generated by a task on the thread pool,
+ * while the current sample set is used. SelectNewSamplesOnUpdate() then swaps
+ * the prefetched samples into the output, without copying, and starts
+ * generating the next set. This requires a sampler that does not share state
+ * with other objects, see PrefetchingSupported(): the random samplers only
+ * support it with their own counter-based random generator, because the
+ * global random generator is also used by other components. The settings and
+ * inputs of the sampler must not be changed while prefetching, so disable it
+ * first.
+ *
  * \ingroup ImageSamplers
  */
 
@@ -65,6 +78,7 @@ public:
   typedef typename Superclass::InputImageConstPointer       InputImageConstPointer;
   typedef typename Superclass::InputImageRegionType         InputImageRegionType;
   typedef typename Superclass::InputImagePixelType          InputImagePixelType;
+  typedef typename Superclass::ThreadPoolType               ThreadPoolType;
 
   /** The input image dimension. */
   itkStaticConstMacro(InputImageDimension, unsigned int, InputImageType::ImageDimension);
@@ -83,6 +97,7 @@ public:
   typedef typename MaskType::ConstPointer                   MaskConstPointer;
   typedef std::vector<MaskConstPointer>                     MaskVectorType;
   typedef std::vector<InputImageRegionType>                 InputImageRegionVectorType;
+  typedef std::vector<float>                                SampleWeightContainerType;
 
   /** ******************** Masks ******************** */
 
@@ -169,6 +184,50 @@ public:
   }
 
 
+  /** Returns whether the sample sets can be generated while other code is running,
+   * because the sample generation does not share state with other objects.
+   * Default: false.
+   */
+  virtual bool
+  PrefetchingSupported(void) const
+  {
+    return false;
+  }
+
+  /** Set/Get whether the next sample set is generated by a task on the thread pool.
+   * Disabling waits for the task to finish. Enabling throws an exception when the
+   * sampler selects new samples, but PrefetchingSupported() is false.
+   */
+  virtual void
+  SetUsePrefetching(const bool _arg);
+  itkGetConstMacro(UsePrefetching, bool);
+  itkBooleanMacro(UsePrefetching);
+
+  /** Returns whether the sampler attaches an importance weight to every sample,
+   * see GetSampleWeights(). Default: false.
+   */
+  virtual bool
+  HasSampleWeights(void) const
+  {
+    return false;
+  }
+
+  /** The importance weights of the output samples, in the same order. Empty when
+   * HasSampleWeights() is false, in which case all samples have weight 1. The
+   * weights are kept outside ImageSample, so that the samples of the other
+   * samplers do not grow.
+   */
+  const SampleWeightContainerType &
+  GetSampleWeights(void) const
+  {
+    return this->m_SampleWeights;
+  }
+
+  /** Generate the output, and start prefetching the next sample set if enabled. */
+  void
+  UpdateOutputData(DataObject * output) override;
+
+
   /** Get a handle to the cropped InputImageregion. */
   itkGetConstReferenceMacro(CroppedInputImageRegion, InputImageRegionType);
 
@@ -184,7 +243,7 @@ protected:
   ImageSamplerBase();
 
   /** The destructor. */
-  ~ImageSamplerBase() override = default;
+  ~ImageSamplerBase() override;
 
   /** PrintSelf. */
   void
@@ -219,6 +278,18 @@ protected:
   void
   AfterThreadedGenerateData(void) override;
 
+  /** The sample container filled by GenerateData(): the output, or the
+   * prefetched sample container in the prefetch task.
+   */
+  ImageSampleContainerType *
+  GetSampleContainerToFill(void);
+
+  /** The sample weights filled by GenerateData(), along with the samples of
+   * GetSampleContainerToFill().
+   */
+  SampleWeightContainerType &
+  GetSampleWeightsToFill(void);
+
   /***/
   unsigned long                            m_NumberOfSamples;
   std::vector<ImageSampleContainerPointer> m_ThreaderSampleContainer;
@@ -243,6 +314,38 @@ private:
 
   InputImageRegionType m_CroppedInputImageRegion;
   InputImageRegionType m_DummyInputImageRegion;
+
+  SampleWeightContainerType m_SampleWeights;
+
+  /** Throws an exception when the sampler does not support prefetching. */
+  void
+  CheckPrefetchingSupported(void) const;
+
+  /** Start generating the next sample set by a task on the thread pool. */
+  void
+  PrefetchSamples(void);
+
+  /** Swap the prefetched samples into the output. Returns false when
+   * nothing was prefetched, or when the prefetched samples are invalid.
+   */
+  bool
+  TakePrefetchedSamples(void);
+
+  /** Wait for the prefetch task and discard its samples. */
+  void
+  WaitForPrefetchedSamples(void);
+
+  /** The modification time the prefetched samples are valid for. */
+  ModifiedTimeType
+  GetPrefetchMTime(void);
+
+  /** Member variables for prefetching. */
+  bool                        m_UsePrefetching;
+  ImageSampleContainerPointer m_PrefetchedSampleContainer;
+  SampleWeightContainerType   m_PrefetchedSampleWeights;
+  ImageSampleContainerType *  m_SampleContainerToFill;
+  std::future<void>           m_PrefetchFuture;
+  ModifiedTimeType            m_PrefetchMTime;
 };
 
 } // end namespace itk
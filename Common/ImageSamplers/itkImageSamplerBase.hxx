@@ -20,6 +20,8 @@
 
 #include "itkImageSamplerBase.h"
 
+#include <algorithm> // For max.
+
 namespace itk
 {
 
@@ -38,9 +40,25 @@ ImageSamplerBase<TInputImage>::ImageSamplerBase()
   // tmp?
   this->m_UseMultiThread = false;
 
+  this->m_UsePrefetching = false;
+  this->m_SampleContainerToFill = nullptr;
+  this->m_PrefetchMTime = 0;
+
 } // end Constructor()
 
 
+/**
+ * ******************* Destructor *******************
+ */
+
+template <class TInputImage>
+ImageSamplerBase<TInputImage>::~ImageSamplerBase()
+{
+  this->WaitForPrefetchedSamples();
+
+} // end Destructor()
+
+
 /**
  * ******************* SetMask *******************
  */
@@ -234,6 +252,15 @@ template <class TInputImage>
 bool
 ImageSamplerBase<TInputImage>::SelectNewSamplesOnUpdate(void)
 {
+  /** When prefetching, the new samples may already be available. Then the
+   * output is up-to-date, and the generation of the next set can start.
+   */
+  if (this->m_UsePrefetching && this->TakePrefetchedSamples())
+  {
+    this->PrefetchSamples();
+    return true;
+  }
+
   /** Set the Modified flag, such that on calling Update(),
    * the GenerateData method is executed again.
    * Return true to indicate that indeed new samples will be selected.
@@ -245,6 +272,229 @@ ImageSamplerBase<TInputImage>::SelectNewSamplesOnUpdate(void)
 } // end SelectNewSamplesOnUpdate()
 
 
+/**
+ * ******************* SetUsePrefetching *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::SetUsePrefetching(const bool _arg)
+{
+  if (this->m_UsePrefetching != _arg)
+  {
+    if (_arg && this->SelectingNewSamplesOnUpdateSupported())
+    {
+      this->CheckPrefetchingSupported();
+    }
+    this->WaitForPrefetchedSamples();
+    this->m_UsePrefetching = _arg;
+  }
+
+} // end SetUsePrefetching()
+
+
+/**
+ * ******************* UpdateOutputData *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::UpdateOutputData(DataObject * output)
+{
+  /** Samples generated by the prefetch task are outdated now. */
+  this->WaitForPrefetchedSamples();
+
+  this->Superclass::UpdateOutputData(output);
+
+  if (this->m_UsePrefetching && this->SelectingNewSamplesOnUpdateSupported())
+  {
+    this->PrefetchSamples();
+  }
+
+} // end UpdateOutputData()
+
+
+/**
+ * ******************* GetSampleContainerToFill *******************
+ */
+
+template <class TInputImage>
+typename ImageSamplerBase<TInputImage>::ImageSampleContainerType *
+ImageSamplerBase<TInputImage>::GetSampleContainerToFill(void)
+{
+  if (this->m_SampleContainerToFill)
+  {
+    return this->m_SampleContainerToFill;
+  }
+  return this->GetOutput();
+
+} // end GetSampleContainerToFill()
+
+
+/**
+ * ******************* GetSampleWeightsToFill *******************
+ */
+
+template <class TInputImage>
+typename ImageSamplerBase<TInputImage>::SampleWeightContainerType &
+ImageSamplerBase<TInputImage>::GetSampleWeightsToFill(void)
+{
+  if (this->m_SampleContainerToFill)
+  {
+    return this->m_PrefetchedSampleWeights;
+  }
+  return this->m_SampleWeights;
+
+} // end GetSampleWeightsToFill()
+
+
+/**
+ * ******************* CheckPrefetchingSupported *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::CheckPrefetchingSupported(void) const
+{
+  if (!this->PrefetchingSupported())
+  {
+    itkExceptionMacro(<< "ERROR: " << this->GetNameOfClass() << " does not support prefetching. The random "
+                      << "samplers only support it with UseCounterBasedRandomGenerator, because the global "
+                      << "random generator is shared with other components.");
+  }
+
+} // end CheckPrefetchingSupported()
+
+
+/**
+ * ******************* PrefetchSamples *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::PrefetchSamples(void)
+{
+  this->CheckPrefetchingSupported();
+
+  if (this->m_PrefetchedSampleContainer.IsNull())
+  {
+    this->m_PrefetchedSampleContainer = ImageSampleContainerType::New();
+  }
+  this->m_PrefetchMTime = this->GetPrefetchMTime();
+
+  /** GenerateData() fills the prefetched container instead of the output,
+   * which is read by the metric in the meantime. Inside the task, the thread
+   * pool runs the parallel loops of GenerateData() serially.
+   */
+  ThreadPoolType * threadPool = this->m_ThreadPool.GetPointer();
+  if (threadPool == nullptr)
+  {
+    threadPool = ThreadPoolType::GetGlobalThreadPool();
+  }
+  this->m_PrefetchFuture = threadPool->Submit([this] {
+    this->m_SampleContainerToFill = this->m_PrefetchedSampleContainer.GetPointer();
+    try
+    {
+      this->GenerateData();
+    }
+    catch (...)
+    {
+      this->m_SampleContainerToFill = nullptr;
+      throw;
+    }
+    this->m_SampleContainerToFill = nullptr;
+  });
+
+} // end PrefetchSamples()
+
+
+/**
+ * ******************* TakePrefetchedSamples *******************
+ */
+
+template <class TInputImage>
+bool
+ImageSamplerBase<TInputImage>::TakePrefetchedSamples(void)
+{
+  if (!this->m_PrefetchFuture.valid())
+  {
+    return false;
+  }
+
+  /** If the generation failed, the samples are generated again on the next
+   * Update(), which reports the error.
+   */
+  try
+  {
+    this->m_PrefetchFuture.get();
+  }
+  catch (...)
+  {
+    return false;
+  }
+
+  /** Check that the inputs and settings did not change in the meantime. */
+  if (this->GetPrefetchMTime() != this->m_PrefetchMTime)
+  {
+    return false;
+  }
+
+  this->GetOutput()->CastToSTLContainer().swap(this->m_PrefetchedSampleContainer->CastToSTLContainer());
+  this->m_SampleWeights.swap(this->m_PrefetchedSampleWeights);
+
+  /** The output is not regenerated, but its samples changed, which users that cache
+   * information about the samples (like the spatial partition of the metric) check.
+   */
+  this->GetOutput()->Modified();
+  return true;
+
+} // end TakePrefetchedSamples()
+
+
+/**
+ * ******************* WaitForPrefetchedSamples *******************
+ */
+
+template <class TInputImage>
+void
+ImageSamplerBase<TInputImage>::WaitForPrefetchedSamples(void)
+{
+  if (this->m_PrefetchFuture.valid())
+  {
+    try
+    {
+      this->m_PrefetchFuture.get();
+    }
+    catch (...)
+    {
+      /** The samples are discarded anyway. */
+    }
+  }
+
+} // end WaitForPrefetchedSamples()
+
+
+/**
+ * ******************* GetPrefetchMTime *******************
+ */
+
+template <class TInputImage>
+ModifiedTimeType
+ImageSamplerBase<TInputImage>::GetPrefetchMTime(void)
+{
+  ModifiedTimeType mtime = this->GetMTime();
+  for (unsigned int i = 0; i < this->GetNumberOfIndexedInputs(); ++i)
+  {
+    if (this->GetInput(i))
+    {
+      mtime = std::max(mtime, this->GetInput(i)->GetMTime());
+    }
+  }
+  return mtime;
+
+} // end GetPrefetchMTime()
+
+
 /**
  * ******************* IsInsideAllMasks *******************
  */
@@ -424,7 +674,7 @@ ImageSamplerBase<TInputImage>::AfterThreadedGenerateData(void)
   }
 
   /** Get handle to the output sample container. */
-  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetSampleContainerToFill();
   sampleContainer->clear();
   sampleContainer->reserve(this->m_NumberOfSamples);
 
@@ -464,6 +714,7 @@ ImageSamplerBase<TInputImage>::PrintSelf(std::ostream & os, Indent indent) const
     os << indent.GetNextIndent() << this->m_InputImageRegionVector[i] << std::endl;
   }
   os << indent << "CroppedInputImageRegion" << this->m_CroppedInputImageRegion << std::endl;
+  os << indent << "UsePrefetching: " << this->m_UsePrefetching << std::endl;
 
 } // end PrintSelf()
 
@@ -20,6 +20,7 @@
 
 #include "itkVectorContainerSource.h"
 #include "itkPlatformMultiThreader.h"
+#include "itkWorkStealingThreadPool.h"
 
 namespace itk
 {
@@ -58,6 +59,14 @@ public:
   typedef typename InputImageType::RegionType   InputImageRegionType;
   typedef typename InputImageType::PixelType    InputImagePixelType;
 
+  /** Typedef for the persistent thread pool. */
+  typedef WorkStealingThreadPool ThreadPoolType;
+
+  /** Set/Get a thread pool. When set, GenerateData() runs the ThreadedGenerateData()
+   * calls on the threads of the pool, instead of on the multi-threader. */
+  itkSetObjectMacro(ThreadPool, ThreadPoolType);
+  itkGetModifiableObjectMacro(ThreadPool, ThreadPoolType);
+
   /** Create a valid output. */
   DataObject::Pointer
   MakeOutput(unsigned int idx) override;
@@ -188,6 +197,9 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** The optional thread pool. */
+  ThreadPoolType::Pointer m_ThreadPool;
+
 private:
   /** The deleted copy constructor. */
   ImageToVectorContainerFilter(const Self &) = delete;
@@ -39,6 +39,8 @@ ImageToVectorContainerFilter<TInputImage, TOutputVectorContainer>::ImageToVector
   this->ProcessObject::SetNumberOfRequiredOutputs(1);
   this->ProcessObject::SetNthOutput(0, output.GetPointer());
 
+  this->m_ThreadPool = nullptr;
+
 } // end Constructor
 
 
@@ -124,6 +126,8 @@ void
 ImageToVectorContainerFilter<TInputImage, TOutputVectorContainer>::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "ThreadPool: " << this->m_ThreadPool.GetPointer() << std::endl;
 } // end PrintSelf()
 
 
@@ -214,11 +218,19 @@ ImageToVectorContainerFilter<TInputImage, TOutputVectorContainer>::GenerateData(
   ThreadStruct str;
   str.Filter = this;
 
-  this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
-  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+  if (this->m_ThreadPool.IsNotNull())
+  {
+    // multithread the execution on the persistent threads of the pool
+    this->m_ThreadPool->SingleMethodExecute(this->GetNumberOfWorkUnits(), this->ThreaderCallback, &str);
+  }
+  else
+  {
+    this->GetMultiThreader()->SetNumberOfWorkUnits(this->GetNumberOfWorkUnits());
+    this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
 
-  // multithread the execution
-  this->GetMultiThreader()->SingleMethodExecute();
+    // multithread the execution
+    this->GetMultiThreader()->SingleMethodExecute();
+  }
 
   // Call a method that can be overridden by a subclass to perform
   // some calculations after all the threads have completed
@@ -85,6 +85,7 @@ public:
   /** The random number generator used to generate random coordinates. */
   typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
   typedef typename RandomGeneratorType::Pointer                  RandomGeneratorPointer;
+  typedef typename Superclass::CounterBasedRandomGeneratorType   CounterBasedRandomGeneratorType;
 
   /** Set/Get the interpolator. A 3rd order B-spline interpolator is used by default. */
   itkSetObjectMacro(Interpolator, InterpolatorType);
@@ -118,6 +119,14 @@ protected:
   void
   GenerateData(void) override;
 
+  /** Set up the interpolator and the sample region, for the counter-based random number generator. */
+  void
+  BeforeGenerateCandidateSamples(void) override;
+
+  /** Draw a random point, which is rejected when outside any of the masks. */
+  bool
+  GenerateCandidateSample(CounterBasedRandomGeneratorType & generator, ImageSampleType & sample) override;
+
   /** Generate a point randomly in a bounding box.
    * This method can be overwritten in subclasses if a different distribution is desired. */
   virtual void
@@ -125,10 +134,21 @@ protected:
                            const InputImageContinuousIndexType & largestContIndex,
                            InputImageContinuousIndexType &       randomContIndex);
 
+  /** Generate a point randomly in a bounding box, with the counter-based random number generator. */
+  void
+  GenerateRandomCoordinate(CounterBasedRandomGeneratorType &     generator,
+                           const InputImageContinuousIndexType & smallestContIndex,
+                           const InputImageContinuousIndexType & largestContIndex,
+                           InputImageContinuousIndexType &       randomContIndex) const;
+
   InterpolatorPointer    m_Interpolator;
   RandomGeneratorPointer m_RandomGenerator;
   InputImageSpacingType  m_SampleRegionSize;
 
+  /** The sample region of the current sample set, for the counter-based random number generator. */
+  InputImageContinuousIndexType m_SmallestSampleContIndex;
+  InputImageContinuousIndexType m_LargestSampleContIndex;
+
   /** Generate the two corners of a sampling region. */
   virtual void
   GenerateSampleRegion(InputImageContinuousIndexType & smallestContIndex,
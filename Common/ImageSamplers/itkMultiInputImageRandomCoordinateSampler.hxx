@@ -61,9 +61,15 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
                       << "is not a subregion of the LargestPossibleRegion");
   }
 
+  /** With the counter-based random number generator, all samples are generated in parallel. */
+  if (this->GetUseCounterBasedRandomGenerator())
+  {
+    return this->GenerateDataWithCounterBasedRandomGenerator();
+  }
+
   /** Get handles to the input image, output sample container, and mask. */
   InputImageConstPointer                     inputImage = this->GetInput();
-  typename ImageSampleContainerType::Pointer sampleContainer = this->GetOutput();
+  typename ImageSampleContainerType::Pointer sampleContainer = this->GetSampleContainerToFill();
   typename MaskType::ConstPointer            mask = this->GetMask();
   typename InterpolatorType::Pointer         interpolator = this->GetModifiableInterpolator();
 
@@ -152,6 +158,53 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateData(void)
 } // end GenerateData()
 
 
+/**
+ * ******************* BeforeGenerateCandidateSamples *******************
+ */
+
+template <class TInputImage>
+void
+MultiInputImageRandomCoordinateSampler<TInputImage>::BeforeGenerateCandidateSamples(void)
+{
+  /** Set up the interpolator. */
+  this->m_Interpolator->SetInputImage(this->GetInput());
+
+  /** Get the intersection of all sample regions. */
+  this->GenerateSampleRegion(this->m_SmallestSampleContIndex, this->m_LargestSampleContIndex);
+
+} // end BeforeGenerateCandidateSamples()
+
+
+/**
+ * ******************* GenerateCandidateSample *******************
+ */
+
+template <class TInputImage>
+bool
+MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateCandidateSample(
+  CounterBasedRandomGeneratorType & generator,
+  ImageSampleType &                 sample)
+{
+  /** Generate a point in the sample region. */
+  InputImageContinuousIndexType sampleContIndex;
+  this->GenerateRandomCoordinate(
+    generator, this->m_SmallestSampleContIndex, this->m_LargestSampleContIndex, sampleContIndex);
+  this->GetInput()->TransformContinuousIndexToPhysicalPoint(sampleContIndex, sample.m_ImageCoordinates);
+
+  /** Check if it's inside all masks. */
+  if (this->GetMask() != nullptr && !this->IsInsideAllMasks(sample.m_ImageCoordinates))
+  {
+    return false;
+  }
+
+  /** Compute the value at the contindex. */
+  sample.m_ImageValue =
+    static_cast<ImageSampleValueType>(this->m_Interpolator->EvaluateAtContinuousIndex(sampleContIndex));
+  return true;
+
+} // end GenerateCandidateSample()
+
+
 /**
  * ******************* GenerateSampleRegion *******************
  */
@@ -242,7 +295,15 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateSampleRegion(
     }
     InputImageContinuousIndexType maxSmallestContIndex = largestContIndex;
     maxSmallestContIndex -= sampleRegionSize;
-    this->GenerateRandomCoordinate(smallestContIndex, maxSmallestContIndex, smallestContIndex);
+    if (this->GetUseCounterBasedRandomGenerator())
+    {
+      CounterBasedRandomGeneratorType generator = this->GetSampleSetRandomGenerator();
+      this->GenerateRandomCoordinate(generator, smallestContIndex, maxSmallestContIndex, smallestContIndex);
+    }
+    else
+    {
+      this->GenerateRandomCoordinate(smallestContIndex, maxSmallestContIndex, smallestContIndex);
+    }
     largestContIndex = smallestContIndex;
     largestContIndex += sampleRegionSize;
   }
@@ -269,6 +330,26 @@ MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateRandomCoordinate(
 } // end GenerateRandomCoordinate()
 
 
+/**
+ * ******************* GenerateRandomCoordinate *******************
+ */
+
+template <class TInputImage>
+void
+MultiInputImageRandomCoordinateSampler<TInputImage>::GenerateRandomCoordinate(
+  CounterBasedRandomGeneratorType &     generator,
+  const InputImageContinuousIndexType & smallestContIndex,
+  const InputImageContinuousIndexType & largestContIndex,
+  InputImageContinuousIndexType &       randomContIndex) const
+{
+  for (unsigned int i = 0; i < InputImageDimension; ++i)
+  {
+    randomContIndex[i] =
+      static_cast<InputImagePointValueType>(generator.GetUniformVariate(smallestContIndex[i], largestContIndex[i]));
+  }
+} // end GenerateRandomCoordinate()
+
+
 /**
  * ******************* PrintSelf *******************
  */
@@ -0,0 +1,137 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPhiloxRandomGenerator_h
+#define itkPhiloxRandomGenerator_h
+
+#include <algorithm>
+#include <cstdint>
+
+namespace itk
+{
+
+/** \class PhiloxRandomGenerator
+ *
+ * \brief A counter-based random number generator: Philox4x32-10.
+ *
+ * The random numbers are a function of a key and a counter only, see
+ * Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC 2011.
+ * The key is the seed. The counter holds a stream and a sub-stream number,
+ * and the index of the block of four 32-bit words within that sub-stream.
+ * Any sub-stream can therefore be generated independently of all others,
+ * without any shared state. The image samplers use one sub-stream per
+ * sample, such that the samples do not depend on which thread draws them.
+ *
+ * This is a lightweight value type, not an itk::Object, so that it can be
+ * created on the stack for every sample.
+ *
+ * \ingroup ImageSamplers
+ */
+
+class PhiloxRandomGenerator
+{
+public:
+  /** The type of the generated words, and of the key and the counter. */
+  typedef std::uint32_t WordType;
+
+  /** The type of the seed, the stream and the sub-stream. */
+  typedef std::uint64_t IdentifierType;
+
+  /** Constructor. Only the lower 32 bits of the stream are used. */
+  PhiloxRandomGenerator(const IdentifierType seed, const IdentifierType stream, const IdentifierType subStream)
+  {
+    this->m_Key[0] = static_cast<WordType>(seed);
+    this->m_Key[1] = static_cast<WordType>(seed >> 32);
+    this->m_Counter[0] = 0;
+    this->m_Counter[1] = static_cast<WordType>(subStream);
+    this->m_Counter[2] = static_cast<WordType>(subStream >> 32);
+    this->m_Counter[3] = static_cast<WordType>(stream);
+    this->m_NumberOfUsedWords = 4;
+  }
+
+  /** The Philox4x32 bijection with 10 rounds, mapping a counter and a key to four random words. */
+  static void
+  Generate(const WordType counter[4], const WordType key[2], WordType output[4])
+  {
+    WordType c[4] = { counter[0], counter[1], counter[2], counter[3] };
+    WordType k[2] = { key[0], key[1] };
+    for (unsigned int round = 0; round < 10; ++round)
+    {
+      if (round > 0)
+      {
+        k[0] += 0x9E3779B9;
+        k[1] += 0xBB67AE85;
+      }
+      const std::uint64_t product0 = static_cast<std::uint64_t>(0xD2511F53) * c[0];
+      const std::uint64_t product1 = static_cast<std::uint64_t>(0xCD9E8D57) * c[2];
+      const WordType      hi0 = static_cast<WordType>(product0 >> 32);
+      const WordType      hi1 = static_cast<WordType>(product1 >> 32);
+      c[0] = hi1 ^ c[1] ^ k[0];
+      c[1] = static_cast<WordType>(product1);
+      c[2] = hi0 ^ c[3] ^ k[1];
+      c[3] = static_cast<WordType>(product0);
+    }
+    std::copy(c, c + 4, output);
+  }
+
+  /** Get the next random 32-bit word of the sub-stream. */
+  WordType
+  GetNextWord(void)
+  {
+    if (this->m_NumberOfUsedWords == 4)
+    {
+      Generate(this->m_Counter, this->m_Key, this->m_Block);
+      ++this->m_Counter[0];
+      this->m_NumberOfUsedWords = 0;
+    }
+    return this->m_Block[this->m_NumberOfUsedWords++];
+  }
+
+  /** Get a uniform variate in [0, 1), with 53-bit resolution. */
+  double
+  GetUniformVariate(void)
+  {
+    const WordType a = this->GetNextWord() >> 5;
+    const WordType b = this->GetNextWord() >> 6;
+    return (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+  }
+
+  /** Get a uniform variate in [a, b). */
+  double
+  GetUniformVariate(const double a, const double b)
+  {
+    return a + (b - a) * this->GetUniformVariate();
+  }
+
+  /** Get an integer variate in [0, n]. */
+  std::uint64_t
+  GetIntegerVariate(const std::uint64_t n)
+  {
+    const double variate = this->GetUniformVariate() * (static_cast<double>(n) + 1.0);
+    return std::min(static_cast<std::uint64_t>(variate), n);
+  }
+
+private:
+  WordType     m_Key[2];
+  WordType     m_Counter[4];
+  WordType     m_Block[4];
+  unsigned int m_NumberOfUsedWords;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkPhiloxRandomGenerator_h
@@ -0,0 +1,185 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScrambledSobolSequence_h
+#define itkScrambledSobolSequence_h
+
+#include <cstdint>
+
+namespace itk
+{
+
+/** \class ScrambledSobolSequence
+ *
+ * \brief The Sobol low-discrepancy sequence, with hash-based Owen scrambling.
+ *
+ * The first 2^m points of the Sobol sequence are stratified: every elementary
+ * interval of volume 2^-m contains exactly one point. Sets of quasi-random
+ * points therefore cover a domain more evenly than pseudo-random points, and
+ * averages over them converge faster.
+ *
+ * Every seed gives a different, randomly scrambled version of the sequence,
+ * following Burley, "Practical Hash-based Owen Scrambling", JCGT 2020. The
+ * index is scrambled first, which shuffles the points while keeping the
+ * stratification of the first 2^m points, and every component is scrambled
+ * with its own seed. A scrambled point is uniformly distributed, so averages
+ * over the points are unbiased, while the stratification is preserved.
+ *
+ * The direction numbers are those of Joe and Kuo (new-joe-kuo-6.21201), for
+ * up to MaximumDimension dimensions.
+ *
+ * \ingroup ImageSamplers
+ */
+
+class ScrambledSobolSequence
+{
+public:
+  /** The type of the indices, the seeds and the components as 32-bit fractions. */
+  typedef std::uint32_t WordType;
+
+  /** The maximum number of dimensions. */
+  static constexpr unsigned int MaximumDimension = 8;
+
+  /** Component dimension of the point with the given index of the unscrambled sequence,
+   * as a fraction of 2^32.
+   */
+  static WordType
+  GetComponent(WordType index, const unsigned int dimension)
+  {
+    const WordType * directions = GetDirectionNumbers()[dimension];
+    WordType         component = 0;
+    for (unsigned int bit = 0; index != 0; index >>= 1, ++bit)
+    {
+      if (index & 1)
+      {
+        component ^= directions[bit];
+      }
+    }
+    return component;
+  }
+
+  /** Compute the point with the given index of the sequence scrambled by the
+   * seed, in [0, 1)^numberOfDimensions.
+   */
+  static void
+  GetPoint(const WordType index, const WordType seed, const unsigned int numberOfDimensions, double * point)
+  {
+    const WordType scrambledIndex = NestedUniformScramble(index, seed);
+    for (unsigned int dimension = 0; dimension < numberOfDimensions; ++dimension)
+    {
+      const WordType dimensionSeed = Hash(seed + 0x9E3779B9u * (dimension + 1));
+      const WordType component = NestedUniformScramble(GetComponent(scrambledIndex, dimension), dimensionSeed);
+      point[dimension] = component * (1.0 / 4294967296.0);
+    }
+  }
+
+  /** A random permutation of the 32-bit fractions, with the Owen property: the
+   * permutation of each bit only depends on the more significant bits.
+   */
+  static WordType
+  NestedUniformScramble(WordType x, const WordType seed)
+  {
+    x = ReverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return ReverseBits(x);
+  }
+
+private:
+  /** The direction numbers of all dimensions, computed once. */
+  typedef WordType DirectionNumbersType[MaximumDimension][32];
+
+  static const DirectionNumbersType &
+  GetDirectionNumbers(void)
+  {
+    struct DirectionNumbers
+    {
+      DirectionNumbersType m_Values;
+
+      DirectionNumbers()
+      {
+        /** The degree s, the coefficients a, and the initial numbers m of the primitive
+         * polynomials of dimensions 2 and higher.
+         */
+        static const unsigned int degrees[MaximumDimension - 1] = { 1, 2, 3, 3, 4, 4, 5 };
+        static const unsigned int coefficients[MaximumDimension - 1] = { 0, 1, 1, 2, 1, 4, 2 };
+        static const WordType     initialNumbers[MaximumDimension - 1][5] = {
+          { 1 }, { 1, 3 }, { 1, 3, 1 }, { 1, 1, 1 }, { 1, 1, 3, 3 }, { 1, 3, 5, 13 }, { 1, 1, 5, 5, 17 }
+        };
+
+        /** The first dimension is the van der Corput sequence. */
+        for (unsigned int bit = 0; bit < 32; ++bit)
+        {
+          this->m_Values[0][bit] = WordType{ 1 } << (31 - bit);
+        }
+
+        for (unsigned int dimension = 1; dimension < MaximumDimension; ++dimension)
+        {
+          WordType *         v = this->m_Values[dimension];
+          const unsigned int s = degrees[dimension - 1];
+          const unsigned int a = coefficients[dimension - 1];
+          for (unsigned int bit = 0; bit < 32; ++bit)
+          {
+            if (bit < s)
+            {
+              v[bit] = initialNumbers[dimension - 1][bit] << (31 - bit);
+              continue;
+            }
+            v[bit] = v[bit - s] ^ (v[bit - s] >> s);
+            for (unsigned int k = 1; k < s; ++k)
+            {
+              v[bit] ^= ((a >> (s - 1 - k)) & 1) * v[bit - k];
+            }
+          }
+        }
+      }
+    };
+
+    static const DirectionNumbers directionNumbers;
+    return directionNumbers.m_Values;
+  }
+
+  /** Reverse the order of the bits of a word. */
+  static WordType
+  ReverseBits(WordType x)
+  {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4);
+    x = ((x >> 8) & 0x00FF00FFu) | ((x & 0x00FF00FFu) << 8);
+    return (x >> 16) | (x << 16);
+  }
+
+  /** An integer hash, to derive the seeds of the dimensions (lowbias32, by C. Wellons). */
+  static WordType
+  Hash(WordType x)
+  {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+  }
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkScrambledSobolSequence_h
@@ -263,6 +263,14 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a batch of points. */
+  void
+  BatchEvaluateJacobianWithImageGradientProduct(const unsigned int              numberOfPoints,
+                                                const InputPointType *          ipp,
+                                                const MovingImageGradientType * movingImageGradient,
+                                                DerivativeType *                imageJacobian,
+                                                NonZeroJacobianIndicesType *    nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
@@ -1521,6 +1521,39 @@ AdvancedCombinationTransform<TScalarType, NDimensions>::EvaluateJacobianWithImag
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ****************** BatchEvaluateJacobianWithImageGradientProduct ****************************
+ */
+
+template <typename TScalarType, unsigned int NDimensions>
+void
+AdvancedCombinationTransform<TScalarType, NDimensions>::BatchEvaluateJacobianWithImageGradientProduct(
+  const unsigned int              numberOfPoints,
+  const InputPointType *          ipp,
+  const MovingImageGradientType * movingImageGradient,
+  DerivativeType *                imageJacobian,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices) const
+{
+  /** Without an initial transform, or when using addition, the points are passed
+   * unchanged to the current transform, so it can process the whole batch at once.
+   */
+  if (this->m_SelectedEvaluateJacobianWithImageGradientProductFunction ==
+        &Self::EvaluateJacobianWithImageGradientProductNoInitialTransform ||
+      this->m_SelectedEvaluateJacobianWithImageGradientProductFunction ==
+        &Self::EvaluateJacobianWithImageGradientProductUseAddition)
+  {
+    this->m_CurrentTransform->BatchEvaluateJacobianWithImageGradientProduct(
+      numberOfPoints, ipp, movingImageGradient, imageJacobian, nonZeroJacobianIndices);
+    return;
+  }
+
+  /** Otherwise evaluate point by point. */
+  Superclass::BatchEvaluateJacobianWithImageGradientProduct(
+    numberOfPoints, ipp, movingImageGradient, imageJacobian, nonZeroJacobianIndices);
+
+} // end BatchEvaluateJacobianWithImageGradientProduct()
+
+
 /**
  * ****************** GetSpatialJacobian ****************************
  */
@@ -193,6 +193,18 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient
+   * for a batch of numberOfPoints points. This default implementation calls
+   * EvaluateJacobianWithImageGradientProduct() for every point; transforms with
+   * a vectorized kernel override it.
+   */
+  virtual void
+  BatchEvaluateJacobianWithImageGradientProduct(const unsigned int              numberOfPoints,
+                                                const InputPointType *          ipp,
+                                                const MovingImageGradientType * movingImageGradient,
+                                                DerivativeType *                imageJacobian,
+                                                NonZeroJacobianIndicesType *    nonZeroJacobianIndices) const;
+
   /** Compute the spatial Jacobian of the transformation.
    *
    * The spatial Jacobian is expressed as a vector of partial derivatives of the
@@ -106,6 +106,28 @@ AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::EvaluateJac
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* BatchEvaluateJacobianWithImageGradientProduct ****************************
+ */
+
+template <class TScalarType, unsigned int NInputDimensions, unsigned int NOutputDimensions>
+void
+AdvancedTransform<TScalarType, NInputDimensions, NOutputDimensions>::BatchEvaluateJacobianWithImageGradientProduct(
+  const unsigned int              numberOfPoints,
+  const InputPointType *          ipp,
+  const MovingImageGradientType * movingImageGradient,
+  DerivativeType *                imageJacobian,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices) const
+{
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    this->EvaluateJacobianWithImageGradientProduct(
+      ipp[i], movingImageGradient[i], imageJacobian[i], nonZeroJacobianIndices[i]);
+  }
+
+} // end BatchEvaluateJacobianWithImageGradientProduct()
+
+
 /**
  * ********************* GetNumberOfNonZeroJacobianIndices ****************************
  */
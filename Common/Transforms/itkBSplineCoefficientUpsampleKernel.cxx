@@ -0,0 +1,336 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBSplineCoefficientUpsampleKernel.h"
+#include "itkCPUDispatch.h"
+
+#include <cmath>
+
+namespace itk
+{
+
+namespace
+{
+
+constexpr unsigned int Lanes = BSplineCoefficientUpsampleKernel::NumberOfLanes;
+
+/** The same tolerance as the default of the BSplineDecompositionImageFilter. */
+constexpr double Tolerance = 1e-10;
+
+
+/** Weighted sums of input rows, for all lanes at once. */
+ELASTIX_KERNEL_INLINE void
+ResampleImpl(unsigned int         outputLength,
+             unsigned int         numberOfWeights,
+             const unsigned int * indices,
+             const double *       weights,
+             const double *       input,
+             double *             output)
+{
+  for (unsigned int i = 0; i < outputLength; ++i)
+  {
+    double sum[Lanes] = {};
+    for (unsigned int k = 0; k < numberOfWeights; ++k)
+    {
+      const double   w = weights[i * numberOfWeights + k];
+      const double * row = input + indices[i * numberOfWeights + k] * Lanes;
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        sum[c] += w * row[c];
+      }
+    }
+    for (unsigned int c = 0; c < Lanes; ++c)
+    {
+      output[i * Lanes + c] = sum[c];
+    }
+  }
+} // end ResampleImpl()
+
+
+/** The recursive filter of the BSplineDecompositionImageFilter, for all lanes at once. */
+ELASTIX_KERNEL_INLINE void
+DecomposeImpl(unsigned int length, unsigned int numberOfPoles, const double * poles, double * x)
+{
+  if (length == 1 || numberOfPoles == 0)
+  {
+    return;
+  }
+
+  /** Compute and apply the overall gain. */
+  double c0 = 1.0;
+  for (unsigned int k = 0; k < numberOfPoles; ++k)
+  {
+    c0 *= (1.0 - poles[k]) * (1.0 - 1.0 / poles[k]);
+  }
+  for (unsigned int n = 0; n < length * Lanes; ++n)
+  {
+    x[n] *= c0;
+  }
+
+  const unsigned int last = (length - 1) * Lanes;
+  for (unsigned int k = 0; k < numberOfPoles; ++k)
+  {
+    const double z = poles[k];
+
+    /** Initial causal coefficient. */
+    const unsigned int horizon = static_cast<unsigned int>(std::ceil(std::log(Tolerance) / std::log(std::fabs(z))));
+    double             sum[Lanes];
+    double             zn = z;
+    if (horizon < length)
+    {
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        sum[c] = x[c];
+      }
+      for (unsigned int n = 1; n < horizon; ++n)
+      {
+        for (unsigned int c = 0; c < Lanes; ++c)
+        {
+          sum[c] += zn * x[n * Lanes + c];
+        }
+        zn *= z;
+      }
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        x[c] = sum[c];
+      }
+    }
+    else
+    {
+      const double iz = 1.0 / z;
+      double       z2n = std::pow(z, static_cast<double>(length - 1));
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        sum[c] = x[c] + z2n * x[last + c];
+      }
+      z2n *= z2n * iz;
+      for (unsigned int n = 1; n + 1 < length; ++n)
+      {
+        const double f = zn + z2n;
+        for (unsigned int c = 0; c < Lanes; ++c)
+        {
+          sum[c] += f * x[n * Lanes + c];
+        }
+        zn *= z;
+        z2n *= iz;
+      }
+      const double denominator = 1.0 - zn * zn;
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        x[c] = sum[c] / denominator;
+      }
+    }
+
+    /** Causal recursion. */
+    for (unsigned int n = 1; n < length; ++n)
+    {
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        x[n * Lanes + c] += z * x[(n - 1) * Lanes + c];
+      }
+    }
+
+    /** Initial anti-causal coefficient. */
+    const double f = z / (z * z - 1.0);
+    for (unsigned int c = 0; c < Lanes; ++c)
+    {
+      x[last + c] = f * (z * x[last - Lanes + c] + x[last + c]);
+    }
+
+    /** Anti-causal recursion. */
+    for (unsigned int n = length - 1; n > 0; --n)
+    {
+      for (unsigned int c = 0; c < Lanes; ++c)
+      {
+        x[(n - 1) * Lanes + c] = z * (x[n * Lanes + c] - x[(n - 1) * Lanes + c]);
+      }
+    }
+  }
+} // end DecomposeImpl()
+
+
+/** The instruction set specific variants. */
+void
+ResampleScalar(unsigned int         outputLength,
+               unsigned int         numberOfWeights,
+               const unsigned int * indices,
+               const double *       weights,
+               const double *       input,
+               double *             output)
+{
+  ResampleImpl(outputLength, numberOfWeights, indices, weights, input, output);
+}
+
+void
+DecomposeScalar(unsigned int length, unsigned int numberOfPoles, const double * poles, double * x)
+{
+  DecomposeImpl(length, numberOfPoles, poles, x);
+}
+
+#ifdef ELASTIX_CPU_DISPATCH
+
+__attribute__((target("avx2"))) void
+ResampleAVX2(unsigned int         outputLength,
+             unsigned int         numberOfWeights,
+             const unsigned int * indices,
+             const double *       weights,
+             const double *       input,
+             double *             output)
+{
+  ResampleImpl(outputLength, numberOfWeights, indices, weights, input, output);
+}
+
+__attribute__((target("avx2"))) void
+DecomposeAVX2(unsigned int length, unsigned int numberOfPoles, const double * poles, double * x)
+{
+  DecomposeImpl(length, numberOfPoles, poles, x);
+}
+
+__attribute__((target("avx512f"))) void
+ResampleAVX512(unsigned int         outputLength,
+               unsigned int         numberOfWeights,
+               const unsigned int * indices,
+               const double *       weights,
+               const double *       input,
+               double *             output)
+{
+  ResampleImpl(outputLength, numberOfWeights, indices, weights, input, output);
+}
+
+__attribute__((target("avx512f"))) void
+DecomposeAVX512(unsigned int length, unsigned int numberOfPoles, const double * poles, double * x)
+{
+  DecomposeImpl(length, numberOfPoles, poles, x);
+}
+
+#endif
+
+} // end namespace
+
+
+/**
+ * ********************* Resample ****************************
+ */
+
+void
+BSplineCoefficientUpsampleKernel::Resample(unsigned int         outputLength,
+                                           unsigned int         numberOfWeights,
+                                           const unsigned int * indices,
+                                           const double *       weights,
+                                           const double *       input,
+                                           double *             output)
+{
+  switch (CPUDispatch::GetInstructionSet())
+  {
+#ifdef ELASTIX_CPU_DISPATCH
+    case CPUDispatch::AVX512:
+      ResampleAVX512(outputLength, numberOfWeights, indices, weights, input, output);
+      break;
+    case CPUDispatch::AVX2:
+      ResampleAVX2(outputLength, numberOfWeights, indices, weights, input, output);
+      break;
+#endif
+    default:
+      ResampleScalar(outputLength, numberOfWeights, indices, weights, input, output);
+  }
+} // end Resample()
+
+
+/**
+ * ********************* Decompose ****************************
+ */
+
+void
+BSplineCoefficientUpsampleKernel::Decompose(unsigned int length, unsigned int splineOrder, double * lines)
+{
+  /** The poles of the B-spline interpolation filter, as in the BSplineDecompositionImageFilter. */
+  double       poles[2];
+  unsigned int numberOfPoles = 0;
+  switch (splineOrder)
+  {
+    case 2:
+      numberOfPoles = 1;
+      poles[0] = std::sqrt(8.0) - 3.0;
+      break;
+    case 3:
+      numberOfPoles = 1;
+      poles[0] = std::sqrt(3.0) - 2.0;
+      break;
+    case 4:
+      numberOfPoles = 2;
+      poles[0] = std::sqrt(664.0 - std::sqrt(438976.0)) + std::sqrt(304.0) - 19.0;
+      poles[1] = std::sqrt(664.0 + std::sqrt(438976.0)) - std::sqrt(304.0) - 19.0;
+      break;
+    case 5:
+      numberOfPoles = 2;
+      poles[0] = std::sqrt(135.0 / 2.0 - std::sqrt(17745.0 / 4.0)) + std::sqrt(105.0 / 4.0) - 13.0 / 2.0;
+      poles[1] = std::sqrt(135.0 / 2.0 + std::sqrt(17745.0 / 4.0)) - std::sqrt(105.0 / 4.0) - 13.0 / 2.0;
+      break;
+    default:
+      /** Orders 0 and 1 are interpolating, the coefficients equal the samples. */
+      break;
+  }
+
+  switch (CPUDispatch::GetInstructionSet())
+  {
+#ifdef ELASTIX_CPU_DISPATCH
+    case CPUDispatch::AVX512:
+      DecomposeAVX512(length, numberOfPoles, poles, lines);
+      break;
+    case CPUDispatch::AVX2:
+      DecomposeAVX2(length, numberOfPoles, poles, lines);
+      break;
+#endif
+    default:
+      DecomposeScalar(length, numberOfPoles, poles, lines);
+  }
+} // end Decompose()
+
+
+/**
+ * ********************* EvaluateBSpline ****************************
+ */
+
+double
+BSplineCoefficientUpsampleKernel::EvaluateBSpline(unsigned int splineOrder, double u)
+{
+  /** The Cox-de Boor recursion for uniform knots, centered around 0. */
+  if (splineOrder == 0)
+  {
+    return (u >= -0.5 && u < 0.5) ? 1.0 : 0.0;
+  }
+
+  const double n = static_cast<double>(splineOrder);
+  const double halfWidth = 0.5 * (n + 1.0);
+  return ((halfWidth + u) * EvaluateBSpline(splineOrder - 1, u + 0.5) +
+          (halfWidth - u) * EvaluateBSpline(splineOrder - 1, u - 0.5)) /
+         n;
+} // end EvaluateBSpline()
+
+
+/**
+ * ********************* GetInstructionSetName ****************************
+ */
+
+const char *
+BSplineCoefficientUpsampleKernel::GetInstructionSetName(void)
+{
+  return CPUDispatch::GetInstructionSetName();
+} // end GetInstructionSetName()
+
+} // end namespace itk
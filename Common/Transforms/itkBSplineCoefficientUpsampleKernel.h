@@ -0,0 +1,78 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBSplineCoefficientUpsampleKernel_h
+#define itkBSplineCoefficientUpsampleKernel_h
+
+namespace itk
+{
+
+/** \class BSplineCoefficientUpsampleKernel
+ *
+ * \brief The 1D operations of the separable B-spline coefficient upsampling.
+ *
+ * Upsampling a B-spline coefficient image consists of evaluating the spline
+ * at the new control points, followed by the B-spline decomposition on the
+ * new grid. Both are separable, so they can be done line by line, one
+ * dimension after the other.
+ *
+ * The kernels operate on a block of NumberOfLanes lines at once, stored
+ * interleaved: element n of line c is at position n * NumberOfLanes + c.
+ * The inner loops run over the lanes, which the compiler vectorizes. On x86
+ * with GCC or Clang, AVX-512 and AVX2 variants are compiled in and the best
+ * variant supported by the CPU is selected at run time.
+ *
+ * \ingroup Transforms
+ */
+
+class BSplineCoefficientUpsampleKernel
+{
+public:
+  /** The number of lines in a block. */
+  static constexpr unsigned int NumberOfLanes = 16;
+
+  /** Evaluate the spline of a block of lines at outputLength new points.
+   * For each new point i the numberOfWeights weights and the indices of the
+   * corresponding input elements are given at i * numberOfWeights.
+   */
+  static void
+  Resample(unsigned int         outputLength,
+           unsigned int         numberOfWeights,
+           const unsigned int * indices,
+           const double *       weights,
+           const double *       input,
+           double *             output);
+
+  /** In-place B-spline decomposition of a block of lines, with mirror
+   * boundary conditions. Gives the same result as the
+   * BSplineDecompositionImageFilter, for spline orders 0 to 5.
+   */
+  static void
+  Decompose(unsigned int length, unsigned int splineOrder, double * lines);
+
+  /** The centered B-spline of the given order, evaluated at u. */
+  static double
+  EvaluateBSpline(unsigned int splineOrder, double u);
+
+  /** The name of the instruction set selected at run time: "AVX-512", "AVX2" or "scalar". */
+  static const char *
+  GetInstructionSetName(void);
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkBSplineCoefficientUpsampleKernel_h
@@ -0,0 +1,310 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBSplineJacobianGradientProductKernel.h"
+#include "itkCPUDispatch.h"
+
+#include <vector>
+
+namespace itk
+{
+
+namespace
+{
+
+/** Compile-time power, to get the number of weights. */
+constexpr unsigned int
+StaticPower(const unsigned int base, const unsigned int exponent)
+{
+  return exponent == 0 ? 1 : base * StaticPower(base, exponent - 1);
+}
+
+
+/** The kernel for a fixed dimension and spline order.
+ *
+ * The tensor product is built starting at the last dimension, such that the
+ * products are formed in the same order as in the recursive implementation,
+ * and the first dimension runs fastest in the result.
+ */
+template <unsigned int VDimension, unsigned int VSplineOrder, class TOutput>
+ELASTIX_KERNEL_INLINE void
+EvaluateFixed(unsigned int numberOfSamples, const double * weights1D, const double * gradients, TOutput * const * out)
+{
+  constexpr unsigned int P = VSplineOrder + 1;
+  constexpr unsigned int N = StaticPower(P, VDimension);
+
+  double weights[N];
+  double tmp[N];
+  for (unsigned int s = 0; s < numberOfSamples; ++s)
+  {
+    /** Tensor product of the 1D weights. */
+    const double * w1D = weights1D + s * VDimension * P;
+    for (unsigned int k = 0; k < P; ++k)
+    {
+      weights[k] = w1D[(VDimension - 1) * P + k];
+    }
+    unsigned int size = P;
+    for (unsigned int d = VDimension - 1; d > 0; --d)
+    {
+      const double * wd = w1D + (d - 1) * P;
+      for (unsigned int m = 0; m < size; ++m)
+      {
+        for (unsigned int k = 0; k < P; ++k)
+        {
+          tmp[m * P + k] = weights[m] * wd[k];
+        }
+      }
+      size *= P;
+      for (unsigned int i = 0; i < size; ++i)
+      {
+        weights[i] = tmp[i];
+      }
+    }
+
+    /** Multiply with the moving image gradient. */
+    const double * g = gradients + s * VDimension;
+    TOutput *      o = out[s];
+    for (unsigned int j = 0; j < VDimension; ++j)
+    {
+      const double gj = g[j];
+      for (unsigned int i = 0; i < N; ++i)
+      {
+        o[j * N + i] = static_cast<TOutput>(weights[i] * gj);
+      }
+    }
+  }
+} // end EvaluateFixed()
+
+
+/** The kernel for any dimension and spline order. */
+template <class TOutput>
+void
+EvaluateGeneric(unsigned int      dimension,
+                unsigned int      splineOrder,
+                unsigned int      numberOfSamples,
+                const double *    weights1D,
+                const double *    gradients,
+                TOutput * const * out)
+{
+  const unsigned int P = splineOrder + 1;
+  unsigned int       N = 1;
+  for (unsigned int d = 0; d < dimension; ++d)
+  {
+    N *= P;
+  }
+
+  std::vector<double> weights(N);
+  std::vector<double> tmp(N);
+  for (unsigned int s = 0; s < numberOfSamples; ++s)
+  {
+    const double * w1D = weights1D + s * dimension * P;
+    for (unsigned int k = 0; k < P; ++k)
+    {
+      weights[k] = w1D[(dimension - 1) * P + k];
+    }
+    unsigned int size = P;
+    for (unsigned int d = dimension - 1; d > 0; --d)
+    {
+      const double * wd = w1D + (d - 1) * P;
+      for (unsigned int m = 0; m < size; ++m)
+      {
+        for (unsigned int k = 0; k < P; ++k)
+        {
+          tmp[m * P + k] = weights[m] * wd[k];
+        }
+      }
+      size *= P;
+      weights.swap(tmp);
+    }
+
+    const double * g = gradients + s * dimension;
+    TOutput *      o = out[s];
+    for (unsigned int j = 0; j < dimension; ++j)
+    {
+      for (unsigned int i = 0; i < N; ++i)
+      {
+        o[j * N + i] = static_cast<TOutput>(weights[i] * g[j]);
+      }
+    }
+  }
+} // end EvaluateGeneric()
+
+
+/** Select the fixed-size kernel for the common cases. Returns false otherwise. */
+template <class TOutput>
+ELASTIX_KERNEL_INLINE bool
+EvaluateSwitch(unsigned int      dimension,
+               unsigned int      splineOrder,
+               unsigned int      numberOfSamples,
+               const double *    weights1D,
+               const double *    gradients,
+               TOutput * const * out)
+{
+  switch (dimension * 10 + splineOrder)
+  {
+    case 21:
+      EvaluateFixed<2, 1>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 22:
+      EvaluateFixed<2, 2>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 23:
+      EvaluateFixed<2, 3>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 31:
+      EvaluateFixed<3, 1>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 32:
+      EvaluateFixed<3, 2>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 33:
+      EvaluateFixed<3, 3>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 41:
+      EvaluateFixed<4, 1>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 42:
+      EvaluateFixed<4, 2>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    case 43:
+      EvaluateFixed<4, 3>(numberOfSamples, weights1D, gradients, out);
+      return true;
+    default:
+      return false;
+  }
+} // end EvaluateSwitch()
+
+
+/** The instruction set specific variants. */
+template <class TOutput>
+bool
+EvaluateScalar(unsigned int      dimension,
+               unsigned int      splineOrder,
+               unsigned int      numberOfSamples,
+               const double *    weights1D,
+               const double *    gradients,
+               TOutput * const * out)
+{
+  return EvaluateSwitch(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+}
+
+#ifdef ELASTIX_CPU_DISPATCH
+
+template <class TOutput>
+__attribute__((target("avx2"))) bool
+EvaluateAVX2(unsigned int      dimension,
+             unsigned int      splineOrder,
+             unsigned int      numberOfSamples,
+             const double *    weights1D,
+             const double *    gradients,
+             TOutput * const * out)
+{
+  return EvaluateSwitch(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+}
+
+template <class TOutput>
+__attribute__((target("avx512f"))) bool
+EvaluateAVX512(unsigned int      dimension,
+               unsigned int      splineOrder,
+               unsigned int      numberOfSamples,
+               const double *    weights1D,
+               const double *    gradients,
+               TOutput * const * out)
+{
+  return EvaluateSwitch(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+}
+
+#endif
+
+
+template <class TOutput>
+void
+EvaluateDispatch(unsigned int      dimension,
+                 unsigned int      splineOrder,
+                 unsigned int      numberOfSamples,
+                 const double *    weights1D,
+                 const double *    gradients,
+                 TOutput * const * out)
+{
+  bool done = false;
+  switch (CPUDispatch::GetInstructionSet())
+  {
+#ifdef ELASTIX_CPU_DISPATCH
+    case CPUDispatch::AVX512:
+      done = EvaluateAVX512(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+      break;
+    case CPUDispatch::AVX2:
+      done = EvaluateAVX2(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+      break;
+#endif
+    default:
+      done = EvaluateScalar(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+  }
+
+  if (!done)
+  {
+    EvaluateGeneric(dimension, splineOrder, numberOfSamples, weights1D, gradients, out);
+  }
+} // end EvaluateDispatch()
+
+} // end namespace
+
+
+/**
+ * ********************* Evaluate ****************************
+ */
+
+void
+BSplineJacobianGradientProductKernel::Evaluate(unsigned int     spaceDimension,
+                                               unsigned int     splineOrder,
+                                               unsigned int     numberOfSamples,
+                                               const double *   weights1D,
+                                               const double *   movingImageGradients,
+                                               double * const * imageJacobians)
+{
+  EvaluateDispatch(spaceDimension, splineOrder, numberOfSamples, weights1D, movingImageGradients, imageJacobians);
+} // end Evaluate()
+
+
+/**
+ * ********************* Evaluate ****************************
+ */
+
+void
+BSplineJacobianGradientProductKernel::Evaluate(unsigned int     spaceDimension,
+                                               unsigned int     splineOrder,
+                                               unsigned int     numberOfSamples,
+                                               const double *   weights1D,
+                                               const double *   movingImageGradients,
+                                               float * const *  imageJacobians)
+{
+  EvaluateDispatch(spaceDimension, splineOrder, numberOfSamples, weights1D, movingImageGradients, imageJacobians);
+} // end Evaluate()
+
+
+/**
+ * ********************* GetInstructionSetName ****************************
+ */
+
+const char *
+BSplineJacobianGradientProductKernel::GetInstructionSetName(void)
+{
+  return CPUDispatch::GetInstructionSetName();
+} // end GetInstructionSetName()
+
+} // end namespace itk
@@ -0,0 +1,77 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBSplineJacobianGradientProductKernel_h
+#define itkBSplineJacobianGradientProductKernel_h
+
+namespace itk
+{
+
+/** \class BSplineJacobianGradientProductKernel
+ *
+ * \brief Fused kernel computing the product of the B-spline transform Jacobian
+ * and the moving image gradient for a batch of samples.
+ *
+ * For every sample the tensor product of the 1D B-spline weights is formed and
+ * multiplied with each component of the moving image gradient:
+ *
+ *   imageJacobian[ j * N + i ] = w_i * dM/dx_j,   N = (SplineOrder + 1)^SpaceDimension.
+ *
+ * This gives the same result as the recursion in
+ * RecursiveBSplineTransformImplementation::EvaluateJacobianWithImageGradientProduct(),
+ * bit for bit, but with contiguous loops of known length, which the compiler
+ * vectorizes. On x86 with GCC or Clang, AVX-512 and AVX2 variants are compiled
+ * in and the best variant supported by the CPU is selected at run time. The
+ * scalar (SSE2) variant is used otherwise.
+ *
+ * The inputs are stored one sample after the other: per sample, weights1D
+ * holds SpaceDimension * (SplineOrder + 1) values and the gradients
+ * SpaceDimension values. The image Jacobian of sample s, of length
+ * SpaceDimension * N, is written to imageJacobians[ s ].
+ *
+ * \ingroup Transforms
+ */
+
+class BSplineJacobianGradientProductKernel
+{
+public:
+  /** Evaluate the kernel for numberOfSamples samples. */
+  static void
+  Evaluate(unsigned int     spaceDimension,
+           unsigned int     splineOrder,
+           unsigned int     numberOfSamples,
+           const double *   weights1D,
+           const double *   movingImageGradients,
+           double * const * imageJacobians);
+
+  /** Evaluate the kernel for numberOfSamples samples, with single precision output. */
+  static void
+  Evaluate(unsigned int     spaceDimension,
+           unsigned int     splineOrder,
+           unsigned int     numberOfSamples,
+           const double *   weights1D,
+           const double *   movingImageGradients,
+           float * const *  imageJacobians);
+
+  /** The name of the instruction set selected at run time: "AVX-512", "AVX2" or "scalar". */
+  static const char *
+  GetInstructionSetName(void);
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkBSplineJacobianGradientProductKernel_h
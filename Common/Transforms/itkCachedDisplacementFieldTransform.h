@@ -0,0 +1,286 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCachedDisplacementFieldTransform_h
+#define itkCachedDisplacementFieldTransform_h
+
+#include "itkAdvancedTransform.h"
+#include "itkAdvancedBSplineDeformableTransformBase.h"
+#include "itkContinuousIndex.h"
+
+namespace itk
+{
+
+/** \class CachedDisplacementFieldTransform
+ *
+ * \brief A transform that replaces another transform by a B-spline
+ * interpolated sampling of its displacements.
+ *
+ * The displacements T(x) - x of the given transform are sampled on a grid,
+ * and interpolated by a linear (SplineOrder 1) or cubic (SplineOrder 3)
+ * B-spline. Inside the grid, a point then costs a single B-spline evaluation,
+ * however many transforms the given transform is composed of. Outside the
+ * grid, the given transform itself is used.
+ *
+ * The cache is computed by UpdateCache(), and is not updated when the given
+ * transform changes afterwards. It is meant for a transform that is fixed,
+ * like the initial transform of a registration. The cached transform has no
+ * parameters, so it is NOT suited to be optimized.
+ *
+ * \ingroup Transforms
+ */
+
+template <class TScalarType = double, unsigned int NDimensions = 3>
+class ITK_TEMPLATE_EXPORT CachedDisplacementFieldTransform
+  : public AdvancedTransform<TScalarType, NDimensions, NDimensions>
+{
+public:
+  /** Standard class typedefs. */
+  typedef CachedDisplacementFieldTransform                         Self;
+  typedef AdvancedTransform<TScalarType, NDimensions, NDimensions> Superclass;
+  typedef SmartPointer<Self>                                       Pointer;
+  typedef SmartPointer<const Self>                                 ConstPointer;
+
+  /** New macro for creation of through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(CachedDisplacementFieldTransform, AdvancedTransform);
+
+  /** Dimension of the domain space. */
+  itkStaticConstMacro(SpaceDimension, unsigned int, NDimensions);
+
+  /** Superclass typedefs */
+  typedef typename Superclass::ScalarType                    ScalarType;
+  typedef typename Superclass::ParametersType                ParametersType;
+  typedef typename Superclass::FixedParametersType           FixedParametersType;
+  typedef typename Superclass::JacobianType                  JacobianType;
+  typedef typename Superclass::InputVectorType               InputVectorType;
+  typedef typename Superclass::OutputVectorType              OutputVectorType;
+  typedef typename Superclass::InputCovariantVectorType      InputCovariantVectorType;
+  typedef typename Superclass::OutputCovariantVectorType     OutputCovariantVectorType;
+  typedef typename Superclass::InputVnlVectorType            InputVnlVectorType;
+  typedef typename Superclass::OutputVnlVectorType           OutputVnlVectorType;
+  typedef typename Superclass::InputPointType                InputPointType;
+  typedef typename Superclass::OutputPointType               OutputPointType;
+  typedef typename Superclass::NonZeroJacobianIndicesType    NonZeroJacobianIndicesType;
+  typedef typename Superclass::SpatialJacobianType           SpatialJacobianType;
+  typedef typename Superclass::JacobianOfSpatialJacobianType JacobianOfSpatialJacobianType;
+  typedef typename Superclass::SpatialHessianType            SpatialHessianType;
+  typedef typename Superclass::JacobianOfSpatialHessianType  JacobianOfSpatialHessianType;
+
+  /** The type of the transform of which the displacements are cached. */
+  typedef Superclass                                   AdvancedTransformType;
+  typedef typename AdvancedTransformType::ConstPointer AdvancedTransformConstPointer;
+
+  /** The B-spline that interpolates the cached displacements. */
+  typedef AdvancedBSplineDeformableTransformBase<TScalarType, NDimensions> BSplineTransformBaseType;
+  typedef typename BSplineTransformBaseType::Pointer                       BSplineTransformBasePointer;
+  typedef typename BSplineTransformBaseType::ImageType                     ImageType;
+  typedef typename BSplineTransformBaseType::ImagePointer                  ImagePointer;
+  typedef typename BSplineTransformBaseType::RegionType                    RegionType;
+  typedef typename BSplineTransformBaseType::SizeType                      SizeType;
+  typedef typename BSplineTransformBaseType::SpacingType                   SpacingType;
+  typedef typename BSplineTransformBaseType::DirectionType                 DirectionType;
+  typedef typename BSplineTransformBaseType::OriginType                    OriginType;
+  typedef ContinuousIndex<ScalarType, NDimensions>                         ContinuousIndexType;
+
+  /** Set/Get the transform of which the displacements are cached. */
+  itkSetConstObjectMacro(Transform, AdvancedTransformType);
+  itkGetConstObjectMacro(Transform, AdvancedTransformType);
+
+  /** Set/Get the grid on which the displacements are sampled. The cache is
+   * used for the points from the first up to the last grid point, in each
+   * dimension.
+   */
+  itkSetMacro(GridSize, SizeType);
+  itkGetConstReferenceMacro(GridSize, SizeType);
+  itkSetMacro(GridSpacing, SpacingType);
+  itkGetConstReferenceMacro(GridSpacing, SpacingType);
+  itkSetMacro(GridOrigin, OriginType);
+  itkGetConstReferenceMacro(GridOrigin, OriginType);
+  itkSetMacro(GridDirection, DirectionType);
+  itkGetConstReferenceMacro(GridDirection, DirectionType);
+
+  /** Set/Get the order of the B-spline that interpolates the displacements:
+   * 1 (linear) or 3 (cubic). Default: 3.
+   */
+  itkSetMacro(SplineOrder, unsigned int);
+  itkGetConstMacro(SplineOrder, unsigned int);
+
+  /** Sample the displacements of the transform on the grid, and compute the
+   * B-spline that interpolates them.
+   */
+  virtual void
+  UpdateCache(void);
+
+  /** Returns true if the cache is used for this point. */
+  bool
+  IsInsideGrid(const InputPointType & point) const;
+
+  /** This transform has no parameters. */
+  void
+  SetParameters(const ParametersType &) override
+  {
+    itkExceptionMacro(<< "ERROR: SetParameters() is not implemented for CachedDisplacementFieldTransform.\n"
+                      << "Note that this transform is NOT suited for image registration.\n"
+                      << "Just use it as an (initial) fixed transform that is not optimized.");
+  }
+
+
+  /** This transform has no fixed parameters. */
+  void
+  SetFixedParameters(const FixedParametersType &) override
+  {}
+
+  /** Transform a point, by adding the cached displacement inside the grid,
+   * and by the transform itself outside the grid.
+   */
+  OutputPointType
+  TransformPoint(const InputPointType & point) const override;
+
+  /** These vector transforms are not implemented for this transform. */
+  OutputVectorType
+  TransformVector(const InputVectorType &) const override
+  {
+    itkExceptionMacro(<< "TransformVector(const InputVectorType &) is not implemented "
+                      << "for CachedDisplacementFieldTransform");
+  }
+
+
+  OutputVnlVectorType
+  TransformVector(const InputVnlVectorType &) const override
+  {
+    itkExceptionMacro(<< "TransformVector(const InputVnlVectorType &) is not implemented "
+                      << "for CachedDisplacementFieldTransform");
+  }
+
+
+  OutputCovariantVectorType
+  TransformCovariantVector(const InputCovariantVectorType &) const override
+  {
+    itkExceptionMacro(<< "TransformCovariantVector(const InputCovariantVectorType &) is not implemented "
+                      << "for CachedDisplacementFieldTransform");
+  }
+
+
+  bool
+  IsLinear(void) const override
+  {
+    return false;
+  }
+
+
+  /** The Jacobian with respect to the (zero) parameters is empty. */
+  void
+  GetJacobian(const InputPointType &,
+              JacobianType &               j,
+              NonZeroJacobianIndicesType & nonZeroJacobianIndices) const override
+  {
+    j.SetSize(SpaceDimension, 0);
+    nonZeroJacobianIndices.clear();
+  }
+
+
+  /** Compute the spatial Jacobian, of the cache inside the grid, and of the
+   * transform itself outside the grid.
+   */
+  void
+  GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
+
+  /** Compute the spatial Hessian, of the cache inside the grid, and of the
+   * transform itself outside the grid.
+   */
+  void
+  GetSpatialHessian(const InputPointType & ipp, SpatialHessianType & sh) const override;
+
+  /** The Jacobians with respect to the (zero) parameters are empty. */
+  void
+  GetJacobianOfSpatialJacobian(const InputPointType &,
+                               JacobianOfSpatialJacobianType & jsj,
+                               NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override
+  {
+    jsj.clear();
+    nonZeroJacobianIndices.clear();
+  }
+
+
+  void
+  GetJacobianOfSpatialJacobian(const InputPointType &          ipp,
+                               SpatialJacobianType &           sj,
+                               JacobianOfSpatialJacobianType & jsj,
+                               NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override
+  {
+    this->GetSpatialJacobian(ipp, sj);
+    jsj.clear();
+    nonZeroJacobianIndices.clear();
+  }
+
+
+  void
+  GetJacobianOfSpatialHessian(const InputPointType &,
+                              JacobianOfSpatialHessianType & jsh,
+                              NonZeroJacobianIndicesType &   nonZeroJacobianIndices) const override
+  {
+    jsh.clear();
+    nonZeroJacobianIndices.clear();
+  }
+
+
+  void
+  GetJacobianOfSpatialHessian(const InputPointType &         ipp,
+                              SpatialHessianType &           sh,
+                              JacobianOfSpatialHessianType & jsh,
+                              NonZeroJacobianIndicesType &   nonZeroJacobianIndices) const override
+  {
+    this->GetSpatialHessian(ipp, sh);
+    jsh.clear();
+    nonZeroJacobianIndices.clear();
+  }
+
+
+protected:
+  CachedDisplacementFieldTransform();
+  ~CachedDisplacementFieldTransform() override = default;
+
+  /** Print contents of a CachedDisplacementFieldTransform. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  CachedDisplacementFieldTransform(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  AdvancedTransformConstPointer m_Transform;
+  SizeType                      m_GridSize;
+  SpacingType                   m_GridSpacing;
+  OriginType                    m_GridOrigin;
+  DirectionType                 m_GridDirection;
+  unsigned int                  m_SplineOrder;
+
+  BSplineTransformBasePointer m_BSplineTransform;
+  ImagePointer                m_CoefficientImage;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkCachedDisplacementFieldTransform.hxx"
+#endif
+
+#endif // end #ifndef itkCachedDisplacementFieldTransform_h
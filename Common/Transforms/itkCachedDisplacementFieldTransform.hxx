@@ -0,0 +1,262 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCachedDisplacementFieldTransform_hxx
+#define itkCachedDisplacementFieldTransform_hxx
+
+#include "itkCachedDisplacementFieldTransform.h"
+#include "itkRecursiveBSplineTransform.h"
+#include "itkBSplineDecompositionImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkWorkStealingThreadPool.h"
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::CachedDisplacementFieldTransform()
+  : Superclass(0)
+{
+  this->m_GridSize.Fill(0);
+  this->m_GridSpacing.Fill(1.0);
+  this->m_GridOrigin.Fill(0.0);
+  this->m_GridDirection.SetIdentity();
+  this->m_SplineOrder = 3;
+
+  this->m_HasNonZeroSpatialHessian = this->m_SplineOrder > 1;
+  this->m_HasNonZeroJacobianOfSpatialHessian = false;
+
+} // end Constructor
+
+
+/**
+ * ********************* UpdateCache ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::UpdateCache(void)
+{
+  /** Check the settings. */
+  if (this->m_Transform.IsNull())
+  {
+    itkExceptionMacro(<< "ERROR: No transform has been set.");
+  }
+  if (this->m_SplineOrder != 1 && this->m_SplineOrder != 3)
+  {
+    itkExceptionMacro(<< "ERROR: The spline order should be 1 or 3, but is " << this->m_SplineOrder << ".");
+  }
+
+  /** A linear B-spline has a zero spatial Hessian. Outside the grid, the given transform is used. */
+  this->m_HasNonZeroSpatialHessian = this->m_SplineOrder > 1 || this->m_Transform->GetHasNonZeroSpatialHessian();
+
+  /** Pad the grid, so that the support of the B-spline lies inside the
+   * coefficient images for every point from the first up to the last grid point.
+   */
+  const IndexValueType           padding = (this->m_SplineOrder + 1) / 2;
+  typename RegionType::IndexType paddedIndex;
+  SizeType                       paddedSize;
+  for (unsigned int d = 0; d < SpaceDimension; ++d)
+  {
+    if (this->m_GridSize[d] == 0)
+    {
+      itkExceptionMacro(<< "ERROR: The grid size should be at least 1 in each dimension.");
+    }
+    paddedIndex[d] = -padding;
+    paddedSize[d] = this->m_GridSize[d] + 2 * padding;
+  }
+  const RegionType paddedRegion(paddedIndex, paddedSize);
+
+  ImagePointer displacements[SpaceDimension];
+  for (unsigned int d = 0; d < SpaceDimension; ++d)
+  {
+    displacements[d] = ImageType::New();
+    displacements[d]->SetRegions(paddedRegion);
+    displacements[d]->SetSpacing(this->m_GridSpacing);
+    displacements[d]->SetOrigin(this->m_GridOrigin);
+    displacements[d]->SetDirection(this->m_GridDirection);
+    displacements[d]->Allocate();
+  }
+
+  /** Sample the displacements of the transform, in parallel, per range of slices
+   * along the last dimension.
+   */
+  const AdvancedTransformType & transform = *this->m_Transform;
+  const auto sampleSlices =
+    [&displacements, &transform, &paddedRegion](ThreadIdType, SizeValueType begin, SizeValueType end) {
+      RegionType region = paddedRegion;
+      region.SetIndex(SpaceDimension - 1,
+                      paddedRegion.GetIndex(SpaceDimension - 1) + static_cast<IndexValueType>(begin));
+      region.SetSize(SpaceDimension - 1, end - begin);
+      for (ImageRegionConstIteratorWithIndex<ImageType> it(displacements[0], region); !it.IsAtEnd(); ++it)
+      {
+        const typename ImageType::IndexType index = it.GetIndex();
+        InputPointType                      point;
+        displacements[0]->TransformIndexToPhysicalPoint(index, point);
+        const OutputPointType transformedPoint = transform.TransformPoint(point);
+        for (unsigned int d = 0; d < SpaceDimension; ++d)
+        {
+          displacements[d]->SetPixel(index, transformedPoint[d] - point[d]);
+        }
+      }
+    };
+  WorkStealingThreadPool::GetGlobalThreadPool()->ParallelFor(paddedSize[SpaceDimension - 1], 1, sampleSlices);
+
+  /** The coefficients of a linear B-spline are the samples themselves.
+   * Those of a cubic B-spline follow from a B-spline decomposition.
+   */
+  BSplineTransformBasePointer bsplineTransform;
+  if (this->m_SplineOrder == 3)
+  {
+    typedef BSplineDecompositionImageFilter<ImageType, ImageType> DecompositionFilterType;
+    for (unsigned int d = 0; d < SpaceDimension; ++d)
+    {
+      const auto decompositionFilter = DecompositionFilterType::New();
+      decompositionFilter->SetSplineOrder(3);
+      decompositionFilter->SetInput(displacements[d]);
+      decompositionFilter->Update();
+      displacements[d] = decompositionFilter->GetOutput();
+      displacements[d]->DisconnectPipeline();
+    }
+    bsplineTransform = RecursiveBSplineTransform<TScalarType, NDimensions, 3>::New();
+  }
+  else
+  {
+    bsplineTransform = RecursiveBSplineTransform<TScalarType, NDimensions, 1>::New();
+  }
+  bsplineTransform->SetCoefficientImages(displacements);
+
+  this->m_BSplineTransform = bsplineTransform;
+  this->m_CoefficientImage = displacements[0];
+
+} // end UpdateCache()
+
+
+/**
+ * ********************* IsInsideGrid ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+bool
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::IsInsideGrid(const InputPointType & point) const
+{
+  if (this->m_CoefficientImage.IsNull())
+  {
+    return false;
+  }
+
+  ContinuousIndexType cindex;
+  this->m_CoefficientImage->TransformPhysicalPointToContinuousIndex(point, cindex);
+  for (unsigned int d = 0; d < SpaceDimension; ++d)
+  {
+    if (!(cindex[d] >= 0.0 && cindex[d] <= static_cast<ScalarType>(this->m_GridSize[d] - 1)))
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end IsInsideGrid()
+
+
+/**
+ * ********************* TransformPoint ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+typename CachedDisplacementFieldTransform<TScalarType, NDimensions>::OutputPointType
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::TransformPoint(const InputPointType & point) const
+{
+  if (this->IsInsideGrid(point))
+  {
+    return this->m_BSplineTransform->TransformPoint(point);
+  }
+  return this->m_Transform->TransformPoint(point);
+
+} // end TransformPoint()
+
+
+/**
+ * ********************* GetSpatialJacobian ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::GetSpatialJacobian(const InputPointType & ipp,
+                                                                               SpatialJacobianType &  sj) const
+{
+  if (this->IsInsideGrid(ipp))
+  {
+    this->m_BSplineTransform->GetSpatialJacobian(ipp, sj);
+  }
+  else
+  {
+    this->m_Transform->GetSpatialJacobian(ipp, sj);
+  }
+
+} // end GetSpatialJacobian()
+
+
+/**
+ * ********************* GetSpatialHessian ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::GetSpatialHessian(const InputPointType & ipp,
+                                                                              SpatialHessianType &   sh) const
+{
+  if (this->IsInsideGrid(ipp))
+  {
+    this->m_BSplineTransform->GetSpatialHessian(ipp, sh);
+  }
+  else
+  {
+    this->m_Transform->GetSpatialHessian(ipp, sh);
+  }
+
+} // end GetSpatialHessian()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template <class TScalarType, unsigned int NDimensions>
+void
+CachedDisplacementFieldTransform<TScalarType, NDimensions>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << indent << "GridSize: " << this->m_GridSize << std::endl;
+  os << indent << "GridSpacing: " << this->m_GridSpacing << std::endl;
+  os << indent << "GridOrigin: " << this->m_GridOrigin << std::endl;
+  os << indent << "GridDirection:\n" << this->m_GridDirection << std::endl;
+  os << indent << "SplineOrder: " << this->m_SplineOrder << std::endl;
+  os << indent << "BSplineTransform: " << this->m_BSplineTransform.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkCachedDisplacementFieldTransform_hxx
@@ -146,6 +146,17 @@ public:
                                            DerivativeType &                imageJacobian,
                                            NonZeroJacobianIndicesType &    nonZeroJacobianIndices) const override;
 
+  /** Compute the inner product of the Jacobian with the moving image gradient for a
+   * batch of points. The weights of up to 16 points are gathered and passed to the
+   * vectorized BSplineJacobianGradientProductKernel in one call.
+   */
+  void
+  BatchEvaluateJacobianWithImageGradientProduct(const unsigned int              numberOfPoints,
+                                                const InputPointType *          ipp,
+                                                const MovingImageGradientType * movingImageGradient,
+                                                DerivativeType *                imageJacobian,
+                                                NonZeroJacobianIndicesType *    nonZeroJacobianIndices) const override;
+
   /** Compute the spatial Jacobian of the transformation. */
   void
   GetSpatialJacobian(const InputPointType & ipp, SpatialJacobianType & sj) const override;
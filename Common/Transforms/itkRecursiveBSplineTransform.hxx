@@ -21,6 +21,9 @@
 #include "itkRecursiveBSplineTransform.h"
 
 #include "itkRecursiveBSplineTransformImplementation.h"
+#include "itkBSplineJacobianGradientProductKernel.h"
+
+#include <algorithm> // For min.
 
 
 namespace itk
@@ -222,18 +225,17 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
   IndexType                       supportIndex;
   this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndex);
 
-  /** Recursively compute the inner product of the Jacobian and the moving image gradient.
-   * The pointer has changed after this function call.
+  /** Compute the inner product of the Jacobian and the moving image gradient,
+   * using the vectorized kernel.
    */
-  // ParametersValueType migArray[ SpaceDimension ];
   double migArray[SpaceDimension]; // InternalFloatType
   for (unsigned int j = 0; j < SpaceDimension; ++j)
   {
     migArray[j] = movingImageGradient[j];
   }
   ParametersValueType * imageJacobianPointer = imageJacobian.data_block();
-  RecursiveBSplineTransformImplementation<SpaceDimension, SpaceDimension, SplineOrder, TScalar>::
-    EvaluateJacobianWithImageGradientProduct(imageJacobianPointer, migArray, weightsArray1D, 1.0);
+  BSplineJacobianGradientProductKernel::Evaluate(
+    SpaceDimension, SplineOrder, 1, weightsArray1D, migArray, &imageJacobianPointer);
 
   /** Setup support region needed for the nonZeroJacobianIndices. */
   RegionType supportRegion;
@@ -248,6 +250,84 @@ RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::EvaluateJacobianW
 } // end EvaluateJacobianWithImageGradientProduct()
 
 
+/**
+ * ********************* BatchEvaluateJacobianWithImageGradientProduct ****************************
+ */
+
+template <class TScalar, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+RecursiveBSplineTransform<TScalar, NDimensions, VSplineOrder>::BatchEvaluateJacobianWithImageGradientProduct(
+  const unsigned int              numberOfPoints,
+  const InputPointType *          ipp,
+  const MovingImageGradientType * movingImageGradient,
+  DerivativeType *                imageJacobian,
+  NonZeroJacobianIndicesType *    nonZeroJacobianIndices) const
+{
+  const unsigned int           numberOfWeights = RecursiveBSplineWeightFunctionType::NumberOfWeights;
+  const NumberOfParametersType nnzji = this->GetNumberOfNonZeroJacobianIndices();
+
+  /** Buffers for one batch: the 1D weights and gradients of all points are
+   * stored contiguously, such that the kernel can process them in one call.
+   */
+  const unsigned int    batchSize = 16;
+  double                weightsBatch[batchSize * numberOfWeights];
+  double                migBatch[batchSize * SpaceDimension];
+  ParametersValueType * imageJacobianPointers[batchSize];
+  IndexType             supportIndices[batchSize];
+  unsigned int          pointIds[batchSize];
+
+  RegionType supportRegion;
+  supportRegion.SetSize(this->m_SupportSize);
+
+  for (unsigned int first = 0; first < numberOfPoints; first += batchSize)
+  {
+    /** Compute the weights of the points in this batch inside the valid region. */
+    const unsigned int last = std::min(first + batchSize, numberOfPoints);
+    unsigned int       numberOfValidPoints = 0;
+    for (unsigned int i = first; i < last; ++i)
+    {
+      ContinuousIndexType cindex;
+      this->TransformPointToContinuousGridIndex(ipp[i], cindex);
+
+      /** NOTE: if the support region does not lie totally within the grid
+       * we assume zero displacement and zero Jacobian.
+       */
+      if (!this->InsideValidRegion(cindex))
+      {
+        nonZeroJacobianIndices[i].resize(nnzji);
+        for (NumberOfParametersType mu = 0; mu < nnzji; ++mu)
+        {
+          nonZeroJacobianIndices[i][mu] = mu;
+        }
+        continue;
+      }
+
+      WeightsType weights1D(weightsBatch + numberOfValidPoints * numberOfWeights, numberOfWeights, false);
+      this->m_RecursiveBSplineWeightFunction->Evaluate(cindex, weights1D, supportIndices[numberOfValidPoints]);
+      for (unsigned int j = 0; j < SpaceDimension; ++j)
+      {
+        migBatch[numberOfValidPoints * SpaceDimension + j] = movingImageGradient[i][j];
+      }
+      imageJacobianPointers[numberOfValidPoints] = imageJacobian[i].data_block();
+      pointIds[numberOfValidPoints] = i;
+      ++numberOfValidPoints;
+    }
+
+    /** Compute the inner products of the whole batch at once. */
+    BSplineJacobianGradientProductKernel::Evaluate(
+      SpaceDimension, SplineOrder, numberOfValidPoints, weightsBatch, migBatch, imageJacobianPointers);
+
+    /** Compute the nonzero Jacobian indices. */
+    for (unsigned int v = 0; v < numberOfValidPoints; ++v)
+    {
+      supportRegion.SetIndex(supportIndices[v]);
+      this->ComputeNonZeroJacobianIndices(nonZeroJacobianIndices[pointIds[v]], supportRegion);
+    }
+  }
+
+} // end BatchEvaluateJacobianWithImageGradientProduct()
+
+
 /**
  * ********************* GetSpatialJacobian ****************************
  */
@@ -62,6 +62,9 @@ namespace itk
  * This filter is implemented as a multithreaded filter.  It provides a
  * ThreadedGenerateData() method for its implementation.
  *
+ * Only the requested region of the output is allocated and computed, so the
+ * output can be generated in pieces, for example by a streaming writer.
+ *
  * \author Marius Staring, Leiden University Medical Center, The Netherlands.
  *
  * This class was taken from the Insight Journal paper:
@@ -21,6 +21,8 @@
 #include "itkObject.h"
 #include "itkArray.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -33,6 +35,12 @@ namespace itk
  * on a denser grid. Therefore, the user needs to supply the old B-spline grid
  * (region, spacing, origin, direction), and the required B-spline grid.
  *
+ * When both grids have the same direction, the upsampling is separable. It is
+ * then done line by line, one dimension after the other, on blocks of lines
+ * that fit in the cache, on the global WorkStealingThreadPool, with the vectorized
+ * BSplineCoefficientUpsampleKernel. Otherwise, the ResampleImageFilter and the
+ * BSplineDecompositionImageFilter are used.
+ *
  */
 
 template <class TArray, class TImage>
@@ -92,6 +100,13 @@ public:
   /** Set the B-spline order. */
   itkSetMacro(BSplineOrder, unsigned int);
 
+  /** Use the separable implementation when possible. Default: true.
+   * When false, the ITK image filters are always used.
+   */
+  itkSetMacro(UseSeparableUpsampling, bool);
+  itkGetConstMacro(UseSeparableUpsampling, bool);
+  itkBooleanMacro(UseSeparableUpsampling);
+
   /** Compute the output parameter array. */
   virtual void
   UpsampleParameters(const ArrayType & param_in, ArrayType & param_out);
@@ -111,11 +126,27 @@ protected:
   virtual bool
   DoUpsampling(void);
 
+  /** Upsample line by line, one dimension after the other. */
+  virtual void
+  UpsampleParametersSeparable(const ArrayType & param_in, ArrayType & param_out);
+
+  /** Upsample using the ResampleImageFilter and the BSplineDecompositionImageFilter. */
+  virtual void
+  UpsampleParametersUsingImageFilters(const ArrayType & param_in, ArrayType & param_out);
+
 private:
   UpsampleBSplineParametersFilter(const Self &) = delete;
   void
   operator=(const Self &) = delete;
 
+  /** Compute for each required grid point along the given dimension the
+   * indices and weights of the current coefficients that contribute to it.
+   */
+  void
+  ComputeResampleWeights(unsigned int                dimension,
+                         std::vector<unsigned int> & indices,
+                         std::vector<double> &       weights) const;
+
   /** Private member variables. */
   OriginType    m_CurrentGridOrigin;
   SpacingType   m_CurrentGridSpacing;
@@ -126,6 +157,7 @@ private:
   DirectionType m_RequiredGridDirection;
   RegionType    m_RequiredGridRegion;
   unsigned int  m_BSplineOrder;
+  bool          m_UseSeparableUpsampling;
 };
 
 } // end namespace itk
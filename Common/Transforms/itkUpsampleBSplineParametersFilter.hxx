@@ -20,9 +20,14 @@
 
 #include "itkUpsampleBSplineParametersFilter.h"
 
+#include "itkBSplineCoefficientUpsampleKernel.h"
 #include "itkBSplineResampleImageFunction.h"
 #include "itkBSplineDecompositionImageFilter.h"
 #include "itkResampleImageFilter.h"
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm> // For copy and min.
+#include <cmath>     // For floor.
 
 namespace itk
 {
@@ -35,6 +40,7 @@ template <class TArray, class TImage>
 UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleBSplineParametersFilter()
 {
   this->m_BSplineOrder = 3;
+  this->m_UseSeparableUpsampling = true;
 
   // Initialize grid settings.
   this->m_CurrentGridOrigin.Fill(0.0);
@@ -62,6 +68,198 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
     return;
   }
 
+  /** The upsampling is separable if the grids have the same direction. */
+  if (this->m_UseSeparableUpsampling && this->m_CurrentGridDirection == this->m_RequiredGridDirection &&
+      this->m_BSplineOrder <= 5)
+  {
+    this->UpsampleParametersSeparable(parameters_in, parameters_out);
+  }
+  else
+  {
+    this->UpsampleParametersUsingImageFilters(parameters_in, parameters_out);
+  }
+
+} // end UpsampleParameters()
+
+
+/**
+ * ******************* UpsampleParametersSeparable *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParametersSeparable(const ArrayType & parameters_in,
+                                                                             ArrayType &       parameters_out)
+{
+  typedef BSplineCoefficientUpsampleKernel KernelType;
+  constexpr unsigned int                   Lanes = KernelType::NumberOfLanes;
+
+  /** Create the new vector of output parameters, with the correct size. */
+  const SizeValueType requiredNumberOfPixels = this->m_RequiredGridRegion.GetNumberOfPixels();
+  parameters_out.SetSize(requiredNumberOfPixels * Dimension);
+
+  /** The parameters are processed as one array of size [ currentGridSize, Dimension ].
+   * For each dimension d all lines along d are upsampled, after which the
+   * array has the required size along d. The intermediate results alternate
+   * between two buffers.
+   */
+  typename RegionType::SizeType size = this->m_CurrentGridRegion.GetSize();
+  std::vector<ValueType>        buffers[2];
+  std::vector<unsigned int>     indices;
+  std::vector<double>           weights;
+  const unsigned int            numberOfWeights = this->m_BSplineOrder + 1;
+
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    this->ComputeResampleWeights(d, indices, weights);
+
+    /** Element n of line l starts at (l / inner) * length * inner + (l % inner), with stride inner. */
+    const SizeValueType inputLength = size[d];
+    const SizeValueType outputLength = this->m_RequiredGridRegion.GetSize(d);
+    SizeValueType       inner = 1;
+    SizeValueType       outer = Dimension;
+    for (unsigned int e = 0; e < d; ++e)
+    {
+      inner *= size[e];
+    }
+    for (unsigned int e = d + 1; e < Dimension; ++e)
+    {
+      outer *= size[e];
+    }
+    const SizeValueType numberOfLines = inner * outer;
+
+    /** Get the source and target of this pass. */
+    const ValueType * source = d == 0 ? parameters_in.data_block() : buffers[(d + 1) % 2].data();
+    ValueType *       target = parameters_out.data_block();
+    if (d + 1 < Dimension)
+    {
+      buffers[d % 2].resize(numberOfLines * outputLength);
+      target = buffers[d % 2].data();
+    }
+
+    /** Process the lines in blocks of Lanes lines. The block of the input and
+     * of the output lines are small enough to stay in the cache.
+     */
+    const SizeValueType numberOfBlocks = (numberOfLines + Lanes - 1) / Lanes;
+    const auto          upsampleBlocks = [&](ThreadIdType, SizeValueType firstBlock, SizeValueType lastBlock) {
+      std::vector<double> inputBlock(inputLength * Lanes);
+      std::vector<double> outputBlock(outputLength * Lanes);
+
+      for (SizeValueType block = firstBlock; block < lastBlock; ++block)
+      {
+        /** The last block is padded with copies of the last line. */
+        const SizeValueType firstLine = block * Lanes;
+        const SizeValueType numberOfLanes = std::min<SizeValueType>(Lanes, numberOfLines - firstLine);
+        SizeValueType       inputStart[Lanes];
+        SizeValueType       outputStart[Lanes];
+        for (unsigned int c = 0; c < Lanes; ++c)
+        {
+          const SizeValueType line = firstLine + std::min<SizeValueType>(c, numberOfLanes - 1);
+          inputStart[c] = (line / inner) * inputLength * inner + line % inner;
+          outputStart[c] = (line / inner) * outputLength * inner + line % inner;
+        }
+
+        for (SizeValueType n = 0; n < inputLength; ++n)
+        {
+          for (unsigned int c = 0; c < Lanes; ++c)
+          {
+            inputBlock[n * Lanes + c] = static_cast<double>(source[inputStart[c] + n * inner]);
+          }
+        }
+
+        KernelType::Resample(
+          outputLength, numberOfWeights, indices.data(), weights.data(), inputBlock.data(), outputBlock.data());
+        KernelType::Decompose(outputLength, this->m_BSplineOrder, outputBlock.data());
+
+        for (SizeValueType n = 0; n < outputLength; ++n)
+        {
+          for (unsigned int c = 0; c < numberOfLanes; ++c)
+          {
+            target[outputStart[c] + n * inner] = static_cast<ValueType>(outputBlock[n * Lanes + c]);
+          }
+        }
+      }
+    };
+    WorkStealingThreadPool::GetGlobalThreadPool()->ParallelFor(numberOfBlocks, 0, upsampleBlocks);
+
+    size[d] = outputLength;
+  }
+
+} // end UpsampleParametersSeparable()
+
+
+/**
+ * ******************* ComputeResampleWeights *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::ComputeResampleWeights(unsigned int                dimension,
+                                                                        std::vector<unsigned int> & indices,
+                                                                        std::vector<double> &       weights) const
+{
+  const unsigned int  splineOrder = this->m_BSplineOrder;
+  const unsigned int  numberOfWeights = splineOrder + 1;
+  const long          currentLength = static_cast<long>(this->m_CurrentGridRegion.GetSize(dimension));
+  const SizeValueType requiredLength = this->m_RequiredGridRegion.GetSize(dimension);
+  indices.assign(requiredLength * numberOfWeights, 0);
+  weights.assign(requiredLength * numberOfWeights, 0.0);
+
+  /** The grids have the same direction, so the continuous index of a required
+   * grid point in the current grid along this dimension is an affine function
+   * of its index along this dimension only.
+   */
+  const DirectionType inverseDirection(this->m_CurrentGridDirection.GetInverse());
+  const auto          originOffset = inverseDirection * (this->m_RequiredGridOrigin - this->m_CurrentGridOrigin);
+  const double        currentSpacing = this->m_CurrentGridSpacing[dimension];
+  const double        step = this->m_RequiredGridSpacing[dimension] / currentSpacing;
+  const double        start = originOffset[dimension] / currentSpacing +
+                       step * static_cast<double>(this->m_RequiredGridRegion.GetIndex(dimension)) -
+                       static_cast<double>(this->m_CurrentGridRegion.GetIndex(dimension));
+
+  /** The mirror boundary conditions of the BSplineInterpolateImageFunction. */
+  const auto mirror = [currentLength](long m) {
+    if (currentLength == 1)
+    {
+      return 0L;
+    }
+    const long length2 = 2 * (currentLength - 1);
+    m = m < 0 ? -m - length2 * (-m / length2) : m - length2 * (m / length2);
+    return currentLength <= m ? length2 - m : m;
+  };
+
+  for (SizeValueType i = 0; i < requiredLength; ++i)
+  {
+    /** Points outside the current grid get zero weights, since the
+     * ResampleImageFilter sets them to zero.
+     */
+    const double x = start + step * static_cast<double>(i);
+    if (!(x >= -0.5 && x < static_cast<double>(currentLength) - 0.5))
+    {
+      continue;
+    }
+
+    const long first = static_cast<long>(std::floor(splineOrder % 2 == 1 ? x : x + 0.5)) - splineOrder / 2;
+    for (unsigned int k = 0; k < numberOfWeights; ++k)
+    {
+      const long m = first + static_cast<long>(k);
+      indices[i * numberOfWeights + k] = static_cast<unsigned int>(mirror(m));
+      weights[i * numberOfWeights + k] = BSplineCoefficientUpsampleKernel::EvaluateBSpline(splineOrder, x - m);
+    }
+  }
+
+} // end ComputeResampleWeights()
+
+
+/**
+ * ******************* UpsampleParametersUsingImageFilters *******************
+ */
+
+template <class TArray, class TImage>
+void
+UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParametersUsingImageFilters(const ArrayType & parameters_in,
+                                                                                     ArrayType &       parameters_out)
+{
   /** Typedefs. */
   typedef itk::ResampleImageFilter<ImageType, ImageType>             UpsampleFilterType;
   typedef itk::BSplineResampleImageFunction<ImageType, ValueType>    CoefficientUpsampleFunctionType;
@@ -107,6 +305,7 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
     typename DecompositionFilterType::Pointer         decompositionFilter = DecompositionFilterType::New();
 
     /** Setup the upsampler. */
+    coeffUpsampleFunction->SetSplineOrder(this->m_BSplineOrder);
     upsampler->SetInterpolator(coeffUpsampleFunction);
     upsampler->SetSize(this->m_RequiredGridRegion.GetSize());
     upsampler->SetOutputStartIndex(this->m_RequiredGridRegion.GetIndex());
@@ -147,7 +346,7 @@ UpsampleBSplineParametersFilter<TArray, TImage>::UpsampleParameters(const ArrayT
 
   } // end for dimension loop
 
-} // end UpsampleParameters()
+} // end UpsampleParametersUsingImageFilters()
 
 
 /**
@@ -189,6 +388,7 @@ UpsampleBSplineParametersFilter<TArray, TImage>::PrintSelf(std::ostream & os, In
   os << indent << "RequiredGridRegion: " << this->m_RequiredGridRegion << std::endl;
 
   os << indent << "BSplineOrder: " << this->m_BSplineOrder << std::endl;
+  os << indent << "UseSeparableUpsampling: " << this->m_UseSeparableUpsampling << std::endl;
 
 } // end PrintSelf()
 
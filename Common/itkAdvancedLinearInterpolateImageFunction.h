@@ -19,6 +19,10 @@
 #define itkAdvancedLinearInterpolateImageFunction_h
 
 #include "itkLinearInterpolateImageFunction.h"
+#include "itkBrickedImageBuffer.h"
+#include "itkTrilinearInterpolationKernel.h"
+
+#include <type_traits>
 
 namespace itk
 {
@@ -50,6 +54,19 @@ namespace itk
  * We opt to subtract a small number from x, which is computationally efficient,
  * gives cleaner code, and almost exactly the same interpolated value.
  *
+ * With UseBrickedLayout, SetInputImage() makes a copy of the image in a
+ * BrickedImageBuffer, from which EvaluateValueAndDerivativeAtContinuousIndex()
+ * reads the pixels. This gives the same results, but reads fewer cache lines
+ * for random positions in large 3D images, at the cost of a copy of the image.
+ *
+ * The bricked copy is read by EvaluateAtContinuousIndex() as well as by
+ * EvaluateValueAndDerivativeAtContinuousIndex().
+ *
+ * EvaluateAtContinuousIndices() and EvaluateValueAndDerivativeAtContinuousIndices()
+ * evaluate a batch of points at once. For 3D float and double images, which are
+ * not copied, they use the vectorized TrilinearInterpolationKernel; otherwise
+ * they evaluate the points one by one.
+ *
  * \sa VectorAdvancedLinearInterpolateImageFunction
  *
  * \ingroup ImageFunctions ImageInterpolators
@@ -101,6 +118,21 @@ public:
   /** Derivative typedef support */
   typedef CovariantVector<OutputType, itkGetStaticConstMacro(ImageDimension)> CovariantVectorType;
 
+  /** Set the input image. Copies the image when UseBrickedLayout is on. */
+  void
+  SetInputImage(const InputImageType * ptr) override;
+
+  /** Set/Get whether the pixels are read from a bricked copy of the input image.
+   * Should be set before the input image. Default off.
+   */
+  itkSetMacro(UseBrickedLayout, bool);
+  itkGetConstMacro(UseBrickedLayout, bool);
+  itkBooleanMacro(UseBrickedLayout);
+
+  /** Method to compute the value. Reads the copy of the input image, if there is one. */
+  OutputType
+  EvaluateAtContinuousIndex(const ContinuousIndexType & x) const override;
+
   /** Method to compute the derivative. */
   CovariantVectorType
   EvaluateDerivativeAtContinuousIndex(const ContinuousIndexType & x) const;
@@ -114,6 +146,27 @@ public:
     return this->EvaluateValueAndDerivativeOptimized(Dispatch<ImageDimension>(), x, value, deriv);
   }
 
+  /** Method to compute the values at a batch of points, as EvaluateAtContinuousIndex() does. */
+  void
+  EvaluateAtContinuousIndices(const unsigned int          numberOfPoints,
+                              const ContinuousIndexType * x,
+                              OutputType *                values) const
+  {
+    return this->EvaluateAtContinuousIndicesOptimized(UseTrilinearKernelType(), numberOfPoints, x, values);
+  }
+
+  /** Method to compute the values and the derivatives at a batch of points,
+   * as EvaluateValueAndDerivativeAtContinuousIndex() does.
+   */
+  void
+  EvaluateValueAndDerivativeAtContinuousIndices(const unsigned int          numberOfPoints,
+                                                const ContinuousIndexType * x,
+                                                OutputType *                values,
+                                                CovariantVectorType *       derivs) const
+  {
+    return this->EvaluateValueAndDerivativeAtContinuousIndicesOptimized(
+      UseTrilinearKernelType(), numberOfPoints, x, values, derivs);
+  }
 
 protected:
   AdvancedLinearInterpolateImageFunction();
@@ -124,6 +177,50 @@ private:
   void
   operator=(const Self &) = delete;
 
+  /** The bricked copy of the input image. */
+  typedef BrickedImageBuffer<InputPixelType, itkGetStaticConstMacro(ImageDimension)> BrickedImageType;
+
+  bool             m_UseBrickedLayout;
+  BrickedImageType m_BrickedImage;
+
+  /** Get the values at the corners of a cell from the bricked copy. The index of
+   * corner c along dimension d is upperIndex[d] if bit d of c is set, and lowerIndex[d] otherwise.
+   */
+  static void
+  GetCornerValues(const BrickedImageType & buffer,
+                  const IndexType &        lowerIndex,
+                  const IndexType &        upperIndex,
+                  RealType *               values)
+  {
+    SizeValueType offsets[ImageDimension][2];
+    for (unsigned int d = 0; d < ImageDimension; ++d)
+    {
+      offsets[d][0] = buffer.GetOffset(d, lowerIndex[d]);
+      offsets[d][1] = buffer.GetOffset(d, upperIndex[d]);
+    }
+    for (unsigned int c = 0; c < (1u << ImageDimension); ++c)
+    {
+      SizeValueType offset = 0;
+      for (unsigned int d = 0; d < ImageDimension; ++d)
+      {
+        offset += offsets[d][(c >> d) & 1u];
+      }
+      values[c] = buffer.GetPixelAtOffset(offset);
+    }
+  }
+
+  /** Get the values at the corners of a cell from the copy of the input image. Returns false if there is none. */
+  bool
+  GetCornerValuesFromCopy(const IndexType & lowerIndex, const IndexType & upperIndex, RealType * values) const
+  {
+    if (!this->m_BrickedImage.IsEmpty())
+    {
+      GetCornerValues(this->m_BrickedImage, lowerIndex, upperIndex, values);
+      return true;
+    }
+    return false;
+  }
+
   /** Helper struct to select the correct dimension. */
   struct DispatchBase
   {};
@@ -131,6 +228,57 @@ private:
   struct Dispatch : public DispatchBase
   {};
 
+  /** Helper type to select the TrilinearInterpolationKernel for the batched evaluation. */
+  typedef std::integral_constant<bool,
+                                 ImageDimension == 3 && (std::is_same<InputPixelType, float>::value ||
+                                                         std::is_same<InputPixelType, double>::value)>
+    UseTrilinearKernelType;
+
+  /** The number of points passed to the TrilinearInterpolationKernel at once. */
+  itkStaticConstMacro(KernelBatchSize, unsigned int, 64);
+
+  /** Method to compute the values at a batch of points. Kernel specialization. */
+  void
+  EvaluateAtContinuousIndicesOptimized(const std::true_type &,
+                                       const unsigned int          numberOfPoints,
+                                       const ContinuousIndexType * x,
+                                       OutputType *                values) const;
+
+  /** Method to compute the values at a batch of points. Generic. */
+  void
+  EvaluateAtContinuousIndicesOptimized(const std::false_type &,
+                                       const unsigned int          numberOfPoints,
+                                       const ContinuousIndexType * x,
+                                       OutputType *                values) const
+  {
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      values[i] = this->EvaluateAtContinuousIndex(x[i]);
+    }
+  }
+
+  /** Method to compute the values and the derivatives at a batch of points. Kernel specialization. */
+  void
+  EvaluateValueAndDerivativeAtContinuousIndicesOptimized(const std::true_type &,
+                                                         const unsigned int          numberOfPoints,
+                                                         const ContinuousIndexType * x,
+                                                         OutputType *                values,
+                                                         CovariantVectorType *       derivs) const;
+
+  /** Method to compute the values and the derivatives at a batch of points. Generic. */
+  void
+  EvaluateValueAndDerivativeAtContinuousIndicesOptimized(const std::false_type &,
+                                                         const unsigned int          numberOfPoints,
+                                                         const ContinuousIndexType * x,
+                                                         OutputType *                values,
+                                                         CovariantVectorType *       derivs) const
+  {
+    for (unsigned int i = 0; i < numberOfPoints; ++i)
+    {
+      this->EvaluateValueAndDerivativeAtContinuousIndex(x[i], values[i], derivs[i]);
+    }
+  }
+
   /** Method to compute both the value and the derivative. 2D specialization. */
   inline void
   EvaluateValueAndDerivativeOptimized(const Dispatch<2> &,
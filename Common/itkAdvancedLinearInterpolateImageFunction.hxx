@@ -22,6 +22,8 @@
 
 #include "vnl/vnl_math.h"
 
+#include <algorithm>
+
 namespace itk
 {
 
@@ -30,7 +32,206 @@ namespace itk
  */
 
 template <class TInputImage, class TCoordRep>
-AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::AdvancedLinearInterpolateImageFunction() = default;
+AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::AdvancedLinearInterpolateImageFunction()
+{
+  this->m_UseBrickedLayout = false;
+} // end Constructor
+
+
+/**
+ * ***************** SetInputImage ***********************
+ */
+
+template <class TInputImage, class TCoordRep>
+void
+AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::SetInputImage(const InputImageType * ptr)
+{
+  this->Superclass::SetInputImage(ptr);
+
+  /** Release the old copy before making a new one. */
+  this->m_BrickedImage.Clear();
+  if (ptr != nullptr && this->m_UseBrickedLayout)
+  {
+    this->m_BrickedImage.CopyImage(ptr);
+  }
+
+} // end SetInputImage()
+
+
+/**
+ * ***************** EvaluateAtContinuousIndex ***********************
+ */
+
+template <class TInputImage, class TCoordRep>
+auto
+AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateAtContinuousIndex(
+  const ContinuousIndexType & x) const -> OutputType
+{
+  if (this->m_BrickedImage.IsEmpty())
+  {
+    return this->Superclass::EvaluateAtContinuousIndex(x);
+  }
+
+  /** Compute the corners and the distances as the superclass does: the lower index is
+   * clamped to the start index, the upper index to the end index, and the distance to 0.
+   */
+  IndexType lowerIndex;
+  IndexType upperIndex;
+  double    dist[ImageDimension];
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    lowerIndex[dim] = std::max(Math::Floor<IndexValueType>(x[dim]), this->m_StartIndex[dim]);
+    upperIndex[dim] = std::min(lowerIndex[dim] + 1, this->m_EndIndex[dim]);
+    dist[dim] = std::max(x[dim] - static_cast<double>(lowerIndex[dim]), 0.0);
+  }
+
+  RealType corners[1u << ImageDimension];
+  this->GetCornerValuesFromCopy(lowerIndex, upperIndex, corners);
+
+  /** Multilinear interpolation, one dimension at a time. */
+  unsigned int numberOfValues = 1u << ImageDimension;
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    numberOfValues /= 2;
+    for (unsigned int c = 0; c < numberOfValues; ++c)
+    {
+      corners[c] = corners[2 * c] + dist[dim] * (corners[2 * c + 1] - corners[2 * c]);
+    }
+  }
+  return static_cast<OutputType>(corners[0]);
+
+} // end EvaluateAtContinuousIndex()
+
+
+/**
+ * ***************** EvaluateAtContinuousIndicesOptimized ***********************
+ */
+
+template <class TInputImage, class TCoordRep>
+void
+AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateAtContinuousIndicesOptimized(
+  const std::true_type &,
+  const unsigned int          numberOfPoints,
+  const ContinuousIndexType * x,
+  OutputType *                values) const
+{
+  /** The kernel reads the input image itself, not the bricked copy. */
+  if (!this->m_BrickedImage.IsEmpty())
+  {
+    return this->EvaluateAtContinuousIndicesOptimized(std::false_type(), numberOfPoints, x, values);
+  }
+
+  const InputImageType * inputImage = this->GetInputImage();
+  std::int64_t           size[ImageDimension];
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    size[dim] = static_cast<std::int64_t>(inputImage->GetBufferedRegion().GetSize(dim));
+  }
+
+  /** The kernel takes the continuous indices per dimension, relative to the start index. */
+  double         indices[ImageDimension][KernelBatchSize];
+  const double * indexPointers[ImageDimension];
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    indexPointers[dim] = indices[dim];
+  }
+
+  for (unsigned int first = 0; first < numberOfPoints; first += KernelBatchSize)
+  {
+    const unsigned int n = std::min(numberOfPoints - first, static_cast<unsigned int>(KernelBatchSize));
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        indices[dim][i] = x[first + i][dim] - static_cast<double>(this->m_StartIndex[dim]);
+      }
+    }
+    TrilinearInterpolationKernel::EvaluateValue(inputImage->GetBufferPointer(), size, n, indexPointers, values + first);
+  }
+
+} // end EvaluateAtContinuousIndicesOptimized()
+
+
+/**
+ * ***************** EvaluateValueAndDerivativeAtContinuousIndicesOptimized ***********************
+ */
+
+template <class TInputImage, class TCoordRep>
+void
+AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateValueAndDerivativeAtContinuousIndicesOptimized(
+  const std::true_type &,
+  const unsigned int          numberOfPoints,
+  const ContinuousIndexType * x,
+  OutputType *                values,
+  CovariantVectorType *       derivs) const
+{
+  /** The kernel reads the input image itself, not the bricked copy, and needs two pixels along each dimension. */
+  const InputImageType * inputImage = this->GetInputImage();
+  std::int64_t           size[ImageDimension];
+  bool                   useKernel = this->m_BrickedImage.IsEmpty();
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    size[dim] = static_cast<std::int64_t>(inputImage->GetBufferedRegion().GetSize(dim));
+    useKernel &= size[dim] >= 2;
+  }
+  if (!useKernel)
+  {
+    return this->EvaluateValueAndDerivativeAtContinuousIndicesOptimized(
+      std::false_type(), numberOfPoints, x, values, derivs);
+  }
+
+  /** The gradient with respect to the index is divided by the spacing and
+   * rotated by the direction cosines, as TransformLocalVectorToPhysicalVector() does.
+   */
+  double indexToPhysicalGradient[ImageDimension * ImageDimension];
+  for (unsigned int i = 0; i < ImageDimension; ++i)
+  {
+    for (unsigned int j = 0; j < ImageDimension; ++j)
+    {
+      indexToPhysicalGradient[i * ImageDimension + j] =
+        inputImage->GetDirection()(i, j) / inputImage->GetSpacing()[j];
+    }
+  }
+
+  /** The kernel takes the continuous indices and returns the gradients per dimension. */
+  double         indices[ImageDimension][KernelBatchSize];
+  double         gradients[ImageDimension][KernelBatchSize];
+  const double * indexPointers[ImageDimension];
+  double *       gradientPointers[ImageDimension];
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    indexPointers[dim] = indices[dim];
+    gradientPointers[dim] = gradients[dim];
+  }
+
+  for (unsigned int first = 0; first < numberOfPoints; first += KernelBatchSize)
+  {
+    const unsigned int n = std::min(numberOfPoints - first, static_cast<unsigned int>(KernelBatchSize));
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        indices[dim][i] = x[first + i][dim] - static_cast<double>(this->m_StartIndex[dim]);
+      }
+    }
+    TrilinearInterpolationKernel::EvaluateValueAndGradient(inputImage->GetBufferPointer(),
+                                                           size,
+                                                           indexToPhysicalGradient,
+                                                           n,
+                                                           indexPointers,
+                                                           values + first,
+                                                           gradientPointers);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+      for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+      {
+        derivs[first + i][dim] = gradients[dim][i];
+      }
+    }
+  }
+
+} // end EvaluateValueAndDerivativeAtContinuousIndicesOptimized()
+
 
 /**
  * ***************** EvaluateDerivativeAtContinuousIndex ***********************
@@ -125,15 +326,28 @@ AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateValueAnd
     dinv[dim] = 1.0 - dist[dim];
   }
 
-  /** Get the 4 corner values. */
-  const RealType val00 = inputImage->GetPixel(baseIndex);
-  ++baseIndex[0];
-  const RealType val10 = inputImage->GetPixel(baseIndex);
-  --baseIndex[0];
-  ++baseIndex[1];
-  const RealType val01 = inputImage->GetPixel(baseIndex);
-  ++baseIndex[0];
-  const RealType val11 = inputImage->GetPixel(baseIndex);
+  /** Get the 4 corner values, from the copy of the input image if there is one. */
+  IndexType upperIndex;
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    upperIndex[dim] = baseIndex[dim] + 1;
+  }
+  RealType corners[4];
+  if (!this->GetCornerValuesFromCopy(baseIndex, upperIndex, corners))
+  {
+    corners[0] = inputImage->GetPixel(baseIndex);
+    ++baseIndex[0];
+    corners[1] = inputImage->GetPixel(baseIndex);
+    --baseIndex[0];
+    ++baseIndex[1];
+    corners[2] = inputImage->GetPixel(baseIndex);
+    ++baseIndex[0];
+    corners[3] = inputImage->GetPixel(baseIndex);
+  }
+  const RealType val00 = corners[0];
+  const RealType val10 = corners[1];
+  const RealType val01 = corners[2];
+  const RealType val11 = corners[3];
 
   /** Interpolate to get the value. */
   value = static_cast<OutputType>(val00 * dinv[0] * dinv[1] + val10 * dist[0] * dinv[1] + val01 * dinv[0] * dist[1] +
@@ -207,22 +421,41 @@ AdvancedLinearInterpolateImageFunction<TInputImage, TCoordRep>::EvaluateValueAnd
     dinv[dim] = 1.0 - dist[dim];
   }
 
-  /** Get the 8 corner values. */
-  const RealType val000 = inputImage->GetPixel(baseIndex);
-  ++baseIndex[0];
-  const RealType val100 = inputImage->GetPixel(baseIndex);
-  ++baseIndex[1];
-  const RealType val110 = inputImage->GetPixel(baseIndex);
-  ++baseIndex[2];
-  const RealType val111 = inputImage->GetPixel(baseIndex);
-  --baseIndex[1];
-  const RealType val101 = inputImage->GetPixel(baseIndex);
-  --baseIndex[0];
-  const RealType val001 = inputImage->GetPixel(baseIndex);
-  ++baseIndex[1];
-  const RealType val011 = inputImage->GetPixel(baseIndex);
-  --baseIndex[2];
-  const RealType val010 = inputImage->GetPixel(baseIndex);
+  /** Get the 8 corner values, from the copy of the input image if there is one.
+   * In the bricked copy, usually all corners are in the same brick.
+   */
+  IndexType upperIndex;
+  for (unsigned int dim = 0; dim < ImageDimension; ++dim)
+  {
+    upperIndex[dim] = baseIndex[dim] + 1;
+  }
+  RealType corners[8];
+  if (!this->GetCornerValuesFromCopy(baseIndex, upperIndex, corners))
+  {
+    corners[0] = inputImage->GetPixel(baseIndex);
+    ++baseIndex[0];
+    corners[1] = inputImage->GetPixel(baseIndex);
+    ++baseIndex[1];
+    corners[3] = inputImage->GetPixel(baseIndex);
+    ++baseIndex[2];
+    corners[7] = inputImage->GetPixel(baseIndex);
+    --baseIndex[1];
+    corners[5] = inputImage->GetPixel(baseIndex);
+    --baseIndex[0];
+    corners[4] = inputImage->GetPixel(baseIndex);
+    ++baseIndex[1];
+    corners[6] = inputImage->GetPixel(baseIndex);
+    --baseIndex[2];
+    corners[2] = inputImage->GetPixel(baseIndex);
+  }
+  const RealType val000 = corners[0];
+  const RealType val100 = corners[1];
+  const RealType val010 = corners[2];
+  const RealType val110 = corners[3];
+  const RealType val001 = corners[4];
+  const RealType val101 = corners[5];
+  const RealType val011 = corners[6];
+  const RealType val111 = corners[7];
 
   /** Interpolate to get the value. */
   value = static_cast<OutputType>(val000 * dinv[0] * dinv[1] * dinv[2] + val100 * dist[0] * dinv[1] * dinv[2] +
@@ -0,0 +1,143 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBrickedImageBuffer_h
+#define itkBrickedImageBuffer_h
+
+#include "itkImageRegion.h"
+
+#include <memory>
+#include <vector>
+
+namespace itk
+{
+
+/** \class BrickedImageBuffer
+ *
+ * \brief A copy of the pixels of an image, stored brick by brick.
+ *
+ * The buffered region of the image is divided into bricks of BrickLength
+ * pixels along each dimension. The pixels of a brick are stored contiguously,
+ * and the bricks are stored one after the other. In 3D, the 8 x 8 x 8 pixels
+ * of a brick of a float image span 32 cache lines, instead of 64 rows of
+ * different slices in the row-major layout of the image. An interpolator
+ * that reads a small neighbourhood around a random position therefore
+ * touches far fewer cache lines and pages.
+ *
+ * The offset of a pixel is the sum of one offset per dimension, which is
+ * looked up in a table. Interpolators compute the offsets of the
+ * neighbourhood with GetOffset(), and read the pixels from
+ * GetBufferPointer().
+ *
+ * The image sizes are rounded up to a multiple of BrickLength, so the copy
+ * takes at most that much more memory than the image. The copy is not
+ * updated when the image changes.
+ *
+ * \ingroup ImageFunctions
+ */
+
+template <class TPixel, unsigned int VDimension>
+class BrickedImageBuffer
+{
+public:
+  /** Typedefs. */
+  typedef TPixel                              PixelType;
+  typedef ImageRegion<VDimension>             RegionType;
+  typedef typename RegionType::IndexType      IndexType;
+  typedef typename RegionType::IndexValueType IndexValueType;
+  typedef typename RegionType::SizeType       SizeType;
+  typedef typename RegionType::SizeValueType  SizeValueType;
+
+  /** The number of pixels of a brick along each dimension. */
+  static constexpr unsigned int BrickLength = 8;
+
+  /** Copy the buffered region of an image, with the same pixel type and dimension. */
+  template <class TImage>
+  void
+  CopyImage(const TImage * image);
+
+  /** Release the copy. */
+  void
+  Clear(void);
+
+  /** Returns true if no image has been copied. */
+  bool
+  IsEmpty(void) const
+  {
+    return this->m_Buffer == nullptr;
+  }
+
+  /** The buffered region of the copied image. */
+  const RegionType &
+  GetBufferedRegion(void) const
+  {
+    return this->m_BufferedRegion;
+  }
+
+  /** The contribution of an index along one dimension to the offset of a pixel. */
+  SizeValueType
+  GetOffset(const unsigned int dimension, const IndexValueType index) const
+  {
+    return this->m_Offsets[dimension][index - this->m_BufferedRegion.GetIndex(dimension)];
+  }
+
+  /** The offset of a pixel in the buffer. */
+  SizeValueType
+  ComputeOffset(const IndexType & index) const
+  {
+    SizeValueType offset = 0;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      offset += this->GetOffset(d, index[d]);
+    }
+    return offset;
+  }
+
+  /** Get the pixel at an offset. No bounds checking is done. */
+  const PixelType &
+  GetPixelAtOffset(const SizeValueType offset) const
+  {
+    return this->m_Buffer[offset];
+  }
+
+  /** Get a pixel. No bounds checking is done. */
+  const PixelType &
+  GetPixel(const IndexType & index) const
+  {
+    return this->m_Buffer[this->ComputeOffset(index)];
+  }
+
+  /** The buffer of bricks. */
+  const PixelType *
+  GetBufferPointer(void) const
+  {
+    return this->m_Buffer.get();
+  }
+
+private:
+  RegionType                   m_BufferedRegion;
+  std::vector<SizeValueType>   m_Offsets[VDimension];
+  std::unique_ptr<PixelType[]> m_Buffer;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkBrickedImageBuffer.hxx"
+#endif
+
+#endif // end #ifndef itkBrickedImageBuffer_h
@@ -0,0 +1,121 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkBrickedImageBuffer_hxx
+#define itkBrickedImageBuffer_hxx
+
+#include "itkBrickedImageBuffer.h"
+
+#include "itkWorkStealingThreadPool.h"
+
+#include <type_traits>
+
+namespace itk
+{
+
+/**
+ * ******************* CopyImage *******************
+ */
+
+template <class TPixel, unsigned int VDimension>
+template <class TImage>
+void
+BrickedImageBuffer<TPixel, VDimension>::CopyImage(const TImage * image)
+{
+  static_assert(std::is_same<typename TImage::PixelType, PixelType>::value, "The pixel types should be equal.");
+  static_assert(TImage::ImageDimension == VDimension, "The image dimensions should be equal.");
+
+  this->Clear();
+  this->m_BufferedRegion = image->GetBufferedRegion();
+  const SizeType size = this->m_BufferedRegion.GetSize();
+
+  /** The offset of a pixel is the offset of its brick plus its offset within the brick,
+   * which are both sums over the dimensions.
+   */
+  SizeValueType brickVolume = 1;
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    brickVolume *= BrickLength;
+  }
+  SizeValueType brickStride = brickVolume;
+  SizeValueType pixelStride = 1;
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    this->m_Offsets[d].resize(size[d]);
+    for (SizeValueType i = 0; i < size[d]; ++i)
+    {
+      this->m_Offsets[d][i] = (i / BrickLength) * brickStride + (i % BrickLength) * pixelStride;
+    }
+    brickStride *= (size[d] + BrickLength - 1) / BrickLength;
+    pixelStride *= BrickLength;
+  }
+  if (this->m_BufferedRegion.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  /** The pixels in the padding of the bricks are never read, so they are not initialized. */
+  this->m_Buffer.reset(new PixelType[brickStride]);
+
+  /** Copy the image row by row, the rows in parallel. */
+  const PixelType *   source = image->GetBufferPointer();
+  PixelType *         target = this->m_Buffer.get();
+  const SizeValueType numberOfRows = this->m_BufferedRegion.GetNumberOfPixels() / size[0];
+  const auto          copyRows = [this, source, target, &size](ThreadIdType, SizeValueType begin, SizeValueType end) {
+    for (SizeValueType row = begin; row < end; ++row)
+    {
+      SizeValueType rowOffset = 0;
+      SizeValueType remainder = row;
+      for (unsigned int d = 1; d < VDimension; ++d)
+      {
+        rowOffset += this->m_Offsets[d][remainder % size[d]];
+        remainder /= size[d];
+      }
+      const PixelType *     sourceRow = source + row * size[0];
+      const SizeValueType * offsets = this->m_Offsets[0].data();
+      for (SizeValueType i = 0; i < size[0]; ++i)
+      {
+        target[rowOffset + offsets[i]] = sourceRow[i];
+      }
+    }
+  };
+  WorkStealingThreadPool::GetGlobalThreadPool()->ParallelFor(numberOfRows, 0, copyRows);
+
+} // end CopyImage()
+
+
+/**
+ * ******************* Clear *******************
+ */
+
+template <class TPixel, unsigned int VDimension>
+void
+BrickedImageBuffer<TPixel, VDimension>::Clear(void)
+{
+  this->m_BufferedRegion = RegionType();
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    std::vector<SizeValueType>().swap(this->m_Offsets[d]);
+  }
+  this->m_Buffer.reset();
+
+} // end Clear()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkBrickedImageBuffer_hxx
@@ -0,0 +1,91 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCPUDispatch_h
+#define itkCPUDispatch_h
+
+/** Helpers to select the instruction set of a kernel at run time.
+ *
+ * A kernel that supports run-time dispatch compiles its loops once per
+ * instruction set, by calling an ELASTIX_KERNEL_INLINE implementation from
+ * functions with the attributes target("avx2") and target("avx512f"), guarded
+ * by ELASTIX_CPU_DISPATCH. CPUDispatch::GetInstructionSet() then tells which
+ * of the variants to call. Runtime dispatch is supported for GCC and Clang
+ * on x86; elsewhere only the scalar variant is compiled.
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#  define ELASTIX_CPU_DISPATCH
+#  define ELASTIX_KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#  define ELASTIX_KERNEL_INLINE inline
+#endif
+
+namespace itk
+{
+namespace CPUDispatch
+{
+
+/** The instruction sets for which a kernel variant may be compiled. */
+enum InstructionSetType
+{
+  Scalar,
+  AVX2,
+  AVX512
+};
+
+
+/** The best instruction set supported by this CPU, determined once. */
+inline InstructionSetType
+GetInstructionSet(void)
+{
+  static const InstructionSetType instructionSet = [] {
+#ifdef ELASTIX_CPU_DISPATCH
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      return AVX512;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+      return AVX2;
+    }
+#endif
+    return Scalar;
+  }();
+  return instructionSet;
+}
+
+
+/** The name of the instruction set selected at run time: "AVX-512", "AVX2" or "scalar". */
+inline const char *
+GetInstructionSetName(void)
+{
+  switch (GetInstructionSet())
+  {
+    case AVX512:
+      return "AVX-512";
+    case AVX2:
+      return "AVX2";
+    default:
+      return "scalar";
+  }
+}
+
+} // end namespace CPUDispatch
+} // end namespace itk
+
+#endif // end #ifndef itkCPUDispatch_h
@@ -25,6 +25,7 @@
 #include "itkImageRandomCoordinateSampler.h"
 #include "itkImageFullSampler.h"
 #include "itkPlatformMultiThreader.h"
+#include "itkWorkStealingThreadPool.h"
 
 namespace itk
 {
@@ -123,6 +124,10 @@ public:
     this->m_Threader->SetNumberOfWorkUnits(numberOfThreads);
   }
 
+  /** Set/Get a persistent thread pool, on which the threaded computation is run if set. */
+  itkSetObjectMacro(ThreadPool, WorkStealingThreadPool);
+  itkGetModifiableObjectMacro(ThreadPool, WorkStealingThreadPool);
+
 
   virtual void
   BeforeThreadedCompute(const ParametersType & mu);
@@ -147,6 +152,7 @@ protected:
   DerivativeType                          m_ExactGradient;
   SizeValueType                           m_NumberOfParameters;
   ThreaderType::Pointer                   m_Threader;
+  WorkStealingThreadPool::Pointer         m_ThreadPool;
 
   typedef typename FixedImageType::IndexType   FixedImageIndexType;
   typedef typename FixedImageType::PointType   FixedImagePointType;
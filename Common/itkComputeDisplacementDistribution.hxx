@@ -52,6 +52,7 @@ ComputeDisplacementDistribution<TFixedImage, TTransform>::ComputeDisplacementDis
   /** Threading related variables. */
   this->m_UseMultiThread = true;
   this->m_Threader = ThreaderType::New();
+  this->m_ThreadPool = nullptr;
 
   /** Initialize the m_ThreaderParameters. */
   this->m_ThreaderParameters.st_Self = this;
@@ -316,6 +317,15 @@ template <class TFixedImage, class TTransform>
 void
 ComputeDisplacementDistribution<TFixedImage, TTransform>::LaunchComputeThreaderCallback(void) const
 {
+  if (this->m_ThreadPool.IsNotNull())
+  {
+    /** Launch on the persistent threads of the pool. */
+    this->m_ThreadPool->SingleMethodExecute(this->m_Threader->GetNumberOfWorkUnits(),
+                                            this->ComputeThreaderCallback,
+                                            const_cast<void *>(static_cast<const void *>(&this->m_ThreaderParameters)));
+    return;
+  }
+
   /** Setup threader. */
   this->m_Threader->SetSingleMethod(this->ComputeThreaderCallback,
                                     const_cast<void *>(static_cast<const void *>(&this->m_ThreaderParameters)));
@@ -20,6 +20,7 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkMultiResolutionPyramidImageFilter.h"
+#include "itkPersistentImageCache.h"
 
 namespace itk
 {
@@ -112,6 +113,12 @@ public:
   itkSetMacro(ResolutionLevel, unsigned int);
   itkGetConstMacro(ResolutionLevel, unsigned int);
 
+  /** Set/Get a persistent cache, from which the eroded mask is read if an
+   * earlier run computed it, and to which it is written otherwise. Default: none.
+   */
+  itkSetConstObjectMacro(PersistentCache, PersistentImageCache);
+  itkGetConstObjectMacro(PersistentCache, PersistentImageCache);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(SameDimensionCheck, (Concept::SameDimension<InputImageDimension, OutputImageDimension>));
@@ -140,6 +147,8 @@ private:
   bool         m_IsMovingMask;
   unsigned int m_ResolutionLevel;
   ScheduleType m_Schedule;
+
+  PersistentImageCache::ConstPointer m_PersistentCache;
 };
 
 } // end namespace itk
@@ -20,6 +20,10 @@
 
 #include "itkErodeMaskImageFilter.h"
 #include "itkParabolicErodeImageFilter.h"
+
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
 //#include "itkThresholdImageFilter.h"
 
 namespace itk
@@ -77,6 +81,25 @@ ErodeMaskImageFilter<TImage>::GenerateData(void)
     radiusarray.SetElement(i, radius);
   }
 
+  /** Reuse the eroded mask computed by an earlier run, if it is in the cache. */
+  const bool                     useCache = this->m_PersistentCache.IsNotNull() && this->m_PersistentCache->IsEnabled();
+  PersistentImageCache::HashType inputHash = 0;
+  std::ostringstream             settings;
+  if (useCache)
+  {
+    settings << std::setprecision(17) << this->GetNameOfClass() << typeid(OutputImageType).name() << " radius "
+             << radiusarray;
+    inputHash = PersistentImageCache::ComputeImageHash(this->GetInput());
+
+    typename OutputImageType::Pointer cachedImage =
+      this->m_PersistentCache->ReadImage<OutputImageType>("erodedmask", inputHash, settings.str());
+    if (cachedImage.IsNotNull())
+    {
+      this->GraftOutput(cachedImage);
+      return;
+    }
+  }
+
   /** Threshold the data first. Every voxel with intensity >= 1 is used.
   // Not needed since IsInside of a mask checks for != 0.
   typename ThresholdFilterType::Pointer threshold = ThresholdFilterType::New();
@@ -97,6 +120,11 @@ ErodeMaskImageFilter<TImage>::GenerateData(void)
    */
   this->GraftOutput(erosion->GetOutput());
 
+  if (useCache)
+  {
+    this->m_PersistentCache->WriteImage("erodedmask", inputHash, settings.str(), this->GetOutput());
+  }
+
 } // end GenerateData()
 
 
@@ -20,6 +20,7 @@
 
 #include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkSmoothingRecursiveGaussianImageFilter.h"
+#include "itkPersistentImageCache.h"
 
 namespace itk
 {
@@ -96,7 +97,14 @@ namespace itk
  *
  * The GenericMultiResolutionPyramidImageFilter provides direct control to
  * compute only single level of the pyramid via SetCurrentLevel() and
- * SetComputeOnlyForCurrentLevel() methods.
+ * SetComputeOnlyForCurrentLevel() methods. In that mode, a level is only
+ * computed when it is updated, and the outputs of all other levels are
+ * released. ReleaseCurrentLevel() also releases the current level, such that
+ * a registration needs the memory of only one level at a time.
+ *
+ * When a PersistentImageCache is set, every level is first looked up in the
+ * cache, by the hash of the input image and the settings of that level.
+ * Levels that are not found are computed and written to the cache.
  *
  * \author Denis P. Shamonin and Marius Staring. Division of Image Processing,
  * Department of Radiology, Leiden, The Netherlands
@@ -222,6 +230,19 @@ public:
   itkGetConstMacro(ComputeOnlyForCurrentLevel, bool);
   itkBooleanMacro(ComputeOnlyForCurrentLevel);
 
+  /** Release the output of the current level, when only the current level is
+   * computed. Call this when the level is no longer needed. The geometry of the
+   * output is kept, and the data is computed again on the next update.
+   */
+  virtual void
+  ReleaseCurrentLevel(void);
+
+  /** Set/Get the persistent cache from which the levels are read, and to which
+   * computed levels are written. Not used by default.
+   */
+  itkSetConstObjectMacro(PersistentCache, PersistentImageCache);
+  itkGetConstObjectMacro(PersistentCache, PersistentImageCache);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro(SameDimensionCheck, (Concept::SameDimension<ImageDimension, OutputImageDimension>));
@@ -272,6 +293,8 @@ protected:
   bool                  m_ComputeOnlyForCurrentLevel;
   bool                  m_SmoothingScheduleDefined;
 
+  PersistentImageCache::ConstPointer m_PersistentCache;
+
 private:
   /** Typedef for smoother. Smooth always happens first, then only from
    * InputImageType to OutputImageType is possible.
@@ -358,6 +381,13 @@ private:
   bool
   IsRescaleUsed(void) const;
 
+  /** The settings under which a level is stored in the persistent cache,
+   * together with the hash of the input image: the sigmas, the shrink
+   * factors and the output geometry of the level.
+   */
+  std::string
+  GetPersistentCacheSettings(const unsigned int level, const OutputImageType * output) const;
+
 private:
   GenericMultiResolutionPyramidImageFilter(const Self &) = delete;
   void
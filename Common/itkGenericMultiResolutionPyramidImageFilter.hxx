@@ -24,6 +24,10 @@
 #include "itkShrinkImageFilter.h"
 #include "itkImageAlgorithm.h"
 
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+
 namespace // anonymous namespace
 {
 /**
@@ -138,6 +142,23 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
 } // end SetComputeOnlyForCurrentLevel()
 
 
+/**
+ * ******************* ReleaseCurrentLevel ***********************
+ */
+
+template <class TInputImage, class TOutputImage, class TPrecisionType>
+void
+GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::ReleaseCurrentLevel(void)
+{
+  // Initialize() frees the pixel buffer, but keeps the geometry of the level.
+  // The empty buffered region makes the next update compute the level again.
+  if (this->m_ComputeOnlyForCurrentLevel)
+  {
+    this->GetOutput(this->m_CurrentLevel)->Initialize();
+  }
+} // end ReleaseCurrentLevel()
+
+
 /**
  * ******************* SetSchedule ***********************
  */
@@ -329,6 +350,15 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
   typename ImageToImageFilterSameTypes::Pointer      rescaleSameTypes;
   typename ImageToImageFilterDifferentTypes::Pointer rescaleDifferentTypes;
 
+  // The hash of the input is only computed when the persistent cache is used
+  const bool useCache = this->m_PersistentCache.IsNotNull() && this->m_PersistentCache->IsEnabled();
+
+  PersistentImageCache::HashType inputHash = 0;
+  if (useCache)
+  {
+    inputHash = PersistentImageCache::ComputeImageHash(input.GetPointer());
+  }
+
   for (unsigned int level = 0; level < this->m_NumberOfLevels; ++level)
   {
     if (!this->m_ComputeOnlyForCurrentLevel)
@@ -338,8 +368,23 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
 
     if (this->ComputeForCurrentLevel(level))
     {
-      // Allocate memory for each output
       OutputImagePointer outputPtr = this->GetOutput(level);
+
+      // Reuse the level computed by an earlier run, if it is in the cache
+      std::string cacheSettings;
+      if (useCache)
+      {
+        cacheSettings = this->GetPersistentCacheSettings(level, outputPtr);
+        OutputImagePointer cachedImage =
+          this->m_PersistentCache->ReadImage<OutputImageType>("pyramid", inputHash, cacheSettings);
+        if (cachedImage.IsNotNull())
+        {
+          this->GraftNthOutput(level, cachedImage);
+          continue;
+        }
+      }
+
+      // Allocate memory for each output
       outputPtr->SetBufferedRegion(outputPtr->GetRequestedRegion());
       outputPtr->Allocate();
 
@@ -372,6 +417,11 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
           this, rescaleDifferentTypes, outputPtr, level);
       }
       // no else needed
+
+      if (useCache)
+      {
+        this->m_PersistentCache->WriteImage("pyramid", inputHash, cacheSettings, this->GetOutput(level));
+      }
     }
   } // end for ilevel
 } // end GenerateData()
@@ -896,6 +946,33 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
 } // end IsRescaleUsed()
 
 
+/**
+ * ******************* GetPersistentCacheSettings ***********************
+ */
+
+template <class TInputImage, class TOutputImage, class TPrecisionType>
+std::string
+GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionType>::GetPersistentCacheSettings(
+  const unsigned int      level,
+  const OutputImageType * output) const
+{
+  SigmaArrayType         sigmaArray;
+  RescaleFactorArrayType shrinkFactors;
+  this->GetSigma(level, sigmaArray);
+  this->GetShrinkFactors(level, shrinkFactors);
+
+  std::ostringstream settings;
+  settings << std::setprecision(17) << this->GetNameOfClass() << typeid(TOutputImage).name()
+           << typeid(TPrecisionType).name() << " sigma " << sigmaArray << " factors " << shrinkFactors
+           << " shrink " << this->GetUseShrinkImageFilter() << " region " << output->GetLargestPossibleRegion()
+           << " spacing " << output->GetSpacing() << " origin " << output->GetOrigin() << " direction "
+           << output->GetDirection();
+
+  return settings.str();
+
+} // end GetPersistentCacheSettings()
+
+
 /**
  * ******************* PrintSelf ***********************
  */
@@ -911,6 +988,7 @@ GenericMultiResolutionPyramidImageFilter<TInputImage, TOutputImage, TPrecisionTy
   os << indent << "ComputeOnlyForCurrentLevel: " << (this->m_ComputeOnlyForCurrentLevel ? "true" : "false")
      << std::endl;
   os << indent << "SmoothingScheduleDefined: " << (this->m_SmoothingScheduleDefined ? "true" : "false") << std::endl;
+  os << indent << "PersistentCache: " << this->m_PersistentCache.GetPointer() << std::endl;
   os << indent << "Smoothing Schedule: ";
   if (this->m_SmoothingSchedule.empty())
   {
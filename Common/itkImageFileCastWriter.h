@@ -23,7 +23,9 @@
 #include "itkMacro.h"
 #include "itkSize.h"
 #include "itkImageIORegion.h"
-#include "itkCastImageFilter.h"
+
+#include <algorithm>
+#include <vector>
 
 namespace itk
 {
@@ -35,6 +37,12 @@ namespace itk
  * if necessary. This is useful in some cases, to avoid the use of
  * a itk::CastImageFilter (to save memory for example).
  *
+ * The cast is done on the requested region of the input only, just before
+ * it is written. With SetNumberOfStreamDivisions(), the input is therefore
+ * requested, cast and written piece by piece, and only one piece of the
+ * cast image is in memory at any time, provided that the ImageIO supports
+ * streamed writing.
+ *
  */
 template <class TInputImage>
 class ITKIOImageBase_HIDDEN ImageFileCastWriter : public ImageFileWriter<TInputImage>
@@ -72,49 +80,54 @@ public:
 
 protected:
   ImageFileCastWriter();
-  ~ImageFileCastWriter() override;
+  ~ImageFileCastWriter() override = default;
 
   /** Does the real work. */
   void
   GenerateData(void) override;
 
 private:
-  /** Templated function that casts the input image and returns a
-   * a pointer to the PixelBuffer. Assumes scalar singlecomponent images
-   * The buffer data is valid until this->m_Caster is destroyed or assigned
-   * a new caster. The ImageIO's PixelType is also adapted by this function */
+  /** Templated function that casts the requested region of the input image and
+   * writes it. Assumes scalar singlecomponent images. The cast is a static_cast,
+   * as in the itk::CastImageFilter. The ImageIO's PixelType is also adapted by
+   * this function.
+   */
   template <class OutputComponentType>
-  void *
-  ConvertScalarImage(const DataObject * inputImage)
+  void
+  CastAndWriteScalarImage(const InputImageType * inputImage)
   {
-    typedef Image<OutputComponentType, InputImageDimension>      DiskImageType;
     typedef typename PixelTraits<InputImagePixelType>::ValueType InputImageComponentType;
-    typedef Image<InputImageComponentType, InputImageDimension>  ScalarInputImageType;
-    typedef CastImageFilter<ScalarInputImageType, DiskImageType> CasterType;
 
     /** Reconfigure the imageIO */
-    // this->GetImageIO()->SetPixelTypeInfo( typeid(OutputComponentType) );
     this->GetModifiableImageIO()->SetPixelTypeInfo(static_cast<const OutputComponentType *>(nullptr));
 
-    /** cast the input image */
-    typename CasterType::Pointer caster = CasterType::New();
-    this->m_Caster = caster;
-    typename ScalarInputImageType::Pointer localInputImage = ScalarInputImageType::New();
-
-    localInputImage->Graft(static_cast<const ScalarInputImageType *>(inputImage));
-
-    caster->SetInput(localInputImage);
-    caster->Update();
-
-    /** return the pixel buffer of the casted image */
-    OutputComponentType * pixelBuffer = caster->GetOutput()->GetBufferPointer();
-    void *                convertedBuffer = static_cast<void *>(pixelBuffer);
-    return convertedBuffer;
+    /** Cast the requested region, which is the current piece when streaming, line by line. */
+    const InputImageRegionType &     region = inputImage->GetRequestedRegion();
+    const InputImageComponentType *  inputBuffer =
+      reinterpret_cast<const InputImageComponentType *>(inputImage->GetBufferPointer());
+    std::vector<OutputComponentType> convertedBuffer(region.GetNumberOfPixels());
+    auto                             convertedPixel = convertedBuffer.begin();
+    for (SizeValueType line = 0; convertedPixel != convertedBuffer.end(); ++line)
+    {
+      typename InputImageType::IndexType index = region.GetIndex();
+      SizeValueType                      remainder = line;
+      for (unsigned int d = 1; d < InputImageDimension; ++d)
+      {
+        index[d] += static_cast<IndexValueType>(remainder % region.GetSize(d));
+        remainder /= region.GetSize(d);
+      }
+      const InputImageComponentType * first = inputBuffer + inputImage->ComputeOffset(index);
+      convertedPixel =
+        std::transform(first, first + region.GetSize(0), convertedPixel, [](const InputImageComponentType value) {
+          return static_cast<OutputComponentType>(value);
+        });
+    }
+
+    /** Do the writing */
+    this->GetModifiableImageIO()->Write(convertedBuffer.data());
   }
 
 
-  ProcessObject::Pointer m_Caster;
-
   ImageFileCastWriter(const Self &) = delete;
   void
   operator=(const Self &) = delete;
@@ -35,7 +35,6 @@ namespace itk
 template <class TInputImage>
 ImageFileCastWriter<TInputImage>::ImageFileCastWriter()
 {
-  this->m_Caster = nullptr;
   this->m_OutputComponentType = this->GetDefaultOutputComponentType();
 }
 
@@ -58,14 +57,6 @@ ImageFileCastWriter<TInputImage>::GetDefaultOutputComponentType(void) const
 }
 
 
-//---------------------------------------------------------
-template <class TInputImage>
-ImageFileCastWriter<TInputImage>::~ImageFileCastWriter()
-{
-  this->m_Caster = nullptr;
-}
-
-
 //---------------------------------------------------------
 template <class TInputImage>
 void
@@ -107,60 +98,63 @@ ImageFileCastWriter<TInputImage>::GenerateData(void)
         this->GetImageIO()->GetComponentTypeAsString(this->GetImageIO()->GetComponentType()) &&
       numberOfComponents == 1)
   {
-    void *             convertedDataBuffer = nullptr;
-    const DataObject * inputAsDataObject = dynamic_cast<const DataObject *>(input);
-
-    /** convert the scalar image to a scalar image with another componenttype
+    /** Convert the scalar image to a scalar image with another componenttype, and write it.
      * The imageIO's PixelType is also changed */
     if (this->m_OutputComponentType == "char")
     {
-      convertedDataBuffer = this->ConvertScalarImage<char>(inputAsDataObject);
+      this->CastAndWriteScalarImage<char>(input);
     }
     else if (this->m_OutputComponentType == "unsigned_char")
     {
-      convertedDataBuffer = this->ConvertScalarImage<unsigned char>(inputAsDataObject);
+      this->CastAndWriteScalarImage<unsigned char>(input);
     }
     else if (this->m_OutputComponentType == "short")
     {
-      convertedDataBuffer = this->ConvertScalarImage<short>(inputAsDataObject);
+      this->CastAndWriteScalarImage<short>(input);
     }
     else if (this->m_OutputComponentType == "unsigned_short")
     {
-      convertedDataBuffer = this->ConvertScalarImage<unsigned short>(inputAsDataObject);
+      this->CastAndWriteScalarImage<unsigned short>(input);
     }
     else if (this->m_OutputComponentType == "int")
     {
-      convertedDataBuffer = this->ConvertScalarImage<int>(inputAsDataObject);
+      this->CastAndWriteScalarImage<int>(input);
     }
     else if (this->m_OutputComponentType == "unsigned_int")
     {
-      convertedDataBuffer = this->ConvertScalarImage<unsigned int>(inputAsDataObject);
+      this->CastAndWriteScalarImage<unsigned int>(input);
     }
     else if (this->m_OutputComponentType == "long")
     {
-      convertedDataBuffer = this->ConvertScalarImage<long>(inputAsDataObject);
+      this->CastAndWriteScalarImage<long>(input);
     }
     else if (this->m_OutputComponentType == "unsigned_long")
     {
-      convertedDataBuffer = this->ConvertScalarImage<unsigned long>(inputAsDataObject);
+      this->CastAndWriteScalarImage<unsigned long>(input);
     }
     else if (this->m_OutputComponentType == "float")
     {
-      convertedDataBuffer = this->ConvertScalarImage<float>(inputAsDataObject);
+      this->CastAndWriteScalarImage<float>(input);
     }
     else if (this->m_OutputComponentType == "double")
     {
-      convertedDataBuffer = this->ConvertScalarImage<double>(inputAsDataObject);
+      this->CastAndWriteScalarImage<double>(input);
+    }
+    else
+    {
+      /** Unknown component type: nothing to convert. */
+      this->GetModifiableImageIO()->Write(nullptr);
     }
-
-    /** Do the writing */
-    this->GetModifiableImageIO()->Write(convertedDataBuffer);
-    /** Release the caster's memory */
-    this->m_Caster = nullptr;
   }
   else
   {
-    /** No casting needed or possible, just write */
+    /** No casting needed or possible, just write. The superclass copies the
+     * requested region first, if the input has more pixels buffered. */
+    if (input->GetRequestedRegion() != input->GetBufferedRegion())
+    {
+      this->Superclass::GenerateData();
+      return;
+    }
     const void * dataPtr = input->GetBufferPointer();
     this->GetModifiableImageIO()->Write(dataPtr);
   }
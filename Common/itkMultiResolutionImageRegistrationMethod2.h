@@ -45,6 +45,7 @@
 #include "itkMultiResolutionPyramidImageFilter.h"
 #include "itkNumericTraits.h"
 #include "itkDataObjectDecorator.h"
+#include "itkWorkStealingThreadPool.h"
 
 namespace itk
 {
@@ -79,6 +80,11 @@ namespace itk
  * The downsampled images are provided by user specified
  * MultiResolutionPyramidImageFilters. User must specify the schedule
  * for each pyramid externally prior to calling StartRegistration().
+ * Only the geometry of the pyramid outputs is used before a level starts,
+ * and the data of a level is only accessed through the metric, which
+ * updates it in Initialize(). Hence a pyramid that computes one level at a
+ * time, like the GenericMultiResolutionPyramidImageFilter, may release the
+ * data of the other levels.
  *
  * \warning If there is discrepancy between the number of level requested
  * and a pyramid schedule. The pyramid schedule will be overridden
@@ -194,6 +200,17 @@ public:
   itkSetObjectMacro(Interpolator, InterpolatorType);
   itkGetModifiableObjectMacro(Interpolator, InterpolatorType);
 
+  /** Set/Get the thread pool. By default the registration uses the persistent, global
+   * pool of threads (WorkStealingThreadPool::GetGlobalThreadPool()), which is handed to
+   * the metric (and via the metric to the image sampler) at every resolution, and can be
+   * used by the other components, such that threads are not created and destroyed at
+   * every iteration. The registration does not resize the pool, as it may be shared with
+   * other registrations and components: the metric splits its work in its own number of
+   * work units, which the threads of the pool execute.
+   */
+  itkSetObjectMacro(ThreadPool, WorkStealingThreadPool);
+  itkGetModifiableObjectMacro(ThreadPool, WorkStealingThreadPool);
+
   /** Set/Get the Fixed image pyramid. */
   itkSetObjectMacro(FixedImagePyramid, FixedImagePyramidType);
   itkGetModifiableObjectMacro(FixedImagePyramid, FixedImagePyramidType);
@@ -293,6 +310,8 @@ private:
   ParametersType m_InitialTransformParameters;
   ParametersType m_InitialTransformParametersOfNextLevel;
 
+  WorkStealingThreadPool::Pointer m_ThreadPool;
+
   MovingImageConstPointer   m_MovingImage;
   FixedImageConstPointer    m_FixedImage;
   MovingImagePyramidPointer m_MovingImagePyramid;
@@ -67,6 +67,9 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::MultiResolut
   this->m_FixedImagePyramid = FixedImagePyramidType::New();
   this->m_MovingImagePyramid = MovingImagePyramidType::New();
 
+  // The persistent, process-wide thread pool, shared by the components.
+  this->m_ThreadPool = WorkStealingThreadPool::GetGlobalThreadPool();
+
   this->m_NumberOfLevels = 1;
   this->m_CurrentLevel = 0;
 
@@ -122,6 +125,7 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::Initialize(v
   this->m_Metric->SetTransform(this->m_Transform);
   this->m_Metric->SetInterpolator(this->m_Interpolator);
   this->m_Metric->SetFixedImageRegion(this->m_FixedImageRegionPyramid[this->m_CurrentLevel]);
+  this->m_Metric->SetThreadPool(this->m_ThreadPool);
   this->m_Metric->Initialize();
 
   // Setup the optimizer
@@ -368,6 +372,7 @@ MultiResolutionImageRegistrationMethod2<TFixedImage, TMovingImage>::PrintSelf(st
   os << indent << "MovingImage: " << this->m_MovingImage.GetPointer() << std::endl;
   os << indent << "FixedImagePyramid: " << this->m_FixedImagePyramid.GetPointer() << std::endl;
   os << indent << "MovingImagePyramid: " << this->m_MovingImagePyramid.GetPointer() << std::endl;
+  os << indent << "ThreadPool: " << this->m_ThreadPool.GetPointer() << std::endl;
 
   os << indent << "NumberOfLevels: " << this->m_NumberOfLevels << std::endl;
   os << indent << "CurrentLevel: " << this->m_CurrentLevel << std::endl;
@@ -0,0 +1,379 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkPersistentImageCache.h"
+
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <vector>
+
+/** Memory mapping is supported on POSIX systems. */
+#if defined(__unix__) || defined(__APPLE__)
+#  define ELASTIX_PERSISTENT_IMAGE_CACHE_MMAP
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace itk
+{
+
+namespace
+{
+
+/** Identifies the files of the cache, and the version of their layout. */
+constexpr char          Magic[8] = { 'E', 'L', 'X', 'C', 'A', 'C', 'H', 'E' };
+constexpr std::uint32_t Version = 2;
+
+inline std::uint64_t
+RotateLeft(const std::uint64_t x, const unsigned int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+/** The finalization mix of MurmurHash3, which makes every output bit depend on every input bit. */
+inline std::uint64_t
+FinalizeHash(std::uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+} // end namespace
+
+
+/**
+ * ****************** HashBytes *********************************
+ */
+
+PersistentImageCache::HashType
+PersistentImageCache::HashBytes(const void * data, std::size_t numberOfBytes, HashType seed)
+{
+  /** The body of MurmurHash3, on one lane of 64-bit words. */
+  constexpr std::uint64_t multiplier1 = 0x87c37b91114253d5ULL;
+  constexpr std::uint64_t multiplier2 = 0x4cf5ad432745937fULL;
+
+  const unsigned char * bytes = static_cast<const unsigned char *>(data);
+  std::uint64_t         hash = seed ^ (numberOfBytes * multiplier1);
+  std::size_t           i = 0;
+  for (; i + sizeof(std::uint64_t) <= numberOfBytes; i += sizeof(std::uint64_t))
+  {
+    std::uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(std::uint64_t));
+    hash ^= RotateLeft(word * multiplier1, 31) * multiplier2;
+    hash = RotateLeft(hash, 27) * 5 + 0x52dce729;
+  }
+  if (i < numberOfBytes)
+  {
+    std::uint64_t word = 0;
+    std::memcpy(&word, bytes + i, numberOfBytes - i);
+    hash ^= RotateLeft(word * multiplier1, 31) * multiplier2;
+  }
+  return FinalizeHash(hash);
+
+} // end HashBytes()
+
+
+/**
+ * ****************** HashString *********************************
+ */
+
+PersistentImageCache::HashType
+PersistentImageCache::HashString(const std::string & text, HashType seed)
+{
+  return HashBytes(text.data(), text.size(), seed);
+
+} // end HashString()
+
+
+/**
+ * ****************** MakeKey *********************************
+ */
+
+std::string
+PersistentImageCache::MakeKey(const std::string & name, HashType hash)
+{
+  std::ostringstream key;
+  key << name << "-" << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return key.str();
+
+} // end MakeKey()
+
+
+/**
+ * ****************** InitializeHeader *********************************
+ */
+
+void
+PersistentImageCache::InitializeHeader(HeaderType & header)
+{
+  std::memset(&header, 0, sizeof(HeaderType));
+  std::memcpy(header.m_Magic, Magic, sizeof(Magic));
+  header.m_Version = Version;
+
+} // end InitializeHeader()
+
+
+/**
+ * ****************** IsValidHeader *********************************
+ */
+
+bool
+PersistentImageCache::IsValidHeader(const char *        headerBlock,
+                                    unsigned int        dimension,
+                                    HashType            pixelTypeHash,
+                                    HashType            inputHash,
+                                    const std::string & settings)
+{
+  HeaderType header;
+  std::memcpy(&header, headerBlock, sizeof(HeaderType));
+
+  /** Compare the full settings text, not only the hash in the file name. */
+  return std::memcmp(header.m_Magic, Magic, sizeof(Magic)) == 0 && header.m_Version == Version &&
+         header.m_Dimension == dimension && header.m_PixelTypeHash == pixelTypeHash &&
+         header.m_InputHash == inputHash && header.m_SettingsLength == settings.size() &&
+         std::memcmp(headerBlock + sizeof(HeaderType), settings.data(), settings.size()) == 0;
+
+} // end IsValidHeader()
+
+
+/**
+ * ****************** GetFileName *********************************
+ */
+
+std::string
+PersistentImageCache::GetFileName(const std::string & key) const
+{
+  return this->m_Directory + "/" + key + ".cache";
+
+} // end GetFileName()
+
+
+/**
+ * ****************** MarkAsUsed *********************************
+ */
+
+void
+PersistentImageCache::MarkAsUsed(const std::string & fileName) const
+{
+  if (this->m_MaximumNumberOfBytes > 0)
+  {
+    itksys::SystemTools::Touch(fileName, false);
+  }
+
+} // end MarkAsUsed()
+
+
+/**
+ * ****************** RemoveLeastRecentlyUsedFiles *********************************
+ */
+
+void
+PersistentImageCache::RemoveLeastRecentlyUsedFiles(const std::string & fileToKeep) const
+{
+  if (this->m_MaximumNumberOfBytes == 0)
+  {
+    return;
+  }
+
+  /** Collect the cache files, with their sizes and the time they were last used. */
+  struct CacheFile
+  {
+    long          m_Time;
+    std::uint64_t m_Size;
+    std::string   m_Name;
+  };
+  std::vector<CacheFile> files;
+  std::uint64_t          totalSize = 0;
+
+  itksys::Directory directory;
+  directory.Load(this->m_Directory);
+  for (unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i)
+  {
+    const std::string name = directory.GetFile(i);
+    if (itksys::SystemTools::GetFilenameLastExtension(name) == ".cache")
+    {
+      const std::string fileName = this->m_Directory + "/" + name;
+      const CacheFile   file = { itksys::SystemTools::ModifiedTime(fileName),
+                               itksys::SystemTools::FileLength(fileName),
+                               fileName };
+      files.push_back(file);
+      totalSize += file.m_Size;
+    }
+  }
+
+  /** Remove the oldest files first. Files that concurrent runs have mapped stay valid for them. */
+  std::sort(files.begin(), files.end(), [](const CacheFile & a, const CacheFile & b) { return a.m_Time < b.m_Time; });
+  for (const auto & file : files)
+  {
+    if (totalSize <= this->m_MaximumNumberOfBytes)
+    {
+      break;
+    }
+    if (file.m_Name != fileToKeep)
+    {
+      itksys::SystemTools::RemoveFile(file.m_Name);
+      totalSize -= file.m_Size;
+    }
+  }
+
+} // end RemoveLeastRecentlyUsedFiles()
+
+
+/**
+ * ****************** MapFile *********************************
+ */
+
+std::shared_ptr<char>
+PersistentImageCache::MapFile(const std::string & fileName, std::size_t & numberOfBytes)
+{
+  numberOfBytes = 0;
+
+#ifdef ELASTIX_PERSISTENT_IMAGE_CACHE_MMAP
+  const int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+  if (fileDescriptor < 0)
+  {
+    return nullptr;
+  }
+  struct stat fileStatus;
+  if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0)
+  {
+    close(fileDescriptor);
+    return nullptr;
+  }
+
+  /** A private mapping is copy-on-write, so the pixels may be modified without affecting the file.
+   * The mapping stays valid after closing the file, and after the file is replaced or removed.
+   */
+  const std::size_t size = static_cast<std::size_t>(fileStatus.st_size);
+  void *            address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileDescriptor, 0);
+  close(fileDescriptor);
+  if (address == MAP_FAILED)
+  {
+    return nullptr;
+  }
+  numberOfBytes = size;
+  return std::shared_ptr<char>(static_cast<char *>(address), [size](char * p) { munmap(p, size); });
+#else
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+  if (!file.is_open())
+  {
+    return nullptr;
+  }
+  const std::streamoff size = file.tellg();
+  if (size <= 0)
+  {
+    return nullptr;
+  }
+  std::shared_ptr<char> buffer(new char[static_cast<std::size_t>(size)], std::default_delete<char[]>());
+  file.seekg(0);
+  if (!file.read(buffer.get(), size))
+  {
+    return nullptr;
+  }
+  numberOfBytes = static_cast<std::size_t>(size);
+  return buffer;
+#endif
+
+} // end MapFile()
+
+
+/**
+ * ****************** WriteFile *********************************
+ */
+
+void
+PersistentImageCache::WriteFile(const std::string & key,
+                                const HeaderType &  header,
+                                const std::string & settings,
+                                const void *        data,
+                                std::size_t         numberOfBytes) const
+{
+  if (!itksys::SystemTools::MakeDirectory(this->m_Directory))
+  {
+    itkWarningMacro(<< "Could not create the cache directory " << this->m_Directory);
+    return;
+  }
+
+  /** A unique temporary name, such that concurrent runs do not write to the same file. */
+  std::random_device randomDevice;
+  const std::string  fileName = this->GetFileName(key);
+  std::ostringstream temporaryFileName;
+  temporaryFileName << fileName << ".tmp" << std::hex << randomDevice() << randomDevice();
+
+  bool success = false;
+  {
+    std::ofstream file(temporaryFileName.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (file.is_open())
+    {
+      std::vector<char> headerBlock(HeaderSize, 0);
+      std::memcpy(headerBlock.data(), &header, sizeof(HeaderType));
+      std::memcpy(headerBlock.data() + sizeof(HeaderType), settings.data(), settings.size());
+      file.write(headerBlock.data(), HeaderSize);
+      file.write(static_cast<const char *>(data), static_cast<std::streamsize>(numberOfBytes));
+      file.close();
+      success = !file.fail();
+    }
+  }
+
+  /** Replace the file atomically. Where renaming does not replace an existing file,
+   * another run has written the same image already.
+   */
+  if (!success || std::rename(temporaryFileName.str().c_str(), fileName.c_str()) != 0)
+  {
+    std::remove(temporaryFileName.str().c_str());
+    if (!success)
+    {
+      itkWarningMacro(<< "Could not write the cache file " << fileName);
+      return;
+    }
+  }
+
+  this->RemoveLeastRecentlyUsedFiles(fileName);
+
+} // end WriteFile()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+PersistentImageCache::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Directory: " << this->m_Directory << std::endl;
+  os << indent << "MaximumNumberOfBytes: " << this->m_MaximumNumberOfBytes << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
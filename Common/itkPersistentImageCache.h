@@ -0,0 +1,238 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPersistentImageCache_h
+#define itkPersistentImageCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImportImageContainer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace itk
+{
+
+/** \class PersistentImageCache
+ *
+ * \brief An on-disk cache of images, shared between runs.
+ *
+ * Some images computed before the actual registration only depend on an
+ * input image and a few settings: the levels of the image pyramids and the
+ * eroded masks, for example. When many registrations share the same fixed
+ * image, these images are the same in every run. This class stores them in a
+ * directory, under a key that is derived from a hash of the input image and
+ * the settings, such that later runs can read them instead of computing them.
+ *
+ * An image is stored as a header of HeaderSize bytes followed by the raw
+ * pixel buffer. The header also holds the hash of the input image and the
+ * full settings text, which are compared on reading, such that a collision
+ * of the file names does not return the wrong image. On POSIX systems the
+ * file is memory mapped, private and copy-on-write, such that concurrent runs
+ * share its pages in the page cache. Elsewhere the file is read into memory.
+ * Files are written under a temporary name and renamed afterwards, so a run
+ * never reads a partially written file. A file that is missing, cannot be
+ * read, or does not match the requested image type, input and settings is a
+ * cache miss. Failing to write a file is not an error either.
+ *
+ * When a maximum size is set, the least recently used files are removed after
+ * writing, until the files in the directory fit in that size.
+ *
+ * An empty directory, the default, disables the cache.
+ *
+ * \ingroup Miscellaneous
+ */
+
+class PersistentImageCache : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef PersistentImageCache     Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(PersistentImageCache, Object);
+
+  /** The type of the hash values. */
+  typedef std::uint64_t HashType;
+
+  /** The maximum image dimension, and the size of the header in bytes. The header
+   * size is a multiple of the page size, to keep the mapped pixels aligned.
+   */
+  static constexpr unsigned int MaximumDimension = 4;
+  static constexpr std::size_t  HeaderSize = 4096;
+
+  /** Set/Get the cache directory. It is created when the first image is written. */
+  itkSetStringMacro(Directory);
+  itkGetStringMacro(Directory);
+
+  /** Set/Get the maximum total size of the files in the cache directory, in bytes.
+   * Default: 0, which means no limit.
+   */
+  itkSetMacro(MaximumNumberOfBytes, std::uint64_t);
+  itkGetConstMacro(MaximumNumberOfBytes, std::uint64_t);
+
+  /** Returns true if a directory is set. */
+  bool
+  IsEnabled(void) const
+  {
+    return !this->m_Directory.empty();
+  }
+
+  /** A 64-bit hash of a block of memory, starting from the given seed. */
+  static HashType
+  HashBytes(const void * data, std::size_t numberOfBytes, HashType seed = 0);
+
+  /** A 64-bit hash of a string, starting from the given seed. */
+  static HashType
+  HashString(const std::string & text, HashType seed = 0);
+
+  /** A 64-bit hash of the pixel type, the geometry and the buffered pixels of an image. */
+  template <class TImage>
+  static HashType
+  ComputeImageHash(const TImage * image);
+
+  /** Create a key from a name, describing the kind of cached image, and a hash. */
+  static std::string
+  MakeKey(const std::string & name, HashType hash);
+
+  /** Read the image computed from an input with the given hash, with the given settings.
+   * The name describes the kind of cached image. Returns a null pointer on a cache miss.
+   */
+  template <class TImage>
+  typename TImage::Pointer
+  ReadImage(const std::string & name, HashType inputHash, const std::string & settings) const;
+
+  /** Store the buffered region of an image computed from an input with the given hash, with the
+   * given settings. Does nothing if the cache is disabled, or if the settings do not fit in the header.
+   */
+  template <class TImage>
+  void
+  WriteImage(const std::string & name, HashType inputHash, const std::string & settings, const TImage * image) const;
+
+protected:
+  /** The constructor. */
+  PersistentImageCache() = default;
+
+  /** The destructor. */
+  ~PersistentImageCache() override = default;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  PersistentImageCache(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** The header of a cached image. */
+  struct HeaderType
+  {
+    char          m_Magic[8];
+    std::uint32_t m_Version;
+    std::uint32_t m_Dimension;
+    std::uint64_t m_PixelTypeHash;
+    std::int64_t  m_Index[MaximumDimension];
+    std::uint64_t m_Size[MaximumDimension];
+    double        m_Spacing[MaximumDimension];
+    double        m_Origin[MaximumDimension];
+    double        m_Direction[MaximumDimension * MaximumDimension];
+    std::uint64_t m_InputHash;
+    std::uint64_t m_SettingsLength;
+  };
+
+  /** The settings text is stored in the header, directly after the HeaderType struct. */
+  static constexpr std::size_t MaximumSettingsLength = HeaderSize - sizeof(HeaderType);
+
+  /** A pixel container that does not own its memory, but keeps a shared buffer alive. */
+  template <class TElement>
+  class SharedBufferPixelContainer : public ImportImageContainer<SizeValueType, TElement>
+  {
+  public:
+    typedef SharedBufferPixelContainer                    Self;
+    typedef ImportImageContainer<SizeValueType, TElement> Superclass;
+    typedef SmartPointer<Self>                            Pointer;
+
+    itkNewMacro(Self);
+    itkTypeMacro(SharedBufferPixelContainer, ImportImageContainer);
+
+    std::shared_ptr<char> m_Buffer;
+  };
+
+  /** A hash identifying a pixel type. */
+  template <class TPixel>
+  static HashType
+  GetPixelTypeHash(void);
+
+  /** Initialize the magic string and the version of a header. */
+  static void
+  InitializeHeader(HeaderType & header);
+
+  /** Check the magic string, the version, the dimension, the pixel type, the input hash and
+   * the settings of a header block.
+   */
+  static bool
+  IsValidHeader(const char *        headerBlock,
+                unsigned int        dimension,
+                HashType            pixelTypeHash,
+                HashType            inputHash,
+                const std::string & settings);
+
+  /** The name of the file in which the image with the given key is stored. */
+  std::string
+  GetFileName(const std::string & key) const;
+
+  /** Mark a file as recently used, by updating its modification time. */
+  void
+  MarkAsUsed(const std::string & fileName) const;
+
+  /** Remove the least recently used files, until the directory fits in the maximum size. */
+  void
+  RemoveLeastRecentlyUsedFiles(const std::string & fileToKeep) const;
+
+  /** Map or read a file. Returns a null pointer if that fails. */
+  static std::shared_ptr<char>
+  MapFile(const std::string & fileName, std::size_t & numberOfBytes);
+
+  /** Write a header, the settings and a data block to the file for the key, through a temporary file. */
+  void
+  WriteFile(const std::string & key,
+            const HeaderType &  header,
+            const std::string & settings,
+            const void *        data,
+            std::size_t         numberOfBytes) const;
+
+  /** Member variables. */
+  std::string   m_Directory;
+  std::uint64_t m_MaximumNumberOfBytes{ 0 };
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkPersistentImageCache.hxx"
+#endif
+
+#endif // end #ifndef itkPersistentImageCache_h
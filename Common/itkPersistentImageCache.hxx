@@ -0,0 +1,207 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkPersistentImageCache_hxx
+#define itkPersistentImageCache_hxx
+
+#include "itkPersistentImageCache.h"
+
+#include <cstring>
+#include <typeinfo>
+
+namespace itk
+{
+
+/**
+ * ****************** GetPixelTypeHash *********************************
+ */
+
+template <class TPixel>
+PersistentImageCache::HashType
+PersistentImageCache::GetPixelTypeHash(void)
+{
+  const HashType sizeOfPixel = sizeof(TPixel);
+  return HashString(typeid(TPixel).name(), sizeOfPixel);
+
+} // end GetPixelTypeHash()
+
+
+/**
+ * ****************** ComputeImageHash *********************************
+ */
+
+template <class TImage>
+PersistentImageCache::HashType
+PersistentImageCache::ComputeImageHash(const TImage * image)
+{
+  typedef typename TImage::PixelType PixelType;
+  constexpr unsigned int             Dimension = TImage::ImageDimension;
+
+  /** Hash the geometry, ... */
+  HashType hash = GetPixelTypeHash<PixelType>();
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    const std::int64_t  index = image->GetBufferedRegion().GetIndex()[i];
+    const std::uint64_t size = image->GetBufferedRegion().GetSize()[i];
+    const double        spacing = image->GetSpacing()[i];
+    const double        origin = image->GetOrigin()[i];
+    hash = HashBytes(&index, sizeof(index), hash);
+    hash = HashBytes(&size, sizeof(size), hash);
+    hash = HashBytes(&spacing, sizeof(spacing), hash);
+    hash = HashBytes(&origin, sizeof(origin), hash);
+    for (unsigned int j = 0; j < Dimension; ++j)
+    {
+      const double direction = image->GetDirection()[i][j];
+      hash = HashBytes(&direction, sizeof(direction), hash);
+    }
+  }
+
+  /** ... and the pixels. */
+  const std::size_t numberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  return HashBytes(image->GetBufferPointer(), numberOfPixels * sizeof(PixelType), hash);
+
+} // end ComputeImageHash()
+
+
+/**
+ * ****************** ReadImage *********************************
+ */
+
+template <class TImage>
+typename TImage::Pointer
+PersistentImageCache::ReadImage(const std::string & name,
+                                const HashType      inputHash,
+                                const std::string & settings) const
+{
+  typedef typename TImage::PixelType PixelType;
+  constexpr unsigned int             Dimension = TImage::ImageDimension;
+  static_assert(Dimension <= MaximumDimension, "The image dimension is not supported by the cache.");
+
+  if (!this->IsEnabled())
+  {
+    return nullptr;
+  }
+
+  /** Map the file and check its header. */
+  const std::string           fileName = this->GetFileName(MakeKey(name, HashString(settings, inputHash)));
+  std::size_t                 numberOfBytes = 0;
+  const std::shared_ptr<char> buffer = MapFile(fileName, numberOfBytes);
+  if (!buffer || numberOfBytes < HeaderSize ||
+      !IsValidHeader(buffer.get(), Dimension, GetPixelTypeHash<PixelType>(), inputHash, settings))
+  {
+    return nullptr;
+  }
+  HeaderType header;
+  std::memcpy(&header, buffer.get(), sizeof(HeaderType));
+
+  /** Restore the geometry. */
+  typename TImage::RegionType    region;
+  typename TImage::SpacingType   spacing;
+  typename TImage::PointType     origin;
+  typename TImage::DirectionType direction;
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    region.SetIndex(i, static_cast<IndexValueType>(header.m_Index[i]));
+    region.SetSize(i, static_cast<SizeValueType>(header.m_Size[i]));
+    spacing[i] = header.m_Spacing[i];
+    origin[i] = header.m_Origin[i];
+    for (unsigned int j = 0; j < Dimension; ++j)
+    {
+      direction[i][j] = header.m_Direction[i * MaximumDimension + j];
+    }
+  }
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  if (numberOfBytes != HeaderSize + numberOfPixels * sizeof(PixelType))
+  {
+    return nullptr;
+  }
+
+  /** Let the image use the pixels in the buffer, without copying them. */
+  typedef SharedBufferPixelContainer<PixelType> PixelContainerType;
+  typename PixelContainerType::Pointer          pixelContainer = PixelContainerType::New();
+  pixelContainer->m_Buffer = buffer;
+  pixelContainer->SetImportPointer(reinterpret_cast<PixelType *>(buffer.get() + HeaderSize), numberOfPixels, false);
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->SetDirection(direction);
+  image->SetPixelContainer(pixelContainer);
+
+  this->MarkAsUsed(fileName);
+  return image;
+
+} // end ReadImage()
+
+
+/**
+ * ****************** WriteImage *********************************
+ */
+
+template <class TImage>
+void
+PersistentImageCache::WriteImage(const std::string & name,
+                                 const HashType      inputHash,
+                                 const std::string & settings,
+                                 const TImage *      image) const
+{
+  typedef typename TImage::PixelType PixelType;
+  constexpr unsigned int             Dimension = TImage::ImageDimension;
+  static_assert(Dimension <= MaximumDimension, "The image dimension is not supported by the cache.");
+
+  if (!this->IsEnabled() || image == nullptr)
+  {
+    return;
+  }
+  if (settings.size() > MaximumSettingsLength)
+  {
+    itkWarningMacro(<< "The settings of the " << name << " image do not fit in the header of the cache file.");
+    return;
+  }
+
+  HeaderType header;
+  InitializeHeader(header);
+  header.m_Dimension = Dimension;
+  header.m_PixelTypeHash = GetPixelTypeHash<PixelType>();
+  header.m_InputHash = inputHash;
+  header.m_SettingsLength = settings.size();
+  for (unsigned int i = 0; i < Dimension; ++i)
+  {
+    header.m_Index[i] = image->GetBufferedRegion().GetIndex()[i];
+    header.m_Size[i] = image->GetBufferedRegion().GetSize()[i];
+    header.m_Spacing[i] = image->GetSpacing()[i];
+    header.m_Origin[i] = image->GetOrigin()[i];
+    for (unsigned int j = 0; j < Dimension; ++j)
+    {
+      header.m_Direction[i * MaximumDimension + j] = image->GetDirection()[i][j];
+    }
+  }
+
+  const std::size_t numberOfPixels = image->GetBufferedRegion().GetNumberOfPixels();
+  this->WriteFile(MakeKey(name, HashString(settings, inputHash)),
+                  header,
+                  settings,
+                  image->GetBufferPointer(),
+                  numberOfPixels * sizeof(PixelType));
+
+} // end WriteImage()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkPersistentImageCache_hxx
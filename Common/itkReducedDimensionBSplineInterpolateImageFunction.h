@@ -45,6 +45,8 @@
 #include "vnl/vnl_matrix.h"
 
 #include "itkMultiOrderBSplineDecompositionImageFilter.h"
+#include "itkBrickedImageBuffer.h"
+#include "itkReducedPrecisionImageBuffer.h"
 #include "itkConceptChecking.h"
 #include "itkCovariantVector.h"
 
@@ -73,6 +75,17 @@ namespace itk
  * MultiOrderBSplineDecompositionImageFilter to enable a zero-th order
  * for the last dimension.
  *
+ * With UseBrickedLayout, the coefficients are read from a BrickedImageBuffer,
+ * which needs fewer cache lines for the region of support of a random position,
+ * at the cost of a copy of the coefficients.
+ *
+ * With UseReducedPrecision, the coefficients are encoded with 16 bits each in a
+ * ReducedPrecisionImageBuffer, and the buffer of the coefficient image is
+ * released. The coefficients are decoded to float when they are read. This
+ * takes a quarter of the memory of double coefficients. The other B-spline
+ * interpolators, based on ITK's BSplineInterpolateImageFunction, do not offer
+ * this option.
+ *
  * Limitations:  Spline order must be between 0 and 5.
  *               Spline order must be set before setting the image.
  *               Requires same spline order for every dimension.
@@ -186,6 +199,28 @@ public:
   itkGetConstMacro(UseImageDirection, bool);
   itkBooleanMacro(UseImageDirection);
 
+  /** Set/Get whether the coefficients are read from a bricked copy of the
+   * coefficient image. Should be set before the input image. Default off.
+   */
+  itkSetMacro(UseBrickedLayout, bool);
+  itkGetConstMacro(UseBrickedLayout, bool);
+  itkBooleanMacro(UseBrickedLayout);
+
+  /** The type of the reduced precision copy of the coefficients. */
+  typedef ReducedPrecisionImageBuffer<CoefficientDataType, ImageDimension> ReducedPrecisionCoefficientsType;
+  typedef typename ReducedPrecisionCoefficientsType::EncodingType          ReducedPrecisionEncodingType;
+
+  /** Set/Get whether the coefficients are stored with 16 bits each.
+   * Takes precedence over UseBrickedLayout. Should be set before the input image. Default off.
+   */
+  itkSetMacro(UseReducedPrecision, bool);
+  itkGetConstMacro(UseReducedPrecision, bool);
+  itkBooleanMacro(UseReducedPrecision);
+
+  /** Set/Get the encoding of the coefficients. Default ReducedPrecisionCoefficientsType::Float16. */
+  itkSetMacro(ReducedPrecisionEncoding, ReducedPrecisionEncodingType);
+  itkGetConstMacro(ReducedPrecisionEncoding, ReducedPrecisionEncodingType);
+
 protected:
   ReducedDimensionBSplineInterpolateImageFunction();
   ~ReducedDimensionBSplineInterpolateImageFunction() override = default;
@@ -199,6 +234,12 @@ protected:
 
   typename CoefficientImageType::ConstPointer m_Coefficients; // Spline coefficients
 
+  /** The bricked copy of the spline coefficients, only used with UseBrickedLayout. */
+  BrickedImageBuffer<CoefficientDataType, itkGetStaticConstMacro(ImageDimension)> m_BrickedCoefficients;
+
+  /** The 16-bit copy of the spline coefficients, only used with UseReducedPrecision. */
+  ReducedPrecisionCoefficientsType m_ReducedPrecisionCoefficients;
+
 private:
   ReducedDimensionBSplineInterpolateImageFunction(const Self &) = delete;
   void
@@ -240,6 +281,70 @@ private:
   void
   ApplyMirrorBoundaryConditions(vnl_matrix<long> & evaluateIndex, unsigned int splineOrder) const;
 
+  /** Gives the coefficient image the GetOffset() and GetPixelAtOffset() interface of the
+   * bricked and the 16-bit copies.
+   */
+  class CoefficientImageBuffer
+  {
+  public:
+    explicit CoefficientImageBuffer(const CoefficientImageType * image)
+      : m_Image(image)
+    {}
+
+    SizeValueType
+    GetOffset(const unsigned int dimension, const IndexValueType index) const
+    {
+      return static_cast<SizeValueType>(index - this->m_Image->GetBufferedRegion().GetIndex(dimension)) *
+             static_cast<SizeValueType>(this->m_Image->GetOffsetTable()[dimension]);
+    }
+
+    CoefficientDataType
+    GetPixelAtOffset(const SizeValueType offset) const
+    {
+      return this->m_Image->GetBufferPointer()[offset];
+    }
+
+  private:
+    const CoefficientImageType * m_Image;
+  };
+
+  /** Views of the 16-bit copy of the coefficients, which decode without checking the encoding. */
+  typedef
+    typename ReducedPrecisionCoefficientsType::template FixedEncodingView<ReducedPrecisionCoefficientsType::Float16>
+      Float16CoefficientsViewType;
+  typedef
+    typename ReducedPrecisionCoefficientsType::template FixedEncodingView<ReducedPrecisionCoefficientsType::UInt16>
+      UInt16CoefficientsViewType;
+
+  /** Compute the offsets of the region of support in a coefficient buffer, per dimension,
+   * such that the offset of a coefficient is the sum of one table entry per dimension.
+   */
+  template <class TBuffer>
+  void
+  ComputeCoefficientOffsets(const TBuffer &          buffer,
+                            const vnl_matrix<long> & evaluateIndex,
+                            const IndexValueType     lastIndex,
+                            SizeValueType *          offsets,
+                            SizeValueType &          lastOffset) const;
+
+  /** Interpolate the value from a coefficient buffer. */
+  template <class TBuffer>
+  double
+  EvaluateFromBuffer(const TBuffer &            buffer,
+                     const vnl_matrix<long> &   evaluateIndex,
+                     const IndexValueType       lastIndex,
+                     const vnl_matrix<double> & weights) const;
+
+  /** Interpolate the derivative, not yet divided by the spacing, from a coefficient buffer. */
+  template <class TBuffer>
+  void
+  EvaluateDerivativeFromBuffer(const TBuffer &            buffer,
+                               const vnl_matrix<long> &   evaluateIndex,
+                               const IndexValueType       lastIndex,
+                               const vnl_matrix<double> & weights,
+                               const vnl_matrix<double> & weightsDerivative,
+                               CovariantVectorType &      derivativeValue) const;
+
   Iterator               m_CIterator;                    // Iterator for traversing spline coefficients.
   unsigned long          m_MaxNumberInterpolationPoints; // number of neighborhood points used for interpolation
   std::vector<IndexType> m_PointsToIndex;                // Preallocation of interpolation neighborhood indicies
@@ -249,6 +354,13 @@ private:
   // flag to take or not the image direction into account when computing the
   // derivatives.
   bool m_UseImageDirection;
+
+  // flag to read the coefficients from a bricked copy.
+  bool m_UseBrickedLayout;
+
+  // flag to store the coefficients with 16 bits each, and their encoding.
+  bool                         m_UseReducedPrecision;
+  ReducedPrecisionEncodingType m_ReducedPrecisionEncoding;
 };
 
 } // namespace itk
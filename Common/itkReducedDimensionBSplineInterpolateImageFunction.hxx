@@ -65,6 +65,9 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
   m_Coefficients = CoefficientImageType::New();
   this->SetSplineOrder(SplineOrder);
   this->m_UseImageDirection = true;
+  this->m_UseBrickedLayout = false;
+  this->m_UseReducedPrecision = false;
+  this->m_ReducedPrecisionEncoding = ReducedPrecisionCoefficientsType::Float16;
 }
 
 
@@ -79,6 +82,11 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
   Superclass::PrintSelf(os, indent);
   os << indent << "Spline Order: " << m_SplineOrder << std::endl;
   os << indent << "UseImageDirection = " << (this->m_UseImageDirection ? "On" : "Off") << std::endl;
+  os << indent << "UseBrickedLayout = " << (this->m_UseBrickedLayout ? "On" : "Off") << std::endl;
+  os << indent << "UseReducedPrecision = " << (this->m_UseReducedPrecision ? "On" : "Off") << std::endl;
+  os << indent << "ReducedPrecisionEncoding = "
+     << (this->m_ReducedPrecisionEncoding == ReducedPrecisionCoefficientsType::Float16 ? "Float16" : "UInt16")
+     << std::endl;
 }
 
 
@@ -99,6 +107,20 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
     m_CoefficientFilter->Update();
     m_Coefficients = m_CoefficientFilter->GetOutput();
 
+    m_BrickedCoefficients.Clear();
+    m_ReducedPrecisionCoefficients.Clear();
+    if (this->m_UseReducedPrecision)
+    {
+      // Only the 16-bit copy is read, so release the buffer of the coefficient image,
+      // which is also referenced by the coefficient filter.
+      m_ReducedPrecisionCoefficients.CopyImage(m_Coefficients.GetPointer(), this->m_ReducedPrecisionEncoding);
+      const_cast<CoefficientImageType *>(m_Coefficients.GetPointer())->Initialize();
+    }
+    else if (this->m_UseBrickedLayout)
+    {
+      m_BrickedCoefficients.CopyImage(m_Coefficients.GetPointer());
+    }
+
     // Call the Superclass implementation after, in case the filter
     // pulls in  more of the input image
     Superclass::SetInputImage(inputData);
@@ -108,6 +130,8 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
   else
   {
     m_Coefficients = nullptr;
+    m_BrickedCoefficients.Clear();
+    m_ReducedPrecisionCoefficients.Clear();
   }
 }
 
@@ -162,28 +186,22 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
   // Modify EvaluateIndex at the boundaries using mirror boundary conditions
   this->ApplyMirrorBoundaryConditions(EvaluateIndex, m_SplineOrder);
 
-  // perform interpolation
-  double    interpolated = 0.0;
-  IndexType coefficientIndex;
-  coefficientIndex[ImageDimension - 1] = vnl_math::rnd(x[ImageDimension - 1]);
-
-  // Step through eachpoint in the N-dimensional interpolation cube.
-  for (unsigned int p = 0; p < m_MaxNumberInterpolationPoints; ++p)
+  // perform interpolation, from the 16-bit or the bricked copy if there is one
+  const IndexValueType lastIndex = vnl_math::rnd(x[ImageDimension - 1]);
+  if (!this->m_ReducedPrecisionCoefficients.IsEmpty())
   {
-    // translate each step into the N-dimensional index.
-    //      IndexType pointIndex = PointToIndex( p );
-
-    double w = 1.0;
-    for (unsigned int n = 0; n < ImageDimension - 1; ++n)
-    {
-      w *= weights[n][m_PointsToIndex[p][n]];
-      coefficientIndex[n] = EvaluateIndex[n][m_PointsToIndex[p][n]]; // Build up ND index for coefficients.
-    }
-    // Convert our step p to the appropriate point in ND space in the
-    // m_Coefficients cube.
-    interpolated += w * m_Coefficients->GetPixel(coefficientIndex);
+    return this->m_ReducedPrecisionCoefficients.GetEncoding() == ReducedPrecisionCoefficientsType::Float16
+             ? this->EvaluateFromBuffer(
+                 Float16CoefficientsViewType(this->m_ReducedPrecisionCoefficients), EvaluateIndex, lastIndex, weights)
+             : this->EvaluateFromBuffer(
+                 UInt16CoefficientsViewType(this->m_ReducedPrecisionCoefficients), EvaluateIndex, lastIndex, weights);
+  }
+  if (!this->m_BrickedCoefficients.IsEmpty())
+  {
+    return this->EvaluateFromBuffer(this->m_BrickedCoefficients, EvaluateIndex, lastIndex, weights);
   }
-  return (interpolated);
+  return this->EvaluateFromBuffer(
+    CoefficientImageBuffer(this->m_Coefficients.GetPointer()), EvaluateIndex, lastIndex, weights);
 }
 
 
@@ -219,34 +237,47 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
   const InputImageType *                       inputImage = this->GetInputImage();
   const typename InputImageType::SpacingType & spacing = inputImage->GetSpacing();
 
-  // Calculate derivative
-  CovariantVectorType derivativeValue;
-  derivativeValue[ImageDimension - 1] = static_cast<OutputType>(0.0);
-  double    tempValue;
-  IndexType coefficientIndex;
-  coefficientIndex[ImageDimension - 1] = vnl_math::rnd(x[ImageDimension - 1]);
-  for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+  // Calculate derivative, from the 16-bit or the bricked copy if there is one
+  CovariantVectorType  derivativeValue;
+  const IndexValueType lastIndex = vnl_math::rnd(x[ImageDimension - 1]);
+  if (!this->m_ReducedPrecisionCoefficients.IsEmpty())
   {
-    derivativeValue[n] = 0.0;
-    for (unsigned int p = 0; p < m_MaxNumberInterpolationPoints; ++p)
+    if (this->m_ReducedPrecisionCoefficients.GetEncoding() == ReducedPrecisionCoefficientsType::Float16)
     {
-      tempValue = 1.0;
-      for (unsigned int n1 = 0; n1 < ImageDimension - 1; ++n1)
-      {
-        coefficientIndex[n1] = EvaluateIndex[n1][m_PointsToIndex[p][n1]];
-
-        if (n1 == n)
-        {
-          // w *= weights[ n ][ m_PointsToIndex[ p ][ n ] ];
-          tempValue *= weightsDerivative[n1][m_PointsToIndex[p][n1]];
-        }
-        else
-        {
-          tempValue *= weights[n1][m_PointsToIndex[p][n1]];
-        }
-      }
-      derivativeValue[n] += m_Coefficients->GetPixel(coefficientIndex) * tempValue;
+      this->EvaluateDerivativeFromBuffer(Float16CoefficientsViewType(this->m_ReducedPrecisionCoefficients),
+                                         EvaluateIndex,
+                                         lastIndex,
+                                         weights,
+                                         weightsDerivative,
+                                         derivativeValue);
+    }
+    else
+    {
+      this->EvaluateDerivativeFromBuffer(UInt16CoefficientsViewType(this->m_ReducedPrecisionCoefficients),
+                                         EvaluateIndex,
+                                         lastIndex,
+                                         weights,
+                                         weightsDerivative,
+                                         derivativeValue);
     }
+  }
+  else if (!this->m_BrickedCoefficients.IsEmpty())
+  {
+    this->EvaluateDerivativeFromBuffer(
+      this->m_BrickedCoefficients, EvaluateIndex, lastIndex, weights, weightsDerivative, derivativeValue);
+  }
+  else
+  {
+    this->EvaluateDerivativeFromBuffer(CoefficientImageBuffer(this->m_Coefficients.GetPointer()),
+                                       EvaluateIndex,
+                                       lastIndex,
+                                       weights,
+                                       weightsDerivative,
+                                       derivativeValue);
+  }
+  derivativeValue[ImageDimension - 1] = static_cast<OutputType>(0.0);
+  for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+  {
     derivativeValue[n] /= spacing[n]; // take spacing into account
   }
 
@@ -261,6 +292,105 @@ ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoeffici
 }
 
 
+template <class TImageType, class TCoordRep, class TCoefficientType>
+template <class TBuffer>
+void
+ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoefficientType>::ComputeCoefficientOffsets(
+  const TBuffer &          buffer,
+  const vnl_matrix<long> & evaluateIndex,
+  const IndexValueType     lastIndex,
+  SizeValueType *          offsets,
+  SizeValueType &          lastOffset) const
+{
+  // One lookup per index of the region of support, instead of one per dimension for every point
+  for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+  {
+    for (unsigned int k = 0; k <= m_SplineOrder; ++k)
+    {
+      offsets[n * (m_SplineOrder + 1) + k] = buffer.GetOffset(n, evaluateIndex[n][k]);
+    }
+  }
+  lastOffset = buffer.GetOffset(ImageDimension - 1, lastIndex);
+}
+
+
+template <class TImageType, class TCoordRep, class TCoefficientType>
+template <class TBuffer>
+double
+ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoefficientType>::EvaluateFromBuffer(
+  const TBuffer &            buffer,
+  const vnl_matrix<long> &   evaluateIndex,
+  const IndexValueType       lastIndex,
+  const vnl_matrix<double> & weights) const
+{
+  const unsigned int maxSplineOrder = 5;
+  const unsigned int maxMatrixSize = (ImageDimension - 1) * (maxSplineOrder + 1);
+  SizeValueType      offsets[maxMatrixSize];
+  SizeValueType      lastOffset;
+  this->ComputeCoefficientOffsets(buffer, evaluateIndex, lastIndex, offsets, lastOffset);
+
+  // Step through each point in the N-dimensional interpolation cube.
+  double interpolated = 0.0;
+  for (unsigned int p = 0; p < m_MaxNumberInterpolationPoints; ++p)
+  {
+    double        w = 1.0;
+    SizeValueType offset = lastOffset;
+    for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+    {
+      w *= weights[n][m_PointsToIndex[p][n]];
+      offset += offsets[n * (m_SplineOrder + 1) + m_PointsToIndex[p][n]];
+    }
+    interpolated += w * buffer.GetPixelAtOffset(offset);
+  }
+  return interpolated;
+}
+
+
+template <class TImageType, class TCoordRep, class TCoefficientType>
+template <class TBuffer>
+void
+ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoefficientType>::EvaluateDerivativeFromBuffer(
+  const TBuffer &            buffer,
+  const vnl_matrix<long> &   evaluateIndex,
+  const IndexValueType       lastIndex,
+  const vnl_matrix<double> & weights,
+  const vnl_matrix<double> & weightsDerivative,
+  CovariantVectorType &      derivativeValue) const
+{
+  const unsigned int maxSplineOrder = 5;
+  const unsigned int maxMatrixSize = (ImageDimension - 1) * (maxSplineOrder + 1);
+  SizeValueType      offsets[maxMatrixSize];
+  SizeValueType      lastOffset;
+  this->ComputeCoefficientOffsets(buffer, evaluateIndex, lastIndex, offsets, lastOffset);
+
+  // Read each coefficient once, and add it to the derivatives along all dimensions.
+  double sums[ImageDimension] = {};
+  for (unsigned int p = 0; p < m_MaxNumberInterpolationPoints; ++p)
+  {
+    SizeValueType offset = lastOffset;
+    for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+    {
+      offset += offsets[n * (m_SplineOrder + 1) + m_PointsToIndex[p][n]];
+    }
+    const double coefficient = buffer.GetPixelAtOffset(offset);
+
+    for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+    {
+      double tempValue = 1.0;
+      for (unsigned int n1 = 0; n1 < ImageDimension - 1; ++n1)
+      {
+        tempValue *= (n1 == n) ? weightsDerivative[n1][m_PointsToIndex[p][n1]] : weights[n1][m_PointsToIndex[p][n1]];
+      }
+      sums[n] += coefficient * tempValue;
+    }
+  }
+  for (unsigned int n = 0; n < ImageDimension - 1; ++n)
+  {
+    derivativeValue[n] = sums[n];
+  }
+}
+
+
 template <class TImageType, class TCoordRep, class TCoefficientType>
 void
 ReducedDimensionBSplineInterpolateImageFunction<TImageType, TCoordRep, TCoefficientType>::SetInterpolationWeights(
@@ -0,0 +1,242 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkReducedPrecisionImageBuffer_h
+#define itkReducedPrecisionImageBuffer_h
+
+#include "itkImageRegion.h"
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace itk
+{
+
+/** \class ReducedPrecisionImageBuffer
+ *
+ * \brief A copy of the pixels of a scalar image, stored with 16 bits per pixel.
+ *
+ * The pixels are encoded either as IEEE half precision floats (Float16), or
+ * as unsigned integers that are mapped linearly to the range of the image
+ * (UInt16). The pixels are decoded to float when they are read. The copy
+ * takes half the memory of a float image, and a quarter of a double image.
+ *
+ * Float16 has a relative precision of 2^-11 over a large dynamic range.
+ * Values beyond the largest half float, 65504, are clamped. UInt16 has an
+ * absolute precision of 1/65535 of the range of the image. When all pixels
+ * are integers within a range of 65536 values, as in 12-bit CT images, the
+ * UInt16 encoding is lossless.
+ *
+ * The pixels are stored in the same order as in the image. Interpolators
+ * compute the offsets of the neighbourhood with GetOffset(), like for the
+ * BrickedImageBuffer, and read the pixels with GetPixelAtOffset(). In inner
+ * loops, GetPixelAtOffset<Encoding>() or a FixedEncodingView decode the pixels
+ * without checking the encoding of every pixel.
+ * The copy is not updated when the image changes.
+ *
+ * \ingroup ImageFunctions
+ */
+
+template <class TPixel, unsigned int VDimension>
+class ReducedPrecisionImageBuffer
+{
+public:
+  /** Typedefs. */
+  typedef TPixel                              PixelType;
+  typedef float                               ValueType;
+  typedef std::uint16_t                       StorageType;
+  typedef ImageRegion<VDimension>             RegionType;
+  typedef typename RegionType::IndexType      IndexType;
+  typedef typename RegionType::IndexValueType IndexValueType;
+  typedef typename RegionType::SizeType       SizeType;
+  typedef typename RegionType::SizeValueType  SizeValueType;
+
+  /** The encodings of the pixels. */
+  enum EncodingType
+  {
+    Float16,
+    UInt16
+  };
+
+  /** Copy and encode the buffered region of an image, with the same pixel type and dimension. */
+  template <class TImage>
+  void
+  CopyImage(const TImage * image, const EncodingType encoding);
+
+  /** Release the copy. */
+  void
+  Clear(void);
+
+  /** Returns true if no image has been copied. */
+  bool
+  IsEmpty(void) const
+  {
+    return this->m_Buffer == nullptr;
+  }
+
+  /** The buffered region of the copied image. */
+  const RegionType &
+  GetBufferedRegion(void) const
+  {
+    return this->m_BufferedRegion;
+  }
+
+  /** The encoding of the copied image. */
+  EncodingType
+  GetEncoding(void) const
+  {
+    return this->m_Encoding;
+  }
+
+  /** The UInt16 encoding decodes a stored value s to Shift + Scale * s. */
+  ValueType
+  GetScale(void) const
+  {
+    return this->m_Scale;
+  }
+
+  ValueType
+  GetShift(void) const
+  {
+    return this->m_Shift;
+  }
+
+  /** The contribution of an index along one dimension to the offset of a pixel. */
+  SizeValueType
+  GetOffset(const unsigned int dimension, const IndexValueType index) const
+  {
+    return static_cast<SizeValueType>(index - this->m_BufferedRegion.GetIndex(dimension)) *
+           this->m_Strides[dimension];
+  }
+
+  /** The offset of a pixel in the buffer. */
+  SizeValueType
+  ComputeOffset(const IndexType & index) const
+  {
+    SizeValueType offset = 0;
+    for (unsigned int d = 0; d < VDimension; ++d)
+    {
+      offset += this->GetOffset(d, index[d]);
+    }
+    return offset;
+  }
+
+  /** Get the decoded pixel at an offset, for the encoding of the copy, which must be VEncoding.
+   * No bounds checking is done.
+   */
+  template <EncodingType VEncoding>
+  ValueType
+  GetPixelAtOffset(const SizeValueType offset) const
+  {
+    const StorageType value = this->m_Buffer[offset];
+    return VEncoding == Float16 ? HalfToFloat(value) : this->m_Shift + this->m_Scale * value;
+  }
+
+  /** Get the decoded pixel at an offset. No bounds checking is done. */
+  ValueType
+  GetPixelAtOffset(const SizeValueType offset) const
+  {
+    return this->m_Encoding == Float16 ? this->template GetPixelAtOffset<Float16>(offset)
+                                       : this->template GetPixelAtOffset<UInt16>(offset);
+  }
+
+  /** A view of the buffer with the GetOffset() and GetPixelAtOffset() interface, of which the
+   * encoding is fixed at compile time, for interpolators that are templated over the buffer type.
+   */
+  template <EncodingType VEncoding>
+  class FixedEncodingView
+  {
+  public:
+    explicit FixedEncodingView(const ReducedPrecisionImageBuffer & buffer)
+      : m_Buffer(buffer)
+    {}
+
+    SizeValueType
+    GetOffset(const unsigned int dimension, const IndexValueType index) const
+    {
+      return this->m_Buffer.GetOffset(dimension, index);
+    }
+
+    ValueType
+    GetPixelAtOffset(const SizeValueType offset) const
+    {
+      return this->m_Buffer.template GetPixelAtOffset<VEncoding>(offset);
+    }
+
+  private:
+    const ReducedPrecisionImageBuffer & m_Buffer;
+  };
+
+  /** Get a decoded pixel. No bounds checking is done. */
+  ValueType
+  GetPixel(const IndexType & index) const
+  {
+    return this->GetPixelAtOffset(this->ComputeOffset(index));
+  }
+
+  /** Convert a float to the nearest half float, clamped to the finite range. */
+  static StorageType
+  FloatToHalf(const float value);
+
+  /** Convert a half float to a float, which is exact. */
+  static ValueType
+  HalfToFloat(const StorageType value)
+  {
+    const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000u) << 16;
+    const std::uint32_t exponent = (value >> 10) & 0x1Fu;
+    const std::uint32_t mantissa = value & 0x3FFu;
+
+    std::uint32_t bits;
+    if (exponent == 0x1Fu)
+    {
+      /** Infinity or NaN. */
+      bits = sign | 0x7F800000u | (mantissa << 13);
+    }
+    else if (exponent != 0)
+    {
+      /** A normal number: rebias the exponent from 15 to 127. */
+      bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    }
+    else
+    {
+      /** Zero or a subnormal number, mantissa * 2^-24. */
+      const float magnitude = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+      return sign != 0 ? -magnitude : magnitude;
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+  }
+
+private:
+  RegionType                     m_BufferedRegion;
+  SizeValueType                  m_Strides[VDimension]{};
+  EncodingType                   m_Encoding{ Float16 };
+  ValueType                      m_Scale{ 1.0f };
+  ValueType                      m_Shift{ 0.0f };
+  std::unique_ptr<StorageType[]> m_Buffer;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkReducedPrecisionImageBuffer.hxx"
+#endif
+
+#endif // end #ifndef itkReducedPrecisionImageBuffer_h
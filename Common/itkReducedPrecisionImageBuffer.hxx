@@ -0,0 +1,204 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkReducedPrecisionImageBuffer_hxx
+#define itkReducedPrecisionImageBuffer_hxx
+
+#include "itkReducedPrecisionImageBuffer.h"
+
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace itk
+{
+
+/**
+ * ******************* CopyImage *******************
+ */
+
+template <class TPixel, unsigned int VDimension>
+template <class TImage>
+void
+ReducedPrecisionImageBuffer<TPixel, VDimension>::CopyImage(const TImage * image, const EncodingType encoding)
+{
+  static_assert(std::is_same<typename TImage::PixelType, PixelType>::value, "The pixel types should be equal.");
+  static_assert(TImage::ImageDimension == VDimension, "The image dimensions should be equal.");
+
+  this->Clear();
+  this->m_BufferedRegion = image->GetBufferedRegion();
+  this->m_Encoding = encoding;
+  const SizeType size = this->m_BufferedRegion.GetSize();
+
+  SizeValueType stride = 1;
+  for (unsigned int d = 0; d < VDimension; ++d)
+  {
+    this->m_Strides[d] = stride;
+    stride *= size[d];
+  }
+  const SizeValueType numberOfPixels = stride;
+  if (numberOfPixels == 0)
+  {
+    return;
+  }
+
+  /** The pixels are processed in parallel, in blocks. */
+  const SizeValueType blockSize = 65536;
+  const SizeValueType numberOfBlocks = (numberOfPixels + blockSize - 1) / blockSize;
+  const PixelType *   source = image->GetBufferPointer();
+
+  /** For the UInt16 encoding, map the range of the image to [0, 65535].
+   * If the pixels are integers in a range of at most 65536 values, they are stored exactly.
+   */
+  if (encoding == UInt16)
+  {
+    std::vector<double> blockMinima(numberOfBlocks);
+    std::vector<double> blockMaxima(numberOfBlocks);
+    std::vector<char>   blockIsIntegral(numberOfBlocks);
+    const auto          computeRange = [&](ThreadIdType, SizeValueType firstBlock, SizeValueType endBlock) {
+      for (SizeValueType block = firstBlock; block < endBlock; ++block)
+      {
+        const SizeValueType end = std::min(numberOfPixels, (block + 1) * blockSize);
+        double              minimum = std::numeric_limits<double>::max();
+        double              maximum = std::numeric_limits<double>::lowest();
+        bool                isIntegral = true;
+        for (SizeValueType i = block * blockSize; i < end; ++i)
+        {
+          const double value = static_cast<double>(source[i]);
+          minimum = std::min(minimum, value);
+          maximum = std::max(maximum, value);
+          isIntegral = isIntegral && value == std::floor(value);
+        }
+        blockMinima[block] = minimum;
+        blockMaxima[block] = maximum;
+        blockIsIntegral[block] = isIntegral;
+      }
+    };
+    WorkStealingThreadPool::GetGlobalThreadPool()->ParallelFor(numberOfBlocks, 1, computeRange);
+
+    const double minimum = *std::min_element(blockMinima.begin(), blockMinima.end());
+    const double maximum = *std::max_element(blockMaxima.begin(), blockMaxima.end());
+    const bool   isIntegral = std::all_of(blockIsIntegral.begin(), blockIsIntegral.end(), [](char b) { return b; });
+
+    const double maximumStoredValue = std::numeric_limits<StorageType>::max();
+    double       scale = 1.0;
+    if (!(isIntegral && maximum - minimum <= maximumStoredValue) && maximum > minimum)
+    {
+      scale = (maximum - minimum) / maximumStoredValue;
+    }
+    this->m_Scale = static_cast<ValueType>(scale);
+    this->m_Shift = static_cast<ValueType>(minimum);
+  }
+  else
+  {
+    this->m_Scale = 1.0f;
+    this->m_Shift = 0.0f;
+  }
+
+  /** Encode the pixels. */
+  this->m_Buffer.reset(new StorageType[numberOfPixels]);
+  StorageType *  target = this->m_Buffer.get();
+  const double   shift = this->m_Shift;
+  const double   inverseScale = 1.0 / this->m_Scale;
+  constexpr auto maximumStoredValue = std::numeric_limits<StorageType>::max();
+  const auto     encodeBlocks = [&](ThreadIdType, SizeValueType firstBlock, SizeValueType endBlock) {
+    const SizeValueType end = std::min(numberOfPixels, endBlock * blockSize);
+    for (SizeValueType i = firstBlock * blockSize; i < end; ++i)
+    {
+      if (encoding == Float16)
+      {
+        target[i] = FloatToHalf(static_cast<float>(source[i]));
+      }
+      else
+      {
+        const double scaled = std::floor((static_cast<double>(source[i]) - shift) * inverseScale + 0.5);
+        target[i] = static_cast<StorageType>(std::min(std::max(scaled, 0.0), static_cast<double>(maximumStoredValue)));
+      }
+    }
+  };
+  WorkStealingThreadPool::GetGlobalThreadPool()->ParallelFor(numberOfBlocks, 1, encodeBlocks);
+
+} // end CopyImage()
+
+
+/**
+ * ******************* Clear *******************
+ */
+
+template <class TPixel, unsigned int VDimension>
+void
+ReducedPrecisionImageBuffer<TPixel, VDimension>::Clear(void)
+{
+  this->m_BufferedRegion = RegionType();
+  std::fill_n(this->m_Strides, VDimension, SizeValueType{ 0 });
+  this->m_Scale = 1.0f;
+  this->m_Shift = 0.0f;
+  this->m_Buffer.reset();
+
+} // end Clear()
+
+
+/**
+ * ******************* FloatToHalf *******************
+ */
+
+template <class TPixel, unsigned int VDimension>
+auto
+ReducedPrecisionImageBuffer<TPixel, VDimension>::FloatToHalf(const float value) -> StorageType
+{
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const StorageType   sign = static_cast<StorageType>((bits >> 16) & 0x8000u);
+  const std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+  if (magnitude > 0x7F800000u)
+  {
+    /** NaN stays NaN. */
+    return static_cast<StorageType>(sign | 0x7E00u);
+  }
+  if (magnitude >= 0x477FF000u)
+  {
+    /** Infinity, or a value that would round to infinity: clamp to the largest half float, 65504. */
+    return static_cast<StorageType>(sign | 0x7BFFu);
+  }
+  if (magnitude < 0x38800000u)
+  {
+    /** Below 2^-14 the half float is subnormal: round magnitude * 2^24 to the nearest integer, ties to even. */
+    float absoluteValue;
+    std::memcpy(&absoluteValue, &magnitude, sizeof(absoluteValue));
+    return static_cast<StorageType>(sign | static_cast<StorageType>(std::nearbyint(absoluteValue * 16777216.0f)));
+  }
+
+  /** A normal number: rebias the exponent from 127 to 15, and round the mantissa to 10 bits, ties to even. */
+  std::uint32_t       half = (magnitude - 0x38000000u) >> 13;
+  const std::uint32_t remainder = magnitude & 0x1FFFu;
+  if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0))
+  {
+    ++half;
+  }
+  return static_cast<StorageType>(sign | half);
+
+} // end FloatToHalf()
+
+
+} // end namespace itk
+
+#endif // end #ifndef itkReducedPrecisionImageBuffer_hxx
@@ -40,6 +40,14 @@ namespace itk
  *
  * The second word in the text file represents the number of points that
  * should be read.
+ *
+ * Alternatively, the points are read from a binary file, which is much
+ * faster for large point sets. A binary point file starts with the eight
+ * characters of GetBinaryFileSignature(), followed by the dimension and a
+ * flag that is nonzero if the points are indices, both as 32-bit unsigned
+ * integers, and the number of points, as a 64-bit unsigned integer. Then
+ * the coordinates follow, point by point, as doubles. All numbers are
+ * little endian.
  **/
 
 template <class TOutputMesh>
@@ -81,6 +89,19 @@ public:
    */
   itkGetConstMacro(NumberOfPoints, unsigned long);
 
+  /** Get whether the points are read from a binary point file. */
+  itkGetConstMacro(IsBinary, bool);
+
+  /** The first characters of a binary point file, which are not terminated by a null character. */
+  static const char *
+  GetBinaryFileSignature(void)
+  {
+    return "ELXPOINT";
+  }
+
+  /** The number of characters of the signature of a binary point file. */
+  itkStaticConstMacro(BinaryFileSignatureLength, unsigned int, 8);
+
   /** Prepare the allocation of the output mesh during the first back
    * propagation of the pipeline. Updates the PointsAreIndices and NumberOfPoints.
    */
@@ -97,6 +118,7 @@ protected:
 
   unsigned long m_NumberOfPoints;
   bool          m_PointsAreIndices;
+  bool          m_IsBinary;
 
   std::ifstream m_Reader;
 
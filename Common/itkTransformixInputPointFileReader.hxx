@@ -21,6 +21,12 @@
 
 #include "itkTransformixInputPointFileReader.h"
 
+#include "itkByteSwapper.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 namespace itk
 {
 
@@ -33,6 +39,7 @@ TransformixInputPointFileReader<TOutputMesh>::TransformixInputPointFileReader()
 {
   this->m_NumberOfPoints = 0;
   this->m_PointsAreIndices = false;
+  this->m_IsBinary = false;
 } // end constructor
 
 
@@ -66,7 +73,38 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateOutputInformation(void)
   {
     this->m_Reader.close();
   }
-  this->m_Reader.open(this->m_FileName.c_str());
+  this->m_Reader.open(this->m_FileName.c_str(), std::ios::binary);
+
+  /** Check whether the file starts with the signature of a binary point file. */
+  char signature[BinaryFileSignatureLength] = {};
+  this->m_Reader.read(signature, BinaryFileSignatureLength);
+  this->m_IsBinary = this->m_Reader.gcount() == static_cast<std::streamsize>(BinaryFileSignatureLength) &&
+                     std::equal(signature, signature + BinaryFileSignatureLength, GetBinaryFileSignature());
+  if (this->m_IsBinary)
+  {
+    /** Read the header of the binary point file. */
+    std::uint32_t dimensionAndPointsAreIndices[2] = {};
+    std::uint64_t numberOfPoints = 0;
+    this->m_Reader.read(reinterpret_cast<char *>(dimensionAndPointsAreIndices), sizeof(dimensionAndPointsAreIndices));
+    this->m_Reader.read(reinterpret_cast<char *>(&numberOfPoints), sizeof(numberOfPoints));
+    ByteSwapper<std::uint32_t>::SwapRangeFromSystemToLittleEndian(dimensionAndPointsAreIndices, 2);
+    ByteSwapper<std::uint64_t>::SwapFromSystemToLittleEndian(&numberOfPoints);
+
+    if (!this->m_Reader || dimensionAndPointsAreIndices[0] != OutputMeshType::PointDimension)
+    {
+      std::ostringstream msg;
+      msg << "The header of the binary point file is invalid, or its dimension is not "
+          << OutputMeshType::PointDimension << "." << std::endl
+          << "Filename: " << this->m_FileName << std::endl;
+      MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+      throw e;
+    }
+    this->m_PointsAreIndices = dimensionAndPointsAreIndices[1] != 0;
+    this->m_NumberOfPoints = static_cast<unsigned long>(numberOfPoints);
+    return;
+  }
+  this->m_Reader.clear();
+  this->m_Reader.seekg(0);
 
   /** Read the first entry */
   std::string indexOrPoint;
@@ -114,7 +152,38 @@ TransformixInputPointFileReader<TOutputMesh>::GenerateData(void)
   PointsContainerPointer points = PointsContainerType::New();
 
   /** Read the file */
-  if (this->m_Reader.is_open())
+  if (this->m_Reader.is_open() && this->m_IsBinary)
+  {
+    /** Read the coordinates in blocks of points, and convert them to the coordinate type of the points. */
+    const unsigned long blockSize = 65536;
+    std::vector<double> coordinates(blockSize * dimension);
+    points->CastToSTLContainer().reserve(this->m_NumberOfPoints);
+    for (unsigned long first = 0; first < this->m_NumberOfPoints; first += blockSize)
+    {
+      const unsigned long numberOfPointsInBlock = std::min(blockSize, this->m_NumberOfPoints - first);
+      this->m_Reader.read(reinterpret_cast<char *>(coordinates.data()),
+                          numberOfPointsInBlock * dimension * sizeof(double));
+      if (!this->m_Reader)
+      {
+        std::ostringstream msg;
+        msg << "The file is not large enough. " << std::endl << "Filename: " << this->m_FileName << std::endl;
+        MeshFileReaderException e(__FILE__, __LINE__, msg.str().c_str(), ITK_LOCATION);
+        throw e;
+      }
+      ByteSwapper<double>::SwapRangeFromSystemToLittleEndian(coordinates.data(), numberOfPointsInBlock * dimension);
+
+      for (unsigned long i = 0; i < numberOfPointsInBlock; ++i)
+      {
+        PointType point;
+        for (unsigned int j = 0; j < dimension; ++j)
+        {
+          point[j] = coordinates[i * dimension + j];
+        }
+        points->push_back(point);
+      }
+    }
+  }
+  else if (this->m_Reader.is_open())
   {
     for (unsigned int i = 0; i < this->m_NumberOfPoints; ++i)
     {
@@ -0,0 +1,412 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkTrilinearInterpolationKernel.h"
+#include "itkCPUDispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace itk
+{
+
+namespace
+{
+
+/** The values at the points, like the LinearInterpolateImageFunction.
+ * The corners are computed in floating point, and the offsets with TOffset,
+ * which allows the compiler to vectorize the loop with gather instructions.
+ */
+template <class TPixel, class TOffset>
+ELASTIX_KERNEL_INLINE void
+ValueImpl(const TPixel * __restrict image,
+          const std::int64_t *      size,
+          unsigned int              numberOfPoints,
+          const double * __restrict x,
+          const double * __restrict y,
+          const double * __restrict z,
+          double * __restrict values)
+{
+  const double  last0 = static_cast<double>(size[0] - 1);
+  const double  last1 = static_cast<double>(size[1] - 1);
+  const double  last2 = static_cast<double>(size[2] - 1);
+  const TOffset stride1 = static_cast<TOffset>(size[0]);
+  const TOffset stride2 = static_cast<TOffset>(size[0] * size[1]);
+
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    /** The lower corner, clamped to the image. */
+    const double b0 = std::min(std::max(std::floor(x[i]), 0.0), last0);
+    const double b1 = std::min(std::max(std::floor(y[i]), 0.0), last1);
+    const double b2 = std::min(std::max(std::floor(z[i]), 0.0), last2);
+
+    /** The step to the upper corner, which is zero at the last index. */
+    const TOffset u0 = b0 < last0 ? 1 : 0;
+    const TOffset u1 = b1 < last1 ? stride1 : 0;
+    const TOffset u2 = b2 < last2 ? stride2 : 0;
+
+    const double d0 = std::max(x[i] - b0, 0.0);
+    const double d1 = std::max(y[i] - b1, 0.0);
+    const double d2 = std::max(z[i] - b2, 0.0);
+
+    const TOffset o000 =
+      static_cast<TOffset>(b0) + stride1 * static_cast<TOffset>(b1) + stride2 * static_cast<TOffset>(b2);
+    const double v000 = image[o000];
+    const double v100 = image[o000 + u0];
+    const double v010 = image[o000 + u1];
+    const double v110 = image[o000 + u1 + u0];
+    const double v001 = image[o000 + u2];
+    const double v101 = image[o000 + u2 + u0];
+    const double v011 = image[o000 + u2 + u1];
+    const double v111 = image[o000 + u2 + u1 + u0];
+
+    /** Interpolate along x, then y, then z, as the LinearInterpolateImageFunction does. */
+    const double vx00 = v000 + (v100 - v000) * d0;
+    const double vx10 = v010 + (v110 - v010) * d0;
+    const double vx01 = v001 + (v101 - v001) * d0;
+    const double vx11 = v011 + (v111 - v011) * d0;
+    const double vxx0 = vx00 + (vx10 - vx00) * d1;
+    const double vxx1 = vx01 + (vx11 - vx01) * d1;
+    values[i] = vxx0 + (vxx1 - vxx0) * d2;
+  }
+} // end ValueImpl()
+
+
+/** The values and the gradients at the points, like the AdvancedLinearInterpolateImageFunction. */
+template <class TPixel, class TOffset>
+ELASTIX_KERNEL_INLINE void
+ValueAndGradientImpl(const TPixel * __restrict image,
+                     const std::int64_t *      size,
+                     const double *            m,
+                     unsigned int              numberOfPoints,
+                     const double * __restrict x,
+                     const double * __restrict y,
+                     const double * __restrict z,
+                     double * __restrict values,
+                     double * __restrict gx,
+                     double * __restrict gy,
+                     double * __restrict gz)
+{
+  const double  end0 = static_cast<double>(size[0] - 1);
+  const double  end1 = static_cast<double>(size[1] - 1);
+  const double  end2 = static_cast<double>(size[2] - 1);
+  const TOffset stride1 = static_cast<TOffset>(size[0]);
+  const TOffset stride2 = static_cast<TOffset>(size[0] * size[1]);
+  const double  m00 = m[0], m01 = m[1], m02 = m[2];
+  const double  m10 = m[3], m11 = m[4], m12 = m[5];
+  const double  m20 = m[6], m21 = m[7], m22 = m[8];
+
+  for (unsigned int i = 0; i < numberOfPoints; ++i)
+  {
+    /** Mirror points outside the image, which flips the sign of the derivative. */
+    const double s0 = (x[i] < 0.0 || x[i] > end0) ? -1.0 : 1.0;
+    const double s1 = (y[i] < 0.0 || y[i] > end1) ? -1.0 : 1.0;
+    const double s2 = (z[i] < 0.0 || z[i] > end2) ? -1.0 : 1.0;
+    const double xm0 = x[i] < 0.0 ? -x[i] : (x[i] > end0 ? 2.0 * end0 - x[i] : x[i]);
+    const double xm1 = y[i] < 0.0 ? -y[i] : (y[i] > end1 ? 2.0 * end1 - y[i] : y[i]);
+    const double xm2 = z[i] < 0.0 ? -z[i] : (z[i] > end2 ? 2.0 * end2 - z[i] : z[i]);
+
+    /** The lower corner, such that the upper corner is within the image too. */
+    const double b0 = std::min(std::max(std::floor(xm0), 0.0), end0 - 1.0);
+    const double b1 = std::min(std::max(std::floor(xm1), 0.0), end1 - 1.0);
+    const double b2 = std::min(std::max(std::floor(xm2), 0.0), end2 - 1.0);
+
+    const double d0 = xm0 - b0;
+    const double d1 = xm1 - b1;
+    const double d2 = xm2 - b2;
+    const double e0 = 1.0 - d0;
+    const double e1 = 1.0 - d1;
+    const double e2 = 1.0 - d2;
+
+    const TOffset o000 =
+      static_cast<TOffset>(b0) + stride1 * static_cast<TOffset>(b1) + stride2 * static_cast<TOffset>(b2);
+    const double v000 = image[o000];
+    const double v100 = image[o000 + 1];
+    const double v010 = image[o000 + stride1];
+    const double v110 = image[o000 + stride1 + 1];
+    const double v001 = image[o000 + stride2];
+    const double v101 = image[o000 + stride2 + 1];
+    const double v011 = image[o000 + stride2 + stride1];
+    const double v111 = image[o000 + stride2 + stride1 + 1];
+
+    /** The same expressions as in the AdvancedLinearInterpolateImageFunction. */
+    values[i] = v000 * e0 * e1 * e2 + v100 * d0 * e1 * e2 + v010 * e0 * d1 * e2 + v001 * e0 * e1 * d2 +
+                v110 * d0 * d1 * e2 + v011 * e0 * d1 * d2 + v101 * d0 * e1 * d2 + v111 * d0 * d1 * d2;
+
+    const double g0 = s0 * (e1 * e2 * (v100 - v000) + d1 * e2 * (v110 - v010) + e1 * d2 * (v101 - v001) +
+                            d1 * d2 * (v111 - v011));
+    const double g1 = s1 * (e0 * e2 * (v010 - v000) + d0 * e2 * (v110 - v100) + e0 * d2 * (v011 - v001) +
+                            d0 * d2 * (v111 - v101));
+    const double g2 = s2 * (e0 * e1 * (v001 - v000) + d0 * e1 * (v101 - v100) + e0 * d1 * (v011 - v010) +
+                            d0 * d1 * (v111 - v110));
+
+    gx[i] = m00 * g0 + m01 * g1 + m02 * g2;
+    gy[i] = m10 * g0 + m11 * g1 + m12 * g2;
+    gz[i] = m20 * g0 + m21 * g1 + m22 * g2;
+  }
+} // end ValueAndGradientImpl()
+
+
+/** Select 32-bit offsets when all pixels can be addressed with them. */
+template <class TPixel>
+ELASTIX_KERNEL_INLINE void
+ValueOffsetImpl(const TPixel *         image,
+                const std::int64_t *   size,
+                unsigned int           numberOfPoints,
+                const double * const * continuousIndices,
+                double *               values)
+{
+  const double * x = continuousIndices[0];
+  const double * y = continuousIndices[1];
+  const double * z = continuousIndices[2];
+  if (size[0] * size[1] * size[2] <= std::numeric_limits<std::int32_t>::max())
+  {
+    ValueImpl<TPixel, std::int32_t>(image, size, numberOfPoints, x, y, z, values);
+  }
+  else
+  {
+    ValueImpl<TPixel, std::int64_t>(image, size, numberOfPoints, x, y, z, values);
+  }
+}
+
+template <class TPixel>
+ELASTIX_KERNEL_INLINE void
+ValueAndGradientOffsetImpl(const TPixel *         image,
+                           const std::int64_t *   size,
+                           const double *         m,
+                           unsigned int           numberOfPoints,
+                           const double * const * continuousIndices,
+                           double *               values,
+                           double * const *       gradients)
+{
+  const double * x = continuousIndices[0];
+  const double * y = continuousIndices[1];
+  const double * z = continuousIndices[2];
+  if (size[0] * size[1] * size[2] <= std::numeric_limits<std::int32_t>::max())
+  {
+    ValueAndGradientImpl<TPixel, std::int32_t>(
+      image, size, m, numberOfPoints, x, y, z, values, gradients[0], gradients[1], gradients[2]);
+  }
+  else
+  {
+    ValueAndGradientImpl<TPixel, std::int64_t>(
+      image, size, m, numberOfPoints, x, y, z, values, gradients[0], gradients[1], gradients[2]);
+  }
+}
+
+
+/** The instruction set specific variants. */
+template <class TPixel>
+void
+ValueScalar(const TPixel *         image,
+            const std::int64_t *   size,
+            unsigned int           numberOfPoints,
+            const double * const * continuousIndices,
+            double *               values)
+{
+  ValueOffsetImpl(image, size, numberOfPoints, continuousIndices, values);
+}
+
+template <class TPixel>
+void
+ValueAndGradientScalar(const TPixel *         image,
+                       const std::int64_t *   size,
+                       const double *         m,
+                       unsigned int           numberOfPoints,
+                       const double * const * continuousIndices,
+                       double *               values,
+                       double * const *       gradients)
+{
+  ValueAndGradientOffsetImpl(image, size, m, numberOfPoints, continuousIndices, values, gradients);
+}
+
+#ifdef ELASTIX_CPU_DISPATCH
+
+template <class TPixel>
+__attribute__((target("avx2"))) void
+ValueAVX2(const TPixel *         image,
+          const std::int64_t *   size,
+          unsigned int           numberOfPoints,
+          const double * const * continuousIndices,
+          double *               values)
+{
+  ValueOffsetImpl(image, size, numberOfPoints, continuousIndices, values);
+}
+
+template <class TPixel>
+__attribute__((target("avx2"))) void
+ValueAndGradientAVX2(const TPixel *         image,
+                     const std::int64_t *   size,
+                     const double *         m,
+                     unsigned int           numberOfPoints,
+                     const double * const * continuousIndices,
+                     double *               values,
+                     double * const *       gradients)
+{
+  ValueAndGradientOffsetImpl(image, size, m, numberOfPoints, continuousIndices, values, gradients);
+}
+
+template <class TPixel>
+__attribute__((target("avx512f"))) void
+ValueAVX512(const TPixel *         image,
+            const std::int64_t *   size,
+            unsigned int           numberOfPoints,
+            const double * const * continuousIndices,
+            double *               values)
+{
+  ValueOffsetImpl(image, size, numberOfPoints, continuousIndices, values);
+}
+
+template <class TPixel>
+__attribute__((target("avx512f"))) void
+ValueAndGradientAVX512(const TPixel *         image,
+                       const std::int64_t *   size,
+                       const double *         m,
+                       unsigned int           numberOfPoints,
+                       const double * const * continuousIndices,
+                       double *               values,
+                       double * const *       gradients)
+{
+  ValueAndGradientOffsetImpl(image, size, m, numberOfPoints, continuousIndices, values, gradients);
+}
+
+#endif
+
+
+template <class TPixel>
+void
+DispatchValue(const TPixel *         image,
+              const std::int64_t *   size,
+              unsigned int           numberOfPoints,
+              const double * const * continuousIndices,
+              double *               values)
+{
+  switch (CPUDispatch::GetInstructionSet())
+  {
+#ifdef ELASTIX_CPU_DISPATCH
+    case CPUDispatch::AVX512:
+      ValueAVX512(image, size, numberOfPoints, continuousIndices, values);
+      break;
+    case CPUDispatch::AVX2:
+      ValueAVX2(image, size, numberOfPoints, continuousIndices, values);
+      break;
+#endif
+    default:
+      ValueScalar(image, size, numberOfPoints, continuousIndices, values);
+  }
+}
+
+
+template <class TPixel>
+void
+DispatchValueAndGradient(const TPixel *         image,
+                         const std::int64_t *   size,
+                         const double *         m,
+                         unsigned int           numberOfPoints,
+                         const double * const * continuousIndices,
+                         double *               values,
+                         double * const *       gradients)
+{
+  switch (CPUDispatch::GetInstructionSet())
+  {
+#ifdef ELASTIX_CPU_DISPATCH
+    case CPUDispatch::AVX512:
+      ValueAndGradientAVX512(image, size, m, numberOfPoints, continuousIndices, values, gradients);
+      break;
+    case CPUDispatch::AVX2:
+      ValueAndGradientAVX2(image, size, m, numberOfPoints, continuousIndices, values, gradients);
+      break;
+#endif
+    default:
+      ValueAndGradientScalar(image, size, m, numberOfPoints, continuousIndices, values, gradients);
+  }
+}
+
+} // end namespace
+
+
+/**
+ * ********************* EvaluateValue ****************************
+ */
+
+void
+TrilinearInterpolationKernel::EvaluateValue(const float *          image,
+                                            const std::int64_t *   size,
+                                            unsigned int           numberOfPoints,
+                                            const double * const * continuousIndices,
+                                            double *               values)
+{
+  DispatchValue(image, size, numberOfPoints, continuousIndices, values);
+} // end EvaluateValue()
+
+
+void
+TrilinearInterpolationKernel::EvaluateValue(const double *         image,
+                                            const std::int64_t *   size,
+                                            unsigned int           numberOfPoints,
+                                            const double * const * continuousIndices,
+                                            double *               values)
+{
+  DispatchValue(image, size, numberOfPoints, continuousIndices, values);
+} // end EvaluateValue()
+
+
+/**
+ * ********************* EvaluateValueAndGradient ****************************
+ */
+
+void
+TrilinearInterpolationKernel::EvaluateValueAndGradient(const float *          image,
+                                                       const std::int64_t *   size,
+                                                       const double *         indexToPhysicalGradient,
+                                                       unsigned int           numberOfPoints,
+                                                       const double * const * continuousIndices,
+                                                       double *               values,
+                                                       double * const *       gradients)
+{
+  DispatchValueAndGradient(
+    image, size, indexToPhysicalGradient, numberOfPoints, continuousIndices, values, gradients);
+} // end EvaluateValueAndGradient()
+
+
+void
+TrilinearInterpolationKernel::EvaluateValueAndGradient(const double *         image,
+                                                       const std::int64_t *   size,
+                                                       const double *         indexToPhysicalGradient,
+                                                       unsigned int           numberOfPoints,
+                                                       const double * const * continuousIndices,
+                                                       double *               values,
+                                                       double * const *       gradients)
+{
+  DispatchValueAndGradient(
+    image, size, indexToPhysicalGradient, numberOfPoints, continuousIndices, values, gradients);
+} // end EvaluateValueAndGradient()
+
+
+/**
+ * ********************* GetInstructionSetName ****************************
+ */
+
+const char *
+TrilinearInterpolationKernel::GetInstructionSetName(void)
+{
+  return CPUDispatch::GetInstructionSetName();
+} // end GetInstructionSetName()
+
+} // end namespace itk
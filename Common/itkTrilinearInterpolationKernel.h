@@ -0,0 +1,101 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTrilinearInterpolationKernel_h
+#define itkTrilinearInterpolationKernel_h
+
+#include <cstdint>
+
+namespace itk
+{
+
+/** \class TrilinearInterpolationKernel
+ *
+ * \brief Trilinear interpolation of the value, and optionally the gradient,
+ * of a 3D image at a batch of points.
+ *
+ * EvaluateValue() gives the same values as the
+ * LinearInterpolateImageFunction::EvaluateAtContinuousIndex(): indices are
+ * clamped to the image, and the distance below the first index is taken as 0.
+ * EvaluateValueAndGradient() gives the same values and gradients as
+ * AdvancedLinearInterpolateImageFunction::EvaluateValueAndDerivativeAtContinuousIndex():
+ * points outside the image are mirrored. The only difference is at the last
+ * index of a dimension, where the interpolator moves the point 1e-6 inwards,
+ * while the kernel takes the distance within the last cell as 1.
+ *
+ * The continuous indices are given per dimension, relative to the first index
+ * of the image buffer, which is stored in the usual order with the given size.
+ * For the gradients, which are also returned per dimension, the gradients
+ * with respect to the index are multiplied with indexToPhysicalGradient: the
+ * direction cosines times the inverse spacing, as a row-major 3x3 matrix.
+ * The points should be inside the image, as for the interpolators. For
+ * EvaluateValueAndGradient() the size should be at least 2 along each dimension.
+ *
+ * The loops over the points do all index arithmetic in registers, and read the
+ * 8 corners with gathers, once the compiler vectorizes them. On x86 with GCC
+ * or Clang, AVX-512 and AVX2 variants are compiled in and the best variant
+ * supported by the CPU is selected at run time. The scalar (SSE2) variant is
+ * used otherwise.
+ *
+ * \ingroup ImageFunctions
+ */
+
+class TrilinearInterpolationKernel
+{
+public:
+  /** Evaluate the values at numberOfPoints points. */
+  static void
+  EvaluateValue(const float *          image,
+                const std::int64_t *   size,
+                unsigned int           numberOfPoints,
+                const double * const * continuousIndices,
+                double *               values);
+
+  static void
+  EvaluateValue(const double *         image,
+                const std::int64_t *   size,
+                unsigned int           numberOfPoints,
+                const double * const * continuousIndices,
+                double *               values);
+
+  /** Evaluate the values and the gradients at numberOfPoints points. */
+  static void
+  EvaluateValueAndGradient(const float *          image,
+                           const std::int64_t *   size,
+                           const double *         indexToPhysicalGradient,
+                           unsigned int           numberOfPoints,
+                           const double * const * continuousIndices,
+                           double *               values,
+                           double * const *       gradients);
+
+  static void
+  EvaluateValueAndGradient(const double *         image,
+                           const std::int64_t *   size,
+                           const double *         indexToPhysicalGradient,
+                           unsigned int           numberOfPoints,
+                           const double * const * continuousIndices,
+                           double *               values,
+                           double * const *       gradients);
+
+  /** The name of the instruction set selected at run time: "AVX-512", "AVX2" or "scalar". */
+  static const char *
+  GetInstructionSetName(void);
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkTrilinearInterpolationKernel_h
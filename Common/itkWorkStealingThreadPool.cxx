@@ -0,0 +1,463 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkWorkStealingThreadPool.h"
+
+#include <algorithm>
+
+namespace itk
+{
+
+namespace
+{
+/** The pool whose job the current thread is executing, and its thread id in that pool.
+ * Used to execute nested calls serially.
+ */
+thread_local const WorkStealingThreadPool * t_ActivePool = nullptr;
+thread_local ThreadIdType                   t_ActiveThreadId = 0;
+
+/** Marks the current thread as executing a job of the specified pool, and restores the
+ * previous marker on destruction, so that a job of another pool can be nested in a job.
+ */
+class ActivePoolGuard
+{
+public:
+  ActivePoolGuard(const WorkStealingThreadPool * pool, const ThreadIdType threadId)
+    : m_PreviousPool(t_ActivePool)
+    , m_PreviousThreadId(t_ActiveThreadId)
+  {
+    t_ActivePool = pool;
+    t_ActiveThreadId = threadId;
+  }
+
+  ~ActivePoolGuard()
+  {
+    t_ActivePool = m_PreviousPool;
+    t_ActiveThreadId = m_PreviousThreadId;
+  }
+
+  ActivePoolGuard(const ActivePoolGuard &) = delete;
+  ActivePoolGuard &
+  operator=(const ActivePoolGuard &) = delete;
+
+private:
+  const WorkStealingThreadPool * const m_PreviousPool;
+  const ThreadIdType                   m_PreviousThreadId;
+};
+} // namespace
+
+
+/**
+ * ****************** Constructor *********************************
+ */
+
+WorkStealingThreadPool::WorkStealingThreadPool()
+{
+  this->m_NumberOfThreads = std::max<ThreadIdType>(1, MultiThreaderBase::GetGlobalDefaultNumberOfThreads());
+  this->m_Generation = 0;
+  this->m_Stop = false;
+  this->m_Function = nullptr;
+  this->m_RemainingChunks = 0;
+
+} // end Constructor
+
+
+/**
+ * ****************** Destructor *********************************
+ */
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+  this->StopThreads();
+
+} // end Destructor
+
+
+/**
+ * ****************** GetGlobalThreadPool *********************************
+ */
+
+WorkStealingThreadPool *
+WorkStealingThreadPool::GetGlobalThreadPool(void)
+{
+  /** Thread-safe initialization; the pool lives until the end of the program. */
+  static const Pointer globalThreadPool = Self::New();
+  return globalThreadPool.GetPointer();
+
+} // end GetGlobalThreadPool()
+
+
+/**
+ * ****************** SetNumberOfThreads *********************************
+ */
+
+void
+WorkStealingThreadPool::SetNumberOfThreads(ThreadIdType numberOfThreads)
+{
+  numberOfThreads = std::max<ThreadIdType>(1, numberOfThreads);
+
+  std::lock_guard<std::mutex> jobLock(this->m_JobMutex);
+  if (numberOfThreads == this->m_NumberOfThreads)
+  {
+    return;
+  }
+
+  this->StopThreads();
+  this->m_NumberOfThreads = numberOfThreads;
+  this->Modified();
+
+} // end SetNumberOfThreads()
+
+
+/**
+ * ****************** StartThreads *********************************
+ */
+
+void
+WorkStealingThreadPool::StartThreads(void)
+{
+  if (this->m_Queues.size() == this->m_NumberOfThreads)
+  {
+    return;
+  }
+
+  this->m_Queues.clear();
+  for (ThreadIdType i = 0; i < this->m_NumberOfThreads; ++i)
+  {
+    this->m_Queues.emplace_back(new ChunkQueueType);
+  }
+
+  /** Thread 0 is the calling thread, so only create the others. */
+  this->m_Stop = false;
+  for (ThreadIdType i = 1; i < this->m_NumberOfThreads; ++i)
+  {
+    this->m_Threads.emplace_back(&Self::WorkerLoop, this, i);
+  }
+
+} // end StartThreads()
+
+
+/**
+ * ****************** StopThreads *********************************
+ */
+
+void
+WorkStealingThreadPool::StopThreads(void)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    this->m_Stop = true;
+  }
+  this->m_WakeCondition.notify_all();
+
+  for (auto & thread : this->m_Threads)
+  {
+    thread.join();
+  }
+  this->m_Threads.clear();
+  this->m_Queues.clear();
+
+  /** Tasks that were not taken by a worker are executed here, so that their futures become ready. */
+  while (!this->m_Tasks.empty())
+  {
+    std::packaged_task<void()> task = std::move(this->m_Tasks.front());
+    this->m_Tasks.pop_front();
+    task();
+  }
+
+} // end StopThreads()
+
+
+/**
+ * ****************** WorkerLoop *********************************
+ */
+
+void
+WorkStealingThreadPool::WorkerLoop(ThreadIdType threadId)
+{
+  const ActivePoolGuard activePoolGuard(this, threadId);
+
+  unsigned long seenGeneration = 0;
+  while (true)
+  {
+    /** Wait for a task or a new job. Tasks go first: their work cannot be stolen, while
+     * the chunks in the queue of this thread can be processed by the other threads.
+     */
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(this->m_Mutex);
+      this->m_WakeCondition.wait(lock, [this, seenGeneration] {
+        return this->m_Stop || !this->m_Tasks.empty() || this->m_Generation != seenGeneration;
+      });
+      if (this->m_Stop)
+      {
+        return;
+      }
+      if (!this->m_Tasks.empty())
+      {
+        task = std::move(this->m_Tasks.front());
+        this->m_Tasks.pop_front();
+      }
+      else
+      {
+        seenGeneration = this->m_Generation;
+      }
+    }
+
+    if (task.valid())
+    {
+      task();
+    }
+    else
+    {
+      this->ProcessChunks(threadId);
+    }
+  }
+
+} // end WorkerLoop()
+
+
+/**
+ * ****************** GetChunk *********************************
+ */
+
+bool
+WorkStealingThreadPool::GetChunk(ThreadIdType threadId, ChunkType & chunk)
+{
+  /** First try the front of the own queue. */
+  {
+    ChunkQueueType &            own = *this->m_Queues[threadId];
+    std::lock_guard<std::mutex> lock(own.m_Mutex);
+    if (!own.m_Chunks.empty())
+    {
+      chunk = own.m_Chunks.front();
+      own.m_Chunks.pop_front();
+      return true;
+    }
+  }
+
+  /** Then steal from the back of the other queues, starting at the neighbour. */
+  const ThreadIdType numberOfQueues = static_cast<ThreadIdType>(this->m_Queues.size());
+  for (ThreadIdType i = 1; i < numberOfQueues; ++i)
+  {
+    ChunkQueueType &            victim = *this->m_Queues[(threadId + i) % numberOfQueues];
+    std::lock_guard<std::mutex> lock(victim.m_Mutex);
+    if (!victim.m_Chunks.empty())
+    {
+      chunk = victim.m_Chunks.back();
+      victim.m_Chunks.pop_back();
+      return true;
+    }
+  }
+
+  return false;
+
+} // end GetChunk()
+
+
+/**
+ * ****************** ProcessChunks *********************************
+ */
+
+void
+WorkStealingThreadPool::ProcessChunks(ThreadIdType threadId)
+{
+  ChunkType chunk;
+  while (this->GetChunk(threadId, chunk))
+  {
+    try
+    {
+      (*this->m_Function)(threadId, chunk.first, chunk.second);
+    }
+    catch (...)
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      if (!this->m_Exception)
+      {
+        this->m_Exception = std::current_exception();
+      }
+    }
+
+    /** The last chunk wakes up the calling thread. */
+    if (this->m_RemainingChunks.fetch_sub(1) == 1)
+    {
+      std::lock_guard<std::mutex> lock(this->m_Mutex);
+      this->m_DoneCondition.notify_all();
+    }
+  }
+
+} // end ProcessChunks()
+
+
+/**
+ * ****************** ParallelFor *********************************
+ */
+
+void
+WorkStealingThreadPool::ParallelFor(SizeValueType             numberOfElements,
+                                    SizeValueType             grainSize,
+                                    const RangeFunctionType & func)
+{
+  if (numberOfElements == 0)
+  {
+    return;
+  }
+
+  /** Nested calls and single-threaded pools run serially in the calling thread. */
+  if (t_ActivePool == this || this->m_NumberOfThreads == 1)
+  {
+    func(t_ActivePool == this ? t_ActiveThreadId : 0, 0, numberOfElements);
+    return;
+  }
+
+  /** Only one job at a time; other threads calling into the pool wait here. */
+  std::lock_guard<std::mutex> jobLock(this->m_JobMutex);
+  this->StartThreads();
+
+  /** Determine the chunks. */
+  const SizeValueType numberOfThreads = this->m_NumberOfThreads;
+  if (grainSize == 0)
+  {
+    grainSize = std::max<SizeValueType>(1, (numberOfElements + 4 * numberOfThreads - 1) / (4 * numberOfThreads));
+  }
+  const SizeValueType numberOfChunks = (numberOfElements + grainSize - 1) / grainSize;
+
+  /** Set up the job, and distribute the chunks in contiguous blocks over the queues. */
+  {
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    this->m_Function = &func;
+    this->m_Exception = nullptr;
+    this->m_RemainingChunks = numberOfChunks;
+
+    for (SizeValueType t = 0; t < numberOfThreads; ++t)
+    {
+      const SizeValueType firstChunk = (numberOfChunks * t) / numberOfThreads;
+      const SizeValueType lastChunk = (numberOfChunks * (t + 1)) / numberOfThreads;
+
+      ChunkQueueType &            queue = *this->m_Queues[t];
+      std::lock_guard<std::mutex> queueLock(queue.m_Mutex);
+      for (SizeValueType c = firstChunk; c < lastChunk; ++c)
+      {
+        const SizeValueType begin = c * grainSize;
+        queue.m_Chunks.emplace_back(begin, std::min(begin + grainSize, numberOfElements));
+      }
+    }
+
+    ++this->m_Generation;
+  }
+  this->m_WakeCondition.notify_all();
+
+  /** The calling thread is thread 0. */
+  {
+    const ActivePoolGuard activePoolGuard(this, 0);
+    this->ProcessChunks(0);
+  }
+
+  /** Wait until the chunks that were stolen from us are finished too. */
+  std::exception_ptr exception;
+  {
+    std::unique_lock<std::mutex> lock(this->m_Mutex);
+    this->m_DoneCondition.wait(lock, [this] { return this->m_RemainingChunks == 0; });
+    this->m_Function = nullptr;
+    std::swap(exception, this->m_Exception);
+  }
+
+  if (exception)
+  {
+    std::rethrow_exception(exception);
+  }
+
+} // end ParallelFor()
+
+
+/**
+ * ****************** SingleMethodExecute *********************************
+ */
+
+void
+WorkStealingThreadPool::SingleMethodExecute(ThreadIdType       numberOfWorkUnits,
+                                            ThreadFunctionType callback,
+                                            void *             userData)
+{
+  numberOfWorkUnits = std::max<ThreadIdType>(1, numberOfWorkUnits);
+
+  const RangeFunctionType func = [numberOfWorkUnits, callback, userData](
+                                   ThreadIdType, SizeValueType begin, SizeValueType end) {
+    for (SizeValueType workUnit = begin; workUnit < end; ++workUnit)
+    {
+      ThreadInfoType info;
+      info.WorkUnitID = static_cast<ThreadIdType>(workUnit);
+      info.NumberOfWorkUnits = numberOfWorkUnits;
+      info.UserData = userData;
+      info.ThreadFunction = callback;
+      callback(&info);
+    }
+  };
+
+  this->ParallelFor(numberOfWorkUnits, 1, func);
+
+} // end SingleMethodExecute()
+
+
+/**
+ * ****************** Submit *********************************
+ */
+
+std::future<void>
+WorkStealingThreadPool::Submit(const TaskFunctionType & task)
+{
+  std::packaged_task<void()> packagedTask(task);
+  std::future<void>          future = packagedTask.get_future();
+
+  /** Nested calls and single-threaded pools run the task in the calling thread. */
+  if (t_ActivePool == this || this->m_NumberOfThreads == 1)
+  {
+    packagedTask();
+    return future;
+  }
+
+  {
+    std::lock_guard<std::mutex> jobLock(this->m_JobMutex);
+    this->StartThreads();
+
+    std::lock_guard<std::mutex> lock(this->m_Mutex);
+    this->m_Tasks.push_back(std::move(packagedTask));
+  }
+  this->m_WakeCondition.notify_one();
+
+  return future;
+
+} // end Submit()
+
+
+/**
+ * ****************** PrintSelf *********************************
+ */
+
+void
+WorkStealingThreadPool::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfThreads: " << this->m_NumberOfThreads.load() << std::endl;
+  os << indent << "NumberOfRunningThreads: " << this->m_Threads.size() + 1 << std::endl;
+
+} // end PrintSelf()
+
+
+} // end namespace itk
@@ -0,0 +1,202 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkWorkStealingThreadPool_h
+#define itkWorkStealingThreadPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreaderBase.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace itk
+{
+
+/** \class WorkStealingThreadPool
+ *
+ * \brief A persistent pool of threads that processes chunked index ranges with work stealing.
+ *
+ * The itk::PlatformMultiThreader creates and joins its threads at every call
+ * of SingleMethodExecute(). During a registration this happens several times
+ * per iteration (metric value and derivative, accumulation of the derivative,
+ * sampling, optimizer step), which for small sample sets costs more than the
+ * computation itself. This pool creates its threads once and keeps them
+ * waiting for work until the pool is destroyed.
+ *
+ * A job is an index range [0, numberOfElements[, split in chunks of grainSize
+ * elements. The chunks are distributed in contiguous blocks over one queue per
+ * thread. Every thread first pops chunks from the front of its own queue and,
+ * when that is empty, steals chunks from the back of the other queues.
+ *
+ * The thread calling ParallelFor() participates as thread 0 and the call only
+ * returns when all chunks have been processed. An exception thrown by the
+ * work function is rethrown in the calling thread. A ParallelFor() issued from
+ * within a running job of the same pool is executed serially by the issuing
+ * thread, so nested use cannot deadlock.
+ *
+ * The SingleMethodExecute() function mimics the interface of the ITK threaders,
+ * such that existing ThreaderCallback functions can be run on the pool as is.
+ *
+ * Independent, single-threaded work can be run next to the jobs with Submit().
+ *
+ * \ingroup Miscellaneous
+ */
+
+class WorkStealingThreadPool : public Object
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef WorkStealingThreadPool   Self;
+  typedef Object                   Superclass;
+  typedef SmartPointer<Self>       Pointer;
+  typedef SmartPointer<const Self> ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(WorkStealingThreadPool, Object);
+
+  /** The function type executed for every chunk: (threadId, begin, end). */
+  typedef std::function<void(ThreadIdType, SizeValueType, SizeValueType)> RangeFunctionType;
+
+  /** The function type of a task, see Submit(). */
+  typedef std::function<void()> TaskFunctionType;
+
+  /** Typedefs to run ITK-style threader callbacks. */
+  typedef MultiThreaderBase::ThreadFunctionType ThreadFunctionType;
+  typedef MultiThreaderBase::WorkUnitInfo       ThreadInfoType;
+
+  /** Get the process-wide pool. It is created at the first call, with the global default
+   * number of threads of ITK. Functions that are not handed a pool by their owner use it,
+   * such that a process does not run several independent sets of threads.
+   */
+  static Self *
+  GetGlobalThreadPool(void);
+
+  /** Set the number of threads, including the calling thread. Running workers are
+   * stopped and restarted lazily when the number changes. Must not be called while
+   * a job is running. */
+  void
+  SetNumberOfThreads(ThreadIdType numberOfThreads);
+
+  /** Get the number of threads, including the calling thread. */
+  itkGetConstMacro(NumberOfThreads, ThreadIdType);
+
+  /** Execute func on all chunks of [0, numberOfElements[ and wait for completion.
+   * A grainSize of zero selects a chunk size giving about four chunks per thread.
+   */
+  void
+  ParallelFor(SizeValueType numberOfElements, SizeValueType grainSize, const RangeFunctionType & func);
+
+  /** Execute an ITK threader callback for numberOfWorkUnits work units, like
+   * PlatformMultiThreader::SingleMethodExecute(). The WorkUnitID and
+   * NumberOfWorkUnits members of the info struct are set accordingly.
+   */
+  void
+  SingleMethodExecute(ThreadIdType numberOfWorkUnits, ThreadFunctionType callback, void * userData);
+
+  /** Run a task on one of the worker threads, next to the jobs of ParallelFor(). An idle
+   * worker takes the task, and the chunks of its queue are stolen by the other threads
+   * in the meantime. An exception thrown by the task is rethrown by the get() of the
+   * returned future. A task that is submitted from within a job or task of this pool,
+   * or to a pool with one thread, is executed immediately by the calling thread.
+   */
+  std::future<void>
+  Submit(const TaskFunctionType & task);
+
+protected:
+  /** The constructor. */
+  WorkStealingThreadPool();
+
+  /** The destructor stops and joins all threads. */
+  ~WorkStealingThreadPool() override;
+
+  /** PrintSelf. */
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  WorkStealingThreadPool(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** A chunk is a half-open range of element indices. */
+  typedef std::pair<SizeValueType, SizeValueType> ChunkType;
+
+  /** A per-thread queue of chunks, padded to avoid false sharing of the mutexes. */
+  struct alignas(64) ChunkQueueType
+  {
+    std::mutex            m_Mutex;
+    std::deque<ChunkType> m_Chunks;
+  };
+
+  /** Create the worker threads, if not done already. */
+  void
+  StartThreads(void);
+
+  /** Stop and join the worker threads. */
+  void
+  StopThreads(void);
+
+  /** The loop executed by worker thread threadId > 0. */
+  void
+  WorkerLoop(ThreadIdType threadId);
+
+  /** Process chunks from the own queue, then steal from the others, until all queues are empty. */
+  void
+  ProcessChunks(ThreadIdType threadId);
+
+  /** Pop a chunk from the front of the own queue or the back of another queue. */
+  bool
+  GetChunk(ThreadIdType threadId, ChunkType & chunk);
+
+  /** Member variables. m_NumberOfThreads is only changed under m_JobMutex, but read
+   * without it by ParallelFor() and Submit(). */
+  std::atomic<ThreadIdType>                    m_NumberOfThreads;
+  std::vector<std::thread>                     m_Threads;
+  std::vector<std::unique_ptr<ChunkQueueType>> m_Queues;
+
+  /** Job state. m_Mutex protects m_Generation, m_Stop, m_Exception and m_Tasks. */
+  std::mutex                 m_JobMutex;
+  std::mutex                 m_Mutex;
+  std::condition_variable    m_WakeCondition;
+  std::condition_variable    m_DoneCondition;
+  unsigned long              m_Generation;
+  bool                       m_Stop;
+  const RangeFunctionType *  m_Function;
+  std::atomic<SizeValueType> m_RemainingChunks;
+  std::exception_ptr         m_Exception;
+
+  /** Tasks that wait for an idle worker, see Submit(). */
+  std::deque<std::packaged_task<void()>> m_Tasks;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef itkWorkStealingThreadPool_h
@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxImportanceRandomSampler_h
+#define elxImportanceRandomSampler_h
+
+#include "elxIncludes.h" // include first to avoid MSVS warning
+#include "itkImageImportanceRandomSampler.h"
+
+namespace elastix
+{
+
+/**
+ * \class ImportanceRandomSampler
+ * \brief An interpolator based on the itk::ImageImportanceRandomSampler.
+ *
+ * This image sampler randomly samples 'NumberOfSamples' voxels in
+ * the InputImageRegion, with a probability proportional to the gradient
+ * magnitude of the fixed image, or to a user-supplied weight image. Voxels
+ * may be selected multiple times. If a mask is given, only voxels within
+ * the mask are selected.
+ *
+ * Every sample carries an importance weight, which makes the weighted mean
+ * over the samples an unbiased estimate of the mean over the image. The
+ * AdvancedMeanSquares, AdvancedNormalizedCorrelation and
+ * AdvancedMattesMutualInformation metrics multiply the contribution of every
+ * sample by its weight; AdvancedMattesMutualInformation not when
+ * FiniteDifferenceDerivative is true. The other metrics do not support the
+ * weights, and report an error when they are combined with this sampler.
+ *
+ * This sampler is suitable to used in combination with the
+ * NewSamplesEveryIteration parameter (defined in the elx::OptimizerBase).
+ *
+ * The parameters used in this class are:
+ * \parameter ImageSampler: Select this image sampler as follows:\n
+ *    <tt>(ImageSampler "ImportanceRandom")</tt>
+ * \parameter NumberOfSpatialSamples: The number of image voxels used for computing the
+ *    metric value and its derivative in each iteration. Must be given for each resolution.\n
+ *    example: <tt>(NumberOfSpatialSamples 2048 2048 4000)</tt> \n
+ *    The default is 5000.
+ * \parameter ImportanceSamplerUniformFraction: The fraction of the samples that is drawn
+ *    uniformly, between 0 and 1. It bounds the importance weights by its inverse.
+ *    Can be given for each resolution.\n
+ *    example: <tt>(ImportanceSamplerUniformFraction 0.2 0.1 0.1)</tt> \n
+ *    The default is 0.1.
+ * \parameter ImportanceSamplerWeightImageFileName: An image with the importance of every
+ *    voxel, in the fixed image domain. Its value at the voxel nearest to a fixed image voxel
+ *    is used. Negative values are treated as zero.\n
+ *    example: <tt>(ImportanceSamplerWeightImageFileName "weights.mhd")</tt> \n
+ *    By default, the gradient magnitude of the fixed image of each resolution is used.
+ *
+ * \ingroup ImageSamplers
+ */
+
+template <class TElastix>
+class ITK_TEMPLATE_EXPORT ImportanceRandomSampler
+  : public itk::ImageImportanceRandomSampler<typename elx::ImageSamplerBase<TElastix>::InputImageType>
+  , public elx::ImageSamplerBase<TElastix>
+{
+public:
+  /** Standard ITK-stuff. */
+  typedef ImportanceRandomSampler                                                                     Self;
+  typedef itk::ImageImportanceRandomSampler<typename elx::ImageSamplerBase<TElastix>::InputImageType> Superclass1;
+  typedef elx::ImageSamplerBase<TElastix>                                                             Superclass2;
+  typedef itk::SmartPointer<Self>                                                                     Pointer;
+  typedef itk::SmartPointer<const Self>                                                               ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImportanceRandomSampler, itk::ImageImportanceRandomSampler);
+
+  /** Name of this class.
+   * Use this name in the parameter file to select this specific interpolator. \n
+   * example: <tt>(ImageSampler "ImportanceRandom")</tt>\n
+   */
+  elxClassNameMacro("ImportanceRandom");
+
+  /** Typedefs inherited from the superclass. */
+  typedef typename Superclass1::DataObjectPointer            DataObjectPointer;
+  typedef typename Superclass1::OutputVectorContainerType    OutputVectorContainerType;
+  typedef typename Superclass1::OutputVectorContainerPointer OutputVectorContainerPointer;
+  typedef typename Superclass1::InputImageType               InputImageType;
+  typedef typename Superclass1::InputImagePointer            InputImagePointer;
+  typedef typename Superclass1::InputImageConstPointer       InputImageConstPointer;
+  typedef typename Superclass1::InputImageRegionType         InputImageRegionType;
+  typedef typename Superclass1::InputImagePixelType          InputImagePixelType;
+  typedef typename Superclass1::ImageSampleType              ImageSampleType;
+  typedef typename Superclass1::ImageSampleContainerType     ImageSampleContainerType;
+  typedef typename Superclass1::MaskType                     MaskType;
+  typedef typename Superclass1::InputImageIndexType          InputImageIndexType;
+  typedef typename Superclass1::InputImagePointType          InputImagePointType;
+  typedef typename Superclass1::WeightImageType              WeightImageType;
+
+  /** The input image dimension. */
+  itkStaticConstMacro(InputImageDimension, unsigned int, Superclass1::InputImageDimension);
+
+  /** Typedefs inherited from Elastix. */
+  typedef typename Superclass2::ElastixType          ElastixType;
+  typedef typename Superclass2::ElastixPointer       ElastixPointer;
+  typedef typename Superclass2::ConfigurationType    ConfigurationType;
+  typedef typename Superclass2::ConfigurationPointer ConfigurationPointer;
+  typedef typename Superclass2::RegistrationType     RegistrationType;
+  typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
+  typedef typename Superclass2::ITKBaseType          ITKBaseType;
+
+  /** Execute stuff before the registration:
+   * \li Read the weight image, if given.
+   */
+  void
+  BeforeRegistration(void) override;
+
+  /** Execute stuff before each resolution:
+   * \li Set the number of samples.
+   * \li Set the uniform fraction.
+   */
+  void
+  BeforeEachResolution(void) override;
+
+protected:
+  /** The constructor. */
+  ImportanceRandomSampler() = default;
+  /** The destructor. */
+  ~ImportanceRandomSampler() override = default;
+
+private:
+  elxOverrideGetSelfMacro;
+
+  /** The deleted copy constructor. */
+  ImportanceRandomSampler(const Self &) = delete;
+  /** The deleted assignment operator. */
+  void
+  operator=(const Self &) = delete;
+};
+
+} // end namespace elastix
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "elxImportanceRandomSampler.hxx"
+#endif
+
+#endif // end #ifndef elxImportanceRandomSampler_h
@@ -0,0 +1,106 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef elxImportanceRandomSampler_hxx
+#define elxImportanceRandomSampler_hxx
+
+#include "elxImportanceRandomSampler.h"
+
+#include "itkChangeInformationImageFilter.h"
+#include "itkImageFileReader.h"
+
+namespace elastix
+{
+
+/**
+ * ******************* BeforeRegistration ******************
+ */
+
+template <class TElastix>
+void
+ImportanceRandomSampler<TElastix>::BeforeRegistration(void)
+{
+  /** Read the name of the weight image. */
+  std::string fileName = "";
+  this->GetConfiguration()->ReadParameter(
+    fileName, "ImportanceSamplerWeightImageFileName", this->GetComponentLabel(), 0, -1, false);
+  if (fileName.empty())
+  {
+    return;
+  }
+
+  /** Read the weight image, possibly overruling the direction cosines, like the fixed image. */
+  typedef itk::ImageFileReader<WeightImageType>              ReaderType;
+  typedef itk::ChangeInformationImageFilter<WeightImageType> ChangeInfoFilterType;
+  typename ReaderType::Pointer                               reader = ReaderType::New();
+  typename ChangeInfoFilterType::Pointer                     infoChanger = ChangeInfoFilterType::New();
+  typename WeightImageType::DirectionType                    direction;
+  direction.SetIdentity();
+  reader->SetFileName(fileName);
+  infoChanger->SetOutputDirection(direction);
+  infoChanger->SetChangeDirection(!this->GetElastix()->GetUseDirectionCosines());
+  infoChanger->SetInput(reader->GetOutput());
+  try
+  {
+    infoChanger->Update();
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    /** Add information to the exception. */
+    excp.SetLocation("ImportanceRandomSampler - BeforeRegistration()");
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while reading the importance sampler weight image.\n";
+    excp.SetDescription(err_str);
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+
+  this->SetWeightImage(infoChanger->GetOutput());
+
+} // end BeforeRegistration()
+
+
+/**
+ * ******************* BeforeEachResolution ******************
+ */
+
+template <class TElastix>
+void
+ImportanceRandomSampler<TElastix>::BeforeEachResolution(void)
+{
+  const unsigned int level = (this->m_Registration->GetAsITKBaseType())->GetCurrentLevel();
+
+  /** Set the NumberOfSpatialSamples. */
+  unsigned long numberOfSpatialSamples = 5000;
+  this->GetConfiguration()->ReadParameter(
+    numberOfSpatialSamples, "NumberOfSpatialSamples", this->GetComponentLabel(), level, 0);
+
+  this->SetNumberOfSamples(numberOfSpatialSamples);
+
+  /** Set the fraction of the samples that is drawn uniformly. */
+  double uniformFraction = 0.1;
+  this->GetConfiguration()->ReadParameter(
+    uniformFraction, "ImportanceSamplerUniformFraction", this->GetComponentLabel(), level, 0);
+
+  this->SetUniformFraction(uniformFraction);
+
+} // end BeforeEachResolution()
+
+
+} // end namespace elastix
+
+#endif // end #ifndef elxImportanceRandomSampler_hxx
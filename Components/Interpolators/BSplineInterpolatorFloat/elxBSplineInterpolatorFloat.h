@@ -108,6 +108,12 @@ public:
   void
   BeforeEachResolution(void) override;
 
+  /** Execute stuff after each pyramid resolution:
+   * \li Release the B-spline coefficient image, except after the last resolution.
+   */
+  void
+  AfterEachResolution(void) override;
+
 protected:
   /** The constructor. */
   BSplineInterpolatorFloat() = default;
@@ -54,6 +54,32 @@ BSplineInterpolatorFloat<TElastix>::BeforeEachResolution(void)
 } // end BeforeEachResolution()
 
 
+/**
+ * ***************** AfterEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+BSplineInterpolatorFloat<TElastix>::AfterEachResolution(void)
+{
+  /** Get the current resolution level and the number of levels. */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+  const unsigned int numberOfLevels = this->m_Registration->GetAsITKBaseType()->GetNumberOfLevels();
+
+  /** The coefficients are computed again when the next resolution sets the input image,
+   * so free them now, before the next pyramid level is computed. The coefficient image is
+   * also referenced by the internal coefficient filter, hence its buffer is released.
+   * After the last resolution the final metric value may still be computed.
+   */
+  if (level + 1 < numberOfLevels && this->m_Coefficients.IsNotNull())
+  {
+    const_cast<CoefficientImageType *>(this->m_Coefficients.GetPointer())->Initialize();
+    this->m_Coefficients = nullptr;
+  }
+
+} // end AfterEachResolution()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef elxBSplineInterpolatorFloat_hxx
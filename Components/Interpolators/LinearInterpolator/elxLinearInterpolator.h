@@ -36,6 +36,10 @@ namespace elastix
  * The parameters used in this class are:
  * \parameter Interpolator: Select this interpolator as follows:\n
  *    <tt>(Interpolator "LinearInterpolator")</tt>
+ * \parameter UseBrickedImageLayout: read the moving image from a copy that is stored in
+ *    bricks of 8 pixels along each dimension, which is faster for large images.\n
+ *    example: <tt>(UseBrickedImageLayout "true")</tt> \n
+ *    Default "false". The parameter can be specified for each resolution.
  *
  * \ingroup Interpolators
  */
@@ -87,6 +91,18 @@ public:
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
 
+  /** Execute stuff before each new pyramid resolution:
+   * \li Set whether a bricked copy of the moving image is used.
+   */
+  void
+  BeforeEachResolution(void) override;
+
+  /** Execute stuff after each pyramid resolution:
+   * \li Release the bricked copy of the moving image, except after the last resolution.
+   */
+  void
+  AfterEachResolution(void) override;
+
 protected:
   /** The constructor. */
   LinearInterpolator() = default;
@@ -24,7 +24,46 @@
 namespace elastix
 {
 
-/** Nothing */
+/**
+ * ***************** BeforeEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+LinearInterpolator<TElastix>::BeforeEachResolution(void)
+{
+  /** Get the current resolution level. */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+
+  /** Read whether the moving image is copied to a bricked layout. */
+  bool useBrickedLayout = false;
+  this->GetConfiguration()->ReadParameter(
+    useBrickedLayout, "UseBrickedImageLayout", this->GetComponentLabel(), level, 0, false);
+  this->SetUseBrickedLayout(useBrickedLayout);
+
+} // end BeforeEachResolution()
+
+
+/**
+ * ***************** AfterEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+LinearInterpolator<TElastix>::AfterEachResolution(void)
+{
+  /** Get the current resolution level and the number of levels. */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+  const unsigned int numberOfLevels = this->m_Registration->GetAsITKBaseType()->GetNumberOfLevels();
+
+  /** The next resolution sets the input image again, so free the bricked copy now. */
+  if (level + 1 < numberOfLevels && this->GetUseBrickedLayout())
+  {
+    this->SetInputImage(nullptr);
+  }
+
+} // end AfterEachResolution()
+
 
 } // end namespace elastix
 
@@ -40,6 +40,19 @@ namespace elastix
  *    The default order is 1. The parameter can be specified for each resolution.\n
  *    If only given for one resolution, that value is used for the other resolutions as well. \n
  *    Currently only first order B-spline interpolation is supported.
+ * \parameter UseBrickedImageLayout: read the B-spline coefficients from a copy that is stored in
+ *    bricks of 8 pixels along each dimension, which is faster for large images.\n
+ *    example: <tt>(UseBrickedImageLayout "true")</tt> \n
+ *    Default "false". The parameter can be specified for each resolution.
+ * \parameter ReducedDimensionBSplineCoefficientStorage: store the B-spline coefficients with
+ *    16 bits each, instead of as doubles, which takes a quarter of the memory. Choose from
+ *    "double", "float16" (half precision floats) and "uint16" (integers scaled to the range of
+ *    the coefficients).\n
+ *    example: <tt>(ReducedDimensionBSplineCoefficientStorage "float16")</tt> \n
+ *    Default "double". The parameter can be specified for each resolution.
+ *    It takes precedence over UseBrickedImageLayout. Only this interpolator supports it: the
+ *    BSplineInterpolator and BSplineInterpolatorFloat always store their coefficients with
+ *    full precision.
  *
  * \ingroup Interpolators
  */
@@ -79,17 +92,18 @@ public:
   itkStaticConstMacro(ImageDimension, unsigned int, Superclass1::ImageDimension);
 
   /** Typedefs inherited from the superclass. */
-  typedef typename Superclass1::OutputType               OutputType;
-  typedef typename Superclass1::InputImageType           InputImageType;
-  typedef typename Superclass1::IndexType                IndexType;
-  typedef typename Superclass1::ContinuousIndexType      ContinuousIndexType;
-  typedef typename Superclass1::PointType                PointType;
-  typedef typename Superclass1::Iterator                 Iterator;
-  typedef typename Superclass1::CoefficientDataType      CoefficientDataType;
-  typedef typename Superclass1::CoefficientImageType     CoefficientImageType;
-  typedef typename Superclass1::CoefficientFilter        CoefficientFilter;
-  typedef typename Superclass1::CoefficientFilterPointer CoefficientFilterPointer;
-  typedef typename Superclass1::CovariantVectorType      CovariantVectorType;
+  typedef typename Superclass1::OutputType                       OutputType;
+  typedef typename Superclass1::InputImageType                   InputImageType;
+  typedef typename Superclass1::IndexType                        IndexType;
+  typedef typename Superclass1::ContinuousIndexType              ContinuousIndexType;
+  typedef typename Superclass1::PointType                        PointType;
+  typedef typename Superclass1::Iterator                         Iterator;
+  typedef typename Superclass1::CoefficientDataType              CoefficientDataType;
+  typedef typename Superclass1::CoefficientImageType             CoefficientImageType;
+  typedef typename Superclass1::CoefficientFilter                CoefficientFilter;
+  typedef typename Superclass1::CoefficientFilterPointer         CoefficientFilterPointer;
+  typedef typename Superclass1::CovariantVectorType              CovariantVectorType;
+  typedef typename Superclass1::ReducedPrecisionCoefficientsType ReducedPrecisionCoefficientsType;
 
   /** Typedefs inherited from Elastix. */
   typedef typename Superclass2::ElastixType          ElastixType;
@@ -102,10 +116,18 @@ public:
 
   /** Execute stuff before each new pyramid resolution:
    * \li Set the spline order.
+   * \li Set whether a bricked copy of the coefficients is used.
+   * \li Set whether the coefficients are stored with 16 bits each.
    */
   void
   BeforeEachResolution(void) override;
 
+  /** Execute stuff after each pyramid resolution:
+   * \li Release the B-spline coefficient image, except after the last resolution.
+   */
+  void
+  AfterEachResolution(void) override;
+
 protected:
   /** The constructor. */
   ReducedDimensionBSplineInterpolator() = default;
@@ -51,9 +51,63 @@ ReducedDimensionBSplineInterpolator<TElastix>::BeforeEachResolution(void)
   /** Set the splineOrder. */
   this->SetSplineOrder(splineOrder);
 
+  /** Read whether the coefficients are copied to a bricked layout. */
+  bool useBrickedLayout = false;
+  this->GetConfiguration()->ReadParameter(
+    useBrickedLayout, "UseBrickedImageLayout", this->GetComponentLabel(), level, 0, false);
+  this->SetUseBrickedLayout(useBrickedLayout);
+
+  /** Read whether the coefficient image is stored with 16 bits per coefficient, and the encoding. */
+  std::string coefficientStorage = "double";
+  this->GetConfiguration()->ReadParameter(
+    coefficientStorage, "ReducedDimensionBSplineCoefficientStorage", this->GetComponentLabel(), level, 0, false);
+  if (coefficientStorage == "float16")
+  {
+    this->SetReducedPrecisionEncoding(ReducedPrecisionCoefficientsType::Float16);
+  }
+  else if (coefficientStorage == "uint16")
+  {
+    this->SetReducedPrecisionEncoding(ReducedPrecisionCoefficientsType::UInt16);
+  }
+  else if (coefficientStorage != "double")
+  {
+    xl::xout["error"] << "ERROR: The ReducedDimensionBSplineCoefficientStorage " << coefficientStorage
+                      << " is not supported." << std::endl;
+    itkExceptionMacro(<< "ERROR: unable to configure " << this->GetComponentLabel());
+  }
+  this->SetUseReducedPrecision(coefficientStorage != "double");
+
 } // end BeforeEachResolution()
 
 
+/**
+ * ***************** AfterEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+ReducedDimensionBSplineInterpolator<TElastix>::AfterEachResolution(void)
+{
+  /** Get the current resolution level and the number of levels. */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+  const unsigned int numberOfLevels = this->m_Registration->GetAsITKBaseType()->GetNumberOfLevels();
+
+  /** The coefficients are computed again when the next resolution sets the input image,
+   * so free them now, before the next pyramid level is computed. The coefficient image is
+   * also referenced by the internal coefficient filter, hence its buffer is released.
+   * After the last resolution the final metric value may still be computed.
+   */
+  if (level + 1 < numberOfLevels && this->m_Coefficients.IsNotNull())
+  {
+    const_cast<CoefficientImageType *>(this->m_Coefficients.GetPointer())->Initialize();
+    this->m_Coefficients = nullptr;
+    this->m_BrickedCoefficients.Clear();
+    this->m_ReducedPrecisionCoefficients.Clear();
+  }
+
+} // end AfterEachResolution()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef elxReducedDimensionBSplineInterpolator_hxx
@@ -672,8 +672,7 @@ AdvancedKappaStatisticImageToImageMetric<TFixedImage, TMovingImage>::AfterThread
     temp->st_Coefficient2 = tmp2;
     temp->st_DerivativePointer = derivative.begin();
 
-    this->m_Threader->SetSingleMethod(AccumulateDerivativesThreaderCallback, temp);
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(AccumulateDerivativesThreaderCallback, temp);
 
     delete temp;
   }
@@ -49,6 +49,10 @@ namespace itk
  * \li Image derivatives are computed using either the B-spline interpolator implementation
  * or by nearest neighbor interpolation of a precomputed central difference image.
  * \li A minimum number of samples that should map within the moving image (mask) can be specified.
+ * \li The contributions of the samples to the joint histogram and to the analytic derivative are
+ * multiplied by the importance weights of the samples, see ImageImportanceRandomSampler, and the
+ * histogram is normalized by the sum of the weights. The finite difference derivative does not
+ * support the weights.
  *
  * Notes:\n
  * 1. This class returns the negative mutual information value.\n
@@ -147,6 +151,15 @@ public:
   itkGetConstMacro(UseJacobianPreconditioning, bool);
   itkSetMacro(UseJacobianPreconditioning, bool);
 
+  /** The histogram contributions are multiplied by the importance weights of the samples,
+   * except with the finite difference derivative.
+   */
+  bool
+  SampleWeightsSupported(void) const override
+  {
+    return !this->GetUseFiniteDifferenceDerivative();
+  }
+
 protected:
   /** The constructor. */
   ParzenWindowMutualInformationImageToImageMetric();
@@ -181,6 +194,7 @@ protected:
   typedef typename Superclass::ParzenValueContainerType            ParzenValueContainerType;
   typedef typename Superclass::KernelFunctionType                  KernelFunctionType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBatchType                     SampleBatchType;
 
   /**  Get the value and analytic derivative.
    * Called by GetValueAndDerivative if UseFiniteDifferenceDerivative == false.
@@ -240,6 +254,15 @@ protected:
   inline void
   ThreadedComputeDerivativeLowMemory(ThreadIdType threadId);
 
+  /** Multi-threaded version of the ComputeDerivativeLowMemory function, for the samples
+   * [firstSample, lastSample[. Adds to the derivative of threadId. With Jacobian preconditioning,
+   * the derivative is normalized per range, so it is then only called once per thread.
+   */
+  inline void
+  ThreadedComputeDerivativeLowMemoryOfSampleRange(ThreadIdType  threadId,
+                                                  SizeValueType firstSample,
+                                                  SizeValueType lastSample);
+
   /** Single-threadedly accumulate results. */
   inline void
   AfterThreadedComputeDerivativeLowMemory(DerivativeType & derivative) const;
@@ -274,10 +297,13 @@ private:
   void
   ComputeDerivativeLowMemory(DerivativeType & derivative) const;
 
-  /** Helper function to update the derivative for the low memory variant. */
+  /** Helper function to update the derivative for the low memory variant,
+   * scaled by the importance weight of the sample.
+   */
   void
   UpdateDerivativeLowMemory(const RealType &                   fixedImageValue,
                             const RealType &                   movingImageValue,
+                            const double                       sampleWeight,
                             const DerivativeType &             imageJacobian,
                             const NonZeroJacobianIndicesType & nzji,
                             DerivativeType &                   derivative) const;
@@ -26,6 +26,7 @@
 #include "itkMatrix.h"
 #include "vnl/vnl_inverse.h"
 #include "vnl/vnl_det.h"
+#include <algorithm> // For min.
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -300,8 +301,9 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
     preconditioningDivisor.Fill(0.0);
   }
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -367,7 +369,8 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Comp
       }
 
       /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
+      const double sampleWeight = sampleWeights != nullptr ? sampleWeights[fiter.Index()] : 1.0;
+      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, sampleWeight, imageJacobian, nzji, derivative);
 
     } // end sampleOk
   }   // end loop over sample container
@@ -426,10 +429,36 @@ void
 ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedComputeDerivativeLowMemory(
   ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  /** Get the samples for this thread. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  this->ThreadedComputeDerivativeLowMemoryOfSampleRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedComputeDerivativeLowMemory()
+
+
+/**
+ * ******************* ThreadedComputeDerivativeLowMemoryOfSampleRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  ThreadedComputeDerivativeLowMemoryOfSampleRange(ThreadIdType  threadId,
+                                                  SizeValueType pos_begin,
+                                                  SizeValueType pos_end)
+{
+  /** Initialize the sparse Jacobian + indices, for the Jacobian preconditioning. */
   const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
   NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nzji.size());
+  TransformJacobianType        jacobian;
 
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
@@ -447,99 +476,63 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
     preconditioningDivisor.Fill(0.0);
   }
 
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
-
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+  /** Create iterator over the sample container, and get the sample weights of this range. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator fiter = sampleContainer->Begin();
+  fiter += (int)pos_begin;
+  const float * sampleWeights = this->GetSampleWeightsAt(pos_begin);
 
-  /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator fiter;
-  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
-  fbegin += (int)pos_begin;
-  fend += (int)pos_end;
+  /** Loop over sample container and compute contribution of each sample to pdfs,
+   * in batches of samples.
+   */
+  const unsigned int batchSize = this->GetSampleBatchSize();
+  SampleBatchType    batch;
+  this->InitializeSampleBatch(batch);
 
-  /** Loop over sample container and compute contribution of each sample to pdfs. */
-  for (fiter = fbegin; fiter != fend; ++fiter)
+  for (unsigned long pos = pos_begin; pos < pos_end; pos += batchSize)
   {
-    /** Read fixed coordinates and create some variables. */
-    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImageDerivativeType   movingImageDerivative;
-    MovingImagePointType        mappedPoint;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if the point is inside the moving mask. */
-    if (sampleOk)
+    /** Evaluate the samples of this batch. */
+    typename ImageSampleContainerType::ConstIterator batch_fend = fiter;
+    batch_fend += (int)std::min<unsigned long>(batchSize, pos_end - pos);
+    const float * batchWeights = sampleWeights != nullptr ? sampleWeights + (pos - pos_begin) : nullptr;
+    this->EvaluateSampleBatch(fiter, batch_fend, batch, true, batchWeights);
+    fiter = batch_fend;
+
+    /** Make sure the values fall within the histogram range. */
+    for (unsigned int v = 0; v < batch.m_NumberOfValidSamples; ++v)
     {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
+      batch.m_FixedImageValues[v] = this->GetFixedImageLimiter()->Evaluate(batch.m_FixedImageValues[v]);
+      batch.m_MovingImageValues[v] =
+        this->GetMovingImageLimiter()->Evaluate(batch.m_MovingImageValues[v], batch.m_MovingImageDerivatives[v]);
     }
 
-    /** Compute the moving image value, its derivative, and check
-     * if the point is inside the moving image buffer.
-     */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
+    /** Compute the image Jacobians, with the limited moving image derivatives. */
+    this->EvaluateSampleBatchImageJacobians(batch);
 
-    if (sampleOk)
+    /** Compute the contributions of the valid samples to the joint distributions. */
+    for (unsigned int v = 0; v < batch.m_NumberOfValidSamples; ++v)
     {
-      /** Get the fixed image value. */
-      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
-
-      /** Make sure the values fall within the histogram range. */
-      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
-      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+      DerivativeType & imageJacobian = batch.m_ImageJacobians[v];
 
       /** If desired, apply the technique introduced by Tustison. */
-      TransformJacobianType jacobian;
       if (this->GetUseJacobianPreconditioning())
       {
-        this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
-
+        this->EvaluateTransformJacobian(batch.m_FixedPoints[v], jacobian, nzji);
         this->ComputeJacobianPreconditioner(jacobian, nzji, jacobianPreconditioner, preconditioningDivisor);
-        DerivativeValueType * imjacit = imageJacobian.begin();
-        DerivativeValueType * jacprecit = jacobianPreconditioner.begin();
-        for (unsigned int i = 0; i < nzji.size(); ++i)
+        for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
         {
-          while (imjacit != imageJacobian.end())
-          {
-            (*imjacit) *= (*jacprecit);
-            ++imjacit;
-            ++jacprecit;
-          }
+          imageJacobian[i] *= jacobianPreconditioner[i];
         }
       }
 
-      /** Compute this sample's contribution to the joint distributions. */
-      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
-
-    } // end sampleOk
-  }   // end loop over sample container
+      this->UpdateDerivativeLowMemory(batch.m_FixedImageValues[v],
+                                      batch.m_MovingImageValues[v],
+                                      batch.m_SampleWeights[v],
+                                      imageJacobian,
+                                      batch.m_NonZeroJacobianIndices[v],
+                                      derivative);
+    }
+  }
 
   /** If desired, apply the technique introduced by Tustison. */
   if (this->GetUseJacobianPreconditioning())
@@ -559,7 +552,7 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Thre
     }
   }
 
-} // end ThreadedComputeDerivativeLowMemory()
+} // end ThreadedComputeDerivativeLowMemoryOfSampleRange()
 
 
 /**
@@ -607,9 +600,8 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Afte
     this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
 
-    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
-                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                                 const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
   }
 
 } // end AfterThreadedComputeDerivativeLowMemory()
@@ -647,13 +639,23 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage,
                                                 TMovingImage>::LaunchComputeDerivativeLowMemoryThreaderCallback(void)
   const
 {
-  /** Setup threader. */
-  this->m_Threader->SetSingleMethod(
-    this->ComputeDerivativeLowMemoryThreaderCallback,
-    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowMutualInformationThreaderParameters)));
+  /** Distribute the samples over the pool in chunks. Not with Jacobian preconditioning,
+   * which normalizes the derivative of each thread by the preconditioner of its samples.
+   */
+  if (this->CanLaunchSampleRangesOnThreadPool() && !this->GetUseJacobianPreconditioning())
+  {
+    Self * metric = this->m_ParzenWindowMutualInformationThreaderParameters.m_Metric;
+    this->LaunchSampleRangesOnThreadPool(
+      [metric](ThreadIdType threadId, SizeValueType firstSample, SizeValueType lastSample) {
+        metric->ThreadedComputeDerivativeLowMemoryOfSampleRange(threadId, firstSample, lastSample);
+      });
+    return;
+  }
 
   /** Launch. */
-  this->m_Threader->SingleMethodExecute();
+  this->LaunchThreaderCallback(
+    this->ComputeDerivativeLowMemoryThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowMutualInformationThreaderParameters)));
 
 } // end LaunchComputeDerivativeLowMemoryThreaderCallback()
 
@@ -742,6 +744,7 @@ void
 ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::UpdateDerivativeLowMemory(
   const RealType &                   fixedImageValue,
   const RealType &                   movingImageValue,
+  const double                       sampleWeight,
   const DerivativeType &             imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   DerivativeType &                   derivative) const
@@ -797,6 +800,9 @@ ParzenWindowMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Upda
     }
   }
 
+  /** Scale the sum by the importance weight of the sample. */
+  sum *= sampleWeight;
+
   /** Now compute derivative -= sum * imageJacobian. */
   if (nzji.size() == this->GetNumberOfParameters())
   {
@@ -47,6 +47,8 @@ namespace itk
  * \li Image derivatives are computed using either the B-spline interpolator's implementation
  * or by nearest neighbor interpolation of a precomputed central difference image.
  * \li A minimum number of samples that should map within the moving image (mask) can be specified.
+ * \li The squared differences are multiplied by the importance weights of the samples, see
+ * ImageImportanceRandomSampler, so that the measure does not depend on how the samples were drawn.
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
@@ -186,6 +188,13 @@ public:
    */
   itkSetMacro(UseOpenMP, bool);
 
+  /** The squared differences are multiplied by the importance weights of the samples. */
+  bool
+  SampleWeightsSupported(void) const override
+  {
+    return true;
+  }
+
 protected:
   AdvancedMeanSquaresImageToImageMetric();
   ~AdvancedMeanSquaresImageToImageMetric() override = default;
@@ -206,6 +215,7 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBatchType                     SampleBatchType;
 
   /** Protected typedefs for SelfHessian */
   typedef SmoothingRecursiveGaussianImageFilter<FixedImageType, FixedImageType>         SmootherType;
@@ -216,11 +226,12 @@ protected:
 
   double m_NormalizationFactor;
 
-  /** Compute a pixel's contribution to the measure and derivatives;
-   * Called by GetValueAndDerivative(). */
+  /** Compute a pixel's contribution to the measure and derivatives, scaled by
+   * the importance weight of the sample; Called by GetValueAndDerivative(). */
   void
   UpdateValueAndDerivativeTerms(const RealType                     fixedImageValue,
                                 const RealType                     movingImageValue,
+                                const RealType                     sampleWeight,
                                 const DerivativeType &             imageJacobian,
                                 const NonZeroJacobianIndicesType & nzji,
                                 MeasureType &                      measure,
@@ -237,6 +248,10 @@ protected:
   inline void
   ThreadedGetValue(ThreadIdType threadID) override;
 
+  /** Get value for a range of samples, on the thread pool. */
+  inline void
+  ThreadedGetValueOfSampleRange(ThreadIdType threadID, SizeValueType firstSample, SizeValueType lastSample) override;
+
   /** Gather the values from all threads. */
   inline void
   AfterThreadedGetValue(MeasureType & value) const override;
@@ -245,10 +260,27 @@ protected:
   inline void
   ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
 
+  /** Get value and derivatives for a range of samples, on the thread pool. */
+  inline void
+  ThreadedGetValueAndDerivativeOfSampleRange(ThreadIdType  threadID,
+                                             SizeValueType firstSample,
+                                             SizeValueType lastSample) override;
+
   /** Gather the values and derivatives from all threads. */
   inline void
   AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
 
+  /** Get value and derivatives of a range of samples. */
+  void
+  GetValueAndDerivativeOfSamples(
+    const typename ImageSampleContainerType::ConstIterator & first,
+    const typename ImageSampleContainerType::ConstIterator & last,
+    const float *                                            sampleWeights,
+    SizeValueType &                                          numberOfPixelsCounted,
+    MeasureType &                                            measure,
+    DerivativeType &                                         derivative,
+    std::vector<unsigned char> *                             touchedDerivativeTiles) const override;
+
 private:
   AdvancedMeanSquaresImageToImageMetric(const Self &) = delete;
   void
@@ -22,6 +22,7 @@
 #include "vnl/algo/vnl_matrix_update.h"
 #include "itkMersenneTwisterRandomVariateGenerator.h"
 #include "itkComputeImageExtremaFilter.h"
+#include <algorithm> // For min.
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -40,6 +41,7 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AdvancedMeanSq
   this->SetUseImageSampler(true);
   this->SetUseFixedImageLimiter(false);
   this->SetUseMovingImageLimiter(false);
+  this->m_UseThreadedSampleRanges = true;
 
   this->m_UseNormalization = false;
   this->m_NormalizationFactor = 1.0;
@@ -201,8 +203,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueSingle
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -238,12 +241,14 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueSingle
     {
       this->m_NumberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
+      /** Get the fixed image value and the importance weight of the sample. */
       const RealType & fixedImageValue = static_cast<double>((*fiter).Value().m_ImageValue);
+      const RealType   sampleWeight =
+        sampleWeights != nullptr ? static_cast<RealType>(sampleWeights[fiter.Index()]) : 1.0;
 
       /** The difference squared. */
       const RealType diff = movingImageValue - fixedImageValue;
-      measure += diff * diff;
+      measure += sampleWeight * diff * diff;
 
     } // end if sampleOk
 
@@ -315,11 +320,8 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValue(ThreadIdType threadId)
 {
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
-
   /** Get the samples for this thread. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
   const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
     std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
 
@@ -328,6 +330,26 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
   pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
+  this->ThreadedGetValueOfSampleRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************* ThreadedGetValueOfSampleRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueOfSampleRange(
+  ThreadIdType  threadId,
+  SizeValueType pos_begin,
+  SizeValueType pos_end)
+{
+  /** Get a handle to the sample container and the sample weights. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
+
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator threader_fiter;
   typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
@@ -369,22 +391,26 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
     {
       numberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
+      /** Get the fixed image value and the importance weight of the sample. */
       const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
+      const RealType   sampleWeight =
+        sampleWeights != nullptr ? static_cast<RealType>(sampleWeights[threader_fiter.Index()]) : 1.0;
 
       /** The difference squared. */
       const RealType diff = movingImageValue - fixedImageValue;
-      measure += diff * diff;
+      measure += sampleWeight * diff * diff;
 
     } // end if sampleOk
 
   } // end for loop over the image sample container
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+  /** Only update these variables at the end to prevent unnecessary "false sharing".
+   * A thread may process several ranges, so add to them.
+   */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += measure;
 
-} // end ThreadedGetValue()
+} // end ThreadedGetValueOfSampleRange()
 
 
 /**
@@ -398,8 +424,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  this->m_NumberOfPixelsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
 
@@ -489,8 +515,9 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -527,8 +554,10 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
     {
       this->m_NumberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
+      /** Get the fixed image value and the importance weight of the sample. */
       const RealType & fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+      const RealType   sampleWeight =
+        sampleWeights != nullptr ? static_cast<RealType>(sampleWeights[fiter.Index()]) : 1.0;
 
 #if 0
       /** Get the TransformJacobian dT/dmu. */
@@ -544,7 +573,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
 #endif
 
       /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
+      this->UpdateValueAndDerivativeTerms(
+        fixedImageValue, movingImageValue, sampleWeight, imageJacobian, nzji, measure, derivative);
 
     } // end if sampleOk
 
@@ -600,8 +630,15 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDer
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Launch multi-threading metric */
-  this->LaunchGetValueAndDerivativeThreaderCallback();
+  /** Launch multi-threading metric, spatially partitioned if possible. */
+  if (this->GetUseSpatiallyPartitionedSampling() && this->InitializeSpatialPartition())
+  {
+    this->LaunchSpatiallyPartitionedGetValueAndDerivative(derivative);
+  }
+  else
+  {
+    this->LaunchGetValueAndDerivativeThreaderCallback();
+  }
 
   /** Gather the metric values and derivatives from all threads. */
   this->AfterThreadedGetValueAndDerivative(value, derivative);
@@ -617,11 +654,32 @@ template <class TFixedImage, class TMovingImage>
 void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nnzji);
+  /** Get the samples for this thread. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
 
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  this->ThreadedGetValueAndDerivativeOfSampleRange(threadId, pos_begin, pos_end);
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeOfSampleRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivativeOfSampleRange(
+  ThreadIdType  threadId,
+  SizeValueType pos_begin,
+  SizeValueType pos_end)
+{
   /** Get a handle to the pre-allocated derivative for the current thread.
    * The initialization is performed at the beginning of each resolution in
    * InitializeThreadingParameters(), and at the end of each iteration in
@@ -631,19 +689,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
 
   /** Get a handle to the sample container. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
-
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
 
   /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
   typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
   typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
 
@@ -651,67 +698,84 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetVal
   threader_fend += (int)pos_end;
 
   /** Create variables to store intermediate results. circumvent false sharing */
-  unsigned long numberOfPixelsCounted = 0;
+  SizeValueType numberOfPixelsCounted = 0;
   MeasureType   measure = NumericTraits<MeasureType>::Zero;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
+  /** Compute the contributions of the samples of this thread, and record the touched
+   * parts of the derivative for the sparse accumulation.
+   */
+  std::vector<unsigned char> * touchedDerivativeTiles = nullptr;
+  if (this->GetUseSparseDerivativeAccumulation())
   {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
-
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint); // thread-safe?
-    }
-
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
-
-    if (sampleOk)
-    {
-      numberOfPixelsCounted++;
-
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
+    touchedDerivativeTiles = &this->m_GetValueAndDerivativePerThreadVariables[threadId].st_TouchedDerivativeTiles;
+  }
+  this->GetValueAndDerivativeOfSamples(threader_fbegin,
+                                       threader_fend,
+                                       this->GetSampleWeightsAt(pos_begin),
+                                       numberOfPixelsCounted,
+                                       measure,
+                                       derivative,
+                                       touchedDerivativeTiles);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing".
+   * A thread may process several ranges, so add to them.
+   */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted += numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value += measure;
 
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+} // end ThreadedGetValueAndDerivativeOfSampleRange()
 
-      /** Compute this pixel's contribution to the measure and derivatives. */
-      this->UpdateValueAndDerivativeTerms(fixedImageValue, movingImageValue, imageJacobian, nzji, measure, derivative);
 
-    } // end if sampleOk
+/**
+ * ******************* GetValueAndDerivativeOfSamples *******************
+ */
 
-  } // end for loop over the image sample container
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivativeOfSamples(
+  const typename ImageSampleContainerType::ConstIterator & first,
+  const typename ImageSampleContainerType::ConstIterator & last,
+  const float *                                            sampleWeights,
+  SizeValueType &                                          numberOfPixelsCounted,
+  MeasureType &                                            measure,
+  DerivativeType &                                         derivative,
+  std::vector<unsigned char> *                             touchedDerivativeTiles) const
+{
+  /** Loop over the fixed image to calculate the mean squares, in batches of samples. */
+  const unsigned int batchSize = this->GetSampleBatchSize();
+  SampleBatchType    batch;
+  this->InitializeSampleBatch(batch);
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator batch_last;
+  for (fiter = first; fiter != last; fiter = batch_last)
+  {
+    /** Evaluate the samples of this batch and their image Jacobians. */
+    batch_last = fiter;
+    batch_last += (int)std::min<SizeValueType>(batchSize, last.Index() - fiter.Index());
+    const float * batchWeights = sampleWeights != nullptr ? sampleWeights + (fiter.Index() - first.Index()) : nullptr;
+    this->EvaluateSampleBatch(fiter, batch_last, batch, true, batchWeights);
+    this->EvaluateSampleBatchImageJacobians(batch);
+
+    /** Compute the contributions of the valid samples to the measure and derivatives. */
+    numberOfPixelsCounted += batch.m_NumberOfValidSamples;
+    for (unsigned int v = 0; v < batch.m_NumberOfValidSamples; ++v)
+    {
+      if (touchedDerivativeTiles != nullptr)
+      {
+        this->MarkTouchedDerivativeTiles(batch.m_NonZeroJacobianIndices[v], *touchedDerivativeTiles);
+      }
+      this->UpdateValueAndDerivativeTerms(batch.m_FixedImageValues[v],
+                                          batch.m_MovingImageValues[v],
+                                          batch.m_SampleWeights[v],
+                                          batch.m_ImageJacobians[v],
+                                          batch.m_NonZeroJacobianIndices[v],
+                                          measure,
+                                          derivative);
+    }
+  }
 
-} // end ThreadedGetValueAndDerivative()
+} // end GetValueAndDerivativeOfSamples()
 
 
 /**
@@ -727,8 +791,8 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted = this->m_GetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  this->m_NumberOfPixelsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
 
@@ -756,8 +820,13 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   value *= normal_sum;
 
   /** Accumulate derivatives. */
+  // spatially partitioned: all threads already wrote to the derivative
+  if (this->m_SpatialPartitionIsInitialized)
+  {
+    derivative *= normal_sum;
+  }
   // compute single-threadedly
-  if (!this->m_UseMultiThread && false) // force multi-threaded
+  else if (!this->m_UseMultiThread && false) // force multi-threaded
   {
     derivative = this->m_GetValueAndDerivativePerThreadVariables[0].st_Derivative * normal_sum;
     for (ThreadIdType i = 1; i < numberOfThreads; ++i)
@@ -770,10 +839,10 @@ AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedG
   {
     this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
     this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0 / normal_sum;
+    this->m_ThreaderMetricParameters.st_UseTouchedDerivativeTiles = this->GetUseSparseDerivativeAccumulation();
 
-    this->m_Threader->SetSingleMethod(this->AccumulateDerivativesThreaderCallback,
-                                      const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                                 const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
   }
 #ifdef ELASTIX_USE_OPENMP
   // compute multi-threadedly with openmp
@@ -806,18 +875,19 @@ void
 AdvancedMeanSquaresImageToImageMetric<TFixedImage, TMovingImage>::UpdateValueAndDerivativeTerms(
   const RealType                     fixedImageValue,
   const RealType                     movingImageValue,
+  const RealType                     sampleWeight,
   const DerivativeType &             imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   MeasureType &                      measure,
   DerivativeType &                   deriv) const
 {
-  /** The difference squared. */
+  /** The difference squared, times the importance weight of the sample. */
   const RealType diff = movingImageValue - fixedImageValue;
-  const RealType diffdiff = diff * diff;
+  const RealType diffdiff = sampleWeight * diff * diff;
   measure += diffdiff;
 
   /** Calculate the contributions to the derivatives with respect to each parameter. */
-  const RealType diff_2 = diff * 2.0;
+  const RealType diff_2 = sampleWeight * diff * 2.0;
   if (nzji.size() == this->GetNumberOfParameters())
   {
     /** Loop over all Jacobians. */
@@ -81,6 +81,10 @@ namespace itk
  *
  * where Af and Am are the average of f and m, respectively.
  *
+ * When the samples have importance weights w(x), see ImageImportanceRandomSampler,
+ * every term of the sums sff, smm, sfm, sf and sm, and of the derivative sums, is
+ * multiplied by w(x), and N is the sum of the weights. With unit weights this is
+ * the unweighted NC.
  *
  * \ingroup RegistrationMetrics
  * \ingroup Metrics
@@ -181,6 +185,13 @@ public:
   itkGetConstReferenceMacro(SubtractMean, bool);
   itkBooleanMacro(SubtractMean);
 
+  /** The terms of the sums are multiplied by the importance weights of the samples. */
+  bool
+  SampleWeightsSupported(void) const override
+  {
+    return true;
+  }
+
 protected:
   AdvancedNormalizedCorrelationImageToImageMetric();
   ~AdvancedNormalizedCorrelationImageToImageMetric() override;
@@ -201,13 +212,15 @@ protected:
   typedef typename Superclass::CentralDifferenceGradientFilterType CentralDifferenceGradientFilterType;
   typedef typename Superclass::MovingImageDerivativeType           MovingImageDerivativeType;
   typedef typename Superclass::NonZeroJacobianIndicesType          NonZeroJacobianIndicesType;
+  typedef typename Superclass::SampleBatchType                     SampleBatchType;
 
-  /** Compute a pixel's contribution to the derivative terms;
-   * Called by GetValueAndDerivative().
+  /** Compute a pixel's contribution to the derivative terms, scaled by
+   * the importance weight of the sample; Called by GetValueAndDerivative().
    */
   void
   UpdateDerivativeTerms(const RealType &                   fixedImageValue,
                         const RealType &                   movingImageValue,
+                        const RealType                     sampleWeight,
                         const DerivativeType &             imageJacobian,
                         const NonZeroJacobianIndicesType & nzji,
                         DerivativeType &                   derivativeF,
@@ -225,6 +238,12 @@ protected:
   inline void
   ThreadedGetValueAndDerivative(ThreadIdType threadID) override;
 
+  /** Get value and derivatives for a range of samples, on the thread pool. */
+  inline void
+  ThreadedGetValueAndDerivativeOfSampleRange(ThreadIdType  threadID,
+                                             SizeValueType firstSample,
+                                             SizeValueType lastSample) override;
+
   /** Gather the values and derivatives from all threads */
   inline void
   AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
@@ -259,6 +278,7 @@ private:
   struct CorrelationGetValueAndDerivativePerThreadStruct
   {
     SizeValueType  st_NumberOfPixelsCounted;
+    AccumulateType st_SumOfWeights;
     AccumulateType st_Sff;
     AccumulateType st_Smm;
     AccumulateType st_Sfm;
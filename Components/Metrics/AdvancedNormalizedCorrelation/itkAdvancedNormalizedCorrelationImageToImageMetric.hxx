@@ -19,6 +19,7 @@
 #define _itkAdvancedNormalizedCorrelationImageToImageMetric_hxx
 
 #include "itkAdvancedNormalizedCorrelationImageToImageMetric.h"
+#include <algorithm> // For min.
 
 #ifdef ELASTIX_USE_OPENMP
 #  include <omp.h>
@@ -44,6 +45,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage,
   // Multi-threading structs
   this->m_CorrelationGetValueAndDerivativePerThreadVariables = nullptr;
   this->m_CorrelationGetValueAndDerivativePerThreadVariablesSize = 0;
+  this->m_UseThreadedSampleRanges = true;
 
 } // end Constructor
 
@@ -93,6 +95,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Init
   {
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted =
       NumericTraits<SizeValueType>::Zero;
+    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_SumOfWeights = zero1;
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sff = zero1;
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Smm = zero1;
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sfm = zero1;
@@ -134,6 +137,7 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::UpdateDerivativeTerms(
   const RealType &                   fixedImageValue,
   const RealType &                   movingImageValue,
+  const RealType                     sampleWeight,
   const DerivativeType &             imageJacobian,
   const NonZeroJacobianIndicesType & nzji,
   DerivativeType &                   derivativeF,
@@ -151,9 +155,10 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Upda
 
     for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
     {
-      (*derivativeFit) += fixedImageValue * (*imjacit);
-      (*derivativeMit) += movingImageValue * (*imjacit);
-      (*differentialit) += (*imjacit);
+      const RealType differentialtmp = sampleWeight * (*imjacit);
+      (*derivativeFit) += fixedImageValue * differentialtmp;
+      (*derivativeMit) += movingImageValue * differentialtmp;
+      (*differentialit) += differentialtmp;
       ++imjacit;
       ++derivativeFit;
       ++derivativeMit;
@@ -166,7 +171,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Upda
     for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
     {
       const unsigned int index = nzji[i];
-      const RealType     differentialtmp = imageJacobian[i];
+      const RealType     differentialtmp = sampleWeight * imageJacobian[i];
       derivativeF[index] += fixedImageValue * differentialtmp;
       derivativeM[index] += movingImageValue * differentialtmp;
       differential[index] += differentialtmp;
@@ -206,8 +211,9 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -215,6 +221,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   typename ImageSampleContainerType::ConstIterator fend = sampleContainer->End();
 
   /** Create variables to store intermediate results. */
+  AccumulateType sumOfWeights = NumericTraits<AccumulateType>::Zero;
   AccumulateType sff = NumericTraits<AccumulateType>::Zero;
   AccumulateType smm = NumericTraits<AccumulateType>::Zero;
   AccumulateType sfm = NumericTraits<AccumulateType>::Zero;
@@ -249,17 +256,20 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
     {
       this->m_NumberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
+      /** Get the fixed image value and the importance weight of the sample. */
       const RealType & fixedImageValue = static_cast<double>((*fiter).Value().m_ImageValue);
+      const RealType   sampleWeight =
+        sampleWeights != nullptr ? static_cast<RealType>(sampleWeights[fiter.Index()]) : 1.0;
 
       /** Update some sums needed to calculate NC. */
-      sff += fixedImageValue * fixedImageValue;
-      smm += movingImageValue * movingImageValue;
-      sfm += fixedImageValue * movingImageValue;
+      sumOfWeights += sampleWeight;
+      sff += sampleWeight * fixedImageValue * fixedImageValue;
+      smm += sampleWeight * movingImageValue * movingImageValue;
+      sfm += sampleWeight * fixedImageValue * movingImageValue;
       if (this->m_SubtractMean)
       {
-        sf += fixedImageValue;
-        sm += movingImageValue;
+        sf += sampleWeight * fixedImageValue;
+        sm += sampleWeight * movingImageValue;
       }
 
     } // end if sampleOk
@@ -270,7 +280,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
 
   /** If SubtractMean, then subtract things from sff, smm and sfm. */
-  const RealType N = static_cast<RealType>(this->m_NumberOfPixelsCounted);
+  const RealType N = sumOfWeights;
   if (this->m_SubtractMean && this->m_NumberOfPixelsCounted > 0)
   {
     sff -= (sf * sf / N);
@@ -350,6 +360,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   TransformJacobianType      jacobian;
 
   /** Initialize some variables for intermediate results. */
+  AccumulateType sumOfWeights = NumericTraits<AccumulateType>::Zero;
   AccumulateType sff = NumericTraits<AccumulateType>::Zero;
   AccumulateType smm = NumericTraits<AccumulateType>::Zero;
   AccumulateType sfm = NumericTraits<AccumulateType>::Zero;
@@ -371,8 +382,9 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
    */
   this->BeforeThreadedGetValueAndDerivative(parameters);
 
-  /** Get a handle to the sample container. */
+  /** Get a handle to the sample container and the sample weights. */
   ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  const float *               sampleWeights = this->GetSampleWeightsAt(0);
 
   /** Create iterator over the sample container. */
   typename ImageSampleContainerType::ConstIterator fiter;
@@ -409,8 +421,10 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
     {
       this->m_NumberOfPixelsCounted++;
 
-      /** Get the fixed image value. */
+      /** Get the fixed image value and the importance weight of the sample. */
       const RealType & fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+      const RealType   sampleWeight =
+        sampleWeights != nullptr ? static_cast<RealType>(sampleWeights[fiter.Index()]) : 1.0;
 
       /** Get the TransformJacobian dT/dmu. */
       this->EvaluateTransformJacobian(fixedPoint, jacobian, nzji);
@@ -419,15 +433,16 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
       this->EvaluateTransformJacobianInnerProduct(jacobian, movingImageDerivative, imageJacobian);
 
       /** Update some sums needed to calculate the value of NC. */
-      sff += fixedImageValue * fixedImageValue;
-      smm += movingImageValue * movingImageValue;
-      sfm += fixedImageValue * movingImageValue;
-      sf += fixedImageValue;  // Only needed when m_SubtractMean == true
-      sm += movingImageValue; // Only needed when m_SubtractMean == true
+      sumOfWeights += sampleWeight;
+      sff += sampleWeight * fixedImageValue * fixedImageValue;
+      smm += sampleWeight * movingImageValue * movingImageValue;
+      sfm += sampleWeight * fixedImageValue * movingImageValue;
+      sf += sampleWeight * fixedImageValue;  // Only needed when m_SubtractMean == true
+      sm += sampleWeight * movingImageValue; // Only needed when m_SubtractMean == true
 
       /** Compute this pixel's contribution to the derivative terms. */
       this->UpdateDerivativeTerms(
-        fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM, differential);
+        fixedImageValue, movingImageValue, sampleWeight, imageJacobian, nzji, derivativeF, derivativeM, differential);
 
     } // end if sampleOk
 
@@ -439,7 +454,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::GetV
   /** If SubtractMean, then subtract things from sff, smm, sfm,
    * derivativeF and derivativeM.
    */
-  const RealType N = static_cast<RealType>(this->m_NumberOfPixelsCounted);
+  const RealType N = sumOfWeights;
   if (this->m_SubtractMean && this->m_NumberOfPixelsCounted > 0)
   {
     sff -= (sf * sf / N);
@@ -524,11 +539,32 @@ void
 AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(
   ThreadIdType threadId)
 {
-  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
-  const NumberOfParametersType nnzji = this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices();
-  NonZeroJacobianIndicesType   nzji = NonZeroJacobianIndicesType(nnzji);
-  DerivativeType               imageJacobian(nzji.size());
+  /** Get the samples for this thread. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  this->ThreadedGetValueAndDerivativeOfSampleRange(threadId, pos_begin, pos_end);
 
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************* ThreadedGetValueAndDerivativeOfSampleRange *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivativeOfSampleRange(
+  ThreadIdType  threadId,
+  SizeValueType pos_begin,
+  SizeValueType pos_end)
+{
   /** Get handles to the pre-allocated derivatives for the current thread.
    * The initialization is performed at the beginning of each resolution in
    * InitializeThreadingParameters(), and at the end of each iteration in
@@ -538,28 +574,16 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   DerivativeType & derivativeM = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_DerivativeM;
   DerivativeType & differential = this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Differential;
 
-  /** Get a handle to the sample container. */
-  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
-  const unsigned long         sampleContainerSize = sampleContainer->Size();
-
-  /** Get the samples for this thread. */
-  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
-    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
-
-  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
-  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
-  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
-  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
-
   /** Create iterator over the sample container. */
-  typename ImageSampleContainerType::ConstIterator threader_fiter;
-  typename ImageSampleContainerType::ConstIterator threader_fbegin = sampleContainer->Begin();
-  typename ImageSampleContainerType::ConstIterator threader_fend = sampleContainer->Begin();
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator threader_fiter = sampleContainer->Begin();
+  threader_fiter += (int)pos_begin;
 
-  threader_fbegin += (int)pos_begin;
-  threader_fend += (int)pos_end;
+  /** Get the importance weights of the samples of this range. */
+  const float * sampleWeights = this->GetSampleWeightsAt(pos_begin);
 
   /** Create variables to store intermediate results. */
+  AccumulateType sumOfWeights = NumericTraits<AccumulateType>::Zero;
   AccumulateType sff = NumericTraits<AccumulateType>::Zero;
   AccumulateType smm = NumericTraits<AccumulateType>::Zero;
   AccumulateType sfm = NumericTraits<AccumulateType>::Zero;
@@ -567,76 +591,61 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Thre
   AccumulateType sm = NumericTraits<AccumulateType>::Zero;
   unsigned long  numberOfPixelsCounted = 0;
 
-  /** Loop over the fixed image to calculate the mean squares. */
-  for (threader_fiter = threader_fbegin; threader_fiter != threader_fend; ++threader_fiter)
-  {
-    /** Read fixed coordinates and initialize some variables. */
-    const FixedImagePointType & fixedPoint = (*threader_fiter).Value().m_ImageCoordinates;
-    RealType                    movingImageValue;
-    MovingImagePointType        mappedPoint;
-    MovingImageDerivativeType   movingImageDerivative;
+  /** Loop over the fixed image to calculate the correlation, in batches of samples. */
+  const unsigned int batchSize = this->GetSampleBatchSize();
+  SampleBatchType    batch;
+  this->InitializeSampleBatch(batch);
 
-    /** Transform point and check if it is inside the B-spline support region. */
-    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
-
-    /** Check if point is inside mask. */
-    if (sampleOk)
-    {
-      sampleOk = this->IsInsideMovingMask(mappedPoint);
-    }
-
-    /** Compute the moving image value M(T(x)) and derivative dM/dx and check if
-     * the point is inside the moving image buffer.
-     */
-    if (sampleOk)
-    {
-      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
-    }
-
-    if (sampleOk)
+  for (unsigned long pos = pos_begin; pos < pos_end; pos += batchSize)
+  {
+    /** Evaluate the samples of this batch and their image Jacobians. */
+    typename ImageSampleContainerType::ConstIterator batch_fend = threader_fiter;
+    batch_fend += (int)std::min<unsigned long>(batchSize, pos_end - pos);
+    const float * batchWeights = sampleWeights != nullptr ? sampleWeights + (pos - pos_begin) : nullptr;
+    this->EvaluateSampleBatch(threader_fiter, batch_fend, batch, true, batchWeights);
+    this->EvaluateSampleBatchImageJacobians(batch);
+    threader_fiter = batch_fend;
+
+    numberOfPixelsCounted += batch.m_NumberOfValidSamples;
+    for (unsigned int v = 0; v < batch.m_NumberOfValidSamples; ++v)
     {
-      numberOfPixelsCounted++;
-
-      /** Get the fixed image value. */
-      const RealType & fixedImageValue = static_cast<RealType>((*threader_fiter).Value().m_ImageValue);
-
-#if 0
-      /** Get the TransformJacobian dT/dmu. */
-      this->EvaluateTransformJacobian( fixedPoint, jacobian, nzji );
-
-      /** Compute the inner products (dM/dx)^T (dT/dmu). */
-      this->EvaluateTransformJacobianInnerProduct(
-        jacobian, movingImageDerivative, imageJacobian );
-#else
-      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
-      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
-        fixedPoint, movingImageDerivative, imageJacobian, nzji);
-#endif
+      const RealType & fixedImageValue = batch.m_FixedImageValues[v];
+      const RealType & movingImageValue = batch.m_MovingImageValues[v];
+      const RealType   sampleWeight = batch.m_SampleWeights[v];
 
       /** Update some sums needed to calculate the value of NC. */
-      sff += fixedImageValue * fixedImageValue;
-      smm += movingImageValue * movingImageValue;
-      sfm += fixedImageValue * movingImageValue;
-      sf += fixedImageValue;  // Only needed when m_SubtractMean == true
-      sm += movingImageValue; // Only needed when m_SubtractMean == true
+      sumOfWeights += sampleWeight;
+      sff += sampleWeight * fixedImageValue * fixedImageValue;
+      smm += sampleWeight * movingImageValue * movingImageValue;
+      sfm += sampleWeight * fixedImageValue * movingImageValue;
+      sf += sampleWeight * fixedImageValue;  // Only needed when m_SubtractMean == true
+      sm += sampleWeight * movingImageValue; // Only needed when m_SubtractMean == true
 
       /** Compute this voxel's contribution to the derivative terms. */
-      this->UpdateDerivativeTerms(
-        fixedImageValue, movingImageValue, imageJacobian, nzji, derivativeF, derivativeM, differential);
-
-    } // end if sampleOk
-
-  } // end for loop over the image sample container
+      this->UpdateDerivativeTerms(fixedImageValue,
+                                  movingImageValue,
+                                  sampleWeight,
+                                  batch.m_ImageJacobians[v],
+                                  batch.m_NonZeroJacobianIndices[v],
+                                  derivativeF,
+                                  derivativeM,
+                                  differential);
+    }
+  }
 
-  /** Only update these variables at the end to prevent unnecessary "false sharing". */
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sff = sff;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Smm = smm;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sfm = sfm;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sf = sf;
-  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sm = sm;
+  /** Only update these variables at the end to prevent unnecessary "false sharing".
+   * A thread may process several ranges, so add to them.
+   */
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted +=
+    numberOfPixelsCounted;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_SumOfWeights += sumOfWeights;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sff += sff;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Smm += smm;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sfm += sfm;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sf += sf;
+  this->m_CorrelationGetValueAndDerivativePerThreadVariables[threadId].st_Sm += sm;
 
-} // end ThreadedGetValueAndDerivative()
+} // end ThreadedGetValueAndDerivativeOfSampleRange()
 
 
 /**
@@ -652,9 +661,8 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
   const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
 
   /** Accumulate the number of pixels. */
-  this->m_NumberOfPixelsCounted =
-    this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_NumberOfPixelsCounted;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  this->m_NumberOfPixelsCounted = 0;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
     this->m_NumberOfPixelsCounted +=
       this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
@@ -669,13 +677,15 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
 
   /** Accumulate values. */
   const AccumulateType zero = NumericTraits<AccumulateType>::Zero;
-  AccumulateType       sff = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sff;
-  AccumulateType       smm = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Smm;
-  AccumulateType       sfm = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sfm;
-  AccumulateType       sf = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sf;
-  AccumulateType       sm = this->m_CorrelationGetValueAndDerivativePerThreadVariables[0].st_Sm;
-  for (ThreadIdType i = 1; i < numberOfThreads; ++i)
+  AccumulateType       sumOfWeights = zero;
+  AccumulateType       sff = zero;
+  AccumulateType       smm = zero;
+  AccumulateType       sfm = zero;
+  AccumulateType       sf = zero;
+  AccumulateType       sm = zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
   {
+    sumOfWeights += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_SumOfWeights;
     sff += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sff;
     smm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Smm;
     sfm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sfm;
@@ -683,6 +693,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
     sm += this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sm;
 
     /** Reset these variables for the next iteration. */
+    this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_SumOfWeights = zero;
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sff = zero;
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Smm = zero;
     this->m_CorrelationGetValueAndDerivativePerThreadVariables[i].st_Sfm = zero;
@@ -691,7 +702,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
   }
 
   /** If SubtractMean, then subtract things from sff, smm and sfm. */
-  const RealType N = static_cast<RealType>(this->m_NumberOfPixelsCounted);
+  const RealType N = sumOfWeights;
   if (this->m_SubtractMean)
   {
     sff -= (sf * sf / N);
@@ -759,8 +770,7 @@ AdvancedNormalizedCorrelationImageToImageMetric<TFixedImage, TMovingImage>::Afte
     temp->st_InvertedDenominator = 1.0 / denom;
     temp->st_DerivativePointer = derivative.begin();
 
-    this->m_Threader->SetSingleMethod(AccumulateDerivativesThreaderCallback, temp);
-    this->m_Threader->SingleMethodExecute();
+    this->LaunchThreaderCallback(AccumulateDerivativesThreaderCallback, temp);
 
     delete temp;
   }
@@ -113,6 +113,13 @@ public:
                         MeasureType &          value,
                         DerivativeType &       derivative) const override;
 
+  /** The displacement magnitude penalty is computed single-threaded. */
+  bool
+  GetValueAndDerivativeIsMultiThreaded(void) const override
+  {
+    return false;
+  }
+
 protected:
   /** Typedefs for indices and points. */
   typedef typename Superclass::FixedImageIndexType            FixedImageIndexType;
@@ -28,6 +28,14 @@ namespace elastix
  * \class GradientDifferenceMetric
  * \brief An metric based on the itk::GradientDifferenceImageToImageMetric.
  *
+ * With a ray cast interpolator, the metric is meant for 2D-3D registration and
+ * its derivative is computed by finite differences. With any other interpolator,
+ * the metric and its analytic derivative are computed multi-threaded on the
+ * samples of the ImageSampler, for 2D-2D and 3D-3D registration.
+ *
+ * The parameters used in this class are:
+ * \parameter Metric: Select this metric as follows:\n
+ *    <tt>(Metric "GradientDifference")</tt>
  *
  * \ingroup Metrics
  *
@@ -123,6 +131,12 @@ public:
   void
   Initialize(void) override;
 
+  /** Use the image sampler only without a ray cast interpolator. This is
+   * decided before the registration, which connects the image sampler.
+   */
+  int
+  BeforeAll(void) override;
+
   /**
    * Do some things before each resolution:
    * \li Set CheckNumberOfSamples setting
@@ -42,6 +42,27 @@ GradientDifferenceMetric<TElastix>::Initialize(void)
 } // end Initialize()
 
 
+/**
+ * ***************** BeforeAll ***********************
+ */
+
+template <class TElastix>
+int
+GradientDifferenceMetric<TElastix>::BeforeAll(void)
+{
+  /** The samples are only used without ray cast interpolator. Initialize() makes
+   * the same choice, but the sampler is already connected in BeforeRegistration()
+   * of the registration component.
+   */
+  typedef typename Superclass1::RayCastInterpolatorType RayCastInterpolatorType;
+  const auto * interpolator = this->GetElastix()->GetElxInterpolatorBase()->GetAsITKBaseType();
+  this->SetUseImageSampler(dynamic_cast<const RayCastInterpolatorType *>(interpolator) == nullptr);
+
+  return 0;
+
+} // end BeforeAll()
+
+
 /**
  * ***************** BeforeRegistration ***********************
  */
@@ -50,6 +71,15 @@ template <class TElastix>
 void
 GradientDifferenceMetric<TElastix>::BeforeRegistration(void)
 {
+  /** The 2D-3D requirements only hold for the ray cast interpolator; with other
+   * interpolators the metric is computed on the samples of the image sampler.
+   */
+  typedef typename Superclass1::RayCastInterpolatorType RayCastInterpolatorType;
+  const auto * interpolator = this->GetElastix()->GetElxInterpolatorBase()->GetAsITKBaseType();
+  if (dynamic_cast<const RayCastInterpolatorType *>(interpolator) == nullptr)
+  {
+    return;
+  }
 
   if (this->m_Elastix->GetFixedImage()->GetImageDimension() != 3)
   {
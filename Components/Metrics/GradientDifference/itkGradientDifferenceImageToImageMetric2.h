@@ -45,6 +45,8 @@
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <vector>
+
 namespace itk
 {
 /** \class GradientDifferenceImageToImageMetric
@@ -64,6 +66,20 @@ namespace itk
  * on it. Values at these non-grid position of the Fixed image are
  * interpolated using a user-selected Interpolator.
  *
+ * With a ray cast interpolator (2D-3D registration), the moving image is
+ * resampled on the fixed image grid and filtered with Sobel operators at each
+ * evaluation, and the derivative is computed by finite differences, using
+ * DerivativeDelta and the optimizer Scales.
+ *
+ * With any other interpolator, the metric is evaluated on the samples of the
+ * ImageSampler. The Sobel stencil of the transformed moving image is evaluated
+ * around each sample, so that the moving image is not resampled, and the
+ * derivative is computed analytically, from the transform Jacobian and the
+ * moving image gradient at each stencil point. Both the value and the
+ * derivative are computed multi-threaded. The subtraction factors, which
+ * depend on the range of the moving gradients, are treated as constants in
+ * the derivative.
+ *
  * Implementation of this class is based on:
  * Hipwell, J. H., et. al. (2003), "Intensity-Based 2-D-3D Registration of
  * Cerebral Angiograms,", IEEE Transactions on Medical Imaging,
@@ -132,6 +148,8 @@ public:
   typedef itk::CastImageFilter<TransformedMovingImageType, MovedGradientImageType> CastMovedImageFilterType;
   typedef typename CastMovedImageFilterType::Pointer                               CastMovedImageFilterPointer;
   typedef typename MovedGradientImageType::PixelType                               MovedGradientPixelType;
+  typedef typename Superclass::ImageSampleContainerType                            ImageSampleContainerType;
+  typedef typename Superclass::ImageSampleContainerPointer                         ImageSampleContainerPointer;
 
   /** Get the derivatives of the match measure. */
   void
@@ -181,6 +199,74 @@ protected:
   MeasureType
   ComputeMeasure(const TransformParametersType & parameters, const double * subtractionFactor) const;
 
+  /** Get the value by resampling the moving image, for the ray cast interpolator. */
+  MeasureType
+  GetValueOfResampledImage(const TransformParametersType & parameters) const;
+
+  /** Get the derivative by finite differences, for the ray cast interpolator. */
+  void
+  GetFiniteDifferenceDerivative(const TransformParametersType & parameters, DerivativeType & derivative) const;
+
+  /** Typedefs for the sampler based computation. */
+  typedef typename Superclass::DerivativeValueType                   DerivativeValueType;
+  typedef typename Superclass::FixedImagePointType                   FixedImagePointType;
+  typedef typename Superclass::MovingImagePointType                  MovingImagePointType;
+  typedef typename Superclass::MovingImageDerivativeType             MovingImageDerivativeType;
+  typedef typename Superclass::NonZeroJacobianIndicesType            NonZeroJacobianIndicesType;
+  typedef ContinuousIndex<double, FixedImageDimension>               FixedImageContinuousIndexType;
+  typedef SobelOperator<FixedGradientPixelType, FixedImageDimension> SobelOperatorType;
+
+  /** Compute the Sobel gradients of the fixed image and of the transformed
+   * moving image at the samples in the range [pos_begin, pos_end).
+   */
+  void
+  ComputeGradientsOfSamples(unsigned long pos_begin, unsigned long pos_end) const;
+
+  /** Compute the gradients at the samples for the given parameters, and the
+   * subtraction factors from the moving gradients.
+   */
+  void
+  ComputeGradientsAndSubtractionFactors(const TransformParametersType & parameters) const;
+
+  /** Compute the value of the transformed moving image at the point with the
+   * given offset from a fixed image continuous index, and optionally its gradient.
+   * Offsets outside the fixed image are clamped, as with zero flux Neumann boundary
+   * conditions. Returns false, and a zero value, for points outside the moving image.
+   */
+  bool
+  EvaluateStencilPoint(const FixedImageContinuousIndexType &          cindex,
+                       const typename SobelOperatorType::OffsetType & offset,
+                       FixedImagePointType &                          fixedPoint,
+                       RealType &                                     movingImageValue,
+                       MovingImageDerivativeType *                    gradient) const;
+
+  /** Compute the value of the samples in the range [pos_begin, pos_end). */
+  MeasureType
+  ComputeValueOfSamples(unsigned long pos_begin, unsigned long pos_end) const;
+
+  /** Compute the value and derivative of the samples in the range [pos_begin, pos_end). */
+  void
+  ComputeValueAndDerivativeOfSamples(unsigned long    pos_begin,
+                                     unsigned long    pos_end,
+                                     MeasureType &    measure,
+                                     DerivativeType & derivative) const;
+
+  /** Get the range of samples of a thread. */
+  void
+  GetSampleRangeOfThread(ThreadIdType threadId, unsigned long & pos_begin, unsigned long & pos_end) const;
+
+  /** Multi-threaded computation of the gradients at the samples. */
+  void
+  ThreadedGetValue(ThreadIdType threadId) override;
+
+  /** Multi-threaded version of GetValueAndDerivative(). */
+  void
+  ThreadedGetValueAndDerivative(ThreadIdType threadId) override;
+
+  /** Gather the values and derivatives from all threads. */
+  void
+  AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
+
   typedef NeighborhoodOperatorImageFilter<FixedGradientImageType, FixedGradientImageType> FixedSobelFilter;
 
   typedef NeighborhoodOperatorImageFilter<MovedGradientImageType, MovedGradientImageType> MovedSobelFilter;
@@ -227,6 +313,16 @@ private:
   double                      m_DerivativeDelta;
   double                      m_Rescalingfactor;
   CombinationTransformPointer m_CombinationTransform;
+
+  /** Whether the interpolator is a ray cast interpolator, which requires resampling. */
+  bool m_InterpolatorIsRayCast;
+
+  /** The Sobel gradients at the samples, stored sample by sample. */
+  mutable std::vector<FixedGradientPixelType> m_SampledFixedGradients;
+  mutable std::vector<MovedGradientPixelType> m_SampledMovedGradients;
+
+  /** The subtraction factors of the sampler based computation. */
+  mutable MovedGradientPixelType m_SubtractionFactor[FixedImageDimension];
 };
 
 } // end namespace itk
@@ -40,6 +40,7 @@
 #include "itkRescaleIntensityImageFilter.h"
 #include "itkImageFileWriter.h"
 
+#include <algorithm>
 #include <iostream>
 #include <iomanip>
 #include <stdio.h>
@@ -67,6 +68,7 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GradientDiffere
     this->m_MinFixedGradient[iDimension] = 0;
     this->m_MaxFixedGradient[iDimension] = 0;
     this->m_Variance[iDimension] = 0;
+    this->m_SubtractionFactor[iDimension] = 1;
   }
 
   for (iDimension = 0; iDimension < MovedImageDimension; ++iDimension)
@@ -77,6 +79,7 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GradientDiffere
 
   this->m_DerivativeDelta = 0.001;
   this->m_Rescalingfactor = 1.0;
+  this->m_InterpolatorIsRayCast = false;
 }
 
 
@@ -88,6 +91,13 @@ template <class TFixedImage, class TMovingImage>
 void
 GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void)
 {
+  /** Only the computation on the samples uses the image sampler, the ray cast
+   * interpolator resamples the moving image instead.
+   */
+  RayCastInterpolatorType * rayCaster = dynamic_cast<RayCastInterpolatorType *>(this->GetInterpolator());
+  this->m_InterpolatorIsRayCast = (rayCaster != nullptr);
+  this->SetUseImageSampler(!this->m_InterpolatorIsRayCast);
+
   /** Initialise the base class */
   Superclass::Initialize();
 
@@ -108,38 +118,33 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void
     this->m_FixedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
   }
 
-  /** Resampling for 3D->2D */
-  RayCastInterpolatorType * rayCaster = dynamic_cast<RayCastInterpolatorType *>(this->GetInterpolator());
-  if (rayCaster != nullptr)
+  /** Resampling for 3D->2D. With other interpolators, the moving gradients are
+   * computed at the samples, so that no resampling is needed.
+   */
+  if (this->m_InterpolatorIsRayCast)
   {
     this->m_TransformMovingImageFilter->SetTransform(rayCaster->GetTransform());
-  }
-  else
-  {
-    itkExceptionMacro(<< "ERROR: the NormalizedGradientCorrelationImageToImageMetric is currently "
-                      << "only suitable for 2D-3D registration.\n"
-                      << "  Therefore it expects an interpolator of type RayCastInterpolator.");
-  }
-  this->m_TransformMovingImageFilter->SetInterpolator(this->m_Interpolator);
-  this->m_TransformMovingImageFilter->SetInput(this->m_MovingImage);
-  this->m_TransformMovingImageFilter->SetDefaultPixelValue(0);
-  this->m_TransformMovingImageFilter->SetSize(this->m_FixedImage->GetLargestPossibleRegion().GetSize());
-  this->m_TransformMovingImageFilter->SetOutputOrigin(this->m_FixedImage->GetOrigin());
-  this->m_TransformMovingImageFilter->SetOutputSpacing(this->m_FixedImage->GetSpacing());
-  this->m_TransformMovingImageFilter->SetOutputDirection(this->m_FixedImage->GetDirection());
-  this->m_TransformMovingImageFilter->Update();
-
-  this->m_CastMovedImageFilter->SetInput(this->m_TransformMovingImageFilter->GetOutput());
-
-  for (iFilter = 0; iFilter < MovedImageDimension; ++iFilter)
-  {
-    this->m_MovedSobelOperators[iFilter].SetDirection(iFilter);
-    this->m_MovedSobelOperators[iFilter].CreateDirectional();
-    this->m_MovedSobelFilters[iFilter] = MovedSobelFilter::New();
-    this->m_MovedSobelFilters[iFilter]->OverrideBoundaryCondition(&this->m_MovedBoundCond);
-    this->m_MovedSobelFilters[iFilter]->SetOperator(this->m_MovedSobelOperators[iFilter]);
-    this->m_MovedSobelFilters[iFilter]->SetInput(this->m_CastMovedImageFilter->GetOutput());
-    this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    this->m_TransformMovingImageFilter->SetInterpolator(this->m_Interpolator);
+    this->m_TransformMovingImageFilter->SetInput(this->m_MovingImage);
+    this->m_TransformMovingImageFilter->SetDefaultPixelValue(0);
+    this->m_TransformMovingImageFilter->SetSize(this->m_FixedImage->GetLargestPossibleRegion().GetSize());
+    this->m_TransformMovingImageFilter->SetOutputOrigin(this->m_FixedImage->GetOrigin());
+    this->m_TransformMovingImageFilter->SetOutputSpacing(this->m_FixedImage->GetSpacing());
+    this->m_TransformMovingImageFilter->SetOutputDirection(this->m_FixedImage->GetDirection());
+    this->m_TransformMovingImageFilter->Update();
+
+    this->m_CastMovedImageFilter->SetInput(this->m_TransformMovingImageFilter->GetOutput());
+
+    for (iFilter = 0; iFilter < MovedImageDimension; ++iFilter)
+    {
+      this->m_MovedSobelOperators[iFilter].SetDirection(iFilter);
+      this->m_MovedSobelOperators[iFilter].CreateDirectional();
+      this->m_MovedSobelFilters[iFilter] = MovedSobelFilter::New();
+      this->m_MovedSobelFilters[iFilter]->OverrideBoundaryCondition(&this->m_MovedBoundCond);
+      this->m_MovedSobelFilters[iFilter]->SetOperator(this->m_MovedSobelOperators[iFilter]);
+      this->m_MovedSobelFilters[iFilter]->SetInput(this->m_CastMovedImageFilter->GetOutput());
+      this->m_MovedSobelFilters[iFilter]->UpdateLargestPossibleRegion();
+    }
   }
 
   /** Compute the variance */
@@ -166,6 +171,7 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "InterpolatorIsRayCast: " << this->m_InterpolatorIsRayCast << std::endl;
 }
 
 
@@ -440,12 +446,12 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
 
 
 /**
- * ******************** GetValue ******************************
+ * ******************** GetValueOfResampledImage ******************************
  */
 
 template <class TFixedImage, class TMovingImage>
 typename GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::MeasureType
-GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetValueOfResampledImage(
   const TransformParametersType & parameters) const
 {
   unsigned int iFilter;
@@ -475,16 +481,16 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
 
   return currentMeasure;
 
-} // end GetValue()
+} // end GetValueOfResampledImage()
 
 
 /**
- * ******************** GetDerivative ******************************
+ * ******************** GetFiniteDifferenceDerivative ******************************
  */
 
 template <class TFixedImage, class TMovingImage>
 void
-GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetDerivative(
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetFiniteDifferenceDerivative(
   const TransformParametersType & parameters,
   DerivativeType &                derivative) const
 {
@@ -496,13 +502,405 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetDerivative(
   for (unsigned int i = 0; i < numberOfParameters; ++i)
   {
     testPoint[i] -= this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
-    const MeasureType valuep0 = this->GetValue(testPoint);
+    const MeasureType valuep0 = this->GetValueOfResampledImage(testPoint);
     testPoint[i] += 2 * this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]);
-    const MeasureType valuep1 = this->GetValue(testPoint);
+    const MeasureType valuep1 = this->GetValueOfResampledImage(testPoint);
     derivative[i] = (valuep1 - valuep0) / (2 * this->m_DerivativeDelta / std::sqrt(this->m_Scales[i]));
     testPoint[i] = parameters[i];
   }
 
+} // end GetFiniteDifferenceDerivative()
+
+
+/**
+ * ******************** GetSampleRangeOfThread ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetSampleRangeOfThread(ThreadIdType    threadId,
+                                                                                        unsigned long & pos_begin,
+                                                                                        unsigned long & pos_end) const
+{
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  pos_begin = nrOfSamplesPerThreads * threadId;
+  pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+} // end GetSampleRangeOfThread()
+
+
+/**
+ * ******************** EvaluateStencilPoint ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::EvaluateStencilPoint(
+  const FixedImageContinuousIndexType &          cindex,
+  const typename SobelOperatorType::OffsetType & offset,
+  FixedImagePointType &                          fixedPoint,
+  RealType &                                     movingImageValue,
+  MovingImageDerivativeType *                    gradient) const
+{
+  /** Clamp the stencil point to the fixed image, like the zero flux Neumann boundary condition. */
+  const typename FixedImageType::RegionType & region = this->m_FixedImage->GetLargestPossibleRegion();
+  FixedImageContinuousIndexType               stencilIndex;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    const double first = static_cast<double>(region.GetIndex()[d]);
+    const double last = first + static_cast<double>(region.GetSize()[d]) - 1.0;
+    stencilIndex[d] = std::min(std::max(cindex[d] + offset[d], first), last);
+  }
+  this->m_FixedImage->TransformContinuousIndexToPhysicalPoint(stencilIndex, fixedPoint);
+
+  /** Transform point and check if it is inside the B-spline support region. */
+  MovingImagePointType mappedPoint;
+  bool                 sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+  /** Compute the moving image value M(T(x)), and possibly its derivative. */
+  if (sampleOk)
+  {
+    sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, gradient);
+  }
+
+  /** Outside the moving image the transformed image is zero, like the default pixel value of the resampler. */
+  if (!sampleOk)
+  {
+    movingImageValue = NumericTraits<RealType>::ZeroValue();
+  }
+  return sampleOk;
+
+} // end EvaluateStencilPoint()
+
+
+/**
+ * ******************** ComputeGradientsOfSamples ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeGradientsOfSamples(
+  unsigned long pos_begin,
+  unsigned long pos_end) const
+{
+  /** All Sobel operators have the same 3 x 3 (x 3) neighborhood. */
+  const unsigned int    numberOfStencilPoints = this->m_FixedSobelOperators[0].Size();
+  std::vector<RealType> stencilValues(numberOfStencilPoints);
+
+  const typename FixedImageType::RegionType & region = this->m_FixedImage->GetLargestPossibleRegion();
+
+  /** Create iterator over the sample container. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator fiter = sampleContainer->Begin();
+  fiter += (int)pos_begin;
+
+  for (unsigned long pos = pos_begin; pos < pos_end; ++pos, ++fiter)
+  {
+    const FixedImagePointType &   fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    FixedImageContinuousIndexType cindex;
+    this->m_FixedImage->TransformPhysicalPointToContinuousIndex(fixedPoint, cindex);
+
+    /** The fixed image gradients are taken from the nearest pixel of the Sobel images. */
+    typename FixedImageType::IndexType index;
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      const IndexValueType first = region.GetIndex()[d];
+      const IndexValueType last = first + static_cast<IndexValueType>(region.GetSize()[d]) - 1;
+      index[d] = std::min(std::max(Math::Round<IndexValueType>(cindex[d]), first), last);
+    }
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      this->m_SampledFixedGradients[pos * FixedImageDimension + d] =
+        this->m_FixedSobelFilters[d]->GetOutput()->GetPixel(index);
+    }
+
+    /** Evaluate the transformed moving image in the neighborhood of the sample. */
+    for (unsigned int n = 0; n < numberOfStencilPoints; ++n)
+    {
+      FixedImagePointType stencilPoint;
+      this->EvaluateStencilPoint(
+        cindex, this->m_FixedSobelOperators[0].GetOffset(n), stencilPoint, stencilValues[n], nullptr);
+    }
+
+    /** Apply the Sobel operators. */
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      MovedGradientPixelType movedGradient = NumericTraits<MovedGradientPixelType>::ZeroValue();
+      for (unsigned int n = 0; n < numberOfStencilPoints; ++n)
+      {
+        movedGradient += this->m_FixedSobelOperators[d][n] * stencilValues[n];
+      }
+      this->m_SampledMovedGradients[pos * FixedImageDimension + d] = movedGradient;
+    }
+  }
+
+} // end ComputeGradientsOfSamples()
+
+
+/**
+ * ******************** ComputeGradientsAndSubtractionFactors ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeGradientsAndSubtractionFactors(
+  const TransformParametersType & parameters) const
+{
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   * Because of these calls GetValueAndDerivative itself is not thread-safe,
+   * so cannot be called multiple times simultaneously.
+   * This is however needed in the CombinationImageToImageMetric.
+   * In that case, you need to:
+   * - switch the use of this function to on, using m_UseMetricSingleThreaded = true
+   * - call BeforeThreadedGetValueAndDerivative once (single-threaded) before
+   *   calling GetValueAndDerivative
+   * - switch the use of this function to off, using m_UseMetricSingleThreaded = false
+   * - Now you can call GetValueAndDerivative multi-threaded.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  /** Compute the gradients at the samples. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  this->m_SampledFixedGradients.resize(sampleContainerSize * FixedImageDimension);
+  this->m_SampledMovedGradients.resize(sampleContainerSize * FixedImageDimension);
+  if (!this->m_UseMultiThread)
+  {
+    this->ComputeGradientsOfSamples(0, sampleContainerSize);
+  }
+  else
+  {
+    this->LaunchGetValueThreaderCallback();
+  }
+
+  /** Compute the range of the moved image gradients, and the subtraction factors. */
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    MovedGradientPixelType maxMovedGradient = NumericTraits<MovedGradientPixelType>::ZeroValue();
+    if (sampleContainerSize > 0)
+    {
+      maxMovedGradient = this->m_SampledMovedGradients[d];
+    }
+    for (unsigned long pos = 1; pos < sampleContainerSize; ++pos)
+    {
+      maxMovedGradient = std::max(maxMovedGradient, this->m_SampledMovedGradients[pos * FixedImageDimension + d]);
+    }
+    this->m_MaxMovedGradient[d] = maxMovedGradient;
+
+    /** Guard against a flat moving image. */
+    this->m_SubtractionFactor[d] = NumericTraits<MovedGradientPixelType>::ZeroValue();
+    if (maxMovedGradient > NumericTraits<MovedGradientPixelType>::ZeroValue())
+    {
+      this->m_SubtractionFactor[d] = this->m_MaxFixedGradient[d] / maxMovedGradient;
+    }
+  }
+
+} // end ComputeGradientsAndSubtractionFactors()
+
+
+/**
+ * ******************** ComputeValueOfSamples ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::MeasureType
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueOfSamples(unsigned long pos_begin,
+                                                                                       unsigned long pos_end) const
+{
+  MeasureType measure = NumericTraits<MeasureType>::Zero;
+  for (unsigned long pos = pos_begin; pos < pos_end; ++pos)
+  {
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      const MovedGradientPixelType variance = this->m_Variance[d];
+      if (variance == NumericTraits<MovedGradientPixelType>::ZeroValue())
+      {
+        continue;
+      }
+      const MovedGradientPixelType diff = this->m_SampledFixedGradients[pos * FixedImageDimension + d] -
+                                          this->m_SubtractionFactor[d] *
+                                            this->m_SampledMovedGradients[pos * FixedImageDimension + d];
+      measure += variance / (variance + diff * diff);
+    }
+  }
+  return measure;
+
+} // end ComputeValueOfSamples()
+
+
+/**
+ * ******************** ComputeValueAndDerivativeOfSamples ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueAndDerivativeOfSamples(
+  unsigned long    pos_begin,
+  unsigned long    pos_end,
+  MeasureType &    measure,
+  DerivativeType & derivative) const
+{
+  /** Array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  NonZeroJacobianIndicesType nzji(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  DerivativeType             imageJacobian(nzji.size());
+
+  const unsigned int numberOfStencilPoints = this->m_FixedSobelOperators[0].Size();
+
+  /** Create iterator over the sample container. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator fiter = sampleContainer->Begin();
+  fiter += (int)pos_begin;
+
+  for (unsigned long pos = pos_begin; pos < pos_end; ++pos, ++fiter)
+  {
+    /** Compute the value, and the weight of each gradient component in the derivative:
+     *   d/dmu V / (V + diff^2) = 2 V s diff / (V + diff^2)^2 d(movedGradient)/dmu,
+     * with diff = fixedGradient - s movedGradient.
+     */
+    double weights[FixedImageDimension];
+    bool   contributes = false;
+    for (unsigned int d = 0; d < FixedImageDimension; ++d)
+    {
+      weights[d] = 0.0;
+      const MovedGradientPixelType variance = this->m_Variance[d];
+      if (variance == NumericTraits<MovedGradientPixelType>::ZeroValue())
+      {
+        continue;
+      }
+      const MovedGradientPixelType diff = this->m_SampledFixedGradients[pos * FixedImageDimension + d] -
+                                          this->m_SubtractionFactor[d] *
+                                            this->m_SampledMovedGradients[pos * FixedImageDimension + d];
+      const double denominator = variance + diff * diff;
+      measure += variance / denominator;
+      weights[d] = 2.0 * variance * this->m_SubtractionFactor[d] * diff / (denominator * denominator);
+      contributes = true;
+    }
+    if (!contributes)
+    {
+      continue;
+    }
+
+    /** The moved gradients are linear combinations of the transformed moving image
+     * at the stencil points, so add the image Jacobians of these points.
+     */
+    const FixedImagePointType &   fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    FixedImageContinuousIndexType cindex;
+    this->m_FixedImage->TransformPhysicalPointToContinuousIndex(fixedPoint, cindex);
+
+    for (unsigned int n = 0; n < numberOfStencilPoints; ++n)
+    {
+      double stencilWeight = 0.0;
+      for (unsigned int d = 0; d < FixedImageDimension; ++d)
+      {
+        stencilWeight += weights[d] * this->m_FixedSobelOperators[d][n];
+      }
+      if (stencilWeight == 0.0)
+      {
+        continue;
+      }
+
+      FixedImagePointType       stencilPoint;
+      RealType                  movingImageValue;
+      MovingImageDerivativeType movingImageDerivative;
+      if (!this->EvaluateStencilPoint(cindex,
+                                      this->m_FixedSobelOperators[0].GetOffset(n),
+                                      stencilPoint,
+                                      movingImageValue,
+                                      &movingImageDerivative))
+      {
+        continue;
+      }
+
+      /** Compute the inner product of the transform Jacobian and the moving image gradient. */
+      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+        stencilPoint, movingImageDerivative, imageJacobian, nzji);
+
+      /** Add the contribution of this stencil point to the derivative. */
+      if (nzji.size() == this->GetNumberOfParameters())
+      {
+        for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
+        {
+          derivative[mu] += static_cast<DerivativeValueType>(stencilWeight * imageJacobian[mu]);
+        }
+      }
+      else
+      {
+        for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
+        {
+          derivative[nzji[i]] += static_cast<DerivativeValueType>(stencilWeight * imageJacobian[i]);
+        }
+      }
+    }
+  }
+
+} // end ComputeValueAndDerivativeOfSamples()
+
+
+/**
+ * ******************** GetValue ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::MeasureType
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
+  const TransformParametersType & parameters) const
+{
+  if (this->m_InterpolatorIsRayCast)
+  {
+    return this->GetValueOfResampledImage(parameters);
+  }
+
+  /** Compute the gradients at the samples, multi-threaded. */
+  this->ComputeGradientsAndSubtractionFactors(parameters);
+
+  /** Compute the measure. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const MeasureType   measure = this->ComputeValueOfSamples(0, sampleContainerSize);
+
+  return measure / -this->m_Rescalingfactor; // negative for minimization
+
+} // end GetValue()
+
+
+/**
+ * ******************** ThreadedGetValue ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValue(ThreadIdType threadId)
+{
+  unsigned long pos_begin, pos_end;
+  this->GetSampleRangeOfThread(threadId, pos_begin, pos_end);
+  this->ComputeGradientsOfSamples(pos_begin, pos_end);
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************** GetDerivative ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetDerivative(
+  const TransformParametersType & parameters,
+  DerivativeType &                derivative) const
+{
+  if (this->m_InterpolatorIsRayCast)
+  {
+    return this->GetFiniteDifferenceDerivative(parameters, derivative);
+  }
+
+  MeasureType dummyvalue = NumericTraits<MeasureType>::Zero;
+  this->GetValueAndDerivative(parameters, dummyvalue, derivative);
+
 } // end GetDerivative()
 
 
@@ -517,12 +915,102 @@ GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDeri
   MeasureType &                   Value,
   DerivativeType &                derivative) const
 {
-  Value = this->GetValue(parameters);
-  this->GetDerivative(parameters, derivative);
+  if (this->m_InterpolatorIsRayCast)
+  {
+    Value = this->GetValueOfResampledImage(parameters);
+    this->GetFiniteDifferenceDerivative(parameters, derivative);
+    return;
+  }
+
+  /** Initialize some variables. */
+  derivative = DerivativeType(this->GetNumberOfParameters());
+  derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+
+  /** Compute the gradients at the samples, multi-threaded. */
+  this->ComputeGradientsAndSubtractionFactors(parameters);
+
+  /** Compute the measure and the derivative. */
+  if (!this->m_UseMultiThread)
+  {
+    const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+    MeasureType         measure = NumericTraits<MeasureType>::Zero;
+    this->ComputeValueAndDerivativeOfSamples(0, sampleContainerSize, measure, derivative);
+
+    Value = measure / -this->m_Rescalingfactor; // negative for minimization
+    derivative /= -this->m_Rescalingfactor;
+    return;
+  }
+
+  /** Launch multi-threading metric */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
+
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative(Value, derivative);
 
 } // end GetValueAndDerivative()
 
 
+/**
+ * ******************** ThreadedGetValueAndDerivative ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * the accumulate function.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  unsigned long pos_begin, pos_end;
+  this->GetSampleRangeOfThread(threadId, pos_begin, pos_end);
+
+  MeasureType measure = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivativeOfSamples(pos_begin, pos_end, measure, derivative);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************** AfterThreadedGetValueAndDerivative ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+GradientDifferenceImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValueAndDerivative(
+  MeasureType &    value,
+  DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Accumulate values. */
+  value = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+  value /= -this->m_Rescalingfactor; // negative for minimization
+
+  /** Accumulate derivatives, which divides them by the normalization factor. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = -this->m_Rescalingfactor;
+  this->m_ThreaderMetricParameters.st_UseTouchedDerivativeTiles = false;
+
+  this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+
+} // end AfterThreadedGetValueAndDerivative()
+
+
 } // end namespace itk
 
 #endif // end #ifndef itkGradientDifferenceImageToImageMetric2_hxx
@@ -18,11 +18,19 @@
 
 #include "itkANNBinaryTreeCreator.h"
 
+#include <mutex>
+
 namespace itk
 {
 
 unsigned int ANNBinaryTreeCreator::m_NumberOfANNBinaryTrees = 0;
 
+namespace
+{
+/** Guards the reference count, since trees may be created and deleted concurrently. */
+std::mutex ReferenceCountMutex;
+} // namespace
+
 /**
  * ************************ CreateANNkDTree *************************
  */
@@ -103,6 +111,7 @@ ANNBinaryTreeCreator::DeleteANNBruteForceTree(ANNBruteForceTreeType *& tree)
 void
 ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 {
+  std::lock_guard<std::mutex> lock(ReferenceCountMutex);
   m_NumberOfANNBinaryTrees++;
 } // end IncreaseReferenceCount
 
@@ -114,6 +123,7 @@ ANNBinaryTreeCreator::IncreaseReferenceCount(void)
 void
 ANNBinaryTreeCreator::DecreaseReferenceCount(void)
 {
+  std::lock_guard<std::mutex> lock(ReferenceCountMutex);
   m_NumberOfANNBinaryTrees--;
   if (m_NumberOfANNBinaryTrees == 0)
   {
@@ -67,6 +67,14 @@ namespace itk
  * IEEE Transactions on Medical Imaging, vol. 28, no. 9, pp. 1412 - 1421,
  * September 2009.
  *
+ * When a thread pool is set, the fixed, moving and joint kNN trees are each
+ * generated by a single task on the pool, so at most three trees are built at
+ * the same time; the ANN tree construction itself is sequential. The nearest
+ * neighbour queries are split in contiguous ranges over the work units, and
+ * each thread searches the points of its range one by one. The fixed tree is
+ * only regenerated when the fixed samples change, e.g. it is reused over the
+ * iterations when a full or grid sampler is used.
+ *
  * \ingroup RegistrationMetrics
  */
 
@@ -263,6 +271,22 @@ protected:
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Get the value for a single thread, by querying its range of samples. */
+  void
+  ThreadedGetValue(ThreadIdType threadId) override;
+
+  /** Gather the values from all threads. */
+  void
+  AfterThreadedGetValue(MeasureType & value) const override;
+
+  /** Get the value and derivative for a single thread, by querying its range of samples. */
+  void
+  ThreadedGetValueAndDerivative(ThreadIdType threadId) override;
+
+  /** Gather the values and derivatives from all threads. */
+  void
+  AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
+
   /** Member variables. */
   BinaryKNNTreePointer m_BinaryKNNTreeFixed;
   BinaryKNNTreePointer m_BinaryKNNTreeMoving;
@@ -339,6 +363,48 @@ private:
                            const MeasureType &                distance_J,
                            DerivativeType &                   dGamma_M,
                            DerivativeType &                   dGamma_J) const;
+
+  /** Generate the three trees and connect them to the searchers. With a thread
+   * pool, every tree is generated by its own task. The fixed tree is kept when
+   * the fixed samples are equal to those of the previous call.
+   */
+  void
+  GenerateTrees(const ListSamplePointer & listSampleFixed,
+                const ListSamplePointer & listSampleMoving,
+                const ListSamplePointer & listSampleJoint) const;
+
+  /** Check if two list samples contain exactly the same points. */
+  static bool
+  ListSamplesAreEqual(const ListSamplePointer & listSample1, const ListSamplePointer & listSample2);
+
+  /** Get the range of query points of a thread. */
+  void
+  GetQueryRangeOfThread(ThreadIdType threadId, unsigned long & pos_begin, unsigned long & pos_end) const;
+
+  /** Search the neighbours of the query points in [pos_begin, pos_end), and
+   * accumulate sum G^(2 gamma) and, if contribution is not a null pointer,
+   * the contribution to the derivative.
+   */
+  void
+  ComputeValueAndDerivativeOfQueryPoints(unsigned long    pos_begin,
+                                         unsigned long    pos_end,
+                                         MeasureType &    sumG,
+                                         DerivativeType * contribution) const;
+
+  /** Compute the negative alpha-mutual information from sum G^(2 gamma). */
+  MeasureType
+  ComputeMeasure(const MeasureType & sumG) const;
+
+  /** The list samples and derivative information of the current evaluation,
+   * which are shared by the threads. m_ListSampleFixed is also the sample
+   * of the fixed tree.
+   */
+  mutable ListSamplePointer                     m_ListSampleFixed;
+  mutable ListSamplePointer                     m_ListSampleMoving;
+  mutable ListSamplePointer                     m_ListSampleJoint;
+  mutable TransformJacobianContainerType        m_JacobianContainer;
+  mutable TransformJacobianIndicesContainerType m_JacobianIndicesContainer;
+  mutable SpatialDerivativeContainerType        m_SpatialDerivativesContainer;
 };
 
 } // end namespace itk
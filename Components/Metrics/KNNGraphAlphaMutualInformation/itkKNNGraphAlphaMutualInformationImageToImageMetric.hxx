@@ -20,6 +20,8 @@
 
 #include "itkKNNGraphAlphaMutualInformationImageToImageMetric.h"
 
+#include <algorithm> // For equal.
+
 namespace itk
 {
 
@@ -288,9 +290,6 @@ typename KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingIm
 KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
   const TransformParametersType & parameters) const
 {
-  /** Initialize some variables. */
-  MeasureType measure = NumericTraits<MeasureType>::Zero;
-
   /** Make sure the transform parameters are up to date. */
   this->SetTransformParameters(parameters);
 
@@ -304,16 +303,13 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   ListSamplePointer listSampleJoint = ListSampleType::New();
 
   /** Compute the three list samples. */
-  TransformJacobianContainerType        dummyJacobianContainer;
-  TransformJacobianIndicesContainerType dummyJacobianIndicesContainer;
-  SpatialDerivativeContainerType        dummySpatialDerivativesContainer;
   this->ComputeListSampleValuesAndDerivativePlusJacobian(listSampleFixed,
                                                          listSampleMoving,
                                                          listSampleJoint,
                                                          false,
-                                                         dummyJacobianContainer,
-                                                         dummyJacobianIndicesContainer,
-                                                         dummySpatialDerivativesContainer);
+                                                         this->m_JacobianContainer,
+                                                         this->m_JacobianIndicesContainer,
+                                                         this->m_SpatialDerivativesContainer);
 
   /** Check if enough samples were valid. */
   unsigned long size = this->GetImageSampler()->GetOutput()->Size();
@@ -325,143 +321,26 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTrees(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI ******************
-   *
-   * This is done by searching for the nearest neighbours of each point
-   * and calculating the distances.
-   *
-   * The estimate for the alpha - mutual information is given by:
-   *
-   *  \alpha MI = 1 / ( \alpha - 1 ) * \log 1/n^\alpha * \sum_{i=1}^n \sum_{p=1}^k
-   *              ( jointLength / \sqrt( fixedLength * movingLength ) )^(2 \gamma),
-   *
-   * where
-   *   - \alpha is set by the user and refers to \alpha - mutual information
-   *   - n is the number of samples
-   *   - k is the number of nearest neighbours
-   *   - jointLength  is the distances to one of the nearest neighbours in listSampleJoint
-   *   - fixedLength  is the distances to one of the nearest neighbours in listSampleFixed
-   *   - movingLength is the distances to one of the nearest neighbours in listSampleMoving
-   *   - \gamma relates to the distance metric and relates to \alpha as:
-   *
-   *        \gamma = d * ( 1 - \alpha ),
-   *
-   *     where d is the dimension of the feature space.
-   *
-   * In the original paper it is assumed that the mutual information of
-   * two feature sets of equal dimension is calculated. If this is not
-   * true, then
-   *
-   *        \gamma = ( ( d1 + d2 ) / 2 ) * ( 1 - alpha ),
-   *
-   * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
-
-  MeasureType    H, G;
-  AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
-
-  /** Get the size of the feature vectors. */
-  unsigned int fixedSize = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * (1.0 - this->m_Alpha);
-
-  /** Loop over all query points, i.e. all samples. */
-  for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; ++i)
+  if (!this->m_UseMultiThread)
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the K nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
-
-    /** Add the distances between the points to get the total graph length.
-     * The outcommented implementation calculates: sum J/sqrt(F*M)
-     *
-    for ( unsigned int j = 0; j < K; j++ )
-    {
-    enumerator = std::sqrt( distsJ[ j ] );
-    denominator = std::sqrt( std::sqrt( distsF[ j ] ) * std::sqrt( distsM[ j ] ) );
-    if ( denominator > 1e-14 )
-    {
-    contribution += std::pow( enumerator / denominator, twoGamma );
-    }
-    }*/
-
-    /** Add the distances of all neighbours of the query point,
-     * for the three graphs:
-     * sum M / sqrt( sum F * sum M)
-     */
-
-    /** Variables to compute the measure. */
-    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
-
-    /** Loop over the neighbours. */
-    for (unsigned int p = 0; p < k; ++p)
-    {
-      Gamma_F += std::sqrt(distances_F[p]);
-      Gamma_M += std::sqrt(distances_M[p]);
-      Gamma_J += std::sqrt(distances_J[p]);
-    } // end loop over the k neighbours
-
-    /** Calculate the contribution of this query point. */
-    H = std::sqrt(Gamma_F * Gamma_M);
-    if (H > this->m_AvoidDivisionBy)
-    {
-      /** Compute some sums. */
-      G = Gamma_J / H;
-      sumG += std::pow(G, twoGamma);
-    }
-  } // end looping over all query points
-
-  /**
-   * *************** Finally, calculate the metric value \alpha MI ******************
-   */
-
-  double n, number;
-  if (sumG > this->m_AvoidDivisionBy)
-  {
-    /** Compute the measure. */
-    n = static_cast<double>(this->m_NumberOfPixelsCounted);
-    number = std::pow(n, this->m_Alpha);
-    measure = std::log(sumG / number) / (this->m_Alpha - 1.0);
+    MeasureType sumG = NumericTraits<MeasureType>::Zero;
+    this->ComputeValueAndDerivativeOfQueryPoints(0, this->m_NumberOfPixelsCounted, sumG, nullptr);
+    return this->ComputeMeasure(sumG);
   }
 
-  /** Return the negative alpha - mutual information. */
-  return -measure;
+  /** Launch multi-threading metric */
+  this->LaunchGetValueThreaderCallback();
+
+  /** Gather the metric values from all threads. */
+  MeasureType value = NumericTraits<MeasureType>::Zero;
+  this->AfterThreadedGetValue(value);
+  return value;
 
 } // end GetValue()
 
@@ -499,7 +378,6 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   DerivativeType &                derivative) const
 {
   /** Initialize some variables. */
-  MeasureType measure = NumericTraits<MeasureType>::Zero;
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
 
@@ -528,16 +406,13 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
   ListSamplePointer listSampleJoint = ListSampleType::New();
 
   /** Compute the three list samples and the derivatives. */
-  TransformJacobianContainerType        jacobianContainer;
-  TransformJacobianIndicesContainerType jacobianIndicesContainer;
-  SpatialDerivativeContainerType        spatialDerivativesContainer;
   this->ComputeListSampleValuesAndDerivativePlusJacobian(listSampleFixed,
                                                          listSampleMoving,
                                                          listSampleJoint,
                                                          true,
-                                                         jacobianContainer,
-                                                         jacobianIndicesContainer,
-                                                         spatialDerivativesContainer);
+                                                         this->m_JacobianContainer,
+                                                         this->m_JacobianIndicesContainer,
+                                                         this->m_SpatialDerivativesContainer);
 
   /** Check if enough samples were valid. */
   unsigned long size = this->GetImageSampler()->GetOutput()->Size();
@@ -549,177 +424,34 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Get
    * and connect them to the searchers.
    */
 
-  /** Generate the tree for the fixed image samples. */
-  this->m_BinaryKNNTreeFixed->SetSample(listSampleFixed);
-  this->m_BinaryKNNTreeFixed->GenerateTree();
-
-  /** Generate the tree for the moving image samples. */
-  this->m_BinaryKNNTreeMoving->SetSample(listSampleMoving);
-  this->m_BinaryKNNTreeMoving->GenerateTree();
-
-  /** Generate the tree for the joint image samples. */
-  this->m_BinaryKNNTreeJoint->SetSample(listSampleJoint);
-  this->m_BinaryKNNTreeJoint->GenerateTree();
-
-  /** Initialize tree searchers. */
-  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
-  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
-  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+  this->GenerateTrees(listSampleFixed, listSampleMoving, listSampleJoint);
 
   /**
    * *************** Estimate the \alpha MI and its derivatives ******************
-   *
-   * This is done by searching for the nearest neighbours of each point
-   * and calculating the distances.
-   *
-   * The estimate for the alpha - mutual information is given by:
-   *
-   *  \alpha MI = 1 / ( \alpha - 1 ) * \log 1/n^\alpha * \sum_{i=1}^n \sum_{p=1}^k
-   *              ( jointLength / \sqrt( fixedLength * movingLength ) )^(2 \gamma),
-   *
-   * where
-   *   - \alpha is set by the user and refers to \alpha - mutual information
-   *   - n is the number of samples
-   *   - k is the number of nearest neighbours
-   *   - jointLength  is the distances to one of the nearest neighbours in listSampleJoint
-   *   - fixedLength  is the distances to one of the nearest neighbours in listSampleFixed
-   *   - movingLength is the distances to one of the nearest neighbours in listSampleMoving
-   *   - \gamma relates to the distance metric and relates to \alpha as:
-   *
-   *        \gamma = d * ( 1 - \alpha ),
-   *
-   *     where d is the dimension of the feature space.
-   *
-   * In the original paper it is assumed that the mutual information of
-   * two feature sets of equal dimension is calculated. If not this is not
-   * true, then
-   *
-   *        \gamma = ( ( d1 + d2 ) / 2 ) * ( 1 - alpha ),
-   *
-   * where d1 and d2 are the possibly different dimensions of the two feature sets.
    */
 
-  /** Temporary variables. */
-  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
-  MeasurementVectorType                                       z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
-  IndexArrayType                                              indices_F, indices_M, indices_J;
-  DistanceArrayType                                           distances_F, distances_M, distances_J;
-  MeasureType                                                 distance_F, distance_M, distance_J;
-
-  MeasureType    H, G, Gpow;
-  AccumulateType sumG = NumericTraits<AccumulateType>::Zero;
-
-  DerivativeType contribution(this->GetNumberOfParameters());
-  contribution.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-  DerivativeType dGamma_M(this->GetNumberOfParameters());
-  DerivativeType dGamma_J(this->GetNumberOfParameters());
-
-  /** Get the size of the feature vectors. */
-  unsigned int fixedSize = this->GetNumberOfFixedImages();
-  unsigned int movingSize = this->GetNumberOfMovingImages();
-  unsigned int jointSize = fixedSize + movingSize;
-
-  /** Get the number of neighbours and \gamma. */
-  unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
-  double       twoGamma = jointSize * (1.0 - this->m_Alpha);
-
-  /** Loop over all query points, i.e. all samples. */
-  for (unsigned long i = 0; i < this->m_NumberOfPixelsCounted; ++i)
+  if (!this->m_UseMultiThread)
   {
-    /** Get the i-th query point. */
-    listSampleFixed->GetMeasurementVector(i, z_F);
-    listSampleMoving->GetMeasurementVector(i, z_M);
-    listSampleJoint->GetMeasurementVector(i, z_J);
-
-    /** Search for the k nearest neighbours of the current query point. */
-    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
-    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
-    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
-
-    /** Variables to compute the measure and its derivative. */
-    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
-    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
-
-    SpatialDerivativeType D1sparse, D2sparse_M, D2sparse_J;
-    D1sparse = spatialDerivativesContainer[i] * jacobianContainer[i];
-
-    dGamma_M.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-    dGamma_J.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
-
-    /** Loop over the neighbours. */
-    for (unsigned int p = 0; p < k; ++p)
-    {
-      /** Get the neighbour point z_ip^M. */
-      listSampleMoving->GetMeasurementVector(indices_M[p], z_M_ip);
-      listSampleMoving->GetMeasurementVector(indices_J[p], z_J_ip);
-
-      /** Get the distances. */
-      distance_F = std::sqrt(distances_F[p]);
-      distance_M = std::sqrt(distances_M[p]);
-      distance_J = std::sqrt(distances_J[p]);
-
-      /** Compute Gamma's. */
-      Gamma_F += distance_F;
-      Gamma_M += distance_M;
-      Gamma_J += distance_J;
-
-      /** Get the difference of z_ip^M with z_i^M. */
-      diff_M = z_M - z_M_ip;
-      diff_J = z_M - z_J_ip;
-
-      /** Compute derivatives. */
-      D2sparse_M = spatialDerivativesContainer[indices_M[p]] * jacobianContainer[indices_M[p]];
-      D2sparse_J = spatialDerivativesContainer[indices_J[p]] * jacobianContainer[indices_J[p]];
-
-      /** Update the dGamma's. */
-      this->UpdateDerivativeOfGammas(D1sparse,
-                                     D2sparse_M,
-                                     D2sparse_J,
-                                     jacobianIndicesContainer[i],
-                                     jacobianIndicesContainer[indices_M[p]],
-                                     jacobianIndicesContainer[indices_J[p]],
-                                     diff_M,
-                                     diff_J,
-                                     distance_M,
-                                     distance_J,
-                                     dGamma_M,
-                                     dGamma_J);
-
-    } // end loop over the k neighbours
-
-    /** Compute contributions. */
-    H = std::sqrt(Gamma_F * Gamma_M);
-    if (H > this->m_AvoidDivisionBy)
+    MeasureType    sumG = NumericTraits<MeasureType>::Zero;
+    DerivativeType contribution(this->GetNumberOfParameters());
+    contribution.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    this->ComputeValueAndDerivativeOfQueryPoints(0, this->m_NumberOfPixelsCounted, sumG, &contribution);
+
+    /** Compute the value and the derivative (-2.0 * d = -jointSize). */
+    value = this->ComputeMeasure(sumG);
+    if (sumG > this->m_AvoidDivisionBy)
     {
-      /** Compute some sums. */
-      G = Gamma_J / H;
-      sumG += std::pow(G, twoGamma);
-
-      /** Compute the contribution to the derivative. */
-      Gpow = std::pow(G, twoGamma - 1.0);
-      contribution += (Gpow / H) * (dGamma_J - (0.5 * Gamma_J / Gamma_M) * dGamma_M);
+      const unsigned int jointSize = this->GetNumberOfFixedImages() + this->GetNumberOfMovingImages();
+      derivative = (static_cast<MeasureType>(jointSize) / sumG) * contribution;
     }
+    return;
+  }
 
-  } // end looping over all query points
-
-  /**
-   * *************** Finally, calculate the metric value and derivative ******************
-   */
-
-  /** Compute the value. */
-  double n, number;
-  if (sumG > this->m_AvoidDivisionBy)
-  {
-    /** Compute the measure. */
-    n = static_cast<double>(this->m_NumberOfPixelsCounted);
-    number = std::pow(n, this->m_Alpha);
-    measure = std::log(sumG / number) / (this->m_Alpha - 1.0);
+  /** Launch multi-threading metric */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
 
-    /** Compute the derivative (-2.0 * d = -jointSize). */
-    derivative = (static_cast<AccumulateType>(jointSize) / sumG) * contribution;
-  }
-  value = -measure;
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative(value, derivative);
 
 } // end GetValueAndDerivative()
 
@@ -1038,6 +770,441 @@ KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::Upd
 } // end UpdateDerivativeOfGammas()
 
 
+/**
+ * ************************ GenerateTrees *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GenerateTrees(
+  const ListSamplePointer & listSampleFixed,
+  const ListSamplePointer & listSampleMoving,
+  const ListSamplePointer & listSampleJoint) const
+{
+  /** The fixed tree only needs to be generated when the fixed samples changed.
+   * A tree that was just set by SetANNkDTree() etc. does not have a sample yet.
+   */
+  const bool generateFixedTree = this->m_BinaryKNNTreeFixed->GetSample() != this->m_ListSampleFixed.GetPointer() ||
+                                 !Self::ListSamplesAreEqual(this->m_ListSampleFixed, listSampleFixed);
+  if (generateFixedTree)
+  {
+    this->m_ListSampleFixed = listSampleFixed;
+  }
+  this->m_ListSampleMoving = listSampleMoving;
+  this->m_ListSampleJoint = listSampleJoint;
+
+  /** Generate the fixed (0), moving (1) and joint (2) tree. */
+  const auto generateTrees = [this, generateFixedTree](ThreadIdType, SizeValueType begin, SizeValueType end) {
+    for (SizeValueType tree = begin; tree < end; ++tree)
+    {
+      if (tree == 0 && generateFixedTree)
+      {
+        this->m_BinaryKNNTreeFixed->SetSample(this->m_ListSampleFixed);
+        this->m_BinaryKNNTreeFixed->GenerateTree();
+      }
+      else if (tree == 1)
+      {
+        this->m_BinaryKNNTreeMoving->SetSample(this->m_ListSampleMoving);
+        this->m_BinaryKNNTreeMoving->GenerateTree();
+      }
+      else if (tree == 2)
+      {
+        this->m_BinaryKNNTreeJoint->SetSample(this->m_ListSampleJoint);
+        this->m_BinaryKNNTreeJoint->GenerateTree();
+      }
+    }
+  };
+
+  if (this->m_UseMultiThread && this->m_ThreadPool.IsNotNull())
+  {
+    this->m_ThreadPool->ParallelFor(3, 1, generateTrees);
+  }
+  else
+  {
+    generateTrees(0, 0, 3);
+  }
+
+  /** Initialize tree searchers. */
+  this->m_BinaryKNNTreeSearcherFixed->SetBinaryTree(this->m_BinaryKNNTreeFixed);
+  this->m_BinaryKNNTreeSearcherMoving->SetBinaryTree(this->m_BinaryKNNTreeMoving);
+  this->m_BinaryKNNTreeSearcherJoint->SetBinaryTree(this->m_BinaryKNNTreeJoint);
+
+} // end GenerateTrees()
+
+
+/**
+ * ************************ ListSamplesAreEqual *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ListSamplesAreEqual(
+  const ListSamplePointer & listSample1,
+  const ListSamplePointer & listSample2)
+{
+  if (listSample1.IsNull() || listSample2.IsNull())
+  {
+    return false;
+  }
+
+  const unsigned long size = listSample1->GetActualSize();
+  const unsigned int  dim = listSample1->GetMeasurementVectorSize();
+  if (size != listSample2->GetActualSize() || dim != listSample2->GetMeasurementVectorSize())
+  {
+    return false;
+  }
+
+  const auto container1 = listSample1->GetInternalContainer();
+  const auto container2 = listSample2->GetInternalContainer();
+  for (unsigned long i = 0; i < size; ++i)
+  {
+    if (!std::equal(container1[i], container1[i] + dim, container2[i]))
+    {
+      return false;
+    }
+  }
+  return true;
+
+} // end ListSamplesAreEqual()
+
+
+/**
+ * ************************ GetQueryRangeOfThread *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::GetQueryRangeOfThread(
+  ThreadIdType    threadId,
+  unsigned long & pos_begin,
+  unsigned long & pos_end) const
+{
+  const unsigned long numberOfQueryPoints = this->m_NumberOfPixelsCounted;
+  const unsigned long nrOfQueryPointsPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(numberOfQueryPoints) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  pos_begin = nrOfQueryPointsPerThreads * threadId;
+  pos_end = nrOfQueryPointsPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > numberOfQueryPoints) ? numberOfQueryPoints : pos_begin;
+  pos_end = (pos_end > numberOfQueryPoints) ? numberOfQueryPoints : pos_end;
+
+} // end GetQueryRangeOfThread()
+
+
+/**
+ * ************************ ComputeValueAndDerivativeOfQueryPoints *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueAndDerivativeOfQueryPoints(
+  unsigned long    pos_begin,
+  unsigned long    pos_end,
+  MeasureType &    sumG,
+  DerivativeType * contribution) const
+{
+  /**
+   * *************** Estimate the \alpha MI and its derivatives ******************
+   *
+   * This is done by searching for the nearest neighbours of each point
+   * and calculating the distances.
+   *
+   * The estimate for the alpha - mutual information is given by:
+   *
+   *  \alpha MI = 1 / ( \alpha - 1 ) * \log 1/n^\alpha * \sum_{i=1}^n \sum_{p=1}^k
+   *              ( jointLength / \sqrt( fixedLength * movingLength ) )^(2 \gamma),
+   *
+   * where
+   *   - \alpha is set by the user and refers to \alpha - mutual information
+   *   - n is the number of samples
+   *   - k is the number of nearest neighbours
+   *   - jointLength  is the distances to one of the nearest neighbours in listSampleJoint
+   *   - fixedLength  is the distances to one of the nearest neighbours in listSampleFixed
+   *   - movingLength is the distances to one of the nearest neighbours in listSampleMoving
+   *   - \gamma relates to the distance metric and relates to \alpha as:
+   *
+   *        \gamma = d * ( 1 - \alpha ),
+   *
+   *     where d is the dimension of the feature space.
+   *
+   * In the original paper it is assumed that the mutual information of
+   * two feature sets of equal dimension is calculated. If this is not
+   * true, then
+   *
+   *        \gamma = ( ( d1 + d2 ) / 2 ) * ( 1 - alpha ),
+   *
+   * where d1 and d2 are the possibly different dimensions of the two feature sets.
+   *
+   * This function only computes the inner sum for the query points in
+   * [pos_begin, pos_end), so that it can be called by multiple threads.
+   * The trees and searchers are only read here, and the ANN search state
+   * is thread local.
+   */
+
+  /** Temporary variables. */
+  typedef typename NumericTraits<MeasureType>::AccumulateType AccumulateType;
+  MeasurementVectorType                                       z_F, z_M, z_J, z_M_ip, z_J_ip, diff_M, diff_J;
+  IndexArrayType                                              indices_F, indices_M, indices_J;
+  DistanceArrayType                                           distances_F, distances_M, distances_J;
+  MeasureType                                                 distance_F, distance_M, distance_J;
+  MeasureType                                                 H, G, Gpow;
+  SpatialDerivativeType                                       D1sparse, D2sparse_M, D2sparse_J;
+
+  const bool     doDerivative = contribution != nullptr;
+  DerivativeType dGamma_M, dGamma_J;
+  if (doDerivative)
+  {
+    dGamma_M.SetSize(this->GetNumberOfParameters());
+    dGamma_J.SetSize(this->GetNumberOfParameters());
+  }
+
+  /** Get the size of the feature vectors. */
+  const unsigned int fixedSize = this->GetNumberOfFixedImages();
+  const unsigned int movingSize = this->GetNumberOfMovingImages();
+  const unsigned int jointSize = fixedSize + movingSize;
+
+  /** Get the number of neighbours and \gamma. */
+  const unsigned int k = this->m_BinaryKNNTreeSearcherFixed->GetKNearestNeighbors();
+  const double       twoGamma = jointSize * (1.0 - this->m_Alpha);
+
+  /** Loop over the query points. The thread safe variant of
+   * GetMeasurementVector() is used, which does not copy.
+   */
+  for (unsigned long i = pos_begin; i < pos_end; ++i)
+  {
+    /** Get the i-th query point. */
+    this->m_ListSampleFixed->GetMeasurementVector(i, z_F);
+    this->m_ListSampleMoving->GetMeasurementVector(i, z_M);
+    this->m_ListSampleJoint->GetMeasurementVector(i, z_J);
+
+    /** Search for the k nearest neighbours of the current query point. */
+    this->m_BinaryKNNTreeSearcherFixed->Search(z_F, indices_F, distances_F);
+    this->m_BinaryKNNTreeSearcherMoving->Search(z_M, indices_M, distances_M);
+    this->m_BinaryKNNTreeSearcherJoint->Search(z_J, indices_J, distances_J);
+
+    /** Variables to compute the measure and its derivative. */
+    AccumulateType Gamma_F = NumericTraits<AccumulateType>::Zero;
+    AccumulateType Gamma_M = NumericTraits<AccumulateType>::Zero;
+    AccumulateType Gamma_J = NumericTraits<AccumulateType>::Zero;
+
+    if (doDerivative)
+    {
+      D1sparse = this->m_SpatialDerivativesContainer[i] * this->m_JacobianContainer[i];
+      dGamma_M.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+      dGamma_J.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+    }
+
+    /** Loop over the neighbours. */
+    for (unsigned int p = 0; p < k; ++p)
+    {
+      /** Get the distances. */
+      distance_F = std::sqrt(distances_F[p]);
+      distance_M = std::sqrt(distances_M[p]);
+      distance_J = std::sqrt(distances_J[p]);
+
+      /** Compute Gamma's. */
+      Gamma_F += distance_F;
+      Gamma_M += distance_M;
+      Gamma_J += distance_J;
+
+      if (!doDerivative)
+      {
+        continue;
+      }
+
+      /** Get the neighbour point z_ip^M. */
+      this->m_ListSampleMoving->GetMeasurementVector(indices_M[p], z_M_ip);
+      this->m_ListSampleMoving->GetMeasurementVector(indices_J[p], z_J_ip);
+
+      /** Get the difference of z_ip^M with z_i^M. */
+      diff_M = z_M - z_M_ip;
+      diff_J = z_M - z_J_ip;
+
+      /** Compute derivatives. */
+      D2sparse_M = this->m_SpatialDerivativesContainer[indices_M[p]] * this->m_JacobianContainer[indices_M[p]];
+      D2sparse_J = this->m_SpatialDerivativesContainer[indices_J[p]] * this->m_JacobianContainer[indices_J[p]];
+
+      /** Update the dGamma's. */
+      this->UpdateDerivativeOfGammas(D1sparse,
+                                     D2sparse_M,
+                                     D2sparse_J,
+                                     this->m_JacobianIndicesContainer[i],
+                                     this->m_JacobianIndicesContainer[indices_M[p]],
+                                     this->m_JacobianIndicesContainer[indices_J[p]],
+                                     diff_M,
+                                     diff_J,
+                                     distance_M,
+                                     distance_J,
+                                     dGamma_M,
+                                     dGamma_J);
+
+    } // end loop over the k neighbours
+
+    /** Compute contributions. */
+    H = std::sqrt(Gamma_F * Gamma_M);
+    if (H > this->m_AvoidDivisionBy)
+    {
+      /** Compute some sums. */
+      G = Gamma_J / H;
+      sumG += std::pow(G, twoGamma);
+
+      /** Compute the contribution to the derivative. */
+      if (doDerivative)
+      {
+        Gpow = std::pow(G, twoGamma - 1.0);
+        *contribution += (Gpow / H) * (dGamma_J - (0.5 * Gamma_J / Gamma_M) * dGamma_M);
+      }
+    }
+
+  } // end looping over the query points
+
+} // end ComputeValueAndDerivativeOfQueryPoints()
+
+
+/**
+ * ************************ ComputeMeasure *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+typename KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::MeasureType
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputeMeasure(
+  const MeasureType & sumG) const
+{
+  MeasureType measure = NumericTraits<MeasureType>::Zero;
+  if (sumG > this->m_AvoidDivisionBy)
+  {
+    /** Compute the measure. */
+    const double n = static_cast<double>(this->m_NumberOfPixelsCounted);
+    const double number = std::pow(n, this->m_Alpha);
+    measure = std::log(sumG / number) / (this->m_Alpha - 1.0);
+  }
+
+  /** Return the negative alpha - mutual information. */
+  return -measure;
+
+} // end ComputeMeasure()
+
+
+/**
+ * ************************ ThreadedGetValue *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValue(ThreadIdType threadId)
+{
+  unsigned long pos_begin, pos_end;
+  this->GetQueryRangeOfThread(threadId, pos_begin, pos_end);
+
+  MeasureType sumG = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivativeOfQueryPoints(pos_begin, pos_end, sumG, nullptr);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = sumG;
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ************************ AfterThreadedGetValue *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValue(
+  MeasureType & value) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Accumulate the sums of the threads. */
+  MeasureType sumG = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    sumG += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+  value = this->ComputeMeasure(sumG);
+
+} // end AfterThreadedGetValue()
+
+
+/**
+ * ************************ ThreadedGetValueAndDerivative *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(
+  ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * the accumulate function.
+   */
+  DerivativeType & contribution = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  unsigned long pos_begin, pos_end;
+  this->GetQueryRangeOfThread(threadId, pos_begin, pos_end);
+
+  MeasureType sumG = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivativeOfQueryPoints(pos_begin, pos_end, sumG, &contribution);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = sumG;
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ************************ AfterThreadedGetValueAndDerivative *************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+KNNGraphAlphaMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValueAndDerivative(
+  MeasureType &    value,
+  DerivativeType & derivative) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Accumulate the sums of the threads. */
+  MeasureType sumG = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    sumG += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset this variable for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+  value = this->ComputeMeasure(sumG);
+
+  /** Accumulate the contributions, which multiplies them with jointSize / sumG
+   * (-2.0 * d = -jointSize). The per-thread derivatives are reset here too.
+   */
+  const bool         validSumG = sumG > this->m_AvoidDivisionBy;
+  const unsigned int jointSize = this->GetNumberOfFixedImages() + this->GetNumberOfMovingImages();
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor =
+    validSumG ? sumG / static_cast<DerivativeValueType>(jointSize) : NumericTraits<DerivativeValueType>::OneValue();
+  this->m_ThreaderMetricParameters.st_UseTouchedDerivativeTiles = false;
+
+  this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+
+  /** As in the single-threaded case, the derivative is zero if sumG is too small. */
+  if (!validSumG)
+  {
+    derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+  }
+
+} // end AfterThreadedGetValueAndDerivative()
+
+
 /**
  * ************************ PrintSelf *************************
  */
@@ -64,6 +64,15 @@ namespace elastix
  *    useful if you use high order B-spline interpolator for the moving image.\n
  *    example: <tt>(MovingLimitRangeRatio 0.001 0.01 0.01)</tt> \n
  *    The default value is 0.01. Can be given for each resolution, or for all resolutions at once.
+ * \parameter UseFastAndLowMemoryVersion: Switch between a version that explicitly computes the
+ *    derivatives of the joint histogram to each transformation parameter (false) and a version
+ *    that loops twice over the samples instead (true). The first option allocates a 3D matrix of size
+ *    NumberOfFixedHistogramBins * NumberOfMovingHistogramBins * number of affected parameters,
+ *    the second one only needs a derivative per thread, and is therefore much more memory
+ *    efficient for large images and fine B-spline grids. Can be given for each resolution,
+ *    or for all resolutions at once.\n
+ *    example: <tt>(UseFastAndLowMemoryVersion "true")</tt> \n
+ *    The default is "false".
  *
  * \sa ParzenWindowNormalizedMutualInformationImageToImageMetric
  * \ingroup Metrics
@@ -99,6 +99,12 @@ NormalizedMutualInformationMetric<TElastix>::BeforeEachResolution(void)
   this->SetFixedKernelBSplineOrder(fixedKernelBSplineOrder);
   this->SetMovingKernelBSplineOrder(movingKernelBSplineOrder);
 
+  /** Set whether a low memory consumption should be used. */
+  bool useFastAndLowMemoryVersion = false;
+  this->GetConfiguration()->ReadParameter(
+    useFastAndLowMemoryVersion, "UseFastAndLowMemoryVersion", this->GetComponentLabel(), level, 0);
+  this->SetUseExplicitPDFDerivatives(!useFastAndLowMemoryVersion);
+
 } // end BeforeEachResolution()
 
 
@@ -20,6 +20,7 @@
 #define itkParzenWindowNormalizedMutualInformationImageToImageMetric_h
 
 #include "itkParzenWindowHistogramImageToImageMetric.h"
+#include "itkArray2D.h"
 
 namespace itk
 {
@@ -39,6 +40,13 @@ namespace itk
  * Construction of the PDFs is implemented in the superclass
  * ParzenWindowHistogramImageToImageMetric.
  *
+ * When UseExplicitPDFDerivatives is false, the derivative is computed without
+ * storing the joint histogram derivative, which has size
+ * \#FixedHistogramBins * \#MovingHistogramBins * \#parameters. Instead, the samples
+ * are visited twice, multi-threaded: first to compute the joint histogram, and
+ * then to compute the derivative. This makes the metric usable for transforms
+ * with many parameters, such as B-splines with a fine control point grid.
+ *
  * This implementation of the NormalizedMutualInformation is based on the
  * AdvancedImageToImageMetric, which means that:
  * \li It uses the ImageSampler-framework
@@ -113,6 +121,7 @@ public:
   typedef typename Superclass::MovingImageMaskPointer          MovingImageMaskPointer;
   typedef typename Superclass::MeasureType                     MeasureType;
   typedef typename Superclass::DerivativeType                  DerivativeType;
+  typedef typename Superclass::DerivativeValueType             DerivativeValueType;
   typedef typename Superclass::ParametersType                  ParametersType;
   typedef typename Superclass::FixedImagePixelType             FixedImagePixelType;
   typedef typename Superclass::MovingImageRegionType           MovingImageRegionType;
@@ -125,6 +134,8 @@ public:
   typedef typename Superclass::FixedImageLimiterOutputType     FixedImageLimiterOutputType;
   typedef typename Superclass::MovingImageLimiterOutputType    MovingImageLimiterOutputType;
   typedef typename Superclass::MovingImageDerivativeScalesType MovingImageDerivativeScalesType;
+  typedef typename Superclass::ThreaderType                    ThreaderType;
+  typedef typename Superclass::ThreadInfoType                  ThreadInfoType;
 
   /** The fixed image dimension. */
   itkStaticConstMacro(FixedImageDimension, unsigned int, FixedImageType::ImageDimension);
@@ -144,7 +155,7 @@ public:
 
 protected:
   /** The constructor. */
-  ParzenWindowNormalizedMutualInformationImageToImageMetric() = default;
+  ParzenWindowNormalizedMutualInformationImageToImageMetric();
 
   /** The destructor. */
   ~ParzenWindowNormalizedMutualInformationImageToImageMetric() override = default;
@@ -194,12 +205,72 @@ protected:
   virtual MeasureType
   ComputeNormalizedMutualInformation(MeasureType & jointEntropy) const;
 
+  /** Get the value and analytic derivative.
+   * Called by GetValueAndDerivative if UseExplicitPDFDerivatives == false.
+   *
+   * Implements a version that avoids the large memory allocation of the
+   * explicit joint histogram derivative. This comes at the cost of looping
+   * over the samples twice, instead of once. The first time does not require
+   * GetJacobian() and moving image derivatives, however.
+   */
+  virtual void
+  GetValueAndAnalyticDerivativeLowMemory(const ParametersType & parameters,
+                                         MeasureType &          value,
+                                         DerivativeType &       derivative) const;
+
+  /** Threading related parameters. */
+  struct ParzenWindowNormalizedMutualInformationMultiThreaderParameterType
+  {
+    Self * m_Metric;
+  };
+  ParzenWindowNormalizedMutualInformationMultiThreaderParameterType
+    m_ParzenWindowNormalizedMutualInformationThreaderParameters;
+
+  /** Multi-threaded version of the derivative computation of the low memory variant. */
+  inline void
+  ThreadedComputeDerivativeLowMemory(ThreadIdType threadId);
+
+  /** Helper function to launch the threads. */
+  static ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+  ComputeDerivativeLowMemoryThreaderCallback(void * arg);
+
+  /** Helper function to launch the threads. */
+  void
+  LaunchComputeDerivativeLowMemoryThreaderCallback(void) const;
+
 private:
   /** The deleted copy constructor. */
   ParzenWindowNormalizedMutualInformationImageToImageMetric(const Self &) = delete;
   /** The deleted assignment operator. */
   void
   operator=(const Self &) = delete;
+
+  /** Helper array for storing the derivative weights of the joint histogram bins. */
+  typedef double              PRatioType;
+  typedef Array2D<PRatioType> PRatioArrayType;
+  mutable PRatioArrayType     m_PRatioArray;
+
+  /** Helper function to compute m_PRatioArray in case of low memory consumption:
+   * alpha * ( NMI log(p(i,k)) - log(pf(k)) - log(pm(i)) ) / Ej.
+   */
+  void
+  ComputePRatioArray(double nMI, double jointEntropy) const;
+
+  /** Helper function to compute the derivative contributions of the samples
+   * in the range [pos_begin, pos_end), for the low memory variant.
+   */
+  void
+  ComputeDerivativeLowMemoryOfSamples(unsigned long    pos_begin,
+                                      unsigned long    pos_end,
+                                      DerivativeType & derivative) const;
+
+  /** Helper function to update the derivative for the low memory variant. */
+  void
+  UpdateDerivativeLowMemory(const RealType &                   fixedImageValue,
+                            const RealType &                   movingImageValue,
+                            const DerivativeType &             imageJacobian,
+                            const NonZeroJacobianIndicesType & nzji,
+                            DerivativeType &                   derivative) const;
 };
 
 } // end namespace itk
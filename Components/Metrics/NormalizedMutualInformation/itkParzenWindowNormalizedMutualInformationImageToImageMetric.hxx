@@ -27,6 +27,20 @@
 namespace itk
 {
 
+/**
+ * ********************* Constructor ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  ParzenWindowNormalizedMutualInformationImageToImageMetric()
+{
+  /** Initialize the m_ParzenWindowNormalizedMutualInformationThreaderParameters. */
+  this->m_ParzenWindowNormalizedMutualInformationThreaderParameters.m_Metric = this;
+
+} // end Constructor
+
+
 /**
  * ********************* PrintSelf ******************************
  *
@@ -182,6 +196,12 @@ ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingIm
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<double>::ZeroValue());
 
+  /** Without the explicit joint histogram derivative, loop twice over the samples. */
+  if (!this->GetUseExplicitPDFDerivatives())
+  {
+    return this->GetValueAndAnalyticDerivativeLowMemory(parameters, value, derivative);
+  }
+
   /** Construct the JointPDF, JointPDFDerivatives, and Alpha. */
   this->ComputePDFsAndPDFDerivatives(parameters);
 
@@ -274,6 +294,331 @@ ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingIm
 } // end GetValueAndDerivative
 
 
+/**
+ * ******************** GetValueAndAnalyticDerivativeLowMemory *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  GetValueAndAnalyticDerivativeLowMemory(const ParametersType & parameters,
+                                         MeasureType &          value,
+                                         DerivativeType &       derivative) const
+{
+  /** Construct the JointPDF and Alpha.
+   * This function contains a loop over the samples.
+   * It executes multi-threadedly when m_UseMultiThread == true.
+   */
+  this->ComputePDFs(parameters);
+
+  /** Normalize the pdfs: p = alpha h */
+  this->NormalizeJointPDF(this->m_JointPDF, this->m_Alpha);
+
+  /** Compute the fixed and moving marginal pdf by summing over the histogram */
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_FixedImageMarginalPDF, 0);
+  this->ComputeMarginalPDF(this->m_JointPDF, this->m_MovingImageMarginalPDF, 1);
+
+  /** Replace the probabilities by log(probabilities) */
+  this->ComputeLogMarginalPDF(this->m_FixedImageMarginalPDF);
+  this->ComputeLogMarginalPDF(this->m_MovingImageMarginalPDF);
+
+  /** Compute the measure and joint entropy (which we both need to compute the derivative) */
+  MeasureType       jointEntropy = 0.0;
+  const MeasureType nMI = this->ComputeNormalizedMutualInformation(jointEntropy);
+  value = static_cast<MeasureType>(-1.0 * nMI);
+
+  /** Compute the weight of each histogram bin in the derivative. */
+  this->ComputePRatioArray(nMI, jointEntropy);
+
+  /* Compute the derivative.
+   * This function contains a second loop over the samples.
+   * It executes multi-threadedly when m_UseMultiThread == true.
+   */
+  if (!this->m_UseMultiThread)
+  {
+    const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+    this->ComputeDerivativeLowMemoryOfSamples(0, sampleContainerSize, derivative);
+    return;
+  }
+
+  /** Launch multi-threading derivative computation. */
+  this->LaunchComputeDerivativeLowMemoryThreaderCallback();
+
+  /** Gather the results from all threads. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = 1.0;
+  this->m_ThreaderMetricParameters.st_UseTouchedDerivativeTiles = false;
+
+  this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+
+} // end GetValueAndAnalyticDerivativeLowMemory()
+
+
+/**
+ * ******************* ComputePRatioArray *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::ComputePRatioArray(
+  double nMI,
+  double jointEntropy) const
+{
+  /** Setup iterators. */
+  typedef ImageLinearConstIteratorWithIndex<JointPDFType> JointPDFConstIteratorType;
+  JointPDFConstIteratorType jointPDFconstit(this->m_JointPDF, this->m_JointPDF->GetLargestPossibleRegion());
+  jointPDFconstit.SetDirection(0);
+  jointPDFconstit.GoToBegin();
+
+  /** The fixed histogram bins are the rows of the array. */
+  this->m_PRatioArray.SetSize(this->m_FixedImageMarginalPDF.GetSize(), this->m_MovingImageMarginalPDF.GetSize());
+  this->m_PRatioArray.Fill(NumericTraits<PRatioType>::ZeroValue());
+
+  /** Loop over the joint histogram. See GetValueAndDerivative() for the expression of the derivative. */
+  for (unsigned int fixedIndex = 0; fixedIndex < this->m_FixedImageMarginalPDF.GetSize(); ++fixedIndex)
+  {
+    const double logFixedImagePDFValue = this->m_FixedImageMarginalPDF[fixedIndex];
+    for (unsigned int movingIndex = 0; movingIndex < this->m_MovingImageMarginalPDF.GetSize(); ++movingIndex)
+    {
+      const double logMovingImagePDFValue = this->m_MovingImageMarginalPDF[movingIndex];
+      const double jointPDFValue = jointPDFconstit.Get();
+      if (jointPDFValue > 1e-16)
+      {
+        const double pRatio =
+          (nMI * std::log(jointPDFValue) - logFixedImagePDFValue - logMovingImagePDFValue) / jointEntropy;
+        this->m_PRatioArray[fixedIndex][movingIndex] = static_cast<PRatioType>(this->m_Alpha * pRatio);
+      }
+      ++jointPDFconstit;
+    }
+    jointPDFconstit.NextLine();
+  }
+
+} // end ComputePRatioArray()
+
+
+/**
+ * ******************* ComputeDerivativeLowMemoryOfSamples *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  ComputeDerivativeLowMemoryOfSamples(unsigned long    pos_begin,
+                                      unsigned long    pos_end,
+                                      DerivativeType & derivative) const
+{
+  /** Initialize array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  NonZeroJacobianIndicesType nzji(this->m_AdvancedTransform->GetNumberOfNonZeroJacobianIndices());
+  DerivativeType             imageJacobian(nzji.size());
+
+  /** Create iterator over the sample container. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator fiter;
+  typename ImageSampleContainerType::ConstIterator fbegin = sampleContainer->Begin();
+  typename ImageSampleContainerType::ConstIterator fend = sampleContainer->Begin();
+  fbegin += (int)pos_begin;
+  fend += (int)pos_end;
+
+  /** Loop over sample container and compute contribution of each sample to the derivative. */
+  for (fiter = fbegin; fiter != fend; ++fiter)
+  {
+    /** Read fixed coordinates and create some variables. */
+    const FixedImagePointType & fixedPoint = (*fiter).Value().m_ImageCoordinates;
+    RealType                    movingImageValue;
+    MovingImageDerivativeType   movingImageDerivative;
+    MovingImagePointType        mappedPoint;
+
+    /** Transform point and check if it is inside the B-spline support region. */
+    bool sampleOk = this->TransformPoint(fixedPoint, mappedPoint);
+
+    /** Check if the point is inside the moving mask. */
+    if (sampleOk)
+    {
+      sampleOk = this->IsInsideMovingMask(mappedPoint);
+    }
+
+    /** Compute the moving image value, its derivative, and check
+     * if the point is inside the moving image buffer.
+     */
+    if (sampleOk)
+    {
+      sampleOk = this->EvaluateMovingImageValueAndDerivative(mappedPoint, movingImageValue, &movingImageDerivative);
+    }
+
+    if (sampleOk)
+    {
+      /** Get the fixed image value. */
+      RealType fixedImageValue = static_cast<RealType>((*fiter).Value().m_ImageValue);
+
+      /** Make sure the values fall within the histogram range. */
+      fixedImageValue = this->GetFixedImageLimiter()->Evaluate(fixedImageValue);
+      movingImageValue = this->GetMovingImageLimiter()->Evaluate(movingImageValue, movingImageDerivative);
+
+      /** Compute the inner product of the transform Jacobian dT/dmu and the moving image gradient dM/dx. */
+      this->m_AdvancedTransform->EvaluateJacobianWithImageGradientProduct(
+        fixedPoint, movingImageDerivative, imageJacobian, nzji);
+
+      /** Compute this sample's contribution to the derivative. */
+      this->UpdateDerivativeLowMemory(fixedImageValue, movingImageValue, imageJacobian, nzji, derivative);
+
+    } // end sampleOk
+  }   // end loop over sample container
+
+} // end ComputeDerivativeLowMemoryOfSamples()
+
+
+/**
+ * ******************* ThreadedComputeDerivativeLowMemory *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  ThreadedComputeDerivativeLowMemory(ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * the accumulate function.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  /** Get the samples for this thread. */
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  unsigned long pos_begin = nrOfSamplesPerThreads * threadId;
+  unsigned long pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+  this->ComputeDerivativeLowMemoryOfSamples(pos_begin, pos_end, derivative);
+
+} // end ThreadedComputeDerivativeLowMemory()
+
+
+/**
+ * **************** ComputeDerivativeLowMemoryThreaderCallback *******
+ */
+
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_FUNCTION_CALL_CONVENTION
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  ComputeDerivativeLowMemoryThreaderCallback(void * arg)
+{
+  ThreadInfoType * infoStruct = static_cast<ThreadInfoType *>(arg);
+  ThreadIdType     threadId = infoStruct->WorkUnitID;
+
+  ParzenWindowNormalizedMutualInformationMultiThreaderParameterType * temp =
+    static_cast<ParzenWindowNormalizedMutualInformationMultiThreaderParameterType *>(infoStruct->UserData);
+
+  temp->m_Metric->ThreadedComputeDerivativeLowMemory(threadId);
+
+  return itk::ITK_THREAD_RETURN_DEFAULT_VALUE;
+
+} // end ComputeDerivativeLowMemoryThreaderCallback()
+
+
+/**
+ * *********************** LaunchComputeDerivativeLowMemoryThreaderCallback***************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::
+  LaunchComputeDerivativeLowMemoryThreaderCallback(void) const
+{
+  /** Launch. */
+  this->LaunchThreaderCallback(
+    this->ComputeDerivativeLowMemoryThreaderCallback,
+    const_cast<void *>(static_cast<const void *>(&this->m_ParzenWindowNormalizedMutualInformationThreaderParameters)));
+
+} // end LaunchComputeDerivativeLowMemoryThreaderCallback()
+
+
+/**
+ * ******************* UpdateDerivativeLowMemory *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+ParzenWindowNormalizedMutualInformationImageToImageMetric<TFixedImage, TMovingImage>::UpdateDerivativeLowMemory(
+  const RealType &                   fixedImageValue,
+  const RealType &                   movingImageValue,
+  const DerivativeType &             imageJacobian,
+  const NonZeroJacobianIndicesType & nzji,
+  DerivativeType &                   derivative) const
+{
+  /** In this function we need to do:
+   *      derivative += imageJacobian *
+   *          \sum_i \sum_k PRatio(i,k) * fixedParzen(i) * dB/dxi(xi,k) / et,
+   * with i, k, the fixed and moving histogram bins, PRatio the precomputed
+   * derivative weight of bin (i,k), and dB/dxi the B-spline derivative.
+   * This equals the sum over the bins of the explicit joint histogram
+   * derivative times PRatio, as computed in GetValueAndDerivative().
+   */
+
+  /** Determine Parzen window arguments (see eq. 6 of Mattes paper [2]). */
+  const double fixedImageParzenWindowTerm =
+    fixedImageValue / this->m_FixedImageBinSize - this->m_FixedImageNormalizedMin;
+  const double movingImageParzenWindowTerm =
+    movingImageValue / this->m_MovingImageBinSize - this->m_MovingImageNormalizedMin;
+
+  /** The lowest bin numbers affected by this pixel: */
+  const int fixedParzenWindowIndex =
+    static_cast<int>(std::floor(fixedImageParzenWindowTerm + this->m_FixedParzenTermToIndexOffset));
+  const int movingParzenWindowIndex =
+    static_cast<int>(std::floor(movingImageParzenWindowTerm + this->m_MovingParzenTermToIndexOffset));
+
+  /** Compute the fixed Parzen values. */
+  ParzenValueContainerType fixedParzenValues(this->m_JointPDFWindow.GetSize()[1]);
+  this->EvaluateParzenValues(
+    fixedImageParzenWindowTerm, fixedParzenWindowIndex, this->m_FixedKernel, fixedParzenValues);
+
+  /** Compute the derivatives of the moving Parzen window. */
+  ParzenValueContainerType derivativeMovingParzenValues(this->m_JointPDFWindow.GetSize()[0]);
+  this->EvaluateParzenValues(
+    movingImageParzenWindowTerm, movingParzenWindowIndex, this->m_DerivativeMovingKernel, derivativeMovingParzenValues);
+
+  /** Get the moving image bin size. */
+  const double et = static_cast<double>(this->m_MovingImageBinSize);
+
+  /** Loop over the Parzen window region and increment sum. */
+  PDFValueType sum = 0.0;
+  for (unsigned int f = 0; f < fixedParzenValues.GetSize(); ++f)
+  {
+    const double fv_et = fixedParzenValues[f] / et;
+    for (unsigned int m = 0; m < derivativeMovingParzenValues.GetSize(); ++m)
+    {
+      sum += this->m_PRatioArray[f + fixedParzenWindowIndex][m + movingParzenWindowIndex] * fv_et *
+             derivativeMovingParzenValues[m];
+    }
+  }
+
+  /** Now compute derivative += sum * imageJacobian. */
+  if (nzji.size() == this->GetNumberOfParameters())
+  {
+    /** Loop over all Jacobians. */
+    for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
+    {
+      derivative[mu] += static_cast<DerivativeValueType>(imageJacobian[mu] * sum);
+    }
+  }
+  else
+  {
+    /** Loop only over the non-zero Jacobians. */
+    for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
+    {
+      const unsigned int mu = nzji[i];
+      derivative[mu] += static_cast<DerivativeValueType>(imageJacobian[i] * sum);
+    }
+  }
+
+} // end UpdateDerivativeLowMemory()
+
+
 } // end namespace itk
 
 #endif // end #ifndef itkParzenWindowNormalizedMutualInformationImageToImageMetric_hxx
@@ -28,6 +28,22 @@ namespace elastix
  * \class PatternIntensityMetric
  * \brief An metric based on the itk::PatternIntensityImageToImageMetric.
  *
+ * The parameters used in this class are:
+ * \parameter Metric: Select this metric as follows:\n
+ *    <tt>(Metric "PatternIntensity")</tt>
+ * \parameter Sigma: The noise constant of the pattern intensity, for each resolution.\n
+ *    <tt>(Sigma 100.0)</tt>\n
+ *    The default value is 100.0.
+ * \parameter OptimizeNormalizationFactor: Whether to search for the best scaling of the
+ *    projection, for each resolution. Not used with ComputeOnSamples.\n
+ *    <tt>(OptimizeNormalizationFactor "false")</tt>\n
+ *    The default value is false.
+ * \parameter ComputeOnSamples: Whether to compute the metric multi-threaded on the samples
+ *    of the ImageSampler, with an analytic derivative, instead of on the whole resampled
+ *    fixed image with a finite difference derivative. Always done without a ray cast
+ *    interpolator. Can be given for each resolution.\n
+ *    <tt>(ComputeOnSamples "true")</tt>\n
+ *    The default value is false.
  *
  * \ingroup Metrics
  *
@@ -123,6 +139,13 @@ public:
   void
   Initialize(void) override;
 
+  /** Use the image sampler only when the metric is computed on the samples, in
+   * any resolution. This is decided before the registration, which connects the
+   * image sampler.
+   */
+  int
+  BeforeAll(void) override;
+
   /**
    * Do some things before each resolution:
    * \li Set CheckNumberOfSamples setting
@@ -42,6 +42,36 @@ PatternIntensityMetric<TElastix>::Initialize(void)
 } // end Initialize()
 
 
+/**
+ * ***************** BeforeAll ***********************
+ */
+
+template <class TElastix>
+int
+PatternIntensityMetric<TElastix>::BeforeAll(void)
+{
+  /** Without a ray cast interpolator the metric is always computed on the samples.
+   * Initialize() decides for each resolution, but the sampler is already connected
+   * in BeforeRegistration() of the registration component.
+   */
+  typedef typename Superclass1::RayCastInterpolatorType RayCastInterpolatorType;
+  const auto * interpolator = this->GetElastix()->GetElxInterpolatorBase()->GetAsITKBaseType();
+  bool         useImageSampler = dynamic_cast<const RayCastInterpolatorType *>(interpolator) == nullptr;
+
+  const std::size_t numberOfEntries = this->m_Configuration->CountNumberOfParameterEntries("ComputeOnSamples");
+  for (unsigned int level = 0; level < numberOfEntries; ++level)
+  {
+    bool computeOnSamples = false;
+    this->m_Configuration->ReadParameter(computeOnSamples, "ComputeOnSamples", this->GetComponentLabel(), level, 0);
+    useImageSampler = useImageSampler || computeOnSamples;
+  }
+  this->SetUseImageSampler(useImageSampler);
+
+  return 0;
+
+} // end BeforeAll()
+
+
 /**
  * ***************** BeforeRegistration ***********************
  */
@@ -50,6 +80,16 @@ template <class TElastix>
 void
 PatternIntensityMetric<TElastix>::BeforeRegistration(void)
 {
+  /** The 2D-3D requirements only hold for the ray cast interpolator; with other
+   * interpolators the metric is computed on the samples of the image sampler.
+   */
+  typedef typename Superclass1::RayCastInterpolatorType RayCastInterpolatorType;
+  const auto * interpolator = this->GetElastix()->GetElxInterpolatorBase()->GetAsITKBaseType();
+  if (dynamic_cast<const RayCastInterpolatorType *>(interpolator) == nullptr)
+  {
+    return;
+  }
+
   if (this->m_Elastix->GetFixedImage()->GetImageDimension() != 3)
   {
     itkExceptionMacro(<< "FixedImage must be 3D");
@@ -87,6 +127,11 @@ PatternIntensityMetric<TElastix>::BeforeEachResolution(void)
     optimizenormalizationfactor, "OptimizeNormalizationFactor", this->GetComponentLabel(), level, 0);
   this->SetOptimizeNormalizationFactor(optimizenormalizationfactor);
 
+  /** Set whether the metric is computed on the samples. */
+  bool computeOnSamples = false;
+  this->m_Configuration->ReadParameter(computeOnSamples, "ComputeOnSamples", this->GetComponentLabel(), level, 0);
+  this->SetComputeOnSamples(computeOnSamples);
+
   typedef typename elastix::OptimizerBase<TElastix>::ITKBaseType::ScalesType ScalesType;
   ScalesType scales = this->m_Elastix->GetElxOptimizerBase()->GetAsITKBaseType()->GetScales();
   this->SetScales(scales);
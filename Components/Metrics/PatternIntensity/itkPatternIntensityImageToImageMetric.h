@@ -30,13 +30,25 @@
 #include "itkAdvancedCombinationTransform.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 
+#include <vector>
+
 namespace itk
 {
 
 /** \class PatternIntensityImageToImageMetric
  * \brief Computes similarity between two objects to be registered
  *
+ * By default the pattern intensity is computed on the whole resampled fixed
+ * image, and its derivative by finite differences. This requires a ray cast
+ * interpolator.
  *
+ * With ComputeOnSamples on, the pattern intensity is computed on the neighbourhoods
+ * of the samples of the ImageSampler instead, multi-threaded over the samples,
+ * and its derivative analytically through the transform Jacobian. With a ray
+ * cast interpolator, the derivative of a projection is computed from the
+ * gradient of the moving image integrated along the ray. With any other
+ * interpolator the moving image is sampled directly, which is always done
+ * on the samples. The OptimizeNormalizationFactor option is ignored then.
  *
  * \ingroup RegistrationMetrics
  */
@@ -160,12 +172,32 @@ public:
   itkSetMacro(OptimizeNormalizationFactor, bool);
   itkGetConstReferenceMacro(OptimizeNormalizationFactor, bool);
 
+  /** Set/Get whether the metric is computed on the samples of the ImageSampler,
+   * with an analytic derivative. Default: false.
+   */
+  itkSetMacro(ComputeOnSamples, bool);
+  itkGetConstReferenceMacro(ComputeOnSamples, bool);
+  itkBooleanMacro(ComputeOnSamples);
+
 protected:
   PatternIntensityImageToImageMetric();
   ~PatternIntensityImageToImageMetric() override = default;
   void
   PrintSelf(std::ostream & os, Indent indent) const override;
 
+  /** Protected typedefs. */
+  typedef typename Superclass::DerivativeValueType            DerivativeValueType;
+  typedef typename Superclass::FixedImagePointType            FixedImagePointType;
+  typedef typename Superclass::MovingImagePointType           MovingImagePointType;
+  typedef typename Superclass::MovingImageContinuousIndexType MovingImageContinuousIndexType;
+  typedef typename Superclass::MovingImageDerivativeType      MovingImageDerivativeType;
+  typedef typename Superclass::LinearInterpolatorType         LinearInterpolatorType;
+  typedef typename Superclass::LinearInterpolatorPointer      LinearInterpolatorPointer;
+  typedef typename Superclass::AdvancedTransformType          AdvancedTransformType;
+  typedef typename AdvancedTransformType::Pointer             AdvancedTransformPointer;
+  typedef typename Superclass::NonZeroJacobianIndicesType     NonZeroJacobianIndicesType;
+  typedef typename FixedImageType::IndexType                  FixedImageIndexType;
+
   /** Compute the pattern intensity fixed image*/
   MeasureType
   ComputePIFixed(void) const;
@@ -174,6 +206,54 @@ protected:
   MeasureType
   ComputePIDiff(const TransformParametersType & parameters, float scalingfactor) const;
 
+  /** Get the grid points of the neighbourhood of a sample and their fixed image values.
+   * Returns false if the neighbourhood is not inside the fixed image.
+   */
+  bool
+  GetNeighborhoodOfSample(const FixedImagePointType &        samplePoint,
+                          std::vector<FixedImagePointType> & points,
+                          std::vector<RealType> &            fixedValues) const;
+
+  /** Compute the projection of the moving image at a fixed image point. If the gradients
+   * are asked for, they are the derivatives of the projection with respect to the mapped
+   * point and, for a ray cast interpolator, the mapped focal point.
+   */
+  void
+  EvaluateProjection(const FixedImagePointType & fixedPoint,
+                     RealType &                  projection,
+                     MovingImageDerivativeType * pointGradient,
+                     MovingImageDerivativeType * focalPointGradient) const;
+
+  /** Compute the difference of the pattern intensities of the difference image and the
+   * fixed image, on a range of samples. The derivative is skipped if it is a null pointer.
+   */
+  void
+  ComputeValueAndDerivativeOfSamples(unsigned long    pos_begin,
+                                     unsigned long    pos_end,
+                                     unsigned long &  numberOfPixelsCounted,
+                                     MeasureType &    measure,
+                                     DerivativeType * derivative) const;
+
+  /** Get the range of samples of a thread. */
+  void
+  GetSampleRangeOfThread(ThreadIdType threadId, unsigned long & pos_begin, unsigned long & pos_end) const;
+
+  /** Get the value on the samples, for a single thread. */
+  void
+  ThreadedGetValue(ThreadIdType threadId) override;
+
+  /** Gather the values from all threads. */
+  void
+  AfterThreadedGetValue(MeasureType & value) const override;
+
+  /** Get the value and derivative on the samples, for a single thread. */
+  void
+  ThreadedGetValueAndDerivative(ThreadIdType threadId) override;
+
+  /** Gather the values and derivatives from all threads. */
+  void
+  AfterThreadedGetValueAndDerivative(MeasureType & value, DerivativeType & derivative) const override;
+
 private:
   PatternIntensityImageToImageMetric(const Self &) = delete;
   void
@@ -192,6 +272,11 @@ private:
   ScalesType                         m_Scales;
   MeasureType                        m_FixedMeasure;
   CombinationTransformPointer        m_CombinationTransform;
+  bool                               m_ComputeOnSamples;
+  bool                               m_EvaluateOnSamples;
+  RayCastInterpolatorPointer         m_RayCastInterpolator;
+  AdvancedTransformPointer           m_RayCastTransform;
+  LinearInterpolatorPointer          m_RayGradientInterpolator;
 };
 
 } // end namespace itk
@@ -22,6 +22,7 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNumericTraits.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <iomanip>
@@ -45,6 +46,9 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::PatternIntensityI
   this->m_NeighborhoodRadius = 3;
   this->m_FixedMeasure = 0;
   this->m_OptimizeNormalizationFactor = false;
+  this->m_ComputeOnSamples = false;
+  this->m_EvaluateOnSamples = false;
+  this->m_RayGradientInterpolator = LinearInterpolatorType::New();
   this->m_TransformMovingImageFilter = TransformMovingImageFilterType::New();
   this->m_CombinationTransform = CombinationTransformType::New();
   this->m_RescaleImageFilter = RescaleIntensityImageFilterType::New();
@@ -62,39 +66,57 @@ template <class TFixedImage, class TMovingImage>
 void
 PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void)
 {
+  /** Without a ray cast interpolator the metric can only be computed on the samples.
+   * Only then the image sampler is used.
+   */
+  RayCastInterpolatorType * rayCaster = dynamic_cast<RayCastInterpolatorType *>(this->GetInterpolator());
+  this->m_RayCastInterpolator = rayCaster;
+  this->m_EvaluateOnSamples = this->m_ComputeOnSamples || rayCaster == nullptr;
+  this->SetUseImageSampler(this->m_EvaluateOnSamples);
+
   Superclass::Initialize();
 
-  /** Resampling for 3D->2D */
-  RayCastInterpolatorType * rayCaster = dynamic_cast<RayCastInterpolatorType *>(this->GetInterpolator());
-  if (rayCaster != nullptr)
+  if (this->m_EvaluateOnSamples)
   {
-    this->m_TransformMovingImageFilter->SetTransform(rayCaster->GetTransform());
+    this->m_NormalizationFactor = this->m_FixedImageTrueMax / this->m_MovingImageTrueMax;
+
+    /** The derivative of a projection needs the Jacobian of the transform of the
+     * rays, and the gradient of the moving image along the rays.
+     */
+    if (rayCaster != nullptr)
+    {
+      this->m_RayCastTransform = dynamic_cast<AdvancedTransformType *>(rayCaster->GetTransform());
+      if (this->m_RayCastTransform.IsNull())
+      {
+        itkExceptionMacro(<< "ERROR: the transform of the RayCastInterpolator is not an AdvancedTransform.");
+      }
+      this->m_RayGradientInterpolator->SetInputImage(this->m_MovingImage);
+    }
   }
   else
   {
-    itkExceptionMacro(<< "ERROR: the NormalizedGradientCorrelationImageToImageMetric is currently "
-                      << "only suitable for 2D-3D registration.\n"
-                      << "  Therefore it expects an interpolator of type RayCastInterpolator.");
+    /** Resampling for 3D->2D */
+    this->m_TransformMovingImageFilter->SetTransform(rayCaster->GetTransform());
+    this->m_TransformMovingImageFilter->SetInterpolator(this->m_Interpolator);
+    this->m_TransformMovingImageFilter->SetInput(this->m_MovingImage);
+    this->m_TransformMovingImageFilter->SetDefaultPixelValue(0);
+
+    this->m_TransformMovingImageFilter->SetSize(this->m_FixedImage->GetLargestPossibleRegion().GetSize());
+    this->m_TransformMovingImageFilter->SetOutputOrigin(this->m_FixedImage->GetOrigin());
+    this->m_TransformMovingImageFilter->SetOutputSpacing(this->m_FixedImage->GetSpacing());
+    this->m_TransformMovingImageFilter->SetOutputDirection(this->m_FixedImage->GetDirection());
+    this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
+
+    // this->InitializeLimiters();
+
+    this->m_NormalizationFactor = this->m_FixedImageTrueMax / this->m_MovingImageTrueMax;
+    this->m_MultiplyImageFilter->SetInput(this->m_TransformMovingImageFilter->GetOutput());
+    this->m_MultiplyImageFilter->SetConstant(this->m_NormalizationFactor);
+    this->m_DifferenceImageFilter->SetInput1(this->m_FixedImage);
+    this->m_DifferenceImageFilter->SetInput2(this->m_MultiplyImageFilter->GetOutput());
+    this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
+    this->m_FixedMeasure = this->ComputePIFixed();
   }
-  this->m_TransformMovingImageFilter->SetInterpolator(this->m_Interpolator);
-  this->m_TransformMovingImageFilter->SetInput(this->m_MovingImage);
-  this->m_TransformMovingImageFilter->SetDefaultPixelValue(0);
-
-  this->m_TransformMovingImageFilter->SetSize(this->m_FixedImage->GetLargestPossibleRegion().GetSize());
-  this->m_TransformMovingImageFilter->SetOutputOrigin(this->m_FixedImage->GetOrigin());
-  this->m_TransformMovingImageFilter->SetOutputSpacing(this->m_FixedImage->GetSpacing());
-  this->m_TransformMovingImageFilter->SetOutputDirection(this->m_FixedImage->GetDirection());
-  this->m_TransformMovingImageFilter->UpdateLargestPossibleRegion();
-
-  // this->InitializeLimiters();
-
-  this->m_NormalizationFactor = this->m_FixedImageTrueMax / this->m_MovingImageTrueMax;
-  this->m_MultiplyImageFilter->SetInput(this->m_TransformMovingImageFilter->GetOutput());
-  this->m_MultiplyImageFilter->SetConstant(this->m_NormalizationFactor);
-  this->m_DifferenceImageFilter->SetInput1(this->m_FixedImage);
-  this->m_DifferenceImageFilter->SetInput2(this->m_MultiplyImageFilter->GetOutput());
-  this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
-  this->m_FixedMeasure = this->ComputePIFixed();
 
   /* to rescale the similarity measure between 0-1;*/
   MeasureType tmpmeasure = this->GetValue(this->m_Transform->GetParameters());
@@ -117,6 +139,7 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::PrintSelf(std::os
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "DerivativeDelta: " << this->m_DerivativeDelta << std::endl;
+  os << indent << "ComputeOnSamples: " << this->m_ComputeOnSamples << std::endl;
 
 } // end PrintSelf()
 
@@ -350,6 +373,27 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::GetValue(
   this->BeforeThreadedGetValueAndDerivative(parameters);
   // this->SetTransformParameters( parameters );
 
+  if (this->m_EvaluateOnSamples)
+  {
+    MeasureType value = NumericTraits<MeasureType>::Zero;
+    if (!this->m_UseMultiThread)
+    {
+      const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+      unsigned long       numberOfPixelsCounted = 0;
+      this->ComputeValueAndDerivativeOfSamples(0, sampleContainerSize, numberOfPixelsCounted, value, nullptr);
+      this->m_NumberOfPixelsCounted = numberOfPixelsCounted;
+      this->CheckNumberOfSamples(sampleContainerSize, this->m_NumberOfPixelsCounted);
+      return -value / this->m_Rescalingfactor;
+    }
+
+    /** Launch multi-threading metric */
+    this->LaunchGetValueThreaderCallback();
+
+    /** Gather the metric values from all threads. */
+    this->AfterThreadedGetValue(value);
+    return value;
+  }
+
   this->m_TransformMovingImageFilter->Modified();
   this->m_DifferenceImageFilter->UpdateLargestPossibleRegion();
   MeasureType measure = 1e10;
@@ -396,6 +440,13 @@ void
 PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::GetDerivative(const TransformParametersType & parameters,
                                                                              DerivativeType & derivative) const
 {
+  if (this->m_EvaluateOnSamples)
+  {
+    MeasureType dummyvalue = NumericTraits<MeasureType>::Zero;
+    this->GetValueAndDerivative(parameters, dummyvalue, derivative);
+    return;
+  }
+
   TransformParametersType testPoint;
   testPoint = parameters;
   const unsigned int numberOfParameters = this->GetNumberOfParameters();
@@ -425,12 +476,498 @@ PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDeriva
   MeasureType &                   Value,
   DerivativeType &                derivative) const
 {
-  Value = this->GetValue(parameters);
-  this->GetDerivative(parameters, derivative);
+  if (!this->m_EvaluateOnSamples)
+  {
+    Value = this->GetValue(parameters);
+    this->GetDerivative(parameters, derivative);
+    return;
+  }
+
+  /** Initialize some variables. */
+  derivative = DerivativeType(this->GetNumberOfParameters());
+  derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
+
+  /** Call non-thread-safe stuff, such as:
+   *   this->SetTransformParameters( parameters );
+   *   this->GetImageSampler()->Update();
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
+
+  if (!this->m_UseMultiThread)
+  {
+    const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+    unsigned long       numberOfPixelsCounted = 0;
+    MeasureType         measure = NumericTraits<MeasureType>::Zero;
+    this->ComputeValueAndDerivativeOfSamples(0, sampleContainerSize, numberOfPixelsCounted, measure, &derivative);
+    this->m_NumberOfPixelsCounted = numberOfPixelsCounted;
+    this->CheckNumberOfSamples(sampleContainerSize, this->m_NumberOfPixelsCounted);
+
+    Value = -measure / this->m_Rescalingfactor; // negative for minimization
+    derivative /= -this->m_Rescalingfactor;
+    return;
+  }
+
+  /** Launch multi-threading metric */
+  this->LaunchGetValueAndDerivativeThreaderCallback();
+
+  /** Gather the metric values and derivatives from all threads. */
+  this->AfterThreadedGetValueAndDerivative(Value, derivative);
 
 } // end GetValueAndDerivative()
 
 
+/**
+ * ******************** GetNeighborhoodOfSample ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+bool
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::GetNeighborhoodOfSample(
+  const FixedImagePointType &        samplePoint,
+  std::vector<FixedImagePointType> & points,
+  std::vector<RealType> &            fixedValues) const
+{
+  /** The neighbourhood is centred at the nearest grid point, and should be inside the image. */
+  FixedImageIndexType centerIndex;
+  if (!this->m_FixedImage->TransformPhysicalPointToIndex(samplePoint, centerIndex))
+  {
+    return false;
+  }
+
+  const typename FixedImageType::RegionType & region = this->m_FixedImage->GetLargestPossibleRegion();
+  const IndexValueType                        radius = static_cast<IndexValueType>(this->m_NeighborhoodRadius);
+  for (unsigned int i = 0; i < 2; ++i) // 2D only
+  {
+    const IndexValueType start = region.GetIndex()[i];
+    const IndexValueType end = start + static_cast<IndexValueType>(region.GetSize()[i]);
+    if (centerIndex[i] - radius < start || centerIndex[i] + radius >= end)
+    {
+      return false;
+    }
+  }
+
+  unsigned int        n = 0;
+  FixedImageIndexType neighborIndex = centerIndex;
+  for (IndexValueType j = -radius; j <= radius; ++j)
+  {
+    neighborIndex[1] = centerIndex[1] + j;
+    for (IndexValueType i = -radius; i <= radius; ++i, ++n)
+    {
+      neighborIndex[0] = centerIndex[0] + i;
+      this->m_FixedImage->TransformIndexToPhysicalPoint(neighborIndex, points[n]);
+      fixedValues[n] = static_cast<RealType>(this->m_FixedImage->GetPixel(neighborIndex));
+    }
+  }
+  return true;
+
+} // end GetNeighborhoodOfSample()
+
+
+/**
+ * ******************** EvaluateProjection ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::EvaluateProjection(
+  const FixedImagePointType & fixedPoint,
+  RealType &                  projection,
+  MovingImageDerivativeType * pointGradient,
+  MovingImageDerivativeType * focalPointGradient) const
+{
+  if (pointGradient != nullptr)
+  {
+    pointGradient->Fill(0.0);
+    focalPointGradient->Fill(0.0);
+  }
+
+  /** Without a ray cast interpolator, the projection is the moving image value. */
+  if (this->m_RayCastInterpolator.IsNull())
+  {
+    MovingImagePointType mappedPoint;
+    projection = NumericTraits<RealType>::ZeroValue();
+    if (this->TransformPoint(fixedPoint, mappedPoint))
+    {
+      if (!this->EvaluateMovingImageValueAndDerivative(mappedPoint, projection, pointGradient))
+      {
+        projection = NumericTraits<RealType>::ZeroValue();
+        if (pointGradient != nullptr)
+        {
+          pointGradient->Fill(0.0);
+        }
+      }
+    }
+    return;
+  }
+
+  /** The ray runs from the mapped point to the mapped focal point. */
+  const MovingImagePointType rayPoint = this->m_RayCastTransform->TransformPoint(fixedPoint);
+  projection = this->m_RayCastInterpolator->Evaluate(rayPoint);
+  if (pointGradient == nullptr)
+  {
+    return;
+  }
+
+  const MovingImagePointType focalPoint =
+    this->m_RayCastTransform->TransformPoint(this->m_RayCastInterpolator->GetFocalPoint());
+  typename MovingImagePointType::VectorType direction = focalPoint - rayPoint;
+  const double                              rayLength = direction.GetNorm();
+  if (rayLength == 0.0)
+  {
+    return;
+  }
+  direction /= rayLength;
+
+  /** Clip the ray, p + s u, against the moving image, in continuous index coordinates. */
+  const MovingImageType *        movingImage = this->m_MovingImage;
+  MovingImageContinuousIndexType startIndex;
+  MovingImageContinuousIndexType stepIndex;
+  movingImage->TransformPhysicalPointToContinuousIndex(rayPoint, startIndex);
+  movingImage->TransformPhysicalPointToContinuousIndex(rayPoint + direction, stepIndex);
+
+  const typename MovingImageType::RegionType & region = movingImage->GetBufferedRegion();
+  double                                       sBegin = -NumericTraits<double>::max();
+  double                                       sEnd = NumericTraits<double>::max();
+  for (unsigned int d = 0; d < MovingImageDimension; ++d)
+  {
+    stepIndex[d] -= startIndex[d];
+    const double lower = static_cast<double>(region.GetIndex()[d]);
+    const double upper = lower + static_cast<double>(region.GetSize()[d]) - 1.0;
+    if (std::abs(stepIndex[d]) < 1e-12)
+    {
+      if (startIndex[d] < lower || startIndex[d] > upper)
+      {
+        return;
+      }
+      continue;
+    }
+    const double s0 = (lower - startIndex[d]) / stepIndex[d];
+    const double s1 = (upper - startIndex[d]) / stepIndex[d];
+    sBegin = std::max(sBegin, std::min(s0, s1));
+    sEnd = std::min(sEnd, std::max(s0, s1));
+  }
+  if (sBegin >= sEnd)
+  {
+    return;
+  }
+
+  /** Integrate the gradient of the moving image above the threshold along the ray,
+   * with the midpoint rule and about one step per voxel:
+   *   G0 = int dM/dx ds,  G1 = int s dM/dx ds.
+   */
+  double minimumSpacing = movingImage->GetSpacing()[0];
+  for (unsigned int d = 1; d < MovingImageDimension; ++d)
+  {
+    minimumSpacing = std::min(minimumSpacing, static_cast<double>(movingImage->GetSpacing()[d]));
+  }
+  const unsigned int numberOfSteps =
+    std::max(1u, static_cast<unsigned int>(std::ceil((sEnd - sBegin) / minimumSpacing)));
+  const double stepLength = (sEnd - sBegin) / numberOfSteps;
+  const double threshold = this->m_RayCastInterpolator->GetThreshold();
+
+  MovingImageDerivativeType gradient0;
+  MovingImageDerivativeType gradient1;
+  gradient0.Fill(0.0);
+  gradient1.Fill(0.0);
+  for (unsigned int k = 0; k < numberOfSteps; ++k)
+  {
+    const double                   s = sBegin + (k + 0.5) * stepLength;
+    MovingImageContinuousIndexType cindex;
+    for (unsigned int d = 0; d < MovingImageDimension; ++d)
+    {
+      cindex[d] = startIndex[d] + s * stepIndex[d];
+    }
+
+    typename LinearInterpolatorType::OutputType          intensity;
+    typename LinearInterpolatorType::CovariantVectorType gradient;
+    this->m_RayGradientInterpolator->EvaluateValueAndDerivativeAtContinuousIndex(cindex, intensity, gradient);
+    if (intensity <= threshold)
+    {
+      continue;
+    }
+    for (unsigned int d = 0; d < MovingImageDimension; ++d)
+    {
+      gradient0[d] += gradient[d] * stepLength;
+      gradient1[d] += s * gradient[d] * stepLength;
+    }
+  }
+
+  /** With u = (q - p) / L, the derivatives of the line integral with respect to the
+   * mapped point p and the mapped focal point q are G0 - H and H, where
+   * H = (I - u u^T) G1 / L. The end points of the ray are assumed to be in the background.
+   */
+  double directionDotGradient1 = 0.0;
+  for (unsigned int d = 0; d < MovingImageDimension; ++d)
+  {
+    directionDotGradient1 += direction[d] * gradient1[d];
+  }
+  for (unsigned int d = 0; d < MovingImageDimension; ++d)
+  {
+    const double h = (gradient1[d] - directionDotGradient1 * direction[d]) / rayLength;
+    (*pointGradient)[d] = gradient0[d] - h;
+    (*focalPointGradient)[d] = h;
+  }
+
+} // end EvaluateProjection()
+
+
+/**
+ * ******************** ComputeValueAndDerivativeOfSamples ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ComputeValueAndDerivativeOfSamples(
+  unsigned long    pos_begin,
+  unsigned long    pos_end,
+  unsigned long &  numberOfPixelsCounted,
+  MeasureType &    measure,
+  DerivativeType * derivative) const
+{
+  /** The transform of which the Jacobian is needed. */
+  const AdvancedTransformType * transform = this->m_AdvancedTransform.GetPointer();
+  if (this->m_RayCastInterpolator.IsNotNull())
+  {
+    transform = this->m_RayCastTransform.GetPointer();
+  }
+
+  /** Array that stores dM(x)/dmu, and the sparse Jacobian + indices. */
+  NonZeroJacobianIndicesType nzji(transform->GetNumberOfNonZeroJacobianIndices());
+  DerivativeType             imageJacobian(nzji.size());
+
+  /** The neighbourhood of a sample, with the sample itself in the centre. */
+  const unsigned int                     neighborhoodWidth = 2 * this->m_NeighborhoodRadius + 1;
+  const unsigned int                     numberOfNeighbors = neighborhoodWidth * neighborhoodWidth;
+  const unsigned int                     center = numberOfNeighbors / 2;
+  std::vector<FixedImagePointType>       points(numberOfNeighbors);
+  std::vector<RealType>                  fixedValues(numberOfNeighbors);
+  std::vector<RealType>                  differences(numberOfNeighbors);
+  std::vector<MovingImageDerivativeType> pointGradients(numberOfNeighbors);
+  std::vector<MovingImageDerivativeType> focalPointGradients(numberOfNeighbors);
+
+  const double sigma2 = this->m_NoiseConstant;
+  const double scaling = this->m_NormalizationFactor;
+
+  /** The focal point terms of all rays share the same Jacobian, so they are added once at the end. */
+  MovingImageDerivativeType focalPointGradientSum;
+  focalPointGradientSum.Fill(0.0);
+
+  /** Lambda that adds the image Jacobian of a point to the derivative. */
+  const auto addImageJacobian = [&](const FixedImagePointType & point, const MovingImageDerivativeType & gradient) {
+    transform->EvaluateJacobianWithImageGradientProduct(point, gradient, imageJacobian, nzji);
+    if (nzji.size() == this->GetNumberOfParameters())
+    {
+      for (unsigned int mu = 0; mu < this->GetNumberOfParameters(); ++mu)
+      {
+        (*derivative)[mu] += static_cast<DerivativeValueType>(imageJacobian[mu]);
+      }
+    }
+    else
+    {
+      for (unsigned int i = 0; i < imageJacobian.GetSize(); ++i)
+      {
+        (*derivative)[nzji[i]] += static_cast<DerivativeValueType>(imageJacobian[i]);
+      }
+    }
+  };
+
+  /** Create iterator over the sample container. */
+  ImageSampleContainerPointer                      sampleContainer = this->GetImageSampler()->GetOutput();
+  typename ImageSampleContainerType::ConstIterator fiter = sampleContainer->Begin();
+  fiter += (int)pos_begin;
+
+  for (unsigned long pos = pos_begin; pos < pos_end; ++pos, ++fiter)
+  {
+    if (!this->GetNeighborhoodOfSample((*fiter).Value().m_ImageCoordinates, points, fixedValues))
+    {
+      continue;
+    }
+    ++numberOfPixelsCounted;
+
+    /** Compute the difference image d = F - s P on the neighbourhood. */
+    for (unsigned int n = 0; n < numberOfNeighbors; ++n)
+    {
+      RealType projection;
+      if (derivative != nullptr)
+      {
+        this->EvaluateProjection(points[n], projection, &pointGradients[n], &focalPointGradients[n]);
+      }
+      else
+      {
+        this->EvaluateProjection(points[n], projection, nullptr, nullptr);
+      }
+      differences[n] = fixedValues[n] - scaling * projection;
+    }
+
+    /** Compute the contributions to the measure, and the weight of each projection in the derivative:
+     *   d/dmu sigma^2 / (sigma^2 + e^2) = 2 sigma^2 s e / (sigma^2 + e^2)^2 d(P_c - P_n)/dmu,
+     * with e = d_c - d_n.
+     */
+    double centerWeight = 0.0;
+    for (unsigned int n = 0; n < numberOfNeighbors; ++n)
+    {
+      const double fixedDifference = fixedValues[center] - fixedValues[n];
+      const double difference = differences[center] - differences[n];
+      const double denominator = sigma2 + difference * difference;
+      measure += sigma2 / denominator - sigma2 / (sigma2 + fixedDifference * fixedDifference);
+
+      if (derivative == nullptr || n == center)
+      {
+        continue;
+      }
+      const double weight = 2.0 * sigma2 * scaling * difference / (denominator * denominator);
+      if (weight != 0.0)
+      {
+        centerWeight += weight;
+        addImageJacobian(points[n], pointGradients[n] * -weight);
+        focalPointGradientSum -= focalPointGradients[n] * weight;
+      }
+    }
+    if (centerWeight != 0.0)
+    {
+      addImageJacobian(points[center], pointGradients[center] * centerWeight);
+      focalPointGradientSum += focalPointGradients[center] * centerWeight;
+    }
+  }
+
+  /** Add the focal point terms of the rays. */
+  if (derivative != nullptr && this->m_RayCastInterpolator.IsNotNull())
+  {
+    addImageJacobian(this->m_RayCastInterpolator->GetFocalPoint(), focalPointGradientSum);
+  }
+
+} // end ComputeValueAndDerivativeOfSamples()
+
+
+/**
+ * ******************** GetSampleRangeOfThread ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::GetSampleRangeOfThread(ThreadIdType    threadId,
+                                                                                      unsigned long & pos_begin,
+                                                                                      unsigned long & pos_end) const
+{
+  const unsigned long sampleContainerSize = this->GetImageSampler()->GetOutput()->Size();
+  const unsigned long nrOfSamplesPerThreads = static_cast<unsigned long>(
+    std::ceil(static_cast<double>(sampleContainerSize) / static_cast<double>(Self::GetNumberOfWorkUnits())));
+
+  pos_begin = nrOfSamplesPerThreads * threadId;
+  pos_end = nrOfSamplesPerThreads * (threadId + 1);
+  pos_begin = (pos_begin > sampleContainerSize) ? sampleContainerSize : pos_begin;
+  pos_end = (pos_end > sampleContainerSize) ? sampleContainerSize : pos_end;
+
+} // end GetSampleRangeOfThread()
+
+
+/**
+ * ******************** ThreadedGetValue ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValue(ThreadIdType threadId)
+{
+  unsigned long pos_begin, pos_end;
+  this->GetSampleRangeOfThread(threadId, pos_begin, pos_end);
+
+  unsigned long numberOfPixelsCounted = 0;
+  MeasureType   measure = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivativeOfSamples(pos_begin, pos_end, numberOfPixelsCounted, measure, nullptr);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+
+} // end ThreadedGetValue()
+
+
+/**
+ * ******************** AfterThreadedGetValue ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValue(MeasureType & value) const
+{
+  const ThreadIdType numberOfThreads = Self::GetNumberOfWorkUnits();
+
+  /** Accumulate the number of pixels and the values. */
+  this->m_NumberOfPixelsCounted = 0;
+  value = NumericTraits<MeasureType>::Zero;
+  for (ThreadIdType i = 0; i < numberOfThreads; ++i)
+  {
+    this->m_NumberOfPixelsCounted += this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted;
+    value += this->m_GetValueAndDerivativePerThreadVariables[i].st_Value;
+
+    /** Reset these variables for the next iteration. */
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_NumberOfPixelsCounted = 0;
+    this->m_GetValueAndDerivativePerThreadVariables[i].st_Value = NumericTraits<MeasureType>::Zero;
+  }
+
+  /** Check if enough samples were valid. */
+  ImageSampleContainerPointer sampleContainer = this->GetImageSampler()->GetOutput();
+  this->CheckNumberOfSamples(sampleContainer->Size(), this->m_NumberOfPixelsCounted);
+
+  value /= -this->m_Rescalingfactor; // negative for minimization
+
+} // end AfterThreadedGetValue()
+
+
+/**
+ * ******************** ThreadedGetValueAndDerivative ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::ThreadedGetValueAndDerivative(ThreadIdType threadId)
+{
+  /** Get a handle to the pre-allocated derivative for the current thread.
+   * The initialization is performed at the beginning of each resolution in
+   * InitializeThreadingParameters(), and at the end of each iteration in
+   * the accumulate function.
+   */
+  DerivativeType & derivative = this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Derivative;
+
+  unsigned long pos_begin, pos_end;
+  this->GetSampleRangeOfThread(threadId, pos_begin, pos_end);
+
+  unsigned long numberOfPixelsCounted = 0;
+  MeasureType   measure = NumericTraits<MeasureType>::Zero;
+  this->ComputeValueAndDerivativeOfSamples(pos_begin, pos_end, numberOfPixelsCounted, measure, &derivative);
+
+  /** Only update these variables at the end to prevent unnecessary "false sharing". */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_NumberOfPixelsCounted = numberOfPixelsCounted;
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].st_Value = measure;
+
+} // end ThreadedGetValueAndDerivative()
+
+
+/**
+ * ******************** AfterThreadedGetValueAndDerivative ******************************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+PatternIntensityImageToImageMetric<TFixedImage, TMovingImage>::AfterThreadedGetValueAndDerivative(
+  MeasureType &    value,
+  DerivativeType & derivative) const
+{
+  /** Accumulate the number of pixels and the values. */
+  this->AfterThreadedGetValue(value);
+
+  /** Accumulate derivatives, which divides them by the normalization factor. */
+  this->m_ThreaderMetricParameters.st_DerivativePointer = derivative.begin();
+  this->m_ThreaderMetricParameters.st_NormalizationFactor = -this->m_Rescalingfactor;
+  this->m_ThreaderMetricParameters.st_UseTouchedDerivativeTiles = false;
+
+  this->LaunchThreaderCallback(this->AccumulateDerivativesThreaderCallback,
+                               const_cast<void *>(static_cast<const void *>(&this->m_ThreaderMetricParameters)));
+
+} // end AfterThreadedGetValueAndDerivative()
+
+
 } // end namespace itk
 
 #endif // end itkPatternIntensityImageToImageMetric_hxx
@@ -184,8 +184,11 @@ MeshPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDerivative(const Transf
   /** Initialize some variables */
   value = NumericTraits<MeasureType>::Zero;
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters are up to date. When this metric is
+   * part of a CombinationImageToImageMetric, this is done beforehand, such that
+   * GetValueAndDerivative can be called concurrently with the other metrics.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
   derivative = DerivativeType(this->GetNumberOfParameters());
   derivative.Fill(NumericTraits<DerivativeValueType>::ZeroValue());
@@ -191,6 +191,13 @@ public:
   void
   BeforeThreadedGetValueAndDerivative(const TransformParametersType & parameters) const override;
 
+  /** The rigidity penalty is computed single-threaded. */
+  bool
+  GetValueAndDerivativeIsMultiThreaded(void) const override
+  {
+    return false;
+  }
+
   /** The GetValueAndDerivative()-method returns the rigid penalty value and its derivative. */
   void
   GetValueAndDerivative(const ParametersType & parameters,
@@ -335,8 +335,14 @@ TransformRigidityPenaltyTerm<TFixedImage, TScalarType>::FillRigidityCoefficientI
     return;
   }
 
-  /** Make sure that the transform is up to date. */
-  this->m_Transform->SetParameters(parameters);
+  /** Make sure that the transform is up to date. The combo-metric has already set the
+   * parameters, and may compute the other metrics concurrently, see
+   * BeforeThreadedGetValueAndDerivative().
+   */
+  if (this->m_UseMetricSingleThreaded)
+  {
+    this->m_Transform->SetParameters(parameters);
+  }
 
   /** Create and reset an iterator over m_RigidityCoefficientImage. */
   RigidityImageIteratorType it(this->m_RigidityCoefficientImage,
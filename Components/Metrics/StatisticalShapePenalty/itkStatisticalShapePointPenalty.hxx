@@ -462,8 +462,11 @@ StatisticalShapePointPenalty<TFixedPointSet, TMovingPointSet>::GetValueAndDeriva
   // InputPointType movingPoint;
   OutputPointType fixedPoint;
 
-  /** Make sure the transform parameters are up to date. */
-  this->SetTransformParameters(parameters);
+  /** Make sure the transform parameters are up to date. When this metric is
+   * part of a CombinationImageToImageMetric, this is done beforehand, such that
+   * GetValueAndDerivative can be called concurrently with the other metrics.
+   */
+  this->BeforeThreadedGetValueAndDerivative(parameters);
 
   const unsigned int shapeLength = Self::FixedPointSetDimension * fixedPointSet->GetNumberOfPoints();
 
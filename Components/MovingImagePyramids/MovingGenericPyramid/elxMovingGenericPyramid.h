@@ -56,10 +56,19 @@ namespace elastix
  * moving_image_spacing.\n If ImagePyramidSmoothingSchedule is specified, that schedule is used for both moving and
  * moving image pyramid. \parameter ImagePyramidSmoothingSchedule: smoothing schedule for both pyramids \parameter
  * ComputePyramidImagesPerResolution: Flag to specify if all resolution levels are computed at once, or per resolution.
- * Latter saves memory.\n example: <tt>(ComputePyramidImagesPerResolution "true")</tt>\n Default false. \parameter
+ * Latter saves memory: a level is computed when its resolution starts, and released when it ends, except for the last
+ * level.\n example: <tt>(ComputePyramidImagesPerResolution "false")</tt>\n Default true. \parameter
  * ImagePyramidUseShrinkImageFilter: Flag to specify if the ShrinkingImageFilter is used for rescaling the image, or the
  * ResampleImageFilter. Shrinker is faster.\n example: <tt>(ImagePyramidUseShrinkImageFilter "true")</tt>\n Default
  * false, so by default the resampler is used.
+ * \parameter CacheDirectory: a directory in which the pyramid images are stored, such that
+ *    later runs with the same moving image and pyramid settings read them instead of computing
+ *    them again. The directory may be shared by concurrent runs.\n
+ *    example: <tt>(CacheDirectory "/data/elastix_cache")</tt>\n
+ *    Default: "", which disables the cache.
+ * \parameter CacheMaximumSize: the maximum size of the files in the CacheDirectory, in megabytes.\n
+ *    example: <tt>(CacheMaximumSize 1024)</tt>\n
+ *    Default: 4096.
  *
  * \ingroup ImagePyramids
  */
@@ -124,6 +133,16 @@ public:
   void
   BeforeEachResolution(void) override;
 
+  /** Release the current resolution level, if it is computed per resolution. */
+  void
+  AfterEachResolution(void) override;
+
+  /** Method to write the pyramid image. Override from MovingImagePyramidBase,
+   * to compute the level first when the pyramid is computed per resolution.
+   */
+  void
+  WritePyramidImage(const std::string & filename, const unsigned int & level) override;
+
 protected:
   /** The constructor. */
   MovingGenericPyramid() = default;
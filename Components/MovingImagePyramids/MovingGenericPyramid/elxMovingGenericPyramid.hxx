@@ -147,10 +147,13 @@ MovingGenericPyramid<TElastix>::SetMovingSchedule(void)
    * resolution. Setting the option to true saves memory, since only one level
    * of the pyramid gets allocated per resolution.
    */
-  bool computeThisResolution = false;
+  bool computeThisResolution = true;
   this->m_Configuration->ReadParameter(computeThisResolution, "ComputePyramidImagesPerResolution", 0, false);
   this->SetComputeOnlyForCurrentLevel(computeThisResolution);
 
+  /** Read the pyramid images from, and write them to, a cache directory that is shared between runs. */
+  this->SetPersistentCache(this->CreatePersistentCache());
+
 } // end SetMovingSchedule()
 
 
@@ -174,6 +177,45 @@ MovingGenericPyramid<TElastix>::BeforeEachResolution(void)
 } // end BeforeEachResolution()
 
 
+/**
+ * ******************* AfterEachResolution ***********************
+ */
+
+template <class TElastix>
+void
+MovingGenericPyramid<TElastix>::AfterEachResolution(void)
+{
+  /** What is the current resolution level? */
+  const unsigned int level = this->m_Registration->GetAsITKBaseType()->GetCurrentLevel();
+
+  /** Free the memory of a finished level, such that only one level is in memory at a time.
+   * The last level is kept, since the final metric value may still be computed with it.
+   */
+  if (level + 1 < this->GetNumberOfLevels())
+  {
+    this->ReleaseCurrentLevel();
+  }
+
+} // end AfterEachResolution()
+
+
+/**
+ * ******************* WritePyramidImage ***********************
+ */
+
+template <class TElastix>
+void
+MovingGenericPyramid<TElastix>::WritePyramidImage(const std::string & filename, const unsigned int & level)
+{
+  /** The pyramid images are written before BeforeEachResolution() has been called,
+   * so let the pyramid filter know which level is needed.
+   */
+  this->SetCurrentLevel(level);
+  this->Superclass2::WritePyramidImage(filename, level);
+
+} // end WritePyramidImage()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef elxMovingGenericPyramid_hxx
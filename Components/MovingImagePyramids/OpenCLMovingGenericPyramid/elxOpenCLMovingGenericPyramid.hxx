@@ -121,6 +121,7 @@ OpenCLMovingGenericPyramid<TElastix>::BeforeGenerateData(void)
     this->m_GPUPyramid->SetSmoothingSchedule(this->GetSmoothingSchedule());
     this->m_GPUPyramid->SetUseShrinkImageFilter(this->GetUseShrinkImageFilter());
     this->m_GPUPyramid->SetComputeOnlyForCurrentLevel(this->GetComputeOnlyForCurrentLevel());
+    this->m_GPUPyramid->SetCurrentLevel(this->GetCurrentLevel());
   }
 
   if (this->m_GPUPyramidReady)
@@ -197,8 +198,14 @@ OpenCLMovingGenericPyramid<TElastix>::GenerateData(void)
 
   if (computedUsingOpenCL)
   {
-    // Graft output
-    this->GraftOutput(this->m_GPUPyramid->GetOutput());
+    // Graft the computed outputs
+    for (unsigned int level = 0; level < this->GetNumberOfLevels(); ++level)
+    {
+      if (!this->GetComputeOnlyForCurrentLevel() || level == this->GetCurrentLevel())
+      {
+        this->GraftNthOutput(level, this->m_GPUPyramid->GetOutput(level));
+      }
+    }
 
     // Report OpenCL device to the log
     this->ReportToLog();
@@ -30,6 +30,17 @@ namespace itk
  * This metric is meant to be used in the
  * MultiMetricMultiResolutionImageRegistrationMethod.
  *
+ * When multi-threading is used, GetValueAndDerivative() submits the metrics that
+ * are not multi-threaded themselves as tasks to the thread pool, such that they
+ * run concurrently with the multi-threaded image metrics, which use the other
+ * threads of the pool. These are the point set metrics, and the image metrics for
+ * which GetValueAndDerivativeIsMultiThreaded() returns false, like the
+ * TransformRigidityPenaltyTerm. The TransformBendingEnergyPenaltyTerm distributes
+ * its samples over the threads, like the image similarity metrics. The other
+ * single-threaded image metrics are still computed one after the other, because
+ * they set the transform parameters themselves. The weighted sum of the
+ * derivatives is computed with the thread pool as well.
+ *
  * NB: while it may seem not logical that the SetInterpolator(arg)
  * sets the interpolator in all submetrics whereas the
  * GetInterpolator(void) returns GetInterpolator(0) it is logical.
@@ -478,6 +489,12 @@ private:
    */
   double
   GetFinalMetricWeight(unsigned int pos) const;
+
+  /** Compute the value, derivative and derivative magnitude of metric pos,
+   * and time the computation.
+   */
+  void
+  ComputeMetricValueAndDerivative(const ParametersType & parameters, unsigned int pos) const;
 };
 
 } // end namespace itk
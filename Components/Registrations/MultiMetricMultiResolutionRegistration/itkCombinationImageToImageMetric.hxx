@@ -22,6 +22,9 @@
 #include "itkTimeProbe.h"
 #include "itkMath.h"
 
+#include <future>
+#include <vector>
+
 /** Macros to reduce some copy-paste work.
  * These macros provide the implementation of
  * all Set/GetFixedImage, Set/GetInterpolator etc methods
@@ -593,6 +596,7 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::Initialize(void)
       // The NumberOfThreadsPerMetric is changed after Initialize() so we save it before and then
       // set it on.
       unsigned nrOfThreadsPerMetric = this->GetNumberOfWorkUnits();
+      testPtr1->SetThreadPool(this->m_ThreadPool);
       testPtr1->Initialize();
       testPtr1->SetNumberOfWorkUnits(nrOfThreadsPerMetric);
     }
@@ -653,6 +657,29 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetFinalMetricWeight(u
 } // end GetFinalMetricWeight()
 
 
+/**
+ * ******************* ComputeMetricValueAndDerivative *******************
+ */
+
+template <class TFixedImage, class TMovingImage>
+void
+CombinationImageToImageMetric<TFixedImage, TMovingImage>::ComputeMetricValueAndDerivative(
+  const ParametersType & parameters,
+  unsigned int           pos) const
+{
+  /** Compute ... */
+  itk::TimeProbe timer;
+  timer.Start();
+  this->m_Metrics[pos]->GetValueAndDerivative(parameters, this->m_MetricValues[pos], this->m_MetricDerivatives[pos]);
+  timer.Stop();
+
+  /** Store computation time and derivative magnitude. */
+  this->m_MetricComputationTime[pos] = timer.GetMean() * 1000.0;
+  this->m_MetricDerivativesMagnitude[pos] = this->m_MetricDerivatives[pos].magnitude();
+
+} // end ComputeMetricValueAndDerivative()
+
+
 /**
  * ********************* GetValue ****************************
  */
@@ -780,9 +807,6 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
                                                                                 MeasureType &          value,
                                                                                 DerivativeType &       derivative) const
 {
-  /** Declare timer. */
-  itk::TimeProbe timer;
-
   /** This function must be called before the multi-threaded code.
    * It calls all the non thread-safe stuff.
    */
@@ -807,55 +831,108 @@ CombinationImageToImageMetric<TFixedImage, TMovingImage>::GetValueAndDerivative(
   /** Initialize some threading related parameters. */
   this->InitializeThreadingParameters();
 
-  /** Compute all metric values and derivatives. */
+  /** Compute all metric values and derivatives. When multi-threading, the
+   * single-threaded metrics are submitted as tasks to the thread pool, while the
+   * multi-threaded image metrics are computed in this thread, using the other
+   * threads of the pool.
+   */
+  const bool        useTasks = this->m_UseMultiThread && this->m_ThreadPool.IsNotNull();
+  std::vector<bool> runAsTask(this->m_NumberOfMetrics, false);
   for (unsigned int i = 0; i < this->m_NumberOfMetrics; ++i)
   {
-    /** Compute ... */
-    timer.Reset();
-    timer.Start();
-    this->m_Metrics[i]->GetValueAndDerivative(parameters, this->m_MetricValues[i], this->m_MetricDerivatives[i]);
-    timer.Stop();
+    const ImageMetricType * imageMetric = dynamic_cast<const ImageMetricType *>(this->GetMetric(i));
+    runAsTask[i] = useTasks && (dynamic_cast<const PointSetMetricType *>(this->GetMetric(i)) != nullptr ||
+                                (imageMetric != nullptr && !imageMetric->GetValueAndDerivativeIsMultiThreaded()));
+  }
 
-    /** Store computation time. */
-    this->m_MetricComputationTime[i] = timer.GetMean() * 1000.0;
+  std::vector<std::future<void>> concurrentMetricsDone;
+  for (unsigned int i = 0; i < this->m_NumberOfMetrics; ++i)
+  {
+    if (runAsTask[i])
+    {
+      concurrentMetricsDone.push_back(
+        this->m_ThreadPool->Submit([this, &parameters, i] { this->ComputeMetricValueAndDerivative(parameters, i); }));
+    }
+  }
+  try
+  {
+    for (unsigned int i = 0; i < this->m_NumberOfMetrics; ++i)
+    {
+      if (!runAsTask[i])
+      {
+        this->ComputeMetricValueAndDerivative(parameters, i);
+      }
+    }
+  }
+  catch (...)
+  {
+    /** The tasks refer to the parameters, so wait for them before leaving. */
+    for (auto & metricDone : concurrentMetricsDone)
+    {
+      metricDone.wait();
+    }
+    throw;
+  }
+  for (auto & metricDone : concurrentMetricsDone)
+  {
+    metricDone.get();
   }
 
-  /** Compute the derivative magnitude. */
+  /** Switch the non thread-safe stuff on again, for the next call to GetValue()
+   * or GetDerivative().
+   */
   for (unsigned int i = 0; i < this->m_NumberOfMetrics; ++i)
   {
-    this->m_MetricDerivativesMagnitude[i] = this->m_MetricDerivatives[i].magnitude();
+    ImageMetricType *    testPtr1 = dynamic_cast<ImageMetricType *>(this->GetMetric(i));
+    PointSetMetricType * testPtr2 = dynamic_cast<PointSetMetricType *>(this->GetMetric(i));
+    if (testPtr1)
+    {
+      testPtr1->SetUseMetricSingleThreaded(true);
+    }
+    if (testPtr2)
+    {
+      testPtr2->SetUseMetricSingleThreaded(true);
+    }
   }
 
   /** Combine the metric values. */
   value = NumericTraits<MeasureType>::Zero;
+  std::vector<double> weights(this->m_NumberOfMetrics, 0.0);
   for (unsigned int i = 0; i < this->m_NumberOfMetrics; ++i)
   {
     if (this->m_UseMetric[i])
     {
-      const double weight = this->GetFinalMetricWeight(i);
-      value += weight * this->m_MetricValues[i];
+      weights[i] = this->GetFinalMetricWeight(i);
+      value += weights[i] * this->m_MetricValues[i];
     }
   }
 
-  /** Combine the metric derivatives. First, the first derivative. */
-  if (this->m_UseMetric[0])
+  /** Combine the metric derivatives, in the same order as the metrics, such that
+   * the result does not depend on the number of threads.
+   */
+  const unsigned int numberOfParameters = this->GetNumberOfParameters();
+  derivative.SetSize(numberOfParameters);
+  const auto combineDerivatives = [this, &weights, &derivative](ThreadIdType, SizeValueType begin, SizeValueType end) {
+    for (SizeValueType p = begin; p < end; ++p)
+    {
+      DerivativeValueType sum = NumericTraits<DerivativeValueType>::ZeroValue();
+      for (unsigned int i = 0; i < this->m_NumberOfMetrics; ++i)
+      {
+        if (this->m_UseMetric[i])
+        {
+          sum += weights[i] * this->m_MetricDerivatives[i][p];
+        }
+      }
+      derivative[p] = sum;
+    }
+  };
+  if (this->m_UseMultiThread && this->m_ThreadPool.IsNotNull())
   {
-    const double weight = this->GetFinalMetricWeight(0);
-    derivative = weight * this->m_MetricDerivatives[0];
+    this->m_ThreadPool->ParallelFor(numberOfParameters, 0, combineDerivatives);
   }
   else
   {
-    derivative.Fill(0);
-  }
-
-  /** Then the remaining derivatives. */
-  for (unsigned int i = 1; i < this->m_NumberOfMetrics; ++i)
-  {
-    if (this->m_UseMetric[i])
-    {
-      const double weight = this->GetFinalMetricWeight(i);
-      derivative += weight * this->m_MetricDerivatives[i];
-    }
+    combineDerivatives(0, 0, numberOfParameters);
   }
 
 } // end GetValueAndDerivative()
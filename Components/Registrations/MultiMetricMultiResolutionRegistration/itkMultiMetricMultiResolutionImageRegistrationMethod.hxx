@@ -178,6 +178,8 @@ MultiMetricMultiResolutionImageRegistrationMethod<TFixedImage, TMovingImage>::In
     this->GetCombinationMetric()->SetFixedImageRegion(this->m_FixedImageRegionPyramids[i][this->GetCurrentLevel()], i);
   }
 
+  this->GetCombinationMetric()->SetThreadPool(this->GetModifiableThreadPool());
+
   // this->GetMetric()->Initialize();
   this->GetCombinationMetric()->Initialize();
 
@@ -19,7 +19,7 @@
 #define elxLinearResampleInterpolator_h
 
 #include "elxIncludes.h" // include first to avoid MSVS warning
-#include "itkLinearInterpolateImageFunction.h"
+#include "itkAdvancedLinearInterpolateImageFunction.h"
 
 namespace elastix
 {
@@ -33,6 +33,10 @@ namespace elastix
  * this resample interpolator if memory burden is an issue and linear interpolation
  * is sufficient.
  *
+ * The values are those of the itk::LinearInterpolateImageFunction. Being an
+ * itk::AdvancedLinearInterpolateImageFunction, the resampler can interpolate
+ * the values of a batch of points at once, which is vectorized for 3D images.
+ *
  * The parameters used in this class are:
  * \parameter ResampleInterpolator: Select this resample interpolator as follows:\n
  *   <tt>(ResampleInterpolator "FinalLinearInterpolator")</tt>
@@ -42,15 +46,15 @@ namespace elastix
 
 template <class TElastix>
 class ITK_TEMPLATE_EXPORT LinearResampleInterpolator
-  : public itk::LinearInterpolateImageFunction<typename ResampleInterpolatorBase<TElastix>::InputImageType,
-                                               typename ResampleInterpolatorBase<TElastix>::CoordRepType>
+  : public itk::AdvancedLinearInterpolateImageFunction<typename ResampleInterpolatorBase<TElastix>::InputImageType,
+                                                       typename ResampleInterpolatorBase<TElastix>::CoordRepType>
   , public ResampleInterpolatorBase<TElastix>
 {
 public:
   /** Standard ITK-stuff. */
   typedef LinearResampleInterpolator Self;
-  typedef itk::LinearInterpolateImageFunction<typename ResampleInterpolatorBase<TElastix>::InputImageType,
-                                              typename ResampleInterpolatorBase<TElastix>::CoordRepType>
+  typedef itk::AdvancedLinearInterpolateImageFunction<typename ResampleInterpolatorBase<TElastix>::InputImageType,
+                                                      typename ResampleInterpolatorBase<TElastix>::CoordRepType>
                                              Superclass1;
   typedef ResampleInterpolatorBase<TElastix> Superclass2;
   typedef itk::SmartPointer<Self>            Pointer;
@@ -60,7 +64,7 @@ public:
   itkNewMacro(Self);
 
   /** Run-time type information (and related methods). */
-  itkTypeMacro(LinearResampleInterpolator, itk::LinearInterpolateImageFunction);
+  itkTypeMacro(LinearResampleInterpolator, itk::AdvancedLinearInterpolateImageFunction);
 
   /** Name of this class.
    * Use this name in the parameter file to select this specific resample interpolator. \n
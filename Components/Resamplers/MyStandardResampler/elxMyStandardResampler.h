@@ -28,6 +28,11 @@ namespace elastix
  * \class MyStandardResampler
  * \brief A resampler based on the itk::ResampleImageFilter.
  *
+ * With the FinalLinearInterpolator and without extrapolator, the output image
+ * is computed scanline by scanline: the points of a scanline that map inside
+ * the input image are interpolated with a single batched call to the
+ * interpolator, which is vectorized for 3D images. The result is the same.
+ *
  * The parameters used in this class are:
  * \parameter Resampler: Select this resampler as follows:\n
  *    <tt>(Resampler "DefaultResampler")</tt>
@@ -85,8 +90,7 @@ public:
   typedef typename Superclass2::RegistrationType     RegistrationType;
   typedef typename Superclass2::RegistrationPointer  RegistrationPointer;
   typedef typename Superclass2::ITKBaseType          ITKBaseType;
-
-  /* Nothing to add. In the baseclass already everything is done what should be done. */
+  typedef typename Superclass2::CoordRepType         CoordRepType;
 
 protected:
   /** The constructor. */
@@ -94,6 +98,12 @@ protected:
   /** The destructor. */
   ~MyStandardResampler() override = default;
 
+  /** Compute the output image with batched interpolation, when the interpolator
+   * is an itk::AdvancedLinearInterpolateImageFunction. Otherwise calls the superclass.
+   */
+  void
+  DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread) override;
+
 private:
   elxOverrideGetSelfMacro;
 
@@ -21,6 +21,99 @@
 
 #include "elxMyStandardResampler.h"
 
-// nothing
+#include "itkAdvancedLinearInterpolateImageFunction.h"
+#include "itkImageScanlineIterator.h"
+#include "itkTotalProgressReporter.h"
+
+#include <vector>
+
+namespace elastix
+{
+
+/**
+ * ******************* DynamicThreadedGenerateData ***********************
+ */
+
+template <class TElastix>
+void
+MyStandardResampler<TElastix>::DynamicThreadedGenerateData(const OutputImageRegionType & outputRegionForThread)
+{
+  typedef itk::AdvancedLinearInterpolateImageFunction<InputImageType, CoordRepType> LinearInterpolatorType;
+  typedef typename LinearInterpolatorType::ContinuousIndexType                       ContinuousIndexType;
+  typedef typename LinearInterpolatorType::OutputType                                InterpolatorOutputType;
+  typedef typename TransformType::InputPointType                                     PointType;
+
+  const LinearInterpolatorType * interpolator =
+    dynamic_cast<const LinearInterpolatorType *>(this->GetInterpolator());
+  if (interpolator == nullptr || this->GetExtrapolator() != nullptr)
+  {
+    return this->Superclass1::DynamicThreadedGenerateData(outputRegionForThread);
+  }
+  if (outputRegionForThread.GetNumberOfPixels() == 0)
+  {
+    return;
+  }
+
+  OutputImageType *     outputImage = this->GetOutput();
+  const TransformType * transform = this->GetTransform();
+  const PixelType       defaultValue = this->GetDefaultPixelValue();
+  const double          minValue = static_cast<double>(itk::NumericTraits<PixelType>::NonpositiveMin());
+  const double          maxValue = static_cast<double>(itk::NumericTraits<PixelType>::max());
+
+  itk::TotalProgressReporter progress(this, outputImage->GetRequestedRegion().GetNumberOfPixels());
+
+  /** The points of a scanline inside the input image, and their positions on the scanline. */
+  const unsigned int                  lineLength = outputRegionForThread.GetSize(0);
+  std::vector<ContinuousIndexType>    cindices(lineLength);
+  std::vector<InterpolatorOutputType> values(lineLength);
+  std::vector<unsigned int>           positions(lineLength);
+
+  itk::ImageScanlineIterator<OutputImageType> it(outputImage, outputRegionForThread);
+  while (!it.IsAtEnd())
+  {
+    /** Map the points of the scanline to the input image. */
+    unsigned int numberOfInsidePoints = 0;
+    IndexType    index = it.GetIndex();
+    for (unsigned int i = 0; i < lineLength; ++i, ++index[0])
+    {
+      PointType outputPoint;
+      outputImage->TransformIndexToPhysicalPoint(index, outputPoint);
+      interpolator->ConvertPointToContinuousIndex(transform->TransformPoint(outputPoint),
+                                                  cindices[numberOfInsidePoints]);
+      if (interpolator->IsInsideBuffer(cindices[numberOfInsidePoints]))
+      {
+        positions[numberOfInsidePoints] = i;
+        ++numberOfInsidePoints;
+      }
+    }
+
+    /** Interpolate them at once. */
+    interpolator->EvaluateAtContinuousIndices(numberOfInsidePoints, cindices.data(), values.data());
+
+    /** Write the scanline, with the same bounds checking as the itk::ResampleImageFilter. */
+    unsigned int inside = 0;
+    for (unsigned int i = 0; i < lineLength; ++i, ++it)
+    {
+      if (inside < numberOfInsidePoints && positions[inside] == i)
+      {
+        const double value = static_cast<double>(values[inside]);
+        it.Set(value < minValue   ? static_cast<PixelType>(minValue)
+               : value > maxValue ? static_cast<PixelType>(maxValue)
+                                  : static_cast<PixelType>(value));
+        ++inside;
+      }
+      else
+      {
+        it.Set(defaultValue);
+      }
+    }
+    it.NextLine();
+    progress.Completed(lineLength);
+  }
+
+} // end DynamicThreadedGenerateData()
+
+
+} // end namespace elastix
 
 #endif
@@ -25,6 +25,7 @@
 #include "elxBaseComponentSE.h"
 
 #include "itkImageSamplerBase.h"
+#include "itkImageRandomSamplerBase.h"
 
 namespace elastix
 {
@@ -36,6 +37,21 @@ namespace elastix
  *
  * This class contains all the common functionality for ImageSamplers.
  *
+ * The parameters used in this class are:
+ * \parameter PrefetchNewSamples: in combination with NewSamplesEveryIteration, generate
+ *    the samples of the next iteration by a task on the thread pool, while the current iteration
+ *    is computed. This requires UseCounterBasedRandomGenerator, because the global random
+ *    generator is also used by other components, such as some metrics and optimizers.\n
+ *    example: <tt>(PrefetchNewSamples "true")</tt> \n
+ *    Choose one from {"true", "false"} for every resolution. The default is "false".
+ * \parameter UseCounterBasedRandomGenerator: for the random samplers, draw every sample
+ *    from its own random stream, derived from the RandomSeed, instead of from the global
+ *    random generator. The samples are then generated in parallel (with -mts "true"), and
+ *    the sample sets do not depend on the number of threads. They do differ from the
+ *    sample sets of the global random generator.\n
+ *    example: <tt>(UseCounterBasedRandomGenerator "true")</tt> \n
+ *    Choose one from {"true", "false"} for every resolution. The default is "false".
+ *
  * \ingroup ImageSamplers
  * \ingroup ComponentBaseClasses
  */
@@ -65,6 +81,9 @@ public:
   /** ITKBaseType. */
   typedef itk::ImageSamplerBase<InputImageType> ITKBaseType;
 
+  /** The base class of the random samplers. */
+  typedef itk::ImageRandomSamplerBase<InputImageType> ImageRandomSamplerBaseType;
+
   /** Retrieves this object as ITKBaseType. */
   ITKBaseType *
   GetAsITKBaseType(void)
@@ -84,19 +103,36 @@ public:
   /** Execute stuff before each resolution:
    * \li Give a warning when NewSamplesEveryIteration is specified,
    * but the sampler is ignoring it.
+   * \li Set up the counter-based random number generator of the random samplers.
    */
   void
   BeforeEachResolutionBase(void) override;
 
+  /** Execute stuff after each iteration:
+   * \li Start prefetching the samples, if PrefetchNewSamples is set. This is
+   * only done during the iterations, because the settings of the sampler may
+   * be changed before, for example by the automatic parameter estimation.
+   */
+  void
+  AfterEachIterationBase(void) override;
+
+  /** Execute stuff after each resolution:
+   * \li Stop prefetching the samples.
+   */
+  void
+  AfterEachResolutionBase(void) override;
+
 protected:
   /** The constructor. */
-  ImageSamplerBase() = default;
+  ImageSamplerBase();
   /** The destructor. */
   ~ImageSamplerBase() override = default;
 
 private:
   elxDeclarePureVirtualGetSelfMacro(ITKBaseType);
 
+  bool m_PrefetchNewSamples;
+
   /** The deleted copy constructor. */
   ImageSamplerBase(const Self &) = delete;
   /** The deleted assignment operator. */
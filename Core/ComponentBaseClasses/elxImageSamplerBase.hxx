@@ -24,6 +24,18 @@
 namespace elastix
 {
 
+/**
+ * ******************* Constructor ******************
+ */
+
+template <class TElastix>
+ImageSamplerBase<TElastix>::ImageSamplerBase()
+{
+  this->m_PrefetchNewSamples = false;
+
+} // end Constructor()
+
+
 /**
  * ******************* BeforeEachResolutionBase ******************
  */
@@ -51,6 +63,45 @@ ImageSamplerBase<TElastix>::BeforeEachResolutionBase(void)
     }
   }
 
+  /** Check if the samples of the next iteration should be generated in the background. */
+  bool prefetchNewSamples = false;
+  this->m_Configuration->ReadParameter(prefetchNewSamples, "PrefetchNewSamples", "", level, 0, true);
+  this->m_PrefetchNewSamples = newSamples && prefetchNewSamples;
+
+  /** Check if the random samplers should use the counter-based random number generator. */
+  ImageRandomSamplerBaseType * randomSampler = dynamic_cast<ImageRandomSamplerBaseType *>(this->GetAsITKBaseType());
+  if (randomSampler != nullptr)
+  {
+    bool useCounterBasedRandomGenerator = false;
+    this->m_Configuration->ReadParameter(
+      useCounterBasedRandomGenerator, "UseCounterBasedRandomGenerator", "", level, 0, true);
+    randomSampler->SetUseCounterBasedRandomGenerator(useCounterBasedRandomGenerator);
+
+    /** The seed is the RandomSeed, with the index of this sampler in the upper bits,
+     * such that the samplers of a multi-metric registration draw different samples.
+     */
+    unsigned int randomSeed = 121212;
+    this->m_Configuration->ReadParameter(randomSeed, "RandomSeed", 0, false);
+    unsigned int samplerIndex = 0;
+    for (unsigned int i = 0; i < this->m_Elastix->GetNumberOfImageSamplers(); ++i)
+    {
+      if (this->m_Elastix->GetElxImageSamplerBase(i) == this)
+      {
+        samplerIndex = i;
+      }
+    }
+    typedef typename ImageRandomSamplerBaseType::RandomSeedType RandomSeedType;
+    randomSampler->SetRandomSeed((static_cast<RandomSeedType>(samplerIndex) << 32) + randomSeed);
+  }
+
+  /** Prefetching is started after the first iteration; report an unsupported combination now. */
+  if (this->m_PrefetchNewSamples && this->GetAsITKBaseType()->SelectingNewSamplesOnUpdateSupported() &&
+      !this->GetAsITKBaseType()->PrefetchingSupported())
+  {
+    itkExceptionMacro(<< "ERROR: PrefetchNewSamples is not supported by this ImageSampler. The random samplers "
+                      << "only support it in combination with (UseCounterBasedRandomGenerator \"true\").");
+  }
+
   /** Temporary?: Use the multi-threaded version or not. */
   std::string useMultiThread = this->m_Configuration->GetCommandLineArgument("-mts"); // mts: multi-threaded samplers
   if (useMultiThread == "true")
@@ -65,6 +116,34 @@ ImageSamplerBase<TElastix>::BeforeEachResolutionBase(void)
 } // end BeforeEachResolutionBase()
 
 
+/**
+ * ******************* AfterEachIterationBase ******************
+ */
+
+template <class TElastix>
+void
+ImageSamplerBase<TElastix>::AfterEachIterationBase(void)
+{
+  /** Called before the optimizer selects the samples of the next iteration. */
+  this->GetAsITKBaseType()->SetUsePrefetching(this->m_PrefetchNewSamples);
+
+} // end AfterEachIterationBase()
+
+
+/**
+ * ******************* AfterEachResolutionBase ******************
+ */
+
+template <class TElastix>
+void
+ImageSamplerBase<TElastix>::AfterEachResolutionBase(void)
+{
+  /** Stop prefetching, such that the sampler can be set up for the next resolution. */
+  this->GetAsITKBaseType()->SetUsePrefetching(false);
+
+} // end AfterEachResolutionBase()
+
+
 } // end namespace elastix
 
 #endif //#ifndef elxImageSamplerBase_hxx
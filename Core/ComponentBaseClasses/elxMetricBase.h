@@ -63,6 +63,25 @@ namespace elastix
  *    CheckNumberOfSamples. \n
  *    example: <tt>(RequiredRatioOfValidSamples 0.1)</tt> \n
  *    The default is 0.25.
+ * \parameter UseSparseDerivativeAccumulation: Whether the per-thread derivatives
+ *    are accumulated only in the parts that were touched by each thread. Saves time
+ *    for transforms with many parameters and compact support, such as B-splines.
+ *    Can be given for each resolution or for all resolutions at once. \n
+ *    example: <tt>(UseSparseDerivativeAccumulation "false")</tt> \n
+ *    The default is true.
+ * \parameter UseSpatiallyPartitionedSampling: Whether the samples are divided over
+ *    the threads by slabs of B-spline control points, such that the threads can write
+ *    to the same derivative and no accumulation is needed. Only used by metrics that
+ *    support it, and only for fine enough B-spline grids. Can be given for each
+ *    resolution or for all resolutions at once. \n
+ *    example: <tt>(UseSpatiallyPartitionedSampling "true")</tt> \n
+ *    The default is false.
+ * \parameter UseSampleBatches: Whether the samples are evaluated in batches, which
+ *    lets the transform and the linear interpolator process several samples at once.
+ *    Only used by metrics that support it. Can be given for each resolution or for
+ *    all resolutions at once. \n
+ *    example: <tt>(UseSampleBatches "false")</tt> \n
+ *    The default is true.
  *
  * \ingroup Metrics
  * \ingroup ComponentBaseClasses
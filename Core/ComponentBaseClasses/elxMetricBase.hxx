@@ -168,6 +168,22 @@ MetricBase<TElastix>::BeforeEachResolutionBase(void)
       }
     }
 
+    /** How should the metric combine the derivatives of the threads? */
+    bool useSparseDerivativeAccumulation = true;
+    this->GetConfiguration()->ReadParameter(
+      useSparseDerivativeAccumulation, "UseSparseDerivativeAccumulation", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseSparseDerivativeAccumulation(useSparseDerivativeAccumulation);
+
+    bool useSpatiallyPartitionedSampling = false;
+    this->GetConfiguration()->ReadParameter(
+      useSpatiallyPartitionedSampling, "UseSpatiallyPartitionedSampling", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseSpatiallyPartitionedSampling(useSpatiallyPartitionedSampling);
+
+    /** Should the samples be evaluated in batches? */
+    bool useSampleBatches = true;
+    this->GetConfiguration()->ReadParameter(useSampleBatches, "UseSampleBatches", this->GetComponentLabel(), level, 0);
+    thisAsAdvanced->SetUseSampleBatches(useSampleBatches);
+
   } // end advanced metric
 
 } // end BeforeEachResolutionBase()
@@ -38,9 +38,9 @@ namespace elastix
  * \parameter NewSamplesEveryIteration: if this flag is set to "true" some
  *    optimizers ask the metric to select a new set of spatial samples in
  *    every iteration. This, if used in combination with the correct optimizer (such as the
- *    StandardGradientDescent), and ImageSampler (Random, RandomCoordinate, or RandomSparseMask),
- *    allows for a very low number of spatial samples (around 2000), even with large images
- *    and transforms with a large number of parameters.\n
+ *    StandardGradientDescent), and ImageSampler (Random, RandomCoordinate, RandomSparseMask,
+ *    ImportanceRandom or QuasiRandomCoordinate), allows for a very low number of spatial samples (around 2000),
+ *    even with large images and transforms with a large number of parameters.\n
  *    Choose one from {"true", "false"} for every resolution.\n
  *    example: <tt>(NewSamplesEveryIteration "true" "true" "true")</tt> \n
  *    Default is "false" for every resolution.\n
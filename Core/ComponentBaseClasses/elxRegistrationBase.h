@@ -66,6 +66,14 @@ namespace elastix
  *    from one resolution level to another. Choose from {"true", "false"} \n
  *    example: <tt>(ErodeMovingMask2 "true" "false")</tt>
  *    This setting overrules ErodeMask and ErodeMovingMask.\n
+ * \parameter CacheDirectory: a directory in which the eroded masks are stored, such that
+ *    later runs with the same masks and pyramid schedules read them instead of eroding the
+ *    masks again. The directory may be shared by concurrent runs.\n
+ *    example: <tt>(CacheDirectory "/data/elastix_cache")</tt>\n
+ *    Default: "", which disables the cache.
+ * \parameter CacheMaximumSize: the maximum size of the files in the CacheDirectory, in megabytes.\n
+ *    example: <tt>(CacheMaximumSize 1024)</tt>\n
+ *    Default: 4096.
  *
  * \ingroup Registrations
  * \ingroup ComponentBaseClasses
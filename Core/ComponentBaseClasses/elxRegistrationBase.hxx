@@ -122,6 +122,7 @@ RegistrationBase<TElastix>::GenerateFixedMaskSpatialObject(const FixedMaskImageT
   erosion->SetSchedule(pyramid->GetSchedule());
   erosion->SetIsMovingMask(false);
   erosion->SetResolutionLevel(level);
+  erosion->SetPersistentCache(this->CreatePersistentCache());
 
   /** Set output of the erosion to fixedImageMaskAsImage. */
   FixedMaskImagePointer erodedFixedMaskAsImage = erosion->GetOutput();
@@ -184,6 +185,7 @@ RegistrationBase<TElastix>::GenerateMovingMaskSpatialObject(const MovingMaskImag
   erosion->SetSchedule(pyramid->GetSchedule());
   erosion->SetIsMovingMask(true);
   erosion->SetResolutionLevel(level);
+  erosion->SetPersistentCache(this->CreatePersistentCache());
 
   /** Set output of the erosion to movingImageMaskAsImage. */
   MovingMaskImagePointer erodedMovingMaskAsImage = erosion->GetOutput();
@@ -67,6 +67,15 @@ namespace elastix
  *    of the written image is desired.\n
  *    example: <tt>(CompressResultImage "true")</tt> \n
  *    The default is "false".
+ * \parameter ResultImageStreamingMemory: the memory budget, in megabytes, for the
+ *    result image while it is resampled and written. When set, the result image is
+ *    resampled, cast to the ResultImagePixelType and written in slabs along the last
+ *    dimension, such that a slab and its cast fit in the budget, instead of resampling
+ *    the whole image before writing it. This needs an image file format that supports
+ *    streamed writing, such as mhd or nrrd without compression; otherwise the whole
+ *    image is resampled at once.\n
+ *    example: <tt>(ResultImageStreamingMemory 512)</tt> \n
+ *    The default is 0, which means no streaming.
  *
  * \ingroup Resamplers
  * \ingroup ComponentBaseClasses
@@ -188,14 +197,26 @@ public:
   virtual void
   ResampleAndWriteResultImage(const char * filename, const bool & showProgress = true);
 
-  /** Function to write the result output image to a file. */
+  /** Function to write the result output image to a file. With more than one stream
+   * division, the image is requested from its source and written slab by slab.
+   */
   virtual void
-  WriteResultImage(OutputImageType * imageimage, const char * filename, const bool & showProgress = true);
+  WriteResultImage(OutputImageType *  imageimage,
+                   const char *       filename,
+                   const bool &       showProgress = true,
+                   const unsigned int numberOfStreamDivisions = 1);
 
   /** Function to create the result image in the format of an itk::Image. */
   virtual void
   CreateItkResultImage(void);
 
+  /** The number of slabs in which an image on the output grid of the resampler, with the
+   * specified number of bytes per pixel, is generated and written, according to the
+   * ResultImageStreamingMemory parameter. Also used for the outputs of transformix.
+   */
+  unsigned int
+  GetNumberOfResultImageStreamDivisions(const double bytesPerPixel) const;
+
 protected:
   /** The constructor. */
   ResamplerBase();
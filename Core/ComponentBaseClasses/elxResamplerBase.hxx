@@ -22,10 +22,14 @@
 #include "elxConversion.h"
 
 #include "itkImageFileCastWriter.h"
+#include "itkCastImageFilter.h"
 #include "itkChangeInformationImageFilter.h"
 #include "itkAdvancedRayCastInterpolateImageFunction.h"
 #include "itkTimeProbe.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace elastix
 {
 
@@ -299,6 +303,17 @@ ResamplerBase<TElastix>::ResampleAndWriteResultImage(const char * filename, cons
   /** Make sure the resampler is updated. */
   this->GetAsITKBaseType()->Modified();
 
+  /** When the result image is streamed, the writer drives the resampler slab by slab.
+   * A slab takes the output pixels and their cast, which is at most a double.
+   */
+  const unsigned int numberOfStreamDivisions =
+    this->GetNumberOfResultImageStreamDivisions(sizeof(OutputPixelType) + sizeof(double));
+  if (numberOfStreamDivisions > 1)
+  {
+    this->WriteResultImage(this->GetAsITKBaseType()->GetOutput(), filename, showProgress, numberOfStreamDivisions);
+    return;
+  }
+
   /** Add a progress observer to the resampler. */
   const auto progressObserver = BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::New();
   if (showProgress && (progressObserver != nullptr))
@@ -343,7 +358,10 @@ ResamplerBase<TElastix>::ResampleAndWriteResultImage(const char * filename, cons
 
 template <class TElastix>
 void
-ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char * filename, const bool & showProgress)
+ResamplerBase<TElastix>::WriteResultImage(OutputImageType *  image,
+                                          const char *       filename,
+                                          const bool &       showProgress,
+                                          const unsigned int numberOfStreamDivisions)
 {
   /** Check if ResampleInterpolator is the RayCastResampleInterpolator  */
   const auto testptr = dynamic_cast<itk::AdvancedRayCastInterpolateImageFunction<InputImageType, CoordRepType> *>(
@@ -395,11 +413,30 @@ ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char *
   writer->SetFileName(filename);
   writer->SetOutputComponentType(resultImagePixelType.c_str());
   writer->SetUseCompression(doCompression);
+  writer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+
+  /** When streaming, the resampling is done while writing, so the progress is that of the writer. */
+  const auto progressObserver =
+    (numberOfStreamDivisions > 1 && !BaseComponent::IsElastixLibrary()) ? ProgressCommandType::New() : nullptr;
+  if (showProgress && (progressObserver != nullptr))
+  {
+    progressObserver->ConnectObserver(writer.GetPointer());
+    progressObserver->SetStartString("  Progress: ");
+    progressObserver->SetEndString("%");
+  }
 
   /** Do the writing. */
   if (showProgress)
   {
-    xl::xout["coutonly"] << "\n  Writing image ..." << std::endl;
+    if (numberOfStreamDivisions > 1)
+    {
+      xl::xout["coutonly"] << "\n  Resampling and writing image in at most " << numberOfStreamDivisions
+                           << " slabs ..." << std::endl;
+    }
+    else
+    {
+      xl::xout["coutonly"] << "\n  Writing image ..." << std::endl;
+    }
   }
   try
   {
@@ -416,9 +453,41 @@ ResamplerBase<TElastix>::WriteResultImage(OutputImageType * image, const char *
     /** Pass the exception to an higher level. */
     throw excp;
   }
+
+  /** Disconnect from the writer. */
+  if (showProgress && (progressObserver != nullptr))
+  {
+    progressObserver->DisconnectObserver(writer.GetPointer());
+  }
 } // end WriteResultImage()
 
 
+/**
+ * ******************* GetNumberOfResultImageStreamDivisions ********************
+ */
+
+template <class TElastix>
+unsigned int
+ResamplerBase<TElastix>::GetNumberOfResultImageStreamDivisions(const double bytesPerPixel) const
+{
+  double streamingMemory = 0.0;
+  this->m_Configuration->ReadParameter(streamingMemory, "ResultImageStreamingMemory", 0, false);
+  if (streamingMemory <= 0.0)
+  {
+    return 1;
+  }
+
+  const auto   size = this->GetAsITKBaseType()->GetSize();
+  const double numberOfPixels = size.CalculateProductOfElements();
+  const double numberOfSlabs = std::ceil(numberOfPixels * bytesPerPixel / (streamingMemory * 1024.0 * 1024.0));
+
+  /** The ImageIO does not split finer than one slice along the last dimension. */
+  const double numberOfSlices = size[ImageDimension - 1];
+  return static_cast<unsigned int>(std::max(1.0, std::min(numberOfSlabs, numberOfSlices)));
+
+} // end GetNumberOfResultImageStreamDivisions()
+
+
 /*
  * ******************* CreateItkResultImage ********************
  * \todo: avoid code duplication with WriteResultImage function
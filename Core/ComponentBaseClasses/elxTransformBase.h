@@ -25,6 +25,7 @@
 #include "elxElastixBase.h"
 #include "itkAdvancedTransform.h"
 #include "itkAdvancedCombinationTransform.h"
+#include "itkCachedDisplacementFieldTransform.h"
 #include "elxComponentDatabase.h"
 #include "elxProgressCommand.h"
 
@@ -55,6 +56,21 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Add".
+ * \parameter CacheInitialTransform: Whether the initial transform is replaced by a cached
+ *   displacement field on the grid of the fixed image, during the registration. Each point
+ *   then costs a single B-spline evaluation, instead of one evaluation of each transform of
+ *   a chain of initial transforms. The cache is not used for points outside the fixed image,
+ *   and is not computed when the initial transform is linear.\n
+ *   example: <tt>(CacheInitialTransform "true")</tt>\n
+ *   Default: "false".
+ * \parameter InitialTransformCacheSplineOrder: The order of the B-spline that interpolates
+ *   the cached displacements, 1 (linear) or 3 (cubic).\n
+ *   example: <tt>(InitialTransformCacheSplineOrder 1)</tt>\n
+ *   Default: 3.
+ * \parameter InitialTransformCacheGridSpacingInVoxels: The spacing of the grid on which the
+ *   displacements are cached, in voxels of the fixed image.\n
+ *   example: <tt>(InitialTransformCacheGridSpacingInVoxels 4.0)</tt>\n
+ *   Default: 2.0.
  *
  * \transformparameter UseDirectionCosines: Controls whether to use or ignore the
  * direction cosines (world matrix, transform matrix) set in the images.
@@ -75,6 +91,13 @@ namespace elastix
  *   "Compose" by composition: \f$T(x) = T_1 ( T_0(x) )\f$.\n
  *   example: <tt>(HowToCombineTransforms "Add")</tt>\n
  *   Default: "Compose".
+ * \transformparameter CacheInitialTransform: Whether transformix replaces the initial transform by
+ *   a cached displacement field on the grid of the resampled image, as during the registration.
+ *   The cache is only used for the last transform of a chain, and is configured by the
+ *   InitialTransformCacheSplineOrder and InitialTransformCacheGridSpacingInVoxels parameters,
+ *   in voxels of the resampled image.\n
+ *   example: <tt>(CacheInitialTransform "true")</tt>\n
+ *   Default: "false".
  * \transformparameter Size: The size (number of voxels in each dimension) of the fixed image
  * that was used during registration, and which is used for resampling the deformed moving image.\n
  * example: <tt>(Size 100 90 90)</tt>\n
@@ -121,10 +144,39 @@ namespace elastix
  *    "point", depending if the user supplies voxel indices or real world coordinates.
  *    The second line should be the number of points that should be transformed. The
  *    third and following lines give the indices or points.\n
+ *    For large point sets, the points may also be given as a binary point file, as
+ *    described at itk::TransformixInputPointFileReader.\n
  *    It is also possible to deform all points, thereby generating a deformation field
  *    image. This is done by:\n
  *    example: <tt>-def all</tt> \n
  *
+ * The parameters used by transformix for the output of -def, -jac and -jacmat:
+ * \parameter OutputPointFileFormat: the format of the file of the points that are transformed by
+ *    "-def inputPoints.txt". With "verbose", outputpoints.txt has for each point its input index
+ *    and point, its output index and point, and its deformation. With "compact", outputpoints.txt
+ *    has the output points only, in the format of an input point file. With "binary", they are
+ *    written to outputpoints.bin, in the binary format of an input point file.\n
+ *    example: <tt>(OutputPointFileFormat "binary")</tt> \n
+ *    The default is "verbose".
+ * \parameter ResultImageStreamingMemory: the memory budget, in megabytes, for each of
+ *    these images. When set, the images are generated and written in slabs along the
+ *    last dimension, instead of being generated as a whole before being written. This
+ *    needs an image file format that supports streamed writing, such as mhd.\n
+ *    example: <tt>(ResultImageStreamingMemory 512)</tt> \n
+ *    The default is 0, which means no streaming.
+ * \parameter ResultDeformationFieldPixelType: the component type of the written
+ *    deformation field, "float" or "short". With "short", each component is rounded to
+ *    a multiple of the ResultDeformationFieldQuantizationStep, which halves the file
+ *    size. The step is written in the image header as DeformationFieldQuantizationStep,
+ *    so a vector in millimeters is the written vector times the step.\n
+ *    example: <tt>(ResultDeformationFieldPixelType "short")</tt> \n
+ *    The default is "float".
+ * \parameter ResultDeformationFieldQuantizationStep: the size, in millimeters, of a unit
+ *    of a "short" deformation field component. Larger components are clamped to 32767
+ *    times the step.\n
+ *    example: <tt>(ResultDeformationFieldQuantizationStep 0.001)</tt> \n
+ *    The default is 0.01.
+ *
  * \ingroup Transforms
  * \ingroup ComponentBaseClasses
  */
@@ -173,6 +225,8 @@ public:
                                                                   CombinationTransformType;
   typedef CombinationTransformType                                ITKBaseType;
   typedef typename CombinationTransformType::InitialTransformType InitialTransformType;
+  typedef itk::CachedDisplacementFieldTransform<CoordRepType, itkGetStaticConstMacro(FixedImageDimension)>
+                                                                  CachedInitialTransformType;
 
   /** Typedef's for parameters. */
   using ValueType = double;
@@ -346,10 +400,33 @@ private:
 
   void WriteDeformationFieldImage(typename DeformationFieldImageType::Pointer) const;
 
+  /** Function to generate the deformation field and write it in slabs, as the specified
+   * pixel type ("float" or "short"), without keeping the whole field in memory.
+   */
+  void
+  GenerateAndWriteDeformationFieldImage(const std::string & pixelType,
+                                        const unsigned int  numberOfStreamDivisions) const;
+
   /** Legacy function that calls GenerateDeformationFieldImage and WriteDeformationFieldImage. */
   void
   TransformPointsAllPoints(void) const;
 
+  /** Replaces the initial transform of the combination by a cached displacement field on the
+   * grid of the specified image, when the CacheInitialTransform parameter is "true".
+   */
+  void
+  CacheInitialTransform(const itk::ImageBase<FixedImageDimension> & image);
+
+  /** Writes an image that is generated while it is written, in the specified number of slabs.
+   * The progress is that of the generator, unless the image is written in more than one slab.
+   */
+  template <class TImage>
+  static void
+  WriteImageInSlabs(TImage &             image,
+                    itk::ProcessObject & generator,
+                    const std::string &  fileName,
+                    const unsigned int   numberOfStreamDivisions);
+
   std::string
   GetInitialTransformParametersFileName(void) const
   {
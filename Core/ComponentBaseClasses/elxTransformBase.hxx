@@ -36,15 +36,25 @@
 #include "itkImageGridSampler.h"
 #include "itkContinuousIndex.h"
 #include "itkChangeInformationImageFilter.h"
+#include "itkUnaryGeneratorImageFilter.h"
+#include "itkMetaDataObject.h"
 #include "itkMesh.h"
 #include "itkMeshFileReader.h"
 #include "itkMeshFileWriter.h"
 #include "itkTransformMeshFilter.h"
 #include "itkCommonEnums.h"
+#include "itkWorkStealingThreadPool.h"
+#include "itkByteSwapper.h"
+#include "itkTimeProbe.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iomanip> // For setprecision.
+#include <limits>
 
 
 namespace itk
@@ -248,6 +258,9 @@ TransformBase<TElastix>::BeforeRegistrationBase(void)
     }
   }
 
+  /** Cache the initial transform on the grid of the fixed image, if desired. */
+  this->CacheInitialTransform(*(this->m_Elastix->GetFixedImage()));
+
 } // end BeforeRegistrationBase()
 
 
@@ -259,7 +272,11 @@ template <class TElastix>
 const typename TransformBase<TElastix>::InitialTransformType *
 TransformBase<TElastix>::GetInitialTransform(void) const
 {
-  return this->GetAsITKBaseType()->GetInitialTransform();
+  const InitialTransformType * const initialTransform = this->GetAsITKBaseType()->GetInitialTransform();
+
+  /** A cached initial transform stands for the transform of which it caches the displacements. */
+  const auto cachedInitialTransform = dynamic_cast<const CachedInitialTransformType *>(initialTransform);
+  return (cachedInitialTransform == nullptr) ? initialTransform : cachedInitialTransform->GetTransform();
 
 } // end GetInitialTransform()
 
@@ -476,6 +493,22 @@ TransformBase<TElastix>::ReadFromFile(void)
    */
   this->SetTransformParametersFileName(this->GetConfiguration()->GetCommandLineArgument("-tp").c_str());
 
+  /** Cache the initial transform on the grid of the resampled image, if desired.
+   * Only for the last transform of a chain, because the initial transforms of the chain
+   * are then no longer evaluated inside the grid.
+   */
+  if (this->m_Elastix->GetElxTransformBase() == this)
+  {
+    const auto resampler = this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType();
+    const auto resampledImageGeometry = itk::ImageBase<FixedImageDimension>::New();
+    resampledImageGeometry->SetRegions(
+      typename itk::ImageBase<FixedImageDimension>::RegionType(resampler->GetOutputStartIndex(), resampler->GetSize()));
+    resampledImageGeometry->SetSpacing(resampler->GetOutputSpacing());
+    resampledImageGeometry->SetOrigin(resampler->GetOutputOrigin());
+    resampledImageGeometry->SetDirection(resampler->GetOutputDirection());
+    this->CacheInitialTransform(*resampledImageGeometry);
+  }
+
 } // end ReadFromFile()
 
 
@@ -813,19 +846,30 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string & filename)
   {
     elxout << "  Input points are specified in world coordinates." << std::endl;
   }
-  unsigned int nrofpoints = ippReader->GetNumberOfPoints();
+  const std::size_t nrofpoints = ippReader->GetNumberOfPoints();
   elxout << "  Number of specified input points: " << nrofpoints << std::endl;
 
   /** Get the set of input points. */
   typename PointSetType::Pointer inputPointSet = ippReader->GetOutput();
 
+  /** Only the verbose output file has the indices and the deformation of each point. */
+  std::string outputPointFileFormat = "verbose";
+  this->m_Configuration->ReadParameter(outputPointFileFormat, "OutputPointFileFormat", 0, false);
+  if (outputPointFileFormat != "verbose" && outputPointFileFormat != "compact" && outputPointFileFormat != "binary")
+  {
+    itkExceptionMacro(<< "ERROR: The OutputPointFileFormat \"" << outputPointFileFormat << "\" is not supported.\n"
+                      << "  Choose \"verbose\", \"compact\", or \"binary\".\n");
+  }
+  const bool        verbose = outputPointFileFormat == "verbose";
+  const std::size_t nrofverbosepoints = verbose ? nrofpoints : 0;
+
   /** Create the storage classes. */
-  std::vector<FixedImageIndexType>   inputindexvec(nrofpoints);
-  std::vector<InputPointType>        inputpointvec(nrofpoints);
+  std::vector<FixedImageIndexType>   inputindexvec(nrofverbosepoints);
+  std::vector<InputPointType>        inputpointvec(nrofverbosepoints);
   std::vector<OutputPointType>       outputpointvec(nrofpoints);
-  std::vector<FixedImageIndexType>   outputindexfixedvec(nrofpoints);
-  std::vector<MovingImageIndexType>  outputindexmovingvec(nrofpoints);
-  std::vector<DeformationVectorType> deformationvec(nrofpoints);
+  std::vector<FixedImageIndexType>   outputindexfixedvec(nrofverbosepoints);
+  std::vector<MovingImageIndexType>  outputindexmovingvec(nrofverbosepoints);
+  std::vector<DeformationVectorType> deformationvec(nrofverbosepoints);
 
   /** Make a temporary image with the right region info,
    * which we can use to convert between points and indices.
@@ -844,10 +888,6 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string & filename)
   dummyImage->SetSpacing(spacing);
   dummyImage->SetDirection(direction);
 
-  /** Temp vars */
-  FixedImageContinuousIndexType  fixedcindex;
-  MovingImageContinuousIndexType movingcindex;
-
   /** Also output moving image indices if a moving image was supplied. */
   bool                              alsoMovingIndices = false;
   typename MovingImageType::Pointer movingImage = this->GetElastix()->GetMovingImage();
@@ -856,79 +896,151 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string & filename)
     alsoMovingIndices = true;
   }
 
-  /** Read the input points, as index or as point. */
-  if (!(ippReader->GetPointsAreIndices()))
-  {
-    for (unsigned int j = 0; j < nrofpoints; ++j)
+  /** Read the input points, as index or as point, and apply the transform.
+   * The points are divided in blocks, which are transformed by the threads of the global pool.
+   */
+  elxout << "  The input points are transformed." << std::endl;
+  const bool          pointsAreIndices = ippReader->GetPointsAreIndices();
+  const ITKBaseType & transform = *this->GetAsITKBaseType();
+  const std::size_t   blockSize = 1024;
+
+  const auto transformPoints = [&](itk::ThreadIdType, const itk::SizeValueType begin, const itk::SizeValueType end) {
+    FixedImageContinuousIndexType  fixedcindex;
+    MovingImageContinuousIndexType movingcindex;
+
+    for (std::size_t j = begin; j < end; ++j)
     {
-      /** Compute index of nearest voxel in fixed image. */
       InputPointType point;
       point.Fill(0.0f);
       inputPointSet->GetPoint(j, &point);
-      inputpointvec[j] = point;
-      dummyImage->TransformPhysicalPointToContinuousIndex(point, fixedcindex);
-      for (unsigned int i = 0; i < FixedImageDimension; ++i)
+
+      /** Compute index of nearest voxel in fixed image, or, if the read point is
+       * actually an index, cast it to the proper type and compute the input point
+       * in physical coordinates.
+       */
+      FixedImageIndexType inputindex{};
+      if (!pointsAreIndices)
       {
-        inputindexvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+        if (verbose)
+        {
+          dummyImage->TransformPhysicalPointToContinuousIndex(point, fixedcindex);
+          for (unsigned int i = 0; i < FixedImageDimension; ++i)
+          {
+            inputindex[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+          }
+        }
       }
-    }
-  }
-  else // so: inputasindex
-  {
-    for (unsigned int j = 0; j < nrofpoints; ++j)
-    {
-      /** The read point from the inutPointSet is actually an index
-       * Cast to the proper type.
-       */
-      InputPointType point;
-      point.Fill(0.0f);
-      inputPointSet->GetPoint(j, &point);
+      else
+      {
+        for (unsigned int i = 0; i < FixedImageDimension; ++i)
+        {
+          inputindex[i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(point[i]));
+        }
+        dummyImage->TransformIndexToPhysicalPoint(inputindex, point);
+      }
+
+      /** Call TransformPoint. */
+      outputpointvec[j] = transform.TransformPoint(point);
+      if (!verbose)
+      {
+        continue;
+      }
+      inputindexvec[j] = inputindex;
+      inputpointvec[j] = point;
+
+      /** Transform back to index in fixed image domain. */
+      dummyImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], fixedcindex);
       for (unsigned int i = 0; i < FixedImageDimension; ++i)
       {
-        inputindexvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(point[i]));
+        outputindexfixedvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
       }
-      /** Compute the input point in physical coordinates. */
-      dummyImage->TransformIndexToPhysicalPoint(inputindexvec[j], inputpointvec[j]);
-    }
-  }
 
-  /** Apply the transform. */
-  elxout << "  The input points are transformed." << std::endl;
-  for (unsigned int j = 0; j < nrofpoints; ++j)
-  {
-    /** Call TransformPoint. */
-    outputpointvec[j] = this->GetAsITKBaseType()->TransformPoint(inputpointvec[j]);
+      if (alsoMovingIndices)
+      {
+        /** Transform back to index in moving image domain. */
+        movingImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], movingcindex);
+        for (unsigned int i = 0; i < MovingImageDimension; ++i)
+        {
+          outputindexmovingvec[j][i] =
+            static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+        }
+      }
 
-    /** Transform back to index in fixed image domain. */
-    dummyImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], fixedcindex);
-    for (unsigned int i = 0; i < FixedImageDimension; ++i)
-    {
-      outputindexfixedvec[j][i] = static_cast<FixedImageIndexValueType>(itk::Math::Round<double>(fixedcindex[i]));
+      /** Compute displacement. */
+      deformationvec[j].CastFrom(outputpointvec[j] - inputpointvec[j]);
     }
+  };
+  itk::WorkStealingThreadPool::GetGlobalThreadPool()->ParallelFor(nrofpoints, blockSize, transformPoints);
 
-    if (alsoMovingIndices)
+  /** The compact and binary output files have the output points only, in the
+   * format of an input point file, so that they can be transformed again.
+   */
+  if (outputPointFileFormat == "binary")
+  {
+    std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
+    outputPointsFileName += "outputpoints.bin";
+    std::ofstream outputPointsFile(outputPointsFileName, std::ios::binary);
+    elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
+
+    std::uint32_t dimensionAndPointsAreIndices[2] = { MovingImageDimension, 0 };
+    std::uint64_t numberOfPoints = nrofpoints;
+    itk::ByteSwapper<std::uint32_t>::SwapRangeFromSystemToLittleEndian(dimensionAndPointsAreIndices, 2);
+    itk::ByteSwapper<std::uint64_t>::SwapFromSystemToLittleEndian(&numberOfPoints);
+    outputPointsFile.write(IPPReaderType::GetBinaryFileSignature(), IPPReaderType::BinaryFileSignatureLength);
+    outputPointsFile.write(reinterpret_cast<const char *>(dimensionAndPointsAreIndices),
+                           sizeof(dimensionAndPointsAreIndices));
+    outputPointsFile.write(reinterpret_cast<const char *>(&numberOfPoints), sizeof(numberOfPoints));
+
+    /** Write the coordinates as little endian doubles, in blocks of points. */
+    std::vector<double> coordinates(blockSize * MovingImageDimension);
+    for (std::size_t first = 0; first < nrofpoints; first += blockSize)
     {
-      /** Transform back to index in moving image domain. */
-      movingImage->TransformPhysicalPointToContinuousIndex(outputpointvec[j], movingcindex);
-      for (unsigned int i = 0; i < MovingImageDimension; ++i)
+      const std::size_t numberOfPointsInBlock = std::min(blockSize, nrofpoints - first);
+      for (std::size_t j = 0; j < numberOfPointsInBlock; ++j)
       {
-        outputindexmovingvec[j][i] = static_cast<MovingImageIndexValueType>(itk::Math::Round<double>(movingcindex[i]));
+        for (unsigned int i = 0; i < MovingImageDimension; ++i)
+        {
+          coordinates[j * MovingImageDimension + i] = static_cast<double>(outputpointvec[first + j][i]);
+        }
       }
+      itk::ByteSwapper<double>::SwapRangeFromSystemToLittleEndian(coordinates.data(),
+                                                                  numberOfPointsInBlock * MovingImageDimension);
+      outputPointsFile.write(reinterpret_cast<const char *>(coordinates.data()),
+                             numberOfPointsInBlock * MovingImageDimension * sizeof(double));
     }
-
-    /** Compute displacement. */
-    deformationvec[j].CastFrom(outputpointvec[j] - inputpointvec[j]);
+    if (!outputPointsFile)
+    {
+      itkExceptionMacro(<< "ERROR: Could not write the output points to " << outputPointsFileName << ".\n");
+    }
+    return;
   }
 
   /** Create filename and file stream. */
   std::string outputPointsFileName = this->m_Configuration->GetCommandLineArgument("-out");
   outputPointsFileName += "outputpoints.txt";
   std::ofstream outputPointsFile(outputPointsFileName);
+  if (outputPointFileFormat == "compact")
+  {
+    /** Write the output points with enough digits to read back the same coordinates. */
+    elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
+    outputPointsFile << std::setprecision(std::numeric_limits<double>::max_digits10);
+    outputPointsFile << "point\n" << nrofpoints << "\n";
+    for (const auto & outputpoint : outputpointvec)
+    {
+      outputPointsFile << outputpoint[0];
+      for (unsigned int i = 1; i < MovingImageDimension; ++i)
+      {
+        outputPointsFile << " " << outputpoint[i];
+      }
+      outputPointsFile << "\n";
+    }
+    return;
+  }
   outputPointsFile << std::showpoint << std::fixed;
   elxout << "  The transformed points are saved in: " << outputPointsFileName << std::endl;
 
   /** Print the results. */
-  for (unsigned int j = 0; j < nrofpoints; ++j)
+  for (std::size_t j = 0; j < nrofpoints; ++j)
   {
     /** The input index. */
     outputPointsFile << "Point\t" << j << "\t; InputIndex = [ ";
@@ -975,7 +1087,7 @@ TransformBase<TElastix>::TransformPointsSomePoints(const std::string & filename)
       }
     }
 
-    outputPointsFile << "]" << std::endl;
+    outputPointsFile << "]\n";
   } // end for nrofpoints
 
 } // end TransformPointsSomePoints()
@@ -1072,6 +1184,24 @@ template <class TElastix>
 void
 TransformBase<TElastix>::TransformPointsAllPoints(void) const
 {
+  /** When the deformation field is streamed or quantized, it is written while it is
+   * generated, so that the whole field is never kept in memory.
+   */
+  if (!BaseComponent::IsElastixLibrary())
+  {
+    std::string pixelType = "float";
+    this->m_Configuration->ReadParameter(pixelType, "ResultDeformationFieldPixelType", 0, false);
+    const double       bytesPerPixel =
+      sizeof(VectorPixelType) + ((pixelType == "float") ? 0 : sizeof(short) * FixedImageDimension);
+    const unsigned int numberOfStreamDivisions =
+      this->m_Elastix->GetElxResamplerBase()->GetNumberOfResultImageStreamDivisions(bytesPerPixel);
+    if (numberOfStreamDivisions > 1 || pixelType != "float")
+    {
+      this->GenerateAndWriteDeformationFieldImage(pixelType, numberOfStreamDivisions);
+      return;
+    }
+  }
+
   typename DeformationFieldImageType::Pointer deformationfield = this->GenerateDeformationFieldImage();
   // put deformation field in container
   this->m_Elastix->SetResultDeformationField(deformationfield.GetPointer());
@@ -1187,6 +1317,217 @@ TransformBase<TElastix>::WriteDeformationFieldImage(
 } // end WriteDeformationFieldImage()
 
 
+/**
+ * ************** GenerateAndWriteDeformationFieldImage **********************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::GenerateAndWriteDeformationFieldImage(const std::string & pixelType,
+                                                               const unsigned int  numberOfStreamDivisions) const
+{
+  /** Typedef's. */
+  typedef typename FixedImageType::DirectionType FixedImageDirectionType;
+  typedef itk::TransformToDisplacementFieldFilter<DeformationFieldImageType, CoordRepType>
+                                                                       DeformationFieldGeneratorType;
+  typedef itk::ChangeInformationImageFilter<DeformationFieldImageType> ChangeInfoFilterType;
+  typedef itk::Vector<short, FixedImageDimension>                      QuantizedVectorPixelType;
+  typedef itk::Image<QuantizedVectorPixelType, FixedImageDimension>    QuantizedDeformationFieldImageType;
+  typedef itk::UnaryGeneratorImageFilter<DeformationFieldImageType, QuantizedDeformationFieldImageType>
+                                                                       QuantizerType;
+
+  if (pixelType != "float" && pixelType != "short")
+  {
+    itkExceptionMacro(<< "ERROR: The ResultDeformationFieldPixelType \"" << pixelType << "\" is not supported.\n"
+                      << "  Choose \"float\" or \"short\".\n");
+  }
+
+  double quantizationStep = 0.01;
+  this->m_Configuration->ReadParameter(quantizationStep, "ResultDeformationFieldQuantizationStep", 0, false);
+  if (!(quantizationStep > 0.0))
+  {
+    itkExceptionMacro(<< "ERROR: The ResultDeformationFieldQuantizationStep should be positive, but is "
+                      << quantizationStep << ".\n");
+  }
+
+  /** Create an setup deformation field generator. */
+  const auto defGenerator = DeformationFieldGeneratorType::New();
+  defGenerator->SetSize(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetSize());
+  defGenerator->SetOutputSpacing(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputSpacing());
+  defGenerator->SetOutputOrigin(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputOrigin());
+  defGenerator->SetOutputStartIndex(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputStartIndex());
+  defGenerator->SetOutputDirection(this->m_Elastix->GetElxResamplerBase()->GetAsITKBaseType()->GetOutputDirection());
+  defGenerator->SetTransform(const_cast<const ITKBaseType *>(this->GetAsITKBaseType()));
+
+  /** Possibly change direction cosines to their original value, as specified
+   * in the tp-file, or by the fixed image. This is only necessary when
+   * the UseDirectionCosines flag was set to false. */
+  const auto              infoChanger = ChangeInfoFilterType::New();
+  FixedImageDirectionType originalDirection;
+  bool                    retdc = this->GetElastix()->GetOriginalFixedImageDirection(originalDirection);
+  infoChanger->SetOutputDirection(originalDirection);
+  infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
+  infoChanger->SetInput(defGenerator->GetOutput());
+
+  /** Create a name for the deformation field file. */
+  std::string resultImageFormat = "mhd";
+  this->m_Configuration->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
+  std::ostringstream makeFileName("");
+  makeFileName << this->m_Configuration->GetCommandLineArgument("-out") << "deformationField." << resultImageFormat;
+
+  /** Do the writing, which drives the generation of the deformation field, slab by slab. */
+  elxout << "  Computing and writing the deformation field in at most " << numberOfStreamDivisions << " slabs ..."
+         << std::endl;
+  try
+  {
+    if (pixelType == "float")
+    {
+      Self::WriteImageInSlabs(*infoChanger->GetOutput(), *defGenerator, makeFileName.str(), numberOfStreamDivisions);
+    }
+    else
+    {
+      /** Round each component to a multiple of the quantization step, clamped to the range of a short.
+       * The clamped components are counted atomically, as the functor is called by multiple threads.
+       */
+      elxout << "  The deformation field is quantized in steps of " << quantizationStep << " mm." << std::endl;
+      const double                    inverseStep = 1.0 / quantizationStep;
+      std::atomic<itk::SizeValueType> numberOfSaturatedComponents(0);
+      const auto                      quantizer = QuantizerType::New();
+      quantizer->SetInput(infoChanger->GetOutput());
+      quantizer->SetFunctor([inverseStep, &numberOfSaturatedComponents](const VectorPixelType & vector) {
+        QuantizedVectorPixelType result;
+        for (unsigned int i = 0; i < FixedImageDimension; ++i)
+        {
+          const double value = std::round(vector[i] * inverseStep);
+          if (std::abs(value) > 32767.0)
+          {
+            ++numberOfSaturatedComponents;
+          }
+          result[i] = static_cast<short>(std::max(-32767.0, std::min(value, 32767.0)));
+        }
+        return result;
+      });
+
+      /** Store the step in the header, so that the vectors can be converted back to millimeters. */
+      itk::EncapsulateMetaData<std::string>(quantizer->GetOutput()->GetMetaDataDictionary(),
+                                            "DeformationFieldQuantizationStep",
+                                            Conversion::ToString(quantizationStep));
+
+      Self::WriteImageInSlabs(*quantizer->GetOutput(), *defGenerator, makeFileName.str(), numberOfStreamDivisions);
+
+      if (numberOfSaturatedComponents > 0)
+      {
+        xl::xout["warning"] << "WARNING: " << numberOfSaturatedComponents.load()
+                            << " components of the deformation field exceed the range of a short, and are clamped to "
+                            << 32767.0 * quantizationStep << " mm.\n"
+                            << "  Consider a larger ResultDeformationFieldQuantizationStep." << std::endl;
+      }
+    }
+  }
+  catch (itk::ExceptionObject & excp)
+  {
+    /** Add information to the exception. */
+    excp.SetLocation("TransformBase - GenerateAndWriteDeformationFieldImage()");
+    std::string err_str = excp.GetDescription();
+    err_str += "\nError occurred while writing deformation field image.\n";
+    excp.SetDescription(err_str);
+
+    /** Pass the exception to an higher level. */
+    throw excp;
+  }
+} // end GenerateAndWriteDeformationFieldImage()
+
+
+/**
+ * ************** WriteImageInSlabs **********************
+ */
+
+template <class TElastix>
+template <class TImage>
+void
+TransformBase<TElastix>::WriteImageInSlabs(TImage &             image,
+                                           itk::ProcessObject & generator,
+                                           const std::string &  fileName,
+                                           const unsigned int   numberOfStreamDivisions)
+{
+  const auto writer = itk::ImageFileWriter<TImage>::New();
+  writer->SetInput(&image);
+  writer->SetFileName(fileName);
+  writer->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+
+  /** When streaming, the image is generated while it is written, so the progress is that of the writer. */
+  itk::ProcessObject & progressSource =
+    (numberOfStreamDivisions > 1) ? static_cast<itk::ProcessObject &>(*writer) : generator;
+  const auto           progressObserver =
+    BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(progressSource);
+
+  writer->Update();
+
+} // end WriteImageInSlabs()
+
+
+/**
+ * ************** CacheInitialTransform **********************
+ */
+
+template <class TElastix>
+void
+TransformBase<TElastix>::CacheInitialTransform(const itk::ImageBase<FixedImageDimension> & image)
+{
+  bool cacheInitialTransform = false;
+  this->m_Configuration->ReadParameter(cacheInitialTransform, "CacheInitialTransform", 0, false);
+
+  /** A linear initial transform is already as cheap as a cache. */
+  const InitialTransformType * const initialTransform = this->GetInitialTransform();
+  if (!cacheInitialTransform || initialTransform == nullptr || initialTransform->IsLinear())
+  {
+    return;
+  }
+
+  unsigned int splineOrder = 3;
+  this->m_Configuration->ReadParameter(splineOrder, "InitialTransformCacheSplineOrder", 0, false);
+  double gridSpacingInVoxels = 2.0;
+  this->m_Configuration->ReadParameter(gridSpacingInVoxels, "InitialTransformCacheGridSpacingInVoxels", 0, false);
+  if (!(gridSpacingInVoxels > 0.0))
+  {
+    itkExceptionMacro(<< "ERROR: InitialTransformCacheGridSpacingInVoxels should be larger than 0, but is "
+                      << gridSpacingInVoxels << ".");
+  }
+
+  /** The grid covers the image, from its first up to (at least) its last voxel. */
+  const auto                                       region = image.GetLargestPossibleRegion();
+  typename CachedInitialTransformType::SizeType    gridSize;
+  typename CachedInitialTransformType::SpacingType gridSpacing;
+  typename CachedInitialTransformType::OriginType  gridOrigin;
+  for (unsigned int d = 0; d < FixedImageDimension; ++d)
+  {
+    gridSize[d] = static_cast<itk::SizeValueType>(std::ceil((region.GetSize(d) - 1) / gridSpacingInVoxels)) + 1;
+    gridSpacing[d] = image.GetSpacing()[d] * gridSpacingInVoxels;
+  }
+  image.TransformIndexToPhysicalPoint(region.GetIndex(), gridOrigin);
+
+  const auto cachedInitialTransform = CachedInitialTransformType::New();
+  cachedInitialTransform->SetTransform(initialTransform);
+  cachedInitialTransform->SetGridSize(gridSize);
+  cachedInitialTransform->SetGridSpacing(gridSpacing);
+  cachedInitialTransform->SetGridOrigin(gridOrigin);
+  cachedInitialTransform->SetGridDirection(image.GetDirection());
+  cachedInitialTransform->SetSplineOrder(splineOrder);
+
+  /** Time the computation of the cache. */
+  itk::TimeProbe timer;
+  timer.Start();
+  elxout << "Caching the initial transform on a grid of size " << gridSize << " ..." << std::endl;
+  cachedInitialTransform->UpdateCache();
+  timer.Stop();
+  elxout << "  Caching the initial transform took " << Conversion::SecondsToDHMS(timer.GetMean(), 2) << std::endl;
+
+  /** Only the combination uses the cache. GetInitialTransform() still returns the original initial transform. */
+  this->GetAsITKBaseType()->SetInitialTransform(cachedInitialTransform);
+
+} // end CacheInitialTransform()
+
+
 /**
  * ************** ComputeDeterminantOfSpatialJacobian **********************
  */
@@ -1242,19 +1583,26 @@ TransformBase<TElastix>::ComputeDeterminantOfSpatialJacobian(void) const
   infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
   infoChanger->SetInput(jacGenerator->GetOutput());
 
-  /** Track the progress of the generation of the deformation field. */
-  const auto progressObserver =
-    BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*jacGenerator);
   /** Create a name for the deformation field file. */
   std::string resultImageFormat = "mhd";
   this->m_Configuration->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
   std::ostringstream makeFileName("");
   makeFileName << this->m_Configuration->GetCommandLineArgument("-out") << "spatialJacobian." << resultImageFormat;
 
-  /** Write outputImage to disk. */
-  const auto jacWriter = JacobianWriterType::New();
+  /** Write outputImage to disk, possibly in slabs, which are generated while they are written. */
+  const double       bytesPerPixel = sizeof(typename JacobianImageType::PixelType);
+  const unsigned int numberOfStreamDivisions =
+    this->m_Elastix->GetElxResamplerBase()->GetNumberOfResultImageStreamDivisions(bytesPerPixel);
+  const auto         jacWriter = JacobianWriterType::New();
   jacWriter->SetInput(infoChanger->GetOutput());
   jacWriter->SetFileName(makeFileName.str().c_str());
+  jacWriter->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+
+  /** Track the progress of the generation of the Jacobian determinant, or of the writer when streaming. */
+  itk::ProcessObject & progressSource =
+    (numberOfStreamDivisions > 1) ? static_cast<itk::ProcessObject &>(*jacWriter) : *jacGenerator;
+  const auto           progressObserver =
+    BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(progressSource);
 
   /** Do the writing. */
   elxout << "  Computing and writing the spatial Jacobian determinant..." << std::endl;
@@ -1330,18 +1678,25 @@ TransformBase<TElastix>::ComputeSpatialJacobian(void) const
   infoChanger->SetChangeDirection(retdc & !this->GetElastix()->GetUseDirectionCosines());
   infoChanger->SetInput(jacGenerator->GetOutput());
 
-  const auto progressObserver =
-    BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(*jacGenerator);
   /** Create a name for the deformation field file. */
   std::string resultImageFormat = "mhd";
   this->m_Configuration->ReadParameter(resultImageFormat, "ResultImageFormat", 0, false);
   std::ostringstream makeFileName("");
   makeFileName << this->m_Configuration->GetCommandLineArgument("-out") << "fullSpatialJacobian." << resultImageFormat;
 
-  /** Write outputImage to disk. */
-  const auto jacWriter = JacobianWriterType::New();
+  /** Write outputImage to disk, possibly in slabs, which are generated while they are written. */
+  const unsigned int numberOfStreamDivisions =
+    this->m_Elastix->GetElxResamplerBase()->GetNumberOfResultImageStreamDivisions(sizeof(OutputSpatialJacobianType));
+  const auto         jacWriter = JacobianWriterType::New();
   jacWriter->SetInput(infoChanger->GetOutput());
   jacWriter->SetFileName(makeFileName.str().c_str());
+  jacWriter->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+
+  /** Track the progress of the generation of the spatial Jacobian, or of the writer when streaming. */
+  itk::ProcessObject & progressSource =
+    (numberOfStreamDivisions > 1) ? static_cast<itk::ProcessObject &>(*jacWriter) : *jacGenerator;
+  const auto           progressObserver =
+    BaseComponent::IsElastixLibrary() ? nullptr : ProgressCommandType::CreateAndConnect(progressSource);
   /** Hack to change the pixel type to vector. Not necessary for mhd. */
   const auto jacStartWriteCommand = PixelTypeChangeCommandType::New();
   if (resultImageFormat != "mhd")
@@ -21,6 +21,8 @@
 #include "elxBaseComponent.h"
 #include "elxConfiguration.h"
 
+#include "itkPersistentImageCache.h"
+
 // ITK header files:
 #include <itkMacro.h> // For ITK_DISALLOW_COPY_AND_ASSIGN.
 #include <itkWeakPointer.h>
@@ -140,6 +142,12 @@ protected:
   BaseComponentSE() = default;
   ~BaseComponentSE() override = default;
 
+  /** Create the persistent cache for images that are shared between runs, if a
+   * CacheDirectory is given in the parameter file. Returns a null pointer otherwise.
+   */
+  itk::PersistentImageCache::Pointer
+  CreatePersistentCache(void) const;
+
   ElastixPointer       m_Elastix{};
   ConfigurationPointer m_Configuration{};
   RegistrationPointer  m_Registration{};
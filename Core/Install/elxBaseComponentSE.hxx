@@ -69,6 +69,33 @@ BaseComponentSE<TElastix>::SetConfiguration(ConfigurationType * const _arg)
 } // end SetConfiguration
 
 
+/**
+ * *********************** CreatePersistentCache ***************************
+ */
+
+template <class TElastix>
+itk::PersistentImageCache::Pointer
+BaseComponentSE<TElastix>::CreatePersistentCache(void) const
+{
+  itk::PersistentImageCache::Pointer cache; // default-constructed (null)
+
+  std::string cacheDirectory;
+  this->m_Configuration->ReadParameter(cacheDirectory, "CacheDirectory", 0, false);
+  if (!cacheDirectory.empty())
+  {
+    /** The maximum size of the cache directory, in megabytes. */
+    unsigned long maximumSize = 4096;
+    this->m_Configuration->ReadParameter(maximumSize, "CacheMaximumSize", 0, false);
+
+    cache = itk::PersistentImageCache::New();
+    cache->SetDirectory(cacheDirectory);
+    cache->SetMaximumNumberOfBytes(static_cast<std::uint64_t>(maximumSize) << 20);
+  }
+  return cache;
+
+} // end CreatePersistentCache()
+
+
 } // end namespace elastix
 
 #endif // end #ifndef elxBaseComponentSE_hxx
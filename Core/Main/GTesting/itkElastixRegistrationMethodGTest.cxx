@@ -34,6 +34,7 @@
 #include <map>
 #include <string>
 #include <utility> // For pair
+#include <vector>
 
 
 // Tests registering two small (5x6) binary images, which are translated with respect to each other.
@@ -330,3 +331,366 @@ GTEST_TEST(itkElastixRegistrationMethod, InitialTransformParameterFileLinkToTran
     }
   }
 }
+
+
+// Tests that the sparse accumulation of the per-thread derivatives does not change the result of a B-spline
+// registration, and that spatially partitioned sampling yields a nearly equal result.
+GTEST_TEST(itkElastixRegistrationMethod, DerivativeAccumulationModes)
+{
+  constexpr auto ImageDimension = 2U;
+  using ImageType = itk::Image<float, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+
+  const SizeType  imageSize{ { 128, 64 } };
+  const auto      regionSize = SizeType::Filled(32);
+  const IndexType fixedImageRegionIndex{ { 40, 16 } };
+  const IndexType movingImageRegionIndex{ { 42, 15 } };
+
+  const auto fixedImage = ImageType::New();
+  fixedImage->SetRegions(imageSize);
+  fixedImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+
+  const auto movingImage = ImageType::New();
+  movingImage->SetRegions(imageSize);
+  movingImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*movingImage, movingImageRegionIndex, regionSize);
+
+  const auto registerAndRetrieveTransformParameters = [fixedImage, movingImage](const std::string & useSparse,
+                                                                                const std::string & usePartitioning) {
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(
+      elx::CoreMainGTestUtilities::CreateParameterMap({ { "FinalGridSpacingInVoxels", "2" },
+                                                        { "ImageSampler", "Full" },
+                                                        { "MaximumNumberOfIterations", "3" },
+                                                        { "Metric", "AdvancedMeanSquares" },
+                                                        { "NumberOfResolutions", "1" },
+                                                        { "Optimizer", "StandardGradientDescent" },
+                                                        { "Transform", "BSplineTransform" },
+                                                        { "UseSparseDerivativeAccumulation", useSparse },
+                                                        { "UseSpatiallyPartitionedSampling", usePartitioning } }));
+
+    // The B-spline grid has about 68 control points along the first axis, so 14 slabs of 5 control points.
+    // The spatial partition needs at least two slabs per thread, so the number of threads is fixed. Otherwise
+    // the metric would silently fall back to the normal threading on machines with many cores.
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetParameterObject(parameterObject);
+    filter->SetNumberOfThreads(2);
+    filter->Update();
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    EXPECT_EQ(transformParameterMaps.size(), 1);
+
+    std::vector<double> transformParameters;
+    for (const auto & value : transformParameterMaps.front().at("TransformParameters"))
+    {
+      transformParameters.push_back(std::stod(value));
+    }
+    return transformParameters;
+  };
+
+  const auto dense = registerAndRetrieveTransformParameters("false", "false");
+  const auto sparse = registerAndRetrieveTransformParameters("true", "false");
+  const auto partitioned = registerAndRetrieveTransformParameters("true", "true");
+
+  ASSERT_FALSE(dense.empty());
+  EXPECT_EQ(sparse, dense);
+  ASSERT_EQ(partitioned.size(), dense.size());
+  for (std::size_t i = 0; i < dense.size(); ++i)
+  {
+    EXPECT_NEAR(partitioned[i], dense[i], 1e-6);
+  }
+}
+
+
+// Tests that the batched evaluation of samples yields the same B-spline registration result as the evaluation of
+// one sample at a time, for the metrics that support the batches.
+GTEST_TEST(itkElastixRegistrationMethod, SampleBatches)
+{
+  constexpr auto ImageDimension = 2U;
+  using ImageType = itk::Image<float, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+
+  const SizeType  imageSize{ { 64, 48 } };
+  const auto      regionSize = SizeType::Filled(24);
+  const IndexType fixedImageRegionIndex{ { 20, 12 } };
+  const IndexType movingImageRegionIndex{ { 22, 11 } };
+
+  const auto fixedImage = ImageType::New();
+  fixedImage->SetRegions(imageSize);
+  fixedImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+
+  const auto movingImage = ImageType::New();
+  movingImage->SetRegions(imageSize);
+  movingImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*movingImage, movingImageRegionIndex, regionSize);
+
+  const auto registerAndRetrieveTransformParameters = [fixedImage, movingImage](const std::string & metric,
+                                                                                const std::string & interpolator,
+                                                                                const std::string & useSampleBatches) {
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(
+      elx::CoreMainGTestUtilities::CreateParameterMap({ { "FinalGridSpacingInVoxels", "4" },
+                                                        { "ImageSampler", "Full" },
+                                                        { "Interpolator", interpolator },
+                                                        { "MaximumNumberOfIterations", "3" },
+                                                        { "Metric", metric },
+                                                        { "NumberOfResolutions", "1" },
+                                                        { "Optimizer", "StandardGradientDescent" },
+                                                        { "Transform", "BSplineTransform" },
+                                                        { "UseSampleBatches", useSampleBatches } }));
+
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetParameterObject(parameterObject);
+    filter->Update();
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    EXPECT_EQ(transformParameterMaps.size(), 1);
+
+    std::vector<double> transformParameters;
+    for (const auto & value : transformParameterMaps.front().at("TransformParameters"))
+    {
+      transformParameters.push_back(std::stod(value));
+    }
+    return transformParameters;
+  };
+
+  for (const std::string metric :
+       { "AdvancedMeanSquares", "AdvancedNormalizedCorrelation", "AdvancedMattesMutualInformation" })
+  {
+    for (const std::string interpolator : { "LinearInterpolator", "BSplineInterpolator" })
+    {
+      const auto batched = registerAndRetrieveTransformParameters(metric, interpolator, "true");
+      const auto unbatched = registerAndRetrieveTransformParameters(metric, interpolator, "false");
+
+      ASSERT_FALSE(batched.empty());
+      ASSERT_EQ(batched.size(), unbatched.size());
+      for (std::size_t i = 0; i < batched.size(); ++i)
+      {
+        EXPECT_NEAR(batched[i], unbatched[i], 1e-5) << metric << ' ' << interpolator << ' ' << i;
+      }
+    }
+  }
+}
+
+
+// Tests that a combination of an image metric and a point set metric yields the same registration result when the
+// point set metric runs as a task on the thread pool, concurrently with the image metric, as when both metrics are
+// evaluated one after the other, by a single thread.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentPointSetMetric)
+{
+  constexpr auto ImageDimension = 2U;
+  using ImageType = itk::Image<float, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+
+  const SizeType  imageSize{ { 64, 48 } };
+  const auto      regionSize = SizeType::Filled(24);
+  const IndexType fixedImageRegionIndex{ { 20, 12 } };
+  const IndexType movingImageRegionIndex{ { 22, 11 } };
+
+  const auto fixedImage = ImageType::New();
+  fixedImage->SetRegions(imageSize);
+  fixedImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+
+  const auto movingImage = ImageType::New();
+  movingImage->SetRegions(imageSize);
+  movingImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*movingImage, movingImageRegionIndex, regionSize);
+
+  const auto registerAndRetrieveTransformParameters = [fixedImage, movingImage](const int numberOfThreads) {
+    auto parameterMap =
+      elx::CoreMainGTestUtilities::CreateParameterMap({ { "ImageSampler", "Full" },
+                                                        { "MaximumNumberOfIterations", "3" },
+                                                        { "NumberOfResolutions", "1" },
+                                                        { "Optimizer", "StandardGradientDescent" },
+                                                        { "Registration", "MultiMetricMultiResolutionRegistration" },
+                                                        { "Transform", "TranslationTransform" } });
+    parameterMap["Metric"] = { "AdvancedMeanSquares", "CorrespondingPointsEuclideanDistanceMetric" };
+
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(parameterMap);
+
+    // With a single thread, the thread pool runs the point set metric task immediately, in the calling thread.
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetFixedPointSetFileName(elx::CoreMainGTestUtilities::GetDataDirectoryPath() +
+                                     "/2D_corresponding_points_fixed.txt");
+    filter->SetMovingPointSetFileName(elx::CoreMainGTestUtilities::GetDataDirectoryPath() +
+                                      "/2D_corresponding_points_moving.txt");
+    filter->SetParameterObject(parameterObject);
+    filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    EXPECT_EQ(transformParameterMaps.size(), 1);
+
+    std::vector<double> transformParameters;
+    for (const auto & value : transformParameterMaps.front().at("TransformParameters"))
+    {
+      transformParameters.push_back(std::stod(value));
+    }
+    return transformParameters;
+  };
+
+  const auto serial = registerAndRetrieveTransformParameters(1);
+  const auto concurrent = registerAndRetrieveTransformParameters(4);
+
+  ASSERT_EQ(serial.size(), ImageDimension);
+  ASSERT_EQ(concurrent.size(), serial.size());
+  for (std::size_t i = 0; i < serial.size(); ++i)
+  {
+    EXPECT_NEAR(concurrent[i], serial[i], 1e-6);
+  }
+}
+
+
+// Tests that the multi-threaded low-memory derivative of NormalizedMutualInformation, and the parallel reduction of
+// its joint histograms, yield the same B-spline registration result as the explicit joint histogram derivative,
+// computed by a single thread.
+GTEST_TEST(itkElastixRegistrationMethod, NormalizedMutualInformationLowMemoryDerivative)
+{
+  constexpr auto ImageDimension = 2U;
+  using ImageType = itk::Image<float, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+
+  const SizeType  imageSize{ { 64, 48 } };
+  const auto      regionSize = SizeType::Filled(24);
+  const IndexType fixedImageRegionIndex{ { 20, 12 } };
+  const IndexType movingImageRegionIndex{ { 22, 11 } };
+
+  const auto fixedImage = ImageType::New();
+  fixedImage->SetRegions(imageSize);
+  fixedImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+
+  const auto movingImage = ImageType::New();
+  movingImage->SetRegions(imageSize);
+  movingImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*movingImage, movingImageRegionIndex, regionSize);
+
+  const auto registerAndRetrieveTransformParameters = [fixedImage, movingImage](const std::string & useLowMemory,
+                                                                                const int numberOfThreads) {
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(
+      elx::CoreMainGTestUtilities::CreateParameterMap({ { "FinalGridSpacingInVoxels", "4" },
+                                                        { "ImageSampler", "Full" },
+                                                        { "MaximumNumberOfIterations", "3" },
+                                                        { "Metric", "NormalizedMutualInformation" },
+                                                        { "NumberOfResolutions", "1" },
+                                                        { "Optimizer", "StandardGradientDescent" },
+                                                        { "Transform", "BSplineTransform" },
+                                                        { "UseFastAndLowMemoryVersion", useLowMemory } }));
+
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetParameterObject(parameterObject);
+    filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    EXPECT_EQ(transformParameterMaps.size(), 1);
+
+    std::vector<double> transformParameters;
+    for (const auto & value : transformParameterMaps.front().at("TransformParameters"))
+    {
+      transformParameters.push_back(std::stod(value));
+    }
+    return transformParameters;
+  };
+
+  const auto explicitSerial = registerAndRetrieveTransformParameters("false", 1);
+  ASSERT_FALSE(explicitSerial.empty());
+
+  for (const std::string useLowMemory : { "false", "true" })
+  {
+    const auto threaded = registerAndRetrieveTransformParameters(useLowMemory, 4);
+
+    ASSERT_EQ(threaded.size(), explicitSerial.size());
+    for (std::size_t i = 0; i < threaded.size(); ++i)
+    {
+      EXPECT_NEAR(threaded[i], explicitSerial[i], 1e-5) << useLowMemory << ' ' << i;
+    }
+  }
+}
+
+
+// Tests that the single-threaded penalty terms yield the same registration result when they run as tasks on the
+// thread pool, concurrently with the multi-threaded image metric, as when all metrics are evaluated one after the
+// other, by a single thread.
+GTEST_TEST(itkElastixRegistrationMethod, ConcurrentPenaltyTerms)
+{
+  constexpr auto ImageDimension = 2U;
+  using ImageType = itk::Image<float, ImageDimension>;
+  using SizeType = itk::Size<ImageDimension>;
+  using IndexType = itk::Index<ImageDimension>;
+
+  const SizeType  imageSize{ { 64, 48 } };
+  const auto      regionSize = SizeType::Filled(24);
+  const IndexType fixedImageRegionIndex{ { 20, 12 } };
+  const IndexType movingImageRegionIndex{ { 22, 11 } };
+
+  const auto fixedImage = ImageType::New();
+  fixedImage->SetRegions(imageSize);
+  fixedImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*fixedImage, fixedImageRegionIndex, regionSize);
+
+  const auto movingImage = ImageType::New();
+  movingImage->SetRegions(imageSize);
+  movingImage->Allocate(true);
+  elx::CoreMainGTestUtilities::FillImageRegion(*movingImage, movingImageRegionIndex, regionSize);
+
+  const auto registerAndRetrieveTransformParameters = [fixedImage, movingImage](const int numberOfThreads) {
+    auto parameterMap =
+      elx::CoreMainGTestUtilities::CreateParameterMap({ { "FinalGridSpacingInVoxels", "8" },
+                                                        { "ImageSampler", "Full" },
+                                                        { "MaximumNumberOfIterations", "3" },
+                                                        { "NumberOfResolutions", "1" },
+                                                        { "Optimizer", "StandardGradientDescent" },
+                                                        { "Registration", "MultiMetricMultiResolutionRegistration" },
+                                                        { "Transform", "BSplineTransform" } });
+    parameterMap["Metric"] = { "AdvancedMeanSquares", "TransformRigidityPenalty", "DisplacementMagnitudePenalty" };
+
+    const auto parameterObject = elastix::ParameterObject::New();
+    parameterObject->SetParameterMap(parameterMap);
+
+    // With a single thread, the thread pool runs the penalty term tasks immediately, in the calling thread.
+    const auto filter = itk::ElastixRegistrationMethod<ImageType, ImageType>::New();
+    filter->SetFixedImage(fixedImage);
+    filter->SetMovingImage(movingImage);
+    filter->SetParameterObject(parameterObject);
+    filter->SetNumberOfThreads(numberOfThreads);
+    filter->Update();
+
+    const auto & transformParameterMaps = filter->GetTransformParameterObject()->GetParameterMap();
+    EXPECT_EQ(transformParameterMaps.size(), 1);
+
+    std::vector<double> transformParameters;
+    for (const auto & value : transformParameterMaps.front().at("TransformParameters"))
+    {
+      transformParameters.push_back(std::stod(value));
+    }
+    return transformParameters;
+  };
+
+  const auto serial = registerAndRetrieveTransformParameters(1);
+  const auto concurrent = registerAndRetrieveTransformParameters(4);
+
+  ASSERT_FALSE(serial.empty());
+  ASSERT_EQ(concurrent.size(), serial.size());
+  for (std::size_t i = 0; i < serial.size(); ++i)
+  {
+    EXPECT_NEAR(concurrent[i], serial[i], 1e-6) << i;
+  }
+}
@@ -0,0 +1,175 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+// First include the header file to be tested:
+#include <itkTransformixBatchResampler.h>
+
+#include <itkTransformixFilter.h>
+#include "elxCoreMainGTestUtilities.h"
+
+#include <itkImage.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+
+namespace
+{
+using ImageType = itk::Image<float, 2>;
+
+// Creates a parameter object that translates a 5x6 image by (1, -2), and then by (0.75, 0.25).
+// No voxel is mapped onto the border half a voxel outside the image, where interpolators may differ.
+elx::ParameterObject::Pointer
+CreateTranslationParameterObject()
+{
+  const elx::ParameterObject::ParameterMapType commonParameterMap = {
+    // Parameters in alphabetic order:
+    { "Direction", { "1", "0", "0", "1" } },
+    { "Index", { "0", "0" } },
+    { "NumberOfParameters", { "2" } },
+    { "Origin", { "0", "0" } },
+    { "ResampleInterpolator", { "FinalLinearInterpolator" } },
+    { "Size", { "5", "6" } },
+    { "Spacing", { "1", "1" } },
+    { "Transform", { "TranslationTransform" } }
+  };
+
+  auto firstParameterMap = commonParameterMap;
+  firstParameterMap["TransformParameters"] = { "1", "-2" };
+  auto secondParameterMap = commonParameterMap;
+  secondParameterMap["TransformParameters"] = { "0.75", "0.25" };
+
+  const elx::ParameterObject::ParameterMapVectorType parameterMaps = { firstParameterMap, secondParameterMap };
+
+  const auto parameterObject = elx::ParameterObject::New();
+  parameterObject->SetParameterMap(parameterMaps);
+  return parameterObject;
+}
+
+
+// Creates a 5x6 image of which the pixel values increase linearly with the index.
+ImageType::Pointer
+CreateImage(const float offset)
+{
+  const auto image = ImageType::New();
+  image->SetRegions(ImageType::SizeType{ { 5, 6 } });
+  image->Allocate();
+
+  for (itk::ImageRegionIterator<ImageType> it(image, image->GetBufferedRegion()); !it.IsAtEnd(); ++it)
+  {
+    const auto index = it.GetIndex();
+    it.Set(offset + index[0] + 2.0f * index[1]);
+  }
+  return image;
+}
+
+} // namespace
+
+
+// Tests that resampling several images with the same transform gives the same result as TransformixFilter.
+GTEST_TEST(itkTransformixBatchResampler, SameAsTransformixFilter)
+{
+  const auto parameterObject = CreateTranslationParameterObject();
+
+  const auto batchResampler = itk::TransformixBatchResampler<ImageType>::New();
+  batchResampler->SetTransformParameterObject(parameterObject);
+  batchResampler->Initialize();
+  ASSERT_TRUE(batchResampler->IsInitialized());
+  EXPECT_EQ(batchResampler->GetSplineOrder(), 1u);
+
+  for (const float offset : { 0.0f, 10.0f, -3.0f })
+  {
+    const auto image = CreateImage(offset);
+
+    const auto transformixFilter = itk::TransformixFilter<ImageType>::New();
+    transformixFilter->SetMovingImage(image);
+    transformixFilter->SetTransformParameterObject(parameterObject);
+    transformixFilter->Update();
+    const auto & expected = elx::CoreMainGTestUtilities::Deref(transformixFilter->GetOutput());
+
+    const auto & actual = elx::CoreMainGTestUtilities::Deref(batchResampler->Resample(*image).GetPointer());
+    ASSERT_EQ(actual.GetBufferedRegion(), expected.GetBufferedRegion());
+    EXPECT_EQ(actual.GetSpacing(), expected.GetSpacing());
+    EXPECT_EQ(actual.GetOrigin(), expected.GetOrigin());
+    EXPECT_EQ(actual.GetDirection(), expected.GetDirection());
+
+    itk::ImageRegionConstIterator<ImageType> actualIt(&actual, actual.GetBufferedRegion());
+    itk::ImageRegionConstIterator<ImageType> expectedIt(&expected, expected.GetBufferedRegion());
+    for (; !actualIt.IsAtEnd(); ++actualIt, ++expectedIt)
+    {
+      EXPECT_NEAR(actualIt.Get(), expectedIt.Get(), 1e-4);
+    }
+  }
+}
+
+
+// Tests that Resample() throws when the deformation field is not yet computed.
+GTEST_TEST(itkTransformixBatchResampler, ResampleThrowsBeforeInitialize)
+{
+  const auto batchResampler = itk::TransformixBatchResampler<ImageType>::New();
+  batchResampler->SetTransformParameterObject(CreateTranslationParameterObject());
+  EXPECT_FALSE(batchResampler->IsInitialized());
+  EXPECT_THROW(batchResampler->Resample(*CreateImage(0.0f)), itk::ExceptionObject);
+}
+
+
+// Tests that images resampled concurrently, from different threads, equal those resampled one by one.
+GTEST_TEST(itkTransformixBatchResampler, ConcurrentResampleSameAsSequential)
+{
+  const auto batchResampler = itk::TransformixBatchResampler<ImageType>::New();
+  batchResampler->SetTransformParameterObject(CreateTranslationParameterObject());
+  batchResampler->Initialize();
+
+  constexpr unsigned int          numberOfImages = 8;
+  std::vector<ImageType::Pointer> images;
+  std::vector<ImageType::Pointer> concurrentResults(numberOfImages);
+  for (unsigned int i = 0; i < numberOfImages; ++i)
+  {
+    images.push_back(CreateImage(static_cast<float>(i)));
+  }
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < numberOfImages; ++i)
+  {
+    threads.emplace_back([&batchResampler, &images, &concurrentResults, i] {
+      concurrentResults[i] = batchResampler->Resample(*images[i]);
+    });
+  }
+  for (auto & thread : threads)
+  {
+    thread.join();
+  }
+
+  for (unsigned int i = 0; i < numberOfImages; ++i)
+  {
+    const auto & expected = elx::CoreMainGTestUtilities::Deref(batchResampler->Resample(*images[i]).GetPointer());
+    const auto & actual = elx::CoreMainGTestUtilities::Deref(concurrentResults[i].GetPointer());
+    ASSERT_EQ(actual.GetBufferedRegion(), expected.GetBufferedRegion());
+
+    itk::ImageRegionConstIterator<ImageType> actualIt(&actual, actual.GetBufferedRegion());
+    itk::ImageRegionConstIterator<ImageType> expectedIt(&expected, expected.GetBufferedRegion());
+    for (; !actualIt.IsAtEnd(); ++actualIt, ++expectedIt)
+    {
+      EXPECT_EQ(actualIt.Get(), expectedIt.Get());
+    }
+  }
+}
@@ -0,0 +1,170 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTransformixBatchResampler_h
+#define itkTransformixBatchResampler_h
+
+#include "itkObject.h"
+#include "itkImage.h"
+#include "itkInterpolateImageFunction.h"
+
+#include "elxTransformixMain.h"
+#include "elxParameterObject.h"
+
+/**
+ * \class TransformixBatchResampler
+ * \brief Applies one transformix transform to many images.
+ *
+ * TransformixFilter creates the transform from the transform parameter maps
+ * for each image that it resamples. Initialize() lets transformix compute the
+ * deformation field of the transform once, on the grid of the output image
+ * (Size, Index, Spacing, Origin and Direction of the last map). Resample()
+ * then maps each voxel by its precomputed displacement, and interpolates the
+ * input image there. This costs one field lookup per voxel, whatever the
+ * transform, and each image is resampled by multiple threads.
+ *
+ * Each call of Resample() grafts the deformation field into an image of its
+ * own, so after Initialize(), images may also be resampled concurrently, from
+ * different threads.
+ *
+ * The displacements are stored as floats, so the result may differ slightly
+ * from that of TransformixFilter.
+ *
+ * \ingroup Elastix
+ */
+
+namespace itk
+{
+
+template <typename TImage>
+class ITK_TEMPLATE_EXPORT TransformixBatchResampler : public Object
+{
+public:
+  /** Standard ITK typedefs. */
+  typedef TransformixBatchResampler Self;
+  typedef Object                    Superclass;
+  typedef SmartPointer<Self>        Pointer;
+  typedef SmartPointer<const Self>  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(TransformixBatchResampler, Object);
+
+  /** Typedefs. */
+  typedef TImage                        ImageType;
+  typedef typename ImageType::Pointer   ImagePointer;
+  typedef typename ImageType::PixelType PixelType;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, TImage::ImageDimension);
+
+  typedef elastix::TransformixMain             TransformixMainType;
+  typedef TransformixMainType::ArgumentMapType ArgumentMapType;
+  typedef ArgumentMapType::value_type          ArgumentMapEntryType;
+
+  typedef elastix::ParameterObject                      ParameterObjectType;
+  typedef ParameterObjectType::ParameterMapVectorType   ParameterMapVectorType;
+  typedef ParameterObjectType::ParameterMapType         ParameterMapType;
+  typedef ParameterObjectType::ParameterValueVectorType ParameterValueVectorType;
+  typedef typename ParameterObjectType::Pointer         ParameterObjectPointer;
+
+  typedef Image<Vector<float, TImage::ImageDimension>, TImage::ImageDimension> DeformationFieldType;
+  typedef typename DeformationFieldType::Pointer                               DeformationFieldPointer;
+  typedef InterpolateImageFunction<ImageType, double>                          InterpolatorType;
+
+  /** Set/Get the transform parameter object. Setting it discards the deformation field. */
+  virtual void
+  SetTransformParameterObject(ParameterObjectType * transformParameterObject);
+
+  itkGetModifiableObjectMacro(TransformParameterObject, ParameterObjectType);
+
+  /** Log to std::cout on/off, while the deformation field is computed. */
+  itkSetMacro(LogToConsole, bool);
+  itkGetConstMacro(LogToConsole, bool);
+  itkBooleanMacro(LogToConsole);
+
+  /** Set/Get the order of the B-spline by which the images are interpolated: 0 (nearest
+   * neighbour), 1 (linear), up to 5. Initialize() sets it according to the ResampleInterpolator
+   * and the FinalBSplineInterpolationOrder of the last transform parameter map.
+   */
+  itkSetMacro(SplineOrder, unsigned int);
+  itkGetConstMacro(SplineOrder, unsigned int);
+
+  /** Set/Get the value of the voxels that are mapped outside the input image. Initialize()
+   * sets it to the DefaultPixelValue of the last transform parameter map.
+   */
+  itkSetMacro(DefaultPixelValue, PixelType);
+  itkGetConstMacro(DefaultPixelValue, PixelType);
+
+  /** Computes the deformation field of the transform, by transformix. */
+  virtual void
+  Initialize(void);
+
+  /** Returns true if the deformation field is computed. */
+  bool
+  IsInitialized(void) const
+  {
+    return this->m_DeformationField.IsNotNull();
+  }
+
+  /** The deformation field of the transform. */
+  itkGetConstObjectMacro(DeformationField, DeformationFieldType);
+
+  /** Resamples an image by the transform, onto the grid of the deformation field,
+   * with the specified spline order and default pixel value.
+   */
+  ImagePointer
+  Resample(const ImageType & image, const unsigned int splineOrder, const PixelType defaultPixelValue) const;
+
+  /** Resamples an image by the transform, with the current spline order and default pixel value. */
+  ImagePointer
+  Resample(const ImageType & image) const
+  {
+    return this->Resample(image, this->m_SplineOrder, this->m_DefaultPixelValue);
+  }
+
+protected:
+  TransformixBatchResampler() = default;
+  ~TransformixBatchResampler() override = default;
+
+  void
+  PrintSelf(std::ostream & os, Indent indent) const override;
+
+private:
+  TransformixBatchResampler(const Self &) = delete;
+  void
+  operator=(const Self &) = delete;
+
+  /** Creates an interpolator of the specified spline order. */
+  static typename InterpolatorType::Pointer
+  CreateInterpolator(const unsigned int splineOrder);
+
+  ParameterObjectPointer  m_TransformParameterObject;
+  DeformationFieldPointer m_DeformationField;
+  bool                    m_LogToConsole{ false };
+  unsigned int            m_SplineOrder{ 3 };
+  PixelType               m_DefaultPixelValue{};
+};
+
+} // namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#  include "itkTransformixBatchResampler.hxx"
+#endif
+
+#endif
@@ -0,0 +1,206 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkTransformixBatchResampler_hxx
+#define itkTransformixBatchResampler_hxx
+
+#include "itkTransformixBatchResampler.h"
+#include "itkWarpImageFilter.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkBSplineInterpolateImageFunction.h"
+
+#include <cstdlib> // For atoi and atof.
+#include <string>
+
+namespace itk
+{
+
+template <typename TImage>
+void
+TransformixBatchResampler<TImage>::SetTransformParameterObject(ParameterObjectType * transformParameterObject)
+{
+  if (this->m_TransformParameterObject != transformParameterObject)
+  {
+    this->m_TransformParameterObject = transformParameterObject;
+    this->m_DeformationField = nullptr;
+    this->Modified();
+  }
+}
+
+
+template <typename TImage>
+void
+TransformixBatchResampler<TImage>::Initialize(void)
+{
+  if (this->m_TransformParameterObject.IsNull() || this->m_TransformParameterObject->GetNumberOfParameterMaps() == 0)
+  {
+    itkExceptionMacro("Empty parameter map in parameter object.");
+  }
+
+  // Set the image dimensions, and chain the maps, as TransformixFilter does
+  const unsigned int     imageDimension = ImageDimension;
+  ParameterMapVectorType transformParameterMapVector = this->m_TransformParameterObject->GetParameterMap();
+  for (unsigned int i = 0; i < transformParameterMapVector.size(); ++i)
+  {
+    transformParameterMapVector[i]["FixedImageDimension"] = ParameterValueVectorType(1, std::to_string(imageDimension));
+    transformParameterMapVector[i]["MovingImageDimension"] =
+      ParameterValueVectorType(1, std::to_string(imageDimension));
+
+    if (i > 0)
+    {
+      transformParameterMapVector[i]["InitialTransformParametersFileName"] =
+        ParameterValueVectorType(1, std::to_string(i - 1));
+    }
+  }
+
+  // Take the interpolation settings of the last map as defaults
+  const ParameterMapType & lastTransformParameterMap = transformParameterMapVector.back();
+  const auto               resampleInterpolatorIter = lastTransformParameterMap.find("ResampleInterpolator");
+  const auto               splineOrderIter = lastTransformParameterMap.find("FinalBSplineInterpolationOrder");
+  const auto               defaultPixelValueIter = lastTransformParameterMap.find("DefaultPixelValue");
+
+  const std::string resampleInterpolator =
+    (resampleInterpolatorIter == lastTransformParameterMap.end() || resampleInterpolatorIter->second.empty())
+      ? "FinalBSplineInterpolator"
+      : resampleInterpolatorIter->second[0];
+
+  this->m_SplineOrder = 3;
+  if (resampleInterpolator == "FinalNearestNeighborInterpolator")
+  {
+    this->m_SplineOrder = 0;
+  }
+  else if (resampleInterpolator == "FinalLinearInterpolator")
+  {
+    this->m_SplineOrder = 1;
+  }
+  else if (splineOrderIter != lastTransformParameterMap.end() && !splineOrderIter->second.empty())
+  {
+    this->m_SplineOrder = std::atoi(splineOrderIter->second[0].c_str());
+  }
+  this->m_DefaultPixelValue = PixelType{};
+  if (defaultPixelValueIter != lastTransformParameterMap.end() && !defaultPixelValueIter->second.empty())
+  {
+    this->m_DefaultPixelValue = static_cast<PixelType>(std::atof(defaultPixelValueIter->second[0].c_str()));
+  }
+
+  // "-def all" lets transformix compute the deformation field, which the library does not write to disk
+  ArgumentMapType argumentMap;
+  argumentMap.insert(ArgumentMapEntryType("-def", "all"));
+  argumentMap.insert(ArgumentMapEntryType("-out", "output_path_not_set"));
+
+  const elx::xoutManager manager("", false, this->m_LogToConsole);
+
+  const auto   transformix = TransformixMainType::New();
+  unsigned int isError = 0;
+  try
+  {
+    isError = transformix->Run(argumentMap, transformParameterMapVector);
+  }
+  catch (itk::ExceptionObject & e)
+  {
+    itkExceptionMacro("Errors occured during execution: " << e.what());
+  }
+
+  if (isError != 0)
+  {
+    itkExceptionMacro("Internal transformix error: See transformix log (use LogToConsoleOn())");
+  }
+
+  const auto             resultDeformationFieldContainer = transformix->GetResultDeformationFieldContainer();
+  DeformationFieldType * deformationField = nullptr;
+  if (resultDeformationFieldContainer.IsNotNull() && resultDeformationFieldContainer->Size() > 0)
+  {
+    deformationField = dynamic_cast<DeformationFieldType *>(resultDeformationFieldContainer->ElementAt(0).GetPointer());
+  }
+  if (deformationField == nullptr)
+  {
+    itkExceptionMacro("Transformix did not compute a deformation field.");
+  }
+  this->m_DeformationField = deformationField;
+}
+
+
+template <typename TImage>
+typename TransformixBatchResampler<TImage>::ImagePointer
+TransformixBatchResampler<TImage>::Resample(const ImageType &  image,
+                                            const unsigned int splineOrder,
+                                            const PixelType    defaultPixelValue) const
+{
+  if (this->m_DeformationField.IsNull())
+  {
+    itkExceptionMacro("The deformation field is not computed. Call Initialize() first.");
+  }
+
+  // The pipeline sets the requested region of its inputs, so each call gets its own image, which shares the
+  // displacements of the deformation field.
+  const auto deformationField = DeformationFieldType::New();
+  deformationField->Graft(this->m_DeformationField);
+
+  // Each voxel is mapped by its displacement, without interpolating the deformation field
+  const auto warpFilter = WarpImageFilter<ImageType, ImageType, DeformationFieldType>::New();
+  warpFilter->SetInput(&image);
+  warpFilter->SetDisplacementField(deformationField);
+  warpFilter->SetOutputParametersFromImage(deformationField);
+  warpFilter->SetInterpolator(CreateInterpolator(splineOrder));
+  warpFilter->SetEdgePaddingValue(defaultPixelValue);
+  warpFilter->Update();
+  return warpFilter->GetOutput();
+}
+
+
+template <typename TImage>
+typename TransformixBatchResampler<TImage>::InterpolatorType::Pointer
+TransformixBatchResampler<TImage>::CreateInterpolator(const unsigned int splineOrder)
+{
+  switch (splineOrder)
+  {
+    case 0:
+      return NearestNeighborInterpolateImageFunction<ImageType, double>::New().GetPointer();
+    case 1:
+      return LinearInterpolateImageFunction<ImageType, double>::New().GetPointer();
+    default:
+    {
+      if (splineOrder > 5)
+      {
+        itkGenericExceptionMacro("The spline order should be at most 5, but is " << splineOrder << ".");
+      }
+      const auto interpolator = BSplineInterpolateImageFunction<ImageType, double, double>::New();
+      interpolator->SetSplineOrder(splineOrder);
+      return interpolator.GetPointer();
+    }
+  }
+}
+
+
+template <typename TImage>
+void
+TransformixBatchResampler<TImage>::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "TransformParameterObject: " << this->m_TransformParameterObject.GetPointer() << std::endl;
+  os << indent << "DeformationField: " << this->m_DeformationField.GetPointer() << std::endl;
+  os << indent << "LogToConsole: " << this->m_LogToConsole << std::endl;
+  os << indent << "SplineOrder: " << this->m_SplineOrder << std::endl;
+  os << indent << "DefaultPixelValue: "
+     << static_cast<typename NumericTraits<PixelType>::PrintType>(this->m_DefaultPixelValue) << std::endl;
+}
+
+} // namespace itk
+
+#endif
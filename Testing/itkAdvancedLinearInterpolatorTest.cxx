@@ -115,9 +115,12 @@ TestInterpolators(void)
   /** Create and setup interpolators. */
   typename LinearInterpolatorType::Pointer         linear = LinearInterpolatorType::New();
   typename AdvancedLinearInterpolatorType::Pointer linearA = AdvancedLinearInterpolatorType::New();
+  typename AdvancedLinearInterpolatorType::Pointer linearB = AdvancedLinearInterpolatorType::New();
   typename BSplineInterpolatorType::Pointer        bspline = BSplineInterpolatorType::New();
   linear->SetInputImage(image);
   linearA->SetInputImage(image);
+  linearB->SetUseBrickedLayout(true); // prior to SetInputImage()
+  linearB->SetInputImage(image);
   bspline->SetSplineOrder(1); // prior to SetInputImage()
   bspline->SetInputImage(image);
 
@@ -161,13 +164,14 @@ TestInterpolators(void)
   }
 
   /** Compare results. */
-  OutputType          valueLinA, valueBSpline, valueBSpline2;
-  CovariantVectorType derivLinA, derivBSpline, derivBSpline2;
+  OutputType          valueLinA, valueLinB, valueBSpline, valueBSpline2;
+  CovariantVectorType derivLinA, derivLinB, derivBSpline, derivBSpline2;
   for (unsigned int i = 0; i < count; ++i)
   {
     ContinuousIndexType cindex(&darray1[i][0]);
 
     linearA->EvaluateValueAndDerivativeAtContinuousIndex(cindex, valueLinA, derivLinA);
+    linearB->EvaluateValueAndDerivativeAtContinuousIndex(cindex, valueLinB, derivLinB);
     valueBSpline = bspline->EvaluateAtContinuousIndex(cindex);
     derivBSpline = bspline->EvaluateDerivativeAtContinuousIndex(cindex);
     bspline->EvaluateValueAndDerivativeAtContinuousIndex(cindex, valueBSpline2, derivBSpline2);
@@ -176,7 +180,16 @@ TestInterpolators(void)
 
     if (linear->IsInsideBuffer(cindex))
     {
-      std::cout << "linear:   " << linear->EvaluateAtContinuousIndex(cindex) << "   ---" << std::endl;
+      const OutputType valueLin = linear->EvaluateAtContinuousIndex(cindex);
+      std::cout << "linear:   " << valueLin << "   ---" << std::endl;
+
+      if (std::abs(valueLin - linearB->EvaluateAtContinuousIndex(cindex)) > 1.0e-3)
+      {
+        std::cerr << "ERROR: there is a difference in the interpolated value, "
+                  << "between the linear interpolator and the advanced linear interpolator with a bricked copy."
+                  << std::endl;
+        return false;
+      }
     }
     else
     {
@@ -186,6 +199,12 @@ TestInterpolators(void)
     std::cout << "B-spline: " << valueBSpline << "   " << derivBSpline << std::endl;
     std::cout << "B-spline: " << valueBSpline2 << "   " << derivBSpline2 << "\n" << std::endl;
 
+    if (valueLinA != valueLinB || derivLinA != derivLinB)
+    {
+      std::cerr << "ERROR: there is a difference between the advanced linear interpolator "
+                << "with and without the bricked image layout." << std::endl;
+      return false;
+    }
     if (std::abs(valueLinA - valueBSpline) > 1.0e-3)
     {
       std::cerr << "ERROR: there is a difference in the interpolated value, "
@@ -239,6 +258,15 @@ TestInterpolators(void)
   timer.Stop();
   std::cout << "linearA (v&d)   : " << 1.0e3 * timer.GetMean() / static_cast<double>(runs) << " ms" << std::endl;
 
+  timer.Reset();
+  timer.Start();
+  for (unsigned int i = 0; i < runs; ++i)
+  {
+    linearB->EvaluateValueAndDerivativeAtContinuousIndex(cindex, value, deriv);
+  }
+  timer.Stop();
+  std::cout << "linearB (v&d)   : " << 1.0e3 * timer.GetMean() / static_cast<double>(runs) << " ms" << std::endl;
+
   timer.Reset();
   timer.Start();
   for (unsigned int i = 0; i < runs; ++i)
@@ -0,0 +1,129 @@
+/*=========================================================================
+ *
+ *  Copyright UMC Utrecht and contributors
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *        http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkUpsampleBSplineParametersFilter.h"
+#include "itkBSplineCoefficientUpsampleKernel.h"
+
+#include "itkImage.h"
+#include "itkOptimizerParameters.h"
+
+// Report timings
+#include "itkTimeProbesCollectorBase.h"
+
+#include <cmath>
+#include <iostream>
+
+//-------------------------------------------------------------------------------------
+
+int
+main(void)
+{
+  /** Some basic type definitions. A 4D grid, as used for the registration
+   * of dynamic 3D data, where the upsampling between resolutions is the
+   * most expensive.
+   */
+  const unsigned int Dimension = 4;
+  const unsigned int SplineOrder = 3;
+  typedef itk::Image<double, Dimension>                                  ImageType;
+  typedef itk::OptimizerParameters<double>                               ParametersType;
+  typedef itk::UpsampleBSplineParametersFilter<ParametersType, ImageType> FilterType;
+
+  /** The number of repetitions. Distinguish between Debug and Release mode. */
+#ifndef NDEBUG
+  unsigned int N = 1;
+#else
+  unsigned int N = 5;
+#endif
+  std::cerr << "N = " << N << std::endl;
+  std::cerr << "Instruction set: " << itk::BSplineCoefficientUpsampleKernel::GetInstructionSetName() << std::endl;
+
+  /** Setup the grids: the required grid has half the spacing of the current grid. */
+  ImageType::RegionType    currentRegion;
+  ImageType::RegionType    requiredRegion;
+  ImageType::SpacingType   currentSpacing;
+  ImageType::SpacingType   requiredSpacing;
+  ImageType::PointType     currentOrigin;
+  ImageType::PointType     requiredOrigin;
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  const unsigned int currentGridSize[Dimension] = { 24, 24, 20, 8 };
+  for (unsigned int d = 0; d < Dimension; ++d)
+  {
+    currentRegion.SetSize(d, currentGridSize[d]);
+    requiredRegion.SetSize(d, 2 * currentGridSize[d] - 3);
+    currentSpacing[d] = 16.0;
+    requiredSpacing[d] = 8.0;
+    currentOrigin[d] = -16.0;
+    requiredOrigin[d] = -8.0;
+  }
+
+  ParametersType parameters(currentRegion.GetNumberOfPixels() * Dimension);
+  for (unsigned int i = 0; i < parameters.GetSize(); ++i)
+  {
+    parameters[i] = std::sin(0.001 * i);
+  }
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetCurrentGridOrigin(currentOrigin);
+  filter->SetCurrentGridSpacing(currentSpacing);
+  filter->SetCurrentGridDirection(direction);
+  filter->SetCurrentGridRegion(currentRegion);
+  filter->SetRequiredGridOrigin(requiredOrigin);
+  filter->SetRequiredGridSpacing(requiredSpacing);
+  filter->SetRequiredGridDirection(direction);
+  filter->SetRequiredGridRegion(requiredRegion);
+  filter->SetBSplineOrder(SplineOrder);
+
+  ParametersType               parametersOld;
+  ParametersType               parametersNew;
+  itk::TimeProbesCollectorBase timeCollector;
+
+  /** Time the image filter pipeline. */
+  filter->UseSeparableUpsamplingOff();
+  timeCollector.Start("Upsample image filters");
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    filter->UpsampleParameters(parameters, parametersOld);
+  }
+  timeCollector.Stop("Upsample image filters");
+
+  /** Time the separable implementation. */
+  filter->UseSeparableUpsamplingOn();
+  timeCollector.Start("Upsample separable");
+  for (unsigned int i = 0; i < N; ++i)
+  {
+    filter->UpsampleParameters(parameters, parametersNew);
+  }
+  timeCollector.Stop("Upsample separable");
+
+  /** Report timings. */
+  timeCollector.Report();
+
+  /** Test accuracy. */
+  const double diffNorm = (parametersOld - parametersNew).magnitude();
+  std::cerr << "Separable upsampling MSD with image filters: " << diffNorm << std::endl;
+  if (diffNorm > 1e-5)
+  {
+    std::cerr << "ERROR: separable UpsampleParameters() returning incorrect result." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Return a value. */
+  return EXIT_SUCCESS;
+
+} // end main